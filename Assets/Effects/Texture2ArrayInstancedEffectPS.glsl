@@ -0,0 +1,14 @@
+// Instanced variant of Texture2ArrayEffectPS.glsl, modulated by the color of
+// the instance.
+
+uniform sampler2DArray baseSampler;
+
+layout(location = 0) in vec3 vertexTCoord;
+layout(location = 1) in vec4 vertexColor;
+layout(location = 0) out vec4 pixelColor;
+
+void main()
+{
+	// Sample 2D texture array.
+    pixelColor = texture(baseSampler, vertexTCoord) * vertexColor;
+}
@@ -0,0 +1,26 @@
+// Instanced variant of Texture2ArrayEffectPS.hlsl, modulated by the color of
+// the instance.
+
+Texture2DArray baseTextureArray;
+SamplerState baseSampler;
+
+struct PS_INPUT
+{
+    float3 vertexTCoord : TEXCOORD0;
+    float4 vertexColor : COLOR0;
+};
+
+struct PS_OUTPUT
+{
+    float4 pixelColor0 : SV_TARGET0;
+};
+
+PS_OUTPUT PSMain(PS_INPUT input)
+{
+    PS_OUTPUT output;
+
+	// Sample texture array.
+	output.pixelColor0 = baseTextureArray.Sample(baseSampler, input.vertexTCoord) * input.vertexColor;
+
+    return output;
+}
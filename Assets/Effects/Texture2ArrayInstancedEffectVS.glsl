@@ -0,0 +1,31 @@
+// Instanced variant of Texture2ArrayEffectVS.glsl.  The world matrix and the
+// color of each instance are read from the Instances buffer with
+// gl_InstanceID, the size of the arrays matches
+// Texture2ArrayInstancedEffect::MAX_INSTANCES.
+
+uniform PVMatrix
+{
+    mat4 pvMatrix;
+};
+
+uniform Instances
+{
+    mat4 worldMatrix[128];
+    vec4 instanceColor[128];
+};
+
+layout(location = 0) in vec3 modelPosition;
+layout(location = 1) in vec3 modelTCoord;
+layout(location = 0) out vec3 vertexTCoord;
+layout(location = 1) out vec4 vertexColor;
+
+void main()
+{
+    vertexTCoord = modelTCoord;
+    vertexColor = instanceColor[gl_InstanceID];
+#if GE_USE_MAT_VEC
+    gl_Position = pvMatrix * (worldMatrix[gl_InstanceID] * vec4(modelPosition, 1.0f));
+#else
+    gl_Position = (vec4(modelPosition, 1.0f) * worldMatrix[gl_InstanceID]) * pvMatrix;
+#endif
+}
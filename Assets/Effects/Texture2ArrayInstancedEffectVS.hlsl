@@ -0,0 +1,44 @@
+// Instanced variant of Texture2ArrayEffectVS.hlsl.  The world matrix and the
+// color of each instance are read from the Instances buffer with
+// SV_InstanceID, the size of the arrays matches
+// Texture2ArrayInstancedEffect::MAX_INSTANCES.
+
+cbuffer PVMatrix
+{
+    float4x4 pvMatrix;
+};
+
+cbuffer Instances
+{
+    float4x4 worldMatrix[128];
+    float4 instanceColor[128];
+};
+
+struct VS_INPUT
+{
+    float3 modelPosition : POSITION;
+    float3 modelTCoord : TEXCOORD0;
+    uint instanceID : SV_InstanceID;
+};
+
+struct VS_OUTPUT
+{
+    float3 vertexTCoord : TEXCOORD0;
+    float4 vertexColor : COLOR0;
+    float4 clipPosition : SV_POSITION;
+};
+
+VS_OUTPUT VSMain(VS_INPUT input)
+{
+    VS_OUTPUT output;
+#if GE_USE_MAT_VEC
+    output.clipPosition = mul(pvMatrix,
+        mul(worldMatrix[input.instanceID], float4(input.modelPosition, 1.0f)));
+#else
+    output.clipPosition = mul(
+        mul(float4(input.modelPosition, 1.0f), worldMatrix[input.instanceID]), pvMatrix);
+#endif
+    output.vertexTCoord = input.modelTCoord;
+    output.vertexColor = instanceColor[input.instanceID];
+    return output;
+}
@@ -0,0 +1,13 @@
+// Instanced variant of Texture2EffectPS.glsl, modulated by the color of the
+// instance.
+
+uniform sampler2D baseSampler;
+
+layout(location = 0) in vec2 vertexTCoord;
+layout(location = 1) in vec4 vertexColor;
+layout(location = 0) out vec4 pixelColor;
+
+void main()
+{
+    pixelColor = texture(baseSampler, vertexTCoord) * vertexColor;
+}
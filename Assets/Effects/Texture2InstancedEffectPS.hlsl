@@ -0,0 +1,23 @@
+// Instanced variant of Texture2EffectPS.hlsl, modulated by the color of the
+// instance.
+
+Texture2D baseTexture;
+SamplerState baseSampler;
+
+struct PS_INPUT
+{
+    float2 vertexTCoord : TEXCOORD0;
+    float4 vertexColor : COLOR0;
+};
+
+struct PS_OUTPUT
+{
+    float4 pixelColor0 : SV_TARGET0;
+};
+
+PS_OUTPUT PSMain(PS_INPUT input)
+{
+    PS_OUTPUT output;
+    output.pixelColor0 = baseTexture.Sample(baseSampler, input.vertexTCoord) * input.vertexColor;
+    return output;
+}
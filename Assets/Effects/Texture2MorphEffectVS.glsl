@@ -0,0 +1,30 @@
+// Morph target variant of Texture2EffectVS.glsl.  The position of the next
+// key frame comes in the second texture coordinate and is blended with the
+// current one by the factor of the Morph buffer.
+
+uniform PVWMatrix
+{
+    mat4 pvwMatrix;
+};
+
+uniform Morph
+{
+    vec4 morph;
+};
+
+layout(location = 0) in vec3 modelPosition;
+layout(location = 1) in vec2 modelTCoord;
+layout(location = 2) in vec3 modelNextPosition;
+layout(location = 0) out vec2 vertexTCoord;
+
+void main()
+{
+    vec3 position = mix(modelPosition, modelNextPosition, morph.x);
+
+    vertexTCoord = modelTCoord;
+#if GE_USE_MAT_VEC
+    gl_Position = pvwMatrix * vec4(position, 1.0f);
+#else
+    gl_Position = vec4(position, 1.0f) * pvwMatrix;
+#endif
+}
@@ -0,0 +1,39 @@
+// Morph target variant of Texture2EffectVS.hlsl.  The position of the next
+// key frame comes in the second texture coordinate and is blended with the
+// current one by the factor of the Morph buffer.
+
+cbuffer PVWMatrix
+{
+    float4x4 pvwMatrix;
+};
+
+cbuffer Morph
+{
+    float4 morph;
+};
+
+struct VS_INPUT
+{
+    float3 modelPosition : POSITION;
+    float2 modelTCoord : TEXCOORD0;
+    float3 modelNextPosition : TEXCOORD1;
+};
+
+struct VS_OUTPUT
+{
+    float2 vertexTCoord : TEXCOORD0;
+    float4 clipPosition : SV_POSITION;
+};
+
+VS_OUTPUT VSMain(VS_INPUT input)
+{
+    VS_OUTPUT output;
+    float3 position = lerp(input.modelPosition, input.modelNextPosition, morph.x);
+#if GE_USE_MAT_VEC
+    output.clipPosition = mul(pvwMatrix, float4(position, 1.0f));
+#else
+    output.clipPosition = mul(float4(position, 1.0f), pvwMatrix);
+#endif
+    output.vertexTCoord = input.modelTCoord;
+    return output;
+}
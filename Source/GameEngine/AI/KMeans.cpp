@@ -38,103 +38,283 @@
 
 #include "KMeans.h"
 
-// return nearest cluster Id (uses euclidean distance)
-int KMeans::GetNearestClusterId(Point point)
+#include "Core/Process/JobSystem.h"
+#include "Core/Profiler/Profiler.h"
+
+#include "Mathematic/Algebra/SIMD.h"
+
+#include <random>
+
+#if defined(MATH_SSE)
+#include <emmintrin.h>
+#endif
+
+namespace
 {
-	float sum = 0.0;
-	for (int i = 0; i < mDimension; i++)
-		sum += (float)pow(mClusters[0].GetCenter(i) - point.GetValue(i), 2.0);
+	unsigned int const NoCluster = 0xFFFFFFFF;
 
-	int nearestClusterId = 0;
-	float minDist = sqrt(sum);
-	for (int i = 1; i < mK; i++)
-	{
-		sum = 0.0;
-		for (int j = 0; j < mDimension; j++)
-			sum += (float)pow(mClusters[i].GetCenter(j) - point.GetValue(j), 2.0);
+	// value of the padding centers, far enough to never be the nearest
+	float const PaddingCenter = FLT_MAX;
+
+	// points assigned by each job
+	unsigned int const PointsPerJob = 256;
+
+	// dimensions of the values broadcast once per point, points with more of them
+	// broadcast each value for every block of centers
+	unsigned int const MaxBroadcastDimension = 16;
+}
+
+KMeans::KMeans(unsigned int numClusters, unsigned int dimension, unsigned int maxIterations)
+	: mRequestedClusters(numClusters), mNumClusters(0), mMaxIterations(maxIterations),
+	mIterations(0), mDimension(dimension), mNumPoints(0), mStride(0), mSeed(5489), mTolerance(0.f)
+{
+	mValues.resize(mDimension);
+}
+
+void KMeans::Reserve(unsigned int numPoints)
+{
+	for (eastl::vector<float>& values : mValues)
+		values.reserve(numPoints);
+}
+
+unsigned int KMeans::AddPoint(float const* values)
+{
+	for (unsigned int d = 0; d < mDimension; d++)
+		mValues[d].push_back(values[d]);
+
+	return mNumPoints++;
+}
+
+void KMeans::ForEachPoint(eastl::function<void(unsigned int, unsigned int)> const& body)
+{
+	JobSystem* jobSystem = JobSystem::Get();
+	if (jobSystem)
+		jobSystem->ParallelFor(mNumPoints, PointsPerJob, body);
+	else
+		body(0, mNumPoints);
+}
 
-		float dist = sqrt(sum);
-		if (dist < minDist)
+void KMeans::UpdateDistances(unsigned int center, unsigned int begin, unsigned int end)
+{
+	for (unsigned int i = begin; i < end; i++)
+	{
+		float distance = 0.f;
+		for (unsigned int d = 0; d < mDimension; d++)
 		{
-			minDist = dist;
-			nearestClusterId = i;
+			float diff = mCenters[d * mStride + center] - mValues[d][i];
+			distance += diff * diff;
 		}
+
+		if (distance < mDistances[i])
+			mDistances[i] = distance;
 	}
+}
+
+void KMeans::Seed()
+{
+	// the random numbers are taken from the raw output of the engine, which unlike the
+	// standard distributions gives the same sequence on every platform
+	std::mt19937 random(mSeed);
 
-	return nearestClusterId;
+	mDistances.assign(mNumPoints, FLT_MAX);
+
+	unsigned int point = random() % mNumPoints;
+	for (unsigned int center = 0; center < mNumClusters; center++)
+	{
+		if (center > 0)
+		{
+			// picks the next center with probability proportional to the squared
+			// distance of the points to their nearest center
+			double total = 0.0;
+			for (unsigned int i = 0; i < mNumPoints; i++)
+				total += mDistances[i];
+
+			if (total > 0.0)
+			{
+				double target = total * ((random() >> 8) * (1.0 / 16777216.0));
+				double cumulative = 0.0;
+				for (unsigned int i = 0; i < mNumPoints; i++)
+				{
+					if (mDistances[i] <= 0.f)
+						continue;
+
+					point = i;
+					cumulative += mDistances[i];
+					if (cumulative > target)
+						break;
+				}
+			}
+			else
+			{
+				// every point lies on a center already
+				point = random() % mNumPoints;
+			}
+		}
+
+		for (unsigned int d = 0; d < mDimension; d++)
+			mCenters[d * mStride + center] = mValues[d][point];
+
+		ForEachPoint([this, center](unsigned int begin, unsigned int end)
+		{
+			UpdateDistances(center, begin, end);
+		});
+	}
 }
 
-void KMeans::Run(eastl::vector<Point> & points)
+void KMeans::Assign(unsigned int begin, unsigned int end)
 {
-	mTotalPoints = points.size();
-	mDimension = points[0].GetDimension();
+#if defined(MATH_SSE)
+	// every lane keeps the nearest center of its own and the block it was found in,
+	// the lanes are reduced at the end taking the lowest cluster on ties as the scalar
+	// loop does
+	unsigned int const numBlocks = mStride / 4;
+	float const* centers = mCenters.data();
+	bool const broadcastOnce = mDimension <= MaxBroadcastDimension;
+	__m128 values[MaxBroadcastDimension];
+	for (unsigned int i = begin; i < end; i++)
+	{
+		if (broadcastOnce)
+		{
+			for (unsigned int d = 0; d < mDimension; d++)
+				values[d] = _mm_set1_ps(mValues[d][i]);
+		}
 
-	//Initializing Clusters
-	eastl::vector<int> usedPointIds;
+		__m128 nearest = _mm_set1_ps(FLT_MAX);
+		__m128 nearestBlock = _mm_setzero_ps();
+		__m128 block = _mm_setzero_ps();
+		for (unsigned int b = 0; b < numBlocks; b++)
+		{
+			float const* center = centers + b * 4;
+			__m128 distance = _mm_setzero_ps();
+			for (unsigned int d = 0; d < mDimension; d++, center += mStride)
+			{
+				__m128 value = broadcastOnce ? values[d] : _mm_set1_ps(mValues[d][i]);
+				__m128 diff = _mm_sub_ps(_mm_loadu_ps(center), value);
+				distance = _mm_add_ps(distance, _mm_mul_ps(diff, diff));
+			}
+
+			__m128 closer = _mm_cmplt_ps(distance, nearest);
+			nearest = _mm_or_ps(_mm_and_ps(closer, distance), _mm_andnot_ps(closer, nearest));
+			nearestBlock = _mm_or_ps(_mm_and_ps(closer, block), _mm_andnot_ps(closer, nearestBlock));
+			block = _mm_add_ps(block, _mm_set1_ps(1.f));
+		}
 
-	for (int i = 0; i < mK; i++)
+		float distances[4], blocks[4];
+		_mm_storeu_ps(distances, nearest);
+		_mm_storeu_ps(blocks, nearestBlock);
+
+		unsigned int cluster = 0;
+		float minDistance = FLT_MAX;
+		for (unsigned int lane = 0; lane < 4; lane++)
+		{
+			unsigned int laneCluster = (unsigned int)blocks[lane] * 4 + lane;
+			if (distances[lane] < minDistance ||
+				(distances[lane] == minDistance && laneCluster < cluster))
+			{
+				minDistance = distances[lane];
+				cluster = laneCluster;
+			}
+		}
+		mNearest[i] = cluster;
+	}
+#else
+	for (unsigned int i = begin; i < end; i++)
 	{
-		while (true)
+		unsigned int cluster = 0;
+		float minDistance = FLT_MAX;
+		for (unsigned int c = 0; c < mNumClusters; c++)
 		{
-			int index = rand() % mTotalPoints;
+			float distance = 0.f;
+			for (unsigned int d = 0; d < mDimension; d++)
+			{
+				float diff = mCenters[d * mStride + c] - mValues[d][i];
+				distance += diff * diff;
+			}
 
-			if (eastl::find(usedPointIds.begin(), usedPointIds.end(), index) == usedPointIds.end())
+			if (distance < minDistance)
 			{
-				usedPointIds.push_back(index);
-				points[index].SetCluster(i);
-				Clustering cluster(i, points[index]);
-				mClusters.push_back(cluster);
-				break;
+				minDistance = distance;
+				cluster = c;
 			}
 		}
+		mNearest[i] = cluster;
 	}
+#endif
+}
+
+void KMeans::Run()
+{
+	PROFILE_ZONE("KMeans");
 
-	printf("Clusters initialized = %i \n", mClusters.size());
-	printf("Running K-Means Clustering..\n");
+	mIterations = 0;
+	mNumClusters = eastl::min(mRequestedClusters, mNumPoints);
+	if (mNumClusters == 0)
+		return;
 
-	int iter = 1;
+	mStride = (mNumClusters + 3) & ~3u;
+	mCenters.assign(mDimension * mStride, PaddingCenter);
+	mSums.assign(mDimension * mNumClusters, 0.0);
+	mClusterSizes.assign(mNumClusters, 0);
+	mClusters.assign(mNumPoints, NoCluster);
+	mNearest.resize(mNumPoints);
+
+	Seed();
+
+	float const tolerance = mTolerance * mTolerance;
 	while (true)
 	{
-		bool done = true;
+		mIterations++;
 
 		// associates each point to the nearest center
-		for (int i = 0; i < mTotalPoints; i++)
+		ForEachPoint([this](unsigned int begin, unsigned int end) { Assign(begin, end); });
+
+		// moves the points which changed cluster between the sums, in order so that
+		// the result doesn't depend on how the assignment was split
+		unsigned int changed = 0;
+		for (unsigned int i = 0; i < mNumPoints; i++)
 		{
-			int currentClusterId = points[i].GetCluster();
-			int nearestClusterId = GetNearestClusterId(points[i]);
+			unsigned int cluster = mNearest[i];
+			unsigned int previous = mClusters[i];
+			if (cluster == previous)
+				continue;
 
-			if (currentClusterId != nearestClusterId)
+			if (previous != NoCluster)
 			{
-				if (currentClusterId != -1)
-					mClusters[currentClusterId].RemovePoint(points[i].GetId());
-
-				points[i].SetCluster(nearestClusterId);
-				mClusters[nearestClusterId].AddPoint(points[i]);
-				done = false;
+				for (unsigned int d = 0; d < mDimension; d++)
+					mSums[d * mNumClusters + previous] -= mValues[d][i];
+				mClusterSizes[previous]--;
 			}
+
+			for (unsigned int d = 0; d < mDimension; d++)
+				mSums[d * mNumClusters + cluster] += mValues[d][i];
+			mClusterSizes[cluster]++;
+
+			mClusters[i] = cluster;
+			changed++;
 		}
 
-		// recalculating the center of each cluster
-		for (int i = 0; i < mK; i++)
+		// recalculating the center of each cluster, empty clusters keep theirs
+		float maxShift = 0.f;
+		for (unsigned int c = 0; c < mNumClusters; c++)
 		{
-			int clusterSize = mClusters[i].GetSize();
-			for (int j = 0; j < mDimension; j++)
+			if (mClusterSizes[c] == 0)
+				continue;
+
+			float shift = 0.f;
+			for (unsigned int d = 0; d < mDimension; d++)
 			{
-				float sum = 0.0;
-				if (clusterSize > 0)
-				{
-					for (int p = 0; p < clusterSize; p++)
-						sum += mClusters[i].GetPoint(p).GetValue(j);
-					mClusters[i].SetCenter(j, sum / clusterSize);
-				}
+				float& center = mCenters[d * mStride + c];
+				float value = (float)(mSums[d * mNumClusters + c] / mClusterSizes[c]);
+				shift += (value - center) * (value - center);
+				center = value;
 			}
+			maxShift = eastl::max(maxShift, shift);
 		}
 
-		if (done == true || iter >= mIterations)
-		{
-			printf("Break in iteration %i\n\n", iter);
+		if (changed == 0 || maxShift <= tolerance || mIterations >= mMaxIterations)
 			break;
-		}
-		iter++;
 	}
-}
\ No newline at end of file
+
+	LogInformation("K-Means clustered " + eastl::to_string(mNumPoints) + " points in " +
+		eastl::to_string(mIterations) + " iterations");
+}
@@ -43,103 +43,85 @@
 
 #include "Core/Logger/Logger.h"
 
-class Point
+/*
+	KMeans groups points into clusters by their euclidean distance. Points are stored by
+	dimension, one array of values per dimension, and so are the centers which the distance
+	kernel compares four at a time with SSE. Centers are seeded with k-means++, every
+	iteration assigns the points to their nearest center in parallel on the job system and
+	only the points which changed cluster update the sums of the centers. The run stops
+	once no point changes cluster, no center moves more than the tolerance or the iteration
+	limit is reached.
+
+	The random seed is fixed unless it is changed with SetSeed, and the result doesn't
+	depend on the number of threads, so the same points always give the same clusters.
+*/
+class KMeans
 {
 
 public:
-	Point(int pointId, eastl::vector<float>& values)
-	{
-		mPointId = pointId;
-		mDimension = values.size();
-
-		for (int i = 0; i < mDimension; i++)
-			mValues.push_back(values[i]);
 
-		mClusterId = -1;
-	}
-
-	int GetId() { return mPointId; }
-	int GetDimension() { return mDimension; }
-	int GetCluster() { return mClusterId; }
-	void SetCluster(int clusterId) { mClusterId = clusterId; }
-	float GetValue(int index) { return mValues[index]; }
-	void AddValue(float value) { mValues.push_back(value); }
+	KMeans(unsigned int numClusters, unsigned int dimension, unsigned int maxIterations);
 
-private:
-	int mDimension;
-	int mPointId, mClusterId;
-	eastl::vector<float> mValues;
-};
+	// Seed of the random engine which picks the initial centers
+	void SetSeed(unsigned int seed) { mSeed = seed; }
 
-class Clustering
-{
+	// Distance under which a center is considered at rest
+	void SetTolerance(float tolerance) { mTolerance = tolerance; }
 
-public:
-	Clustering(int clusterId, Point point)
-	{
-		mClusterId = clusterId;
+	void Reserve(unsigned int numPoints);
 
-		int dimension = point.GetDimension();
+	// Adds a point with as many values as the dimension and returns its index
+	unsigned int AddPoint(float const* values);
 
-		for (int i = 0; i < dimension; i++)
-			mCenters.push_back(point.GetValue(i));
+	void Run();
 
-		mPoints.push_back(point);
-	}
+	unsigned int GetNumPoints() const { return mNumPoints; }
+	unsigned int GetDimension() const { return mDimension; }
 
-	int GetId() { return mClusterId; }
+	// Number of clusters of the last run, less than requested if there are fewer points
+	unsigned int GetNumClusters() const { return mNumClusters; }
+	unsigned int GetIterations() const { return mIterations; }
 
-	void AddPoint(Point point) { mPoints.push_back(point); }
-	bool RemovePoint(int pointId)
+	unsigned int GetCluster(unsigned int point) const { return mClusters[point]; }
+	unsigned int GetClusterSize(unsigned int cluster) const { return mClusterSizes[cluster]; }
+	float GetCenter(unsigned int cluster, unsigned int dimension) const
 	{
-		for (unsigned int i = 0; i < mPoints.size(); i++)
-		{
-			if (mPoints[i].GetId() == pointId)
-			{
-				mPoints.erase(mPoints.begin() + i);
-				return true;
-			}
-		}
-		return false;
+		return mCenters[dimension * mStride + cluster];
 	}
 
-	float GetCenter(int index) { return mCenters[index]; }
-	void SetCenter(int index, float value) { mCenters[index] = value; }
-
-	Point GetPoint(int index) { return mPoints[index]; }
-	int GetSize() { return mPoints.size(); }
-
 private:
-	int mClusterId;
-	eastl::vector<float> mCenters;
-	eastl::vector<Point> mPoints;
 
-};
+	// picks the initial centers with k-means++
+	void Seed();
 
-class KMeans
-{
+	// squared distance from every point in the range to the center
+	void UpdateDistances(unsigned int center, unsigned int begin, unsigned int end);
 
-public:
+	// assigns the points in the range to their nearest center
+	void Assign(unsigned int begin, unsigned int end);
 
-	KMeans(int K, int maxIterations)
-	{
-		mK = K;
-		mIterations = maxIterations;
-	}
+	// runs the body over the points, on the job system if there is one
+	void ForEachPoint(eastl::function<void(unsigned int, unsigned int)> const& body);
 
-	void Run(eastl::vector<Point> & points);
+	unsigned int mRequestedClusters, mNumClusters;
+	unsigned int mMaxIterations, mIterations;
+	unsigned int mDimension, mNumPoints, mStride;
+	unsigned int mSeed;
+	float mTolerance;
 
-	const eastl::vector<Clustering>& GetClusters() { return mClusters; }
+	// point values by dimension
+	eastl::vector<eastl::vector<float>> mValues;
 
-private:
-
-	int mK; // number of clusters
-	int mIterations, mDimension, mTotalPoints;
-	eastl::vector<Clustering> mClusters;
+	// centers by dimension, mStride apart as their count is padded to a multiple of four
+	eastl::vector<float> mCenters;
 
-	// return nearest cluster Id (uses euclidean distance)
-	int GetNearestClusterId(Point point);
+	// sums of the points of each cluster by dimension
+	eastl::vector<double> mSums;
 
+	eastl::vector<unsigned int> mClusters;
+	eastl::vector<unsigned int> mNearest;
+	eastl::vector<unsigned int> mClusterSizes;
+	eastl::vector<float> mDistances;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -40,6 +40,7 @@
 #include "Pathing.h"
 
 #include "Core/OS/OS.h"
+#include "Core/Profiler/Profiler.h"
 
 
 //--------------------------------------------------------------------------------------------------------
@@ -1373,8 +1374,12 @@ PathPlan* PathingGraph::FindPath(
 	PathingNode* pStartNode, PathingNodeVec& searchNodes, int skipArc, float threshold)
 {
 	// find the best path using an A* search algorithm
+	PROFILE_ZONE("FindPath");
 	PathFinder pathFinder;
-	return pathFinder(pStartNode, searchNodes, skipArc, threshold);
+	PathPlan* plan = pathFinder(pStartNode, searchNodes, skipArc, threshold);
+	if (plan)
+		PROFILE_COUNTER("Paths found", 1);
+	return plan;
 }
 
 PathPlan* PathingGraph::FindPath(
@@ -1395,8 +1400,12 @@ PathPlan* PathingGraph::FindPath(
 	PathingNode* pStartNode, PathingNode* pGoalNode, int skipArc, float threshold)
 {
 	// find the best path using an A* search algorithm
+	PROFILE_ZONE("FindPath");
 	PathFinder pathFinder;
-	return pathFinder(pStartNode, pGoalNode, skipArc, threshold);
+	PathPlan* plan = pathFinder(pStartNode, pGoalNode, skipArc, threshold);
+	if (plan)
+		PROFILE_COUNTER("Paths found", 1);
+	return plan;
 }
 
 void PathingGraph::InsertNode(PathingNode* pNode)
@@ -173,6 +173,7 @@ bool GameApplication::OnInitialize()
 	RegisterEngineEvents();
 	RegisterGameEvents();
 
+	mJobSystem = eastl::shared_ptr<JobSystem>(new JobSystem());
 	mFileSystem = eastl::shared_ptr<FileSystem>(new FileSystem());
 
 	// Always check the application directory.
@@ -309,6 +310,10 @@ void GameApplication::OnRun()
 	{
 		OnPreidle();
 
+		PROFILE_THREAD("Main");
+		if (!mOption.mProfilerCapture.empty())
+			Profiler::StartCapture(mOption.mProfilerCapture);
+
 		// performs the main loop
 		while (IsRunning())
 		{
@@ -324,15 +329,32 @@ void GameApplication::OnRun()
 			const unsigned int elapsedTime = UpdateTime();
 
 			// game logic execution
-			OnUpdateGame(elapsedTime);
+			{
+				PROFILE_ZONE("UpdateGame");
+				OnUpdateGame(elapsedTime);
+			}
 
 			// update all game views
-			OnUpdateView(Timer::GetTime(), elapsedTime);
+			{
+				PROFILE_ZONE("UpdateView");
+				OnUpdateView(Timer::GetTime(), elapsedTime);
+			}
 
 			// Render the scene
-			OnRender(elapsedTime);
+			{
+				PROFILE_ZONE("Render");
+				OnRender(elapsedTime);
+			}
 
 			OnIdle();
+
+			PROFILE_FRAME();
+		}
+
+		if (Profiler::IsCapturing())
+		{
+			Profiler::StopCapture();
+			Profiler::ExportChromeTrace(mOption.mProfilerCapture, mOption.mProfilerCapture + ".json");
 		}
 
 		OnTerminate();
@@ -16,6 +16,7 @@
 
 #include "System/System.h"
 #include "Core/IO/FileSystem.h"
+#include "Core/Process/JobSystem.h"
 #include "Core/IO/ResourceCache.h"
 
 #include "Graphic/Renderer/Renderer.h"
@@ -81,6 +82,7 @@ public:
 
 	eastl::shared_ptr<ProgramFactory> mProgramFactory;
 	eastl::shared_ptr<FileSystem> mFileSystem;
+	eastl::shared_ptr<JobSystem> mJobSystem;
 	eastl::shared_ptr<Renderer> mRenderer;
 	eastl::shared_ptr<System> mSystem;
 
@@ -86,11 +86,9 @@ Audio::~Audio()
 //
 void Audio::Shutdown()
 {
-	AudioBufferList::iterator it=mAllSamples.begin();
-
-	while (it!=mAllSamples.end())
+	while (!mAllSamples.empty())
 	{
-		BaseAudioBuffer *audioBuffer = (*it);
+		BaseAudioBuffer *audioBuffer = mAllSamples.front();
 		audioBuffer->Stop();
 		mAllSamples.pop_front();
 	}
@@ -112,6 +112,16 @@ public:
     virtual void SetPosition(unsigned long newPosition)=0;
 	virtual int GetVolume() const=0;
 	virtual float GetProgress()=0;
+
+	// Which sounds keep a voice when a mixer runs out of them, and where they are heard.
+	// Higher priorities steal the voices of lower ones, the distance to the listener
+	// attenuates the sound and the pan goes from -1 full left to 1 full right.
+	virtual void SetPriority(int priority)=0;
+	virtual void SetDistance(float distance)=0;
+	virtual void SetPan(float pan)=0;
+
+	// Called every frame while the sound plays, streaming buffers refill here
+	virtual void OnUpdate()=0;
 };
 
 /*
@@ -126,6 +136,11 @@ public:
 	virtual eastl::shared_ptr<ResHandle> GetResource() { return mResource; }
 	virtual bool IsLooping() const { return mIsLooping; }
 	virtual int GetVolume() const { return mVolume; }
+
+	// only the software mixer places and prioritizes its sounds
+	virtual void SetPriority(int priority) { }
+	virtual void SetDistance(float distance) { }
+	virtual void SetPan(float pan) { }
 protected:
 	AudioBuffer(eastl::shared_ptr<ResHandle>resource)
 	{ 
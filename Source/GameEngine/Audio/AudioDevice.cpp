@@ -0,0 +1,105 @@
+#include "AudioDevice.h"
+
+#include "Core/Logger/Logger.h"
+
+#include <thread>
+
+NullAudioDevice::NullAudioDevice()
+	: mSampleRate(0)
+{
+
+}
+
+bool NullAudioDevice::Open(unsigned int sampleRate, unsigned int blockFrames)
+{
+	mSampleRate = sampleRate;
+	mDeadline = std::chrono::steady_clock::now();
+	return true;
+}
+
+void NullAudioDevice::Close()
+{
+
+}
+
+void NullAudioDevice::Write(short const* block, unsigned int frames)
+{
+	// sleep until the previous block would have played
+	std::this_thread::sleep_until(mDeadline);
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (mDeadline < now)
+		mDeadline = now;
+	mDeadline += std::chrono::microseconds(1000000ull * frames / mSampleRate);
+}
+
+WaveFileAudioDevice::WaveFileAudioDevice(eastl::string const& filename)
+	: mFilename(filename), mDataSize(0)
+{
+
+}
+
+WaveFileAudioDevice::~WaveFileAudioDevice()
+{
+	Close();
+}
+
+namespace
+{
+	void WriteWaveHeader(std::ofstream& file, unsigned int sampleRate, unsigned int dataSize)
+	{
+		unsigned short const channels = 2;
+		unsigned short const bitsPerSample = 16;
+		unsigned short const blockAlign = channels * bitsPerSample / 8;
+		unsigned short const formatTag = 1;
+		unsigned int const byteRate = sampleRate * blockAlign;
+		unsigned int const formatSize = 16;
+		unsigned int const riffSize = 36 + dataSize;
+
+		file.write("RIFF", 4);
+		file.write((char const*)&riffSize, 4);
+		file.write("WAVEfmt ", 8);
+		file.write((char const*)&formatSize, 4);
+		file.write((char const*)&formatTag, 2);
+		file.write((char const*)&channels, 2);
+		file.write((char const*)&sampleRate, 4);
+		file.write((char const*)&byteRate, 4);
+		file.write((char const*)&blockAlign, 2);
+		file.write((char const*)&bitsPerSample, 2);
+		file.write("data", 4);
+		file.write((char const*)&dataSize, 4);
+	}
+}
+
+bool WaveFileAudioDevice::Open(unsigned int sampleRate, unsigned int blockFrames)
+{
+	mFile.open(mFilename.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (!mFile)
+	{
+		LogError("Couldn't open wave file " + mFilename);
+		return false;
+	}
+
+	// the sizes are patched on close
+	mDataSize = 0;
+	WriteWaveHeader(mFile, sampleRate, mDataSize);
+	return NullAudioDevice::Open(sampleRate, blockFrames);
+}
+
+void WaveFileAudioDevice::Close()
+{
+	if (!mFile.is_open())
+		return;
+
+	mFile.seekp(0);
+	WriteWaveHeader(mFile, mSampleRate, mDataSize);
+	mFile.close();
+}
+
+void WaveFileAudioDevice::Write(short const* block, unsigned int frames)
+{
+	mFile.write((char const*)block, frames * 2 * sizeof(short));
+	mDataSize += frames * 2 * sizeof(short);
+
+	NullAudioDevice::Write(block, frames);
+}
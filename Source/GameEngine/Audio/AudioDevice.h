@@ -0,0 +1,62 @@
+#ifndef AUDIODEVICE_H
+#define AUDIODEVICE_H
+
+#include "GameEngineStd.h"
+
+#include <chrono>
+#include <fstream>
+
+/*
+	BaseAudioDevice is the output of the software mixer. The mixer hands it fixed blocks
+	of 16-bit interleaved stereo, and the device blocks in Write until it has room for
+	the next one, which paces the mixing thread.
+*/
+class BaseAudioDevice
+{
+public:
+	virtual ~BaseAudioDevice() { }
+
+	virtual bool Open(unsigned int sampleRate, unsigned int blockFrames)=0;
+	virtual void Close()=0;
+	virtual void Write(short const* block, unsigned int frames)=0;
+};
+
+/*
+	NullAudioDevice discards the mixed blocks at the rate a sound card would consume them,
+	so the mixer runs on machines without audio hardware.
+*/
+class NullAudioDevice : public BaseAudioDevice
+{
+public:
+	NullAudioDevice();
+
+	virtual bool Open(unsigned int sampleRate, unsigned int blockFrames);
+	virtual void Close();
+	virtual void Write(short const* block, unsigned int frames);
+
+protected:
+	unsigned int mSampleRate;
+	std::chrono::steady_clock::time_point mDeadline;
+};
+
+/*
+	WaveFileAudioDevice records the mixed blocks into a wav file at the rate a sound card 
+	would consume them. The header sizes are written when the device is closed.
+*/
+class WaveFileAudioDevice : public NullAudioDevice
+{
+public:
+	WaveFileAudioDevice(eastl::string const& filename);
+	virtual ~WaveFileAudioDevice();
+
+	virtual bool Open(unsigned int sampleRate, unsigned int blockFrames);
+	virtual void Close();
+	virtual void Write(short const* block, unsigned int frames);
+
+protected:
+	eastl::string mFilename;
+	std::ofstream mFile;
+	unsigned int mDataSize;
+};
+
+#endif
@@ -42,6 +42,9 @@
 
 #include <cguid.h>
 
+// Number of segments in the buffer of a streaming sound
+#define STREAM_SEGMENTS 4
+
 //////////////////////////////////////////////////////////////////////
 // 
 // DirectSoundAudio::Audio Implementation
@@ -228,8 +231,25 @@ BaseAudioBuffer *DirectSoundAudio::InitAudioBuffer(eastl::shared_ptr<ResHandle>
     dsbd.dwSize = sizeof(DSBUFFERDESC);
     dsbd.dwFlags = DSBCAPS_CTRLVOLUME;
     dsbd.dwBufferBytes = resHandle->Size();
+	if (extra->IsStreaming())
+	{
+		// streaming sounds loop over a short buffer and need an accurate play cursor
+		dsbd.dwFlags |= DSBCAPS_GETCURRENTPOSITION2;
+		dsbd.dwBufferBytes = DirectSoundAudioBuffer::GetStreamBufferSize(extra->GetFormat());
+	}
     dsbd.guid3DAlgorithm = GUID_NULL;
-    dsbd.lpwfxFormat = const_cast<WAVEFORMATEX *>(extra->GetFormat());
+
+	// DirectSound takes the format of the resource as a WAVEFORMATEX
+	SoundFormat const* format = extra->GetFormat();
+	WAVEFORMATEX wfx;
+	ZeroMemory( &wfx, sizeof(WAVEFORMATEX) );
+	wfx.wFormatTag = format->mFormatTag;
+	wfx.nChannels = format->mChannels;
+	wfx.nSamplesPerSec = format->mSamplesPerSec;
+	wfx.nAvgBytesPerSec = format->mAvgBytesPerSec;
+	wfx.nBlockAlign = format->mBlockAlign;
+	wfx.wBitsPerSample = format->mBitsPerSample;
+    dsbd.lpwfxFormat = &wfx;
 
 	HRESULT hr;
     if( FAILED( hr = mDS->CreateSoundBuffer( &dsbd, &sampleHandle, NULL ) ) )
@@ -261,9 +281,33 @@ DirectSoundAudioBuffer::DirectSoundAudioBuffer(
  : AudioBuffer(resource) 
 { 
 	mSample = sample; 
+	mSegmentSize = 0;
+	mWriteSegment = 0;
+	mLastPlayCursor = 0;
+	mPlayedBytes = 0;
+
+	eastl::shared_ptr<SoundResourceExtraData> extra =
+		eastl::static_pointer_cast<SoundResourceExtraData>(mResource->GetExtra());
+	if (extra->IsStreaming())
+	{
+		mStream = eastl::make_unique<OggStream>(mResource);
+		mSegmentSize = GetStreamBufferSize(extra->GetFormat()) / STREAM_SEGMENTS;
+	}
+
 	FillBufferWithSound();
 }
 
+//
+// DirectSoundAudioBuffer::GetStreamBufferSize
+//    A quarter of a second per segment, in whole samples
+//
+unsigned long DirectSoundAudioBuffer::GetStreamBufferSize(SoundFormat const* format)
+{
+	unsigned long segmentSize = format->mAvgBytesPerSec / 4;
+	segmentSize -= segmentSize % format->mBlockAlign;
+	return segmentSize * STREAM_SEGMENTS;
+}
+
 //
 // DirectSoundAudioBuffer::Get						- Chapter 13, page 420
 //
@@ -298,6 +342,18 @@ bool DirectSoundAudioBuffer::Play(int volume, bool looping)
     
     unsigned long dwFlags = looping ? DSBPLAY_LOOPING : 0L;
 
+	if (mStream)
+	{
+		// restart the stream, the buffer itself always loops
+		mStream->SetLooping(looping);
+		mStream->Seek(0);
+		dsb->SetCurrentPosition(0);
+		mLastPlayCursor = 0;
+		mPlayedBytes = 0;
+		FillBufferWithSound();
+		dwFlags = DSBPLAY_LOOPING;
+	}
+
     return (S_OK==dsb->Play( 0, 0, dwFlags ) );
 
 }//end Play
@@ -349,6 +405,15 @@ bool DirectSoundAudioBuffer::Pause()
 bool DirectSoundAudioBuffer::Resume()
 {
 	mIsPaused=false;
+	if (mStream)
+	{
+		// continue from the play cursor, the segments are still filled
+		LPDIRECTSOUNDBUFFER dsb = (LPDIRECTSOUNDBUFFER)Get();
+		if (!dsb)
+			return false;
+
+		return (S_OK == dsb->Play(0, 0, DSBPLAY_LOOPING));
+	}
 	return Play(GetVolume(), IsLooping());
 }
 
@@ -427,9 +492,51 @@ void DirectSoundAudioBuffer::SetVolume(int volume)
 
 void DirectSoundAudioBuffer::SetPosition(unsigned long newPosition)
 {
+	if (mStream)
+	{
+		mStream->Seek(newPosition);
+		mSample->SetCurrentPosition(0);
+		mLastPlayCursor = 0;
+		mPlayedBytes = newPosition;
+		FillBufferWithSound();
+		return;
+	}
+
     mSample->SetCurrentPosition(newPosition);
 }
 
+//
+// DirectSoundAudioBuffer::OnUpdate
+//    Refills the segments of a streaming buffer which have been played
+//
+void DirectSoundAudioBuffer::OnUpdate()
+{
+	if (!mStream || !IsPlaying())
+		return;
+
+	unsigned long playCursor = 0;
+	if (FAILED(mSample->GetCurrentPosition(&playCursor, NULL)))
+		return;
+
+	unsigned long bufferSize = mSegmentSize * STREAM_SEGMENTS;
+	mPlayedBytes += (playCursor + bufferSize - mLastPlayCursor) % bufferSize;
+	mLastPlayCursor = playCursor;
+
+	if (!mIsLooping && mPlayedBytes >= mStream->GetSize())
+	{
+		// the rest of the buffer is silence
+		Stop();
+		return;
+	}
+
+	unsigned int playSegment = playCursor / mSegmentSize;
+	while (mWriteSegment != playSegment)
+	{
+		if (FAILED(FillStreamSegment(mWriteSegment)))
+			return;
+	}
+}
+
 
 //
 // DirectSoundAudioBuffer::OnRestore		- Chapter 13, page 423
@@ -521,6 +628,17 @@ HRESULT DirectSoundAudioBuffer::FillBufferWithSound( void )
     if( FAILED( hr = RestoreBuffer( NULL ) ) ) 
 		return hr;
 
+	if (mStream)
+	{
+		// fill every segment from the current stream position
+		for (unsigned int segment = 0; segment < STREAM_SEGMENTS; ++segment)
+		{
+			if (FAILED(hr = FillStreamSegment(segment)))
+				return hr;
+		}
+		return S_OK;
+	}
+
 	
     // Lock the buffer down
     if(FAILED( hr = mSample->Lock(0, pcmBufferSize, 
@@ -532,7 +650,7 @@ HRESULT DirectSoundAudioBuffer::FillBufferWithSound( void )
         // Wav is blank, so just fill with silence
         FillMemory( (BYTE*) dsLockedBuffer, 
                     dwDSLockedBufferSize, 
-                    (BYTE)(extra->GetFormat()->wBitsPerSample == 8 ? 128 : 0 ) );
+                    (BYTE)(extra->GetFormat()->mBitsPerSample == 8 ? 128 : 0 ) );
     }
     else 
 	{
@@ -542,7 +660,7 @@ HRESULT DirectSoundAudioBuffer::FillBufferWithSound( void )
             // If the buffer sizes are different fill in the rest with silence 
             FillMemory( (BYTE*) dsLockedBuffer + pcmBufferSize, 
                         dwDSLockedBufferSize - pcmBufferSize, 
-                        (BYTE)(extra->GetFormat()->wBitsPerSample == 8 ? 128 : 0 ) );
+                        (BYTE)(extra->GetFormat()->mBitsPerSample == 8 ? 128 : 0 ) );
         }
     }
 
@@ -552,6 +670,36 @@ HRESULT DirectSoundAudioBuffer::FillBufferWithSound( void )
     return S_OK;
 }
 
+//
+// DirectSoundAudioBuffer::FillStreamSegment
+//    Decodes the next piece of the stream into a segment, silence past its end
+//
+HRESULT DirectSoundAudioBuffer::FillStreamSegment(unsigned int segment)
+{
+	HRESULT hr;
+	eastl::shared_ptr<SoundResourceExtraData> extra = 
+		eastl::static_pointer_cast<SoundResourceExtraData>(mResource->GetExtra());
+
+	VOID* dsLockedBuffer = NULL;
+	unsigned long dwDSLockedBufferSize = 0;
+	if (FAILED(hr = mSample->Lock(segment * mSegmentSize, mSegmentSize,
+		&dsLockedBuffer, &dwDSLockedBufferSize, NULL, NULL, 0L)))
+		return hr;
+
+	unsigned int read = mStream->Read(dsLockedBuffer, dwDSLockedBufferSize);
+	if (read < dwDSLockedBufferSize)
+	{
+		FillMemory( (BYTE*) dsLockedBuffer + read, 
+					dwDSLockedBufferSize - read, 
+					(BYTE)(extra->GetFormat()->mBitsPerSample == 8 ? 128 : 0 ) );
+	}
+
+	mSample->Unlock(dsLockedBuffer, dwDSLockedBufferSize, NULL, 0);
+
+	mWriteSegment = (segment + 1) % STREAM_SEGMENTS;
+	return S_OK;
+}
+
 //
 // DirectSoundAudioBuffer::GetProgress				- Chapter 13, page 426
 //
@@ -560,6 +708,16 @@ float DirectSoundAudioBuffer::GetProgress()
 	LPDIRECTSOUNDBUFFER dsb = (LPDIRECTSOUNDBUFFER)Get();	
 	unsigned long progress = 0;
 
+	if (mStream)
+	{
+		if (mStream->GetSize() == 0)
+			return 0.f;
+
+		unsigned long played = mIsLooping ? 
+			mPlayedBytes % mStream->GetSize() : eastl::min(mPlayedBytes, (unsigned long)mStream->GetSize());
+		return (float)played / (float)mStream->GetSize();
+	}
+
 	dsb->GetCurrentPosition(&progress, NULL);
 
 	float length = (float)mResource->Size();
@@ -42,6 +42,7 @@
 #include "GameEngineStd.h"
 
 #include "Audio.h"
+#include "SoundResource.h"
 
 // DirectSound includes
 #include <mmsystem.h>
@@ -50,13 +51,21 @@
 /*
 	DirectSoundAudio::AudioBuffer
 	Platform-dependent implementation of the DirectSoundAudioBuffer. It picks up and defines
-	the remaining unimplemented virtual functions from the AudioBuffer interface
+	the remaining unimplemented virtual functions from the AudioBuffer interface.
+	Streaming resources play from a short looping buffer split in segments. Every update
+	refills the segments the play cursor has left behind with data from an OggStream.
 */
 class DirectSoundAudioBuffer : public AudioBuffer
 {
 protected:
 	LPDIRECTSOUNDBUFFER mSample;
 
+	eastl::unique_ptr<OggStream> mStream;
+	unsigned long mSegmentSize; // bytes of a streaming segment
+	unsigned int mWriteSegment; // next segment to refill
+	unsigned long mLastPlayCursor;
+	unsigned long mPlayedBytes; // stream bytes played since the last seek
+
 public:
 	DirectSoundAudioBuffer(LPDIRECTSOUNDBUFFER sample, eastl::shared_ptr<ResHandle> resource);
 	virtual void *Get();
@@ -74,8 +83,14 @@ public:
 
 	virtual float GetProgress();
 
+	virtual void OnUpdate();
+
+	// Size of the DirectSound buffer which plays a streaming resource
+	static unsigned long GetStreamBufferSize(SoundFormat const* format);
+
 private:
 	HRESULT FillBufferWithSound( );
+	HRESULT FillStreamSegment(unsigned int segment);
 	HRESULT RestoreBuffer( BOOL* pbWasRestored );
 };
 
@@ -0,0 +1,569 @@
+#include "MixerAudio.h"
+
+#include "Mathematic/Algebra/SIMD.h"
+
+#include <cmath>
+
+MixerAudioBuffer::MixerAudioBuffer(MixerAudio* mixer, eastl::shared_ptr<ResHandle> resource)
+	: AudioBuffer(resource), mMixer(mixer), mVoice(-1), mPriority(0), mDistance(0.f), mPan(0.f),
+	mSamples(nullptr), mNumFrames(0), mPosition(0.0),
+	mStagingFrames(0), mStagingStart(0), mStreamEnded(false)
+{
+	eastl::shared_ptr<SoundResourceExtraData> extra =
+		eastl::static_pointer_cast<SoundResourceExtraData>(mResource->GetExtra());
+	SoundFormat const* format = extra->GetFormat();
+
+	mChannels = format->mChannels;
+	mStep = (double)format->mSamplesPerSec / (double)mMixer->GetSampleRate();
+
+	if (extra->IsStreaming())
+	{
+		// room for two blocks of source frames plus the interpolation tail
+		mStream = eastl::make_unique<OggStream>(mResource);
+		unsigned int stagingFrames = 2 * ((unsigned int)(mStep * mMixer->mBlockFrames) + 3);
+		mStaging.resize(stagingFrames * mChannels);
+	}
+	else
+	{
+		mSamples = (short const*)mResource->Buffer();
+		mNumFrames = mResource->Size() / (2 * mChannels);
+	}
+
+	mGain[0] = mGain[1] = 0.f;
+	mLastGain[0] = mLastGain[1] = 0.f;
+}
+
+MixerAudioBuffer::~MixerAudioBuffer()
+{
+	Stop();
+}
+
+//
+// MixerAudioBuffer::Play
+//    Play the sound from the beginning if the mixer has a voice for it
+//
+bool MixerAudioBuffer::Play(int volume, bool looping)
+{
+	LogAssert(volume >= 0 && volume <= 100, "Volume must be a number between 0 and 100");
+
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	Stop();
+
+	mVolume = volume;
+	mIsLooping = looping;
+	mIsPaused = false;
+
+	mPosition = 0.0;
+	if (mStream)
+	{
+		mStream->SetLooping(looping);
+		mStream->Seek(0);
+		mStagingFrames = 0;
+		mStagingStart = 0;
+		mStreamEnded = false;
+	}
+
+	// fade in over the first block
+	mLastGain[0] = mLastGain[1] = 0.f;
+	mMixer->UpdateGain(this);
+	return mMixer->StartVoice(this);
+}
+
+//
+// MixerAudioBuffer::Stop
+//    Stop the sound and give its voice back to the mixer
+//
+bool MixerAudioBuffer::Stop()
+{
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	mIsPaused = true;
+	mMixer->StopVoice(this);
+	return true;
+}
+
+//
+// MixerAudioBuffer::Pause
+//    Pause the sound, it keeps its voice
+//
+bool MixerAudioBuffer::Pause()
+{
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	mIsPaused = true;
+	return true;
+}
+
+//
+// MixerAudioBuffer::Resume
+//    Resume the sound where it was paused
+//
+bool MixerAudioBuffer::Resume()
+{
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	mIsPaused = false;
+	if (mVoice < 0)
+		return mMixer->StartVoice(this);
+	return true;
+}
+
+bool MixerAudioBuffer::TogglePause()
+{
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	if (mIsPaused)
+		Resume();
+	else
+		Pause();
+
+	return true;
+}
+
+bool MixerAudioBuffer::IsPlaying()
+{
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	return mVoice >= 0;
+}
+
+void MixerAudioBuffer::SetVolume(int volume)
+{
+	LogAssert(volume >= 0 && volume <= 100, "Volume must be a number between 0 and 100");
+
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	mVolume = volume;
+	mMixer->UpdateGain(this);
+}
+
+void MixerAudioBuffer::SetPosition(unsigned long newPosition)
+{
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	if (mStream)
+	{
+		mStream->Seek(newPosition);
+		mPosition = 0.0;
+		mStagingFrames = 0;
+		mStagingStart = newPosition / (2 * mChannels);
+		mStreamEnded = false;
+		return;
+	}
+
+	mPosition = eastl::min(newPosition / (2 * mChannels), (unsigned long)mNumFrames);
+}
+
+float MixerAudioBuffer::GetProgress()
+{
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	if (mStream)
+	{
+		double length = (double)(mStream->GetSize() / (2 * mChannels));
+		if (length <= 0.0)
+			return 0.f;
+
+		double position = (double)mStagingStart + mPosition;
+		position = mIsLooping ? fmod(position, length) : eastl::min(position, length);
+		return (float)(position / length);
+	}
+
+	if (mNumFrames == 0)
+		return 0.f;
+
+	return (float)(mPosition / (double)mNumFrames);
+}
+
+void MixerAudioBuffer::SetPriority(int priority)
+{
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	mPriority = priority;
+}
+
+void MixerAudioBuffer::SetDistance(float distance)
+{
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	mDistance = distance;
+	mMixer->UpdateGain(this);
+}
+
+void MixerAudioBuffer::SetPan(float pan)
+{
+	std::lock_guard<std::recursive_mutex> lock(mMixer->mMutex);
+	mPan = eastl::max(-1.f, eastl::min(pan, 1.f));
+	mMixer->UpdateGain(this);
+}
+
+
+MixerAudio::MixerAudio(eastl::shared_ptr<BaseAudioDevice> device,
+	unsigned int maxVoices, unsigned int sampleRate, unsigned int blockFrames)
+	: mDevice(device), mSampleRate(sampleRate), mBlockFrames(blockFrames),
+	mReferenceDistance(10.f), mIsRunning(false)
+{
+	mVoices.resize(maxVoices, nullptr);
+	mAccumulator.resize(2 * mBlockFrames);
+	mScratch.resize(2 * mBlockFrames);
+	mBlock.resize(2 * mBlockFrames);
+}
+
+MixerAudio::~MixerAudio()
+{
+	Shutdown();
+}
+
+bool MixerAudio::Initialize(void* id)
+{
+	if (mInitialized)
+		return true;
+
+	if (!mDevice || !mDevice->Open(mSampleRate, mBlockFrames))
+	{
+		LogError("Couldn't open the audio device");
+		return false;
+	}
+
+	mIsRunning.store(true);
+	mThread = std::thread(&MixerAudio::MixLoop, this);
+
+	mInitialized = true;
+	return true;
+}
+
+void MixerAudio::Shutdown()
+{
+	if (mInitialized)
+	{
+		Audio::Shutdown();
+
+		mIsRunning.store(false);
+		mThread.join();
+		mDevice->Close();
+
+		mInitialized = false;
+	}
+}
+
+/*
+	MixerAudio::InitAudioBuffer
+	The mixer plays 16-bit mono and stereo sounds, decoded or streaming. A buffer doesn't
+	take a voice until it plays.
+*/
+BaseAudioBuffer *MixerAudio::InitAudioBuffer(eastl::shared_ptr<ResHandle> resHandle)
+{
+	eastl::shared_ptr<SoundResourceExtraData> extra =
+		eastl::static_pointer_cast<SoundResourceExtraData>(resHandle->GetExtra());
+
+	switch (extra->GetSoundType())
+	{
+		case SOUND_TYPE_OGG:
+		case SOUND_TYPE_WAVE:
+			break;
+
+		case SOUND_TYPE_MP3:
+		case SOUND_TYPE_MIDI:
+			LogError("MP3s and MIDI are not supported");
+			return NULL;
+
+		default:
+			LogError("Unknown sound type");
+			return NULL;
+	}
+
+	SoundFormat const* format = extra->GetFormat();
+	if (format->mBitsPerSample != 16 || format->mChannels < 1 || format->mChannels > 2)
+	{
+		LogError("The mixer only plays 16-bit mono and stereo sounds");
+		return NULL;
+	}
+
+	BaseAudioBuffer *audioBuffer = new MixerAudioBuffer(this, resHandle);
+	mAllSamples.push_front(audioBuffer);
+
+	return audioBuffer;
+}
+
+void MixerAudio::ReleaseAudioBuffer(BaseAudioBuffer *sampleHandle)
+{
+	sampleHandle->Stop();
+	mAllSamples.remove(sampleHandle);
+}
+
+unsigned int MixerAudio::GetNumPlayingVoices()
+{
+	std::lock_guard<std::recursive_mutex> lock(mMutex);
+
+	unsigned int numPlaying = 0;
+	for (MixerAudioBuffer* buffer : mVoices)
+		if (buffer)
+			++numPlaying;
+	return numPlaying;
+}
+
+//
+// MixerAudio::GetAudibility
+//    Volume and distance attenuation of a sound, the same volume curve as DirectSound
+//
+float MixerAudio::GetAudibility(MixerAudioBuffer* buffer) const
+{
+	float volume = powf(buffer->mVolume / 100.f, 2.5f);
+	float attenuation = mReferenceDistance / eastl::max(mReferenceDistance, buffer->mDistance);
+	return volume * attenuation;
+}
+
+void MixerAudio::UpdateGain(MixerAudioBuffer* buffer)
+{
+	float audibility = GetAudibility(buffer);
+	buffer->mGain[0] = audibility * eastl::min(1.f, 1.f - buffer->mPan);
+	buffer->mGain[1] = audibility * eastl::min(1.f, 1.f + buffer->mPan);
+}
+
+//
+// MixerAudio::StartVoice
+//    Takes a free voice, or steals the least important one if the sound is more important
+//
+bool MixerAudio::StartVoice(MixerAudioBuffer* buffer)
+{
+	std::lock_guard<std::recursive_mutex> lock(mMutex);
+	if (mVoices.empty())
+		return false;
+
+	int voice = -1;
+	for (unsigned int v = 0; v < mVoices.size(); ++v)
+	{
+		if (!mVoices[v])
+		{
+			voice = v;
+			break;
+		}
+	}
+
+	if (voice < 0)
+	{
+		// lowest priority first, then the least audible
+		int victim = 0;
+		float victimAudibility = GetAudibility(mVoices[0]);
+		for (unsigned int v = 1; v < mVoices.size(); ++v)
+		{
+			float audibility = GetAudibility(mVoices[v]);
+			if (mVoices[v]->mPriority < mVoices[victim]->mPriority ||
+				(mVoices[v]->mPriority == mVoices[victim]->mPriority && audibility < victimAudibility))
+			{
+				victim = v;
+				victimAudibility = audibility;
+			}
+		}
+
+		MixerAudioBuffer* weakest = mVoices[victim];
+		if (buffer->mPriority < weakest->mPriority ||
+			(buffer->mPriority == weakest->mPriority && GetAudibility(buffer) <= victimAudibility))
+			return false;
+
+		weakest->mVoice = -1;
+		voice = victim;
+	}
+
+	mVoices[voice] = buffer;
+	buffer->mVoice = voice;
+	return true;
+}
+
+void MixerAudio::StopVoice(MixerAudioBuffer* buffer)
+{
+	std::lock_guard<std::recursive_mutex> lock(mMutex);
+	if (buffer->mVoice >= 0)
+	{
+		mVoices[buffer->mVoice] = nullptr;
+		buffer->mVoice = -1;
+	}
+}
+
+void MixerAudio::Mix(short* output, unsigned int frames)
+{
+	std::lock_guard<std::recursive_mutex> lock(mMutex);
+	while (frames > 0)
+	{
+		unsigned int blockFrames = eastl::min(frames, mBlockFrames);
+		MixBlock(output, blockFrames);
+
+		output += 2 * blockFrames;
+		frames -= blockFrames;
+	}
+}
+
+void MixerAudio::MixBlock(short* output, unsigned int frames)
+{
+	unsigned int const numSamples = 2 * frames;
+	float* accumulator = mAccumulator.data();
+	memset(accumulator, 0, numSamples * sizeof(float));
+
+	for (unsigned int v = 0; v < mVoices.size(); ++v)
+	{
+		MixerAudioBuffer* buffer = mVoices[v];
+		if (!buffer || buffer->mIsPaused)
+			continue;
+
+		if (!MixVoice(buffer, frames))
+		{
+			// the sound ended, free its voice
+			mVoices[v] = nullptr;
+			buffer->mVoice = -1;
+		}
+	}
+
+	// clamp and convert to 16 bits
+	unsigned int i = 0;
+#if defined(MATH_SSE)
+	__m128 const minimum = _mm_set1_ps(-32768.f);
+	__m128 const maximum = _mm_set1_ps(32767.f);
+	for (; i + 8 <= numSamples; i += 8)
+	{
+		__m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(accumulator + i), minimum), maximum);
+		__m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(accumulator + i + 4), minimum), maximum);
+		__m128i packed = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+		_mm_storeu_si128((__m128i*)(output + i), packed);
+	}
+#endif
+	for (; i < numSamples; ++i)
+	{
+		float sample = eastl::max(-32768.f, eastl::min(accumulator[i], 32767.f));
+		output[i] = (short)lrintf(sample);
+	}
+}
+
+//
+// MixerAudio::MixVoice
+//    Adds a voice to the accumulator with its gains ramped over the block. Returns false
+//    when the sound ended.
+//
+bool MixerAudio::MixVoice(MixerAudioBuffer* buffer, unsigned int frames)
+{
+	bool isPlaying = Resample(buffer, frames);
+
+	float const* source = mScratch.data();
+	float* accumulator = mAccumulator.data();
+
+	float const left = buffer->mLastGain[0];
+	float const right = buffer->mLastGain[1];
+	float const deltaLeft = (buffer->mGain[0] - left) / frames;
+	float const deltaRight = (buffer->mGain[1] - right) / frames;
+
+	unsigned int frame = 0;
+#if defined(MATH_SSE)
+	// two stereo frames per iteration
+	__m128 gain = _mm_setr_ps(left, right, left + deltaLeft, right + deltaRight);
+	__m128 const increment = _mm_setr_ps(
+		2.f * deltaLeft, 2.f * deltaRight, 2.f * deltaLeft, 2.f * deltaRight);
+	for (; frame + 2 <= frames; frame += 2)
+	{
+		__m128 mixed = _mm_add_ps(_mm_loadu_ps(accumulator + 2 * frame),
+			_mm_mul_ps(_mm_loadu_ps(source + 2 * frame), gain));
+		_mm_storeu_ps(accumulator + 2 * frame, mixed);
+		gain = _mm_add_ps(gain, increment);
+	}
+#endif
+	for (; frame < frames; ++frame)
+	{
+		accumulator[2 * frame] += source[2 * frame] * (left + deltaLeft * frame);
+		accumulator[2 * frame + 1] += source[2 * frame + 1] * (right + deltaRight * frame);
+	}
+
+	buffer->mLastGain[0] = buffer->mGain[0];
+	buffer->mLastGain[1] = buffer->mGain[1];
+	return isPlaying;
+}
+
+//
+// MixerAudio::Resample
+//    Interpolates the source into stereo frames at the output rate. The frames past the
+//    end of a sound which doesn't loop are silent, and so are the frames a stream hasn't
+//    decoded yet, the stream keeps its position and plays them late instead.
+//
+bool MixerAudio::Resample(MixerAudioBuffer* buffer, unsigned int frames)
+{
+	short const* samples = buffer->mSamples;
+	unsigned int numFrames = buffer->mNumFrames;
+	if (buffer->mStream)
+	{
+		FillStaging(buffer, frames);
+		samples = buffer->mStaging.data();
+		numFrames = buffer->mStagingFrames;
+	}
+
+	// a stream loops by itself, and one which hasn't ended waits for its next frames
+	bool const wraps = buffer->mIsLooping && !buffer->mStream && numFrames > 0;
+	bool const waits = buffer->mStream && !buffer->mStreamEnded;
+	unsigned int const channels = buffer->mChannels;
+	double const step = buffer->mStep;
+	double position = buffer->mPosition;
+	float* output = mScratch.data();
+
+	unsigned int frame = 0;
+	for (; frame < frames; ++frame)
+	{
+		if (position >= numFrames)
+		{
+			if (!wraps)
+				break;
+			position -= numFrames;
+		}
+
+		unsigned int index = (unsigned int)position;
+		unsigned int next = index + 1;
+		if (next >= numFrames)
+		{
+			if (waits)
+				break;
+			next = wraps ? 0 : index;
+		}
+
+		float const t = (float)(position - index);
+		short const* s0 = samples + index * channels;
+		short const* s1 = samples + next * channels;
+
+		float const left = s0[0] + (s1[0] - s0[0]) * t;
+		output[2 * frame] = left;
+		output[2 * frame + 1] = channels > 1 ? s0[1] + (s1[1] - s0[1]) * t : left;
+
+		position += step;
+	}
+	buffer->mPosition = position;
+
+	if (frame < frames)
+	{
+		memset(output + 2 * frame, 0, 2 * (frames - frame) * sizeof(float));
+		return waits;
+	}
+	return true;
+}
+
+//
+// MixerAudio::FillStaging
+//    Tops up the staging data of a stream with the source frames of the next block. The
+//    mixer holds its lock here, so it only takes what the decoder has ready.
+//
+void MixerAudio::FillStaging(MixerAudioBuffer* buffer, unsigned int frames)
+{
+	unsigned int needed = (unsigned int)(buffer->mPosition + buffer->mStep * frames) + 2;
+	if (buffer->mStreamEnded || needed <= buffer->mStagingFrames)
+		return;
+
+	// drop the frames already played
+	unsigned int const channels = buffer->mChannels;
+	unsigned int dropped = eastl::min((unsigned int)buffer->mPosition, buffer->mStagingFrames);
+	short* staging = buffer->mStaging.data();
+	memmove(staging, staging + dropped * channels,
+		(buffer->mStagingFrames - dropped) * channels * sizeof(short));
+	buffer->mStagingFrames -= dropped;
+	buffer->mStagingStart += dropped;
+	buffer->mPosition -= dropped;
+
+	// read as far ahead as the staging data holds
+	unsigned int capacity = (unsigned int)buffer->mStaging.size() / channels;
+	unsigned int bytes = (capacity - buffer->mStagingFrames) * channels * sizeof(short);
+	bool ended = false;
+	unsigned int read = buffer->mStream->TryRead(staging + buffer->mStagingFrames * channels, bytes, ended);
+	buffer->mStagingFrames += read / (channels * sizeof(short));
+	buffer->mStreamEnded = ended;
+}
+
+void MixerAudio::MixLoop()
+{
+	while (mIsRunning.load())
+	{
+		Mix(mBlock.data(), mBlockFrames);
+		mDevice->Write(mBlock.data(), mBlockFrames);
+	}
+}
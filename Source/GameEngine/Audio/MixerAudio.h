@@ -0,0 +1,148 @@
+#ifndef MIXERAUDIO_H
+#define MIXERAUDIO_H
+
+#include "GameEngineStd.h"
+
+#include "Audio.h"
+#include "AudioDevice.h"
+#include "SoundResource.h"
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+class MixerAudio;
+
+/*
+	MixerAudioBuffer is one sound of the software mixer. It only references the resource,
+	so creating one doesn't copy the sound data. A buffer takes one of the mixer voices
+	while it plays and loses it when it ends, stops or is stolen by a more important sound.
+	Priority and the distance to the listener decide which voice is stolen when all of
+	them are taken.
+*/
+class MixerAudioBuffer : public AudioBuffer
+{
+public:
+	MixerAudioBuffer(MixerAudio* mixer, eastl::shared_ptr<ResHandle> resource);
+	virtual ~MixerAudioBuffer();
+
+	virtual void *Get() { return this; }
+	virtual bool OnRestore() { return true; }
+
+	virtual bool Play(int volume, bool looping);
+	virtual bool Pause();
+	virtual bool Stop();
+	virtual bool Resume();
+
+	virtual bool TogglePause();
+	virtual bool IsPlaying();
+	virtual void SetVolume(int volume);
+	virtual void SetPosition(unsigned long newPosition);
+
+	virtual float GetProgress();
+
+	virtual void OnUpdate() { }
+
+	// Higher priorities steal the voices of lower ones
+	virtual void SetPriority(int priority);
+	int GetPriority() const { return mPriority; }
+
+	// Distance to the listener, it attenuates the sound past the mixer reference distance
+	virtual void SetDistance(float distance);
+	float GetDistance() const { return mDistance; }
+
+	// -1 is full left, 1 full right
+	virtual void SetPan(float pan);
+	float GetPan() const { return mPan; }
+
+protected:
+
+	friend class MixerAudio;
+
+	MixerAudio* mMixer;
+	int mVoice; // index of the mixer voice, -1 if it has none
+	int mPriority;
+	float mDistance;
+	float mPan;
+
+	short const* mSamples; // decoded data, null for streaming sounds
+	unsigned int mNumFrames;
+	unsigned int mChannels;
+	double mStep; // source frames per output frame
+	double mPosition; // source frame, relative to the staging data when streaming
+
+	eastl::unique_ptr<OggStream> mStream;
+	eastl::vector<short> mStaging; // window of decoded frames of the stream
+	unsigned int mStagingFrames;
+	unsigned long long mStagingStart; // stream frame of the first staging frame
+	bool mStreamEnded;
+
+	float mGain[2]; // left and right gains for the next block
+	float mLastGain[2]; // gains at the end of the last block, ramped from to avoid clicks
+};
+
+/*
+	MixerAudio is a platform neutral implementation of the audio system. It mixes up to a
+	fixed number of voices in software into blocks of 16-bit stereo which a mixing thread
+	hands to a BaseAudioDevice. Volume, pan and distance are applied as gains ramped over
+	each block, and sources are resampled to the output rate by linear interpolation.
+	Mix can be called directly to render offline instead of starting the thread.
+*/
+class MixerAudio : public Audio
+{
+public:
+	MixerAudio(eastl::shared_ptr<BaseAudioDevice> device, unsigned int maxVoices = 32,
+		unsigned int sampleRate = 44100, unsigned int blockFrames = 512);
+	virtual ~MixerAudio();
+
+	virtual bool Active() { return mInitialized; }
+
+	virtual BaseAudioBuffer *InitAudioBuffer(eastl::shared_ptr<ResHandle> handle);
+	virtual void ReleaseAudioBuffer(BaseAudioBuffer* audioBuffer);
+
+	virtual void Shutdown();
+	virtual bool Initialize(void* id);
+
+	// Mixes frames of interleaved stereo from the playing voices
+	void Mix(short* output, unsigned int frames);
+
+	unsigned int GetSampleRate() const { return mSampleRate; }
+	unsigned int GetNumVoices() const { return (unsigned int)mVoices.size(); }
+	unsigned int GetNumPlayingVoices();
+
+	// Distance up to which sounds play at full volume
+	void SetReferenceDistance(float distance) { mReferenceDistance = distance; }
+
+protected:
+
+	friend class MixerAudioBuffer;
+
+	bool StartVoice(MixerAudioBuffer* buffer);
+	void StopVoice(MixerAudioBuffer* buffer);
+	void UpdateGain(MixerAudioBuffer* buffer);
+	float GetAudibility(MixerAudioBuffer* buffer) const;
+
+	void MixBlock(short* output, unsigned int frames);
+	bool MixVoice(MixerAudioBuffer* buffer, unsigned int frames);
+	bool Resample(MixerAudioBuffer* buffer, unsigned int frames);
+	void FillStaging(MixerAudioBuffer* buffer, unsigned int frames);
+
+	void MixLoop();
+
+	eastl::shared_ptr<BaseAudioDevice> mDevice;
+	unsigned int mSampleRate;
+	unsigned int mBlockFrames;
+	float mReferenceDistance;
+
+	eastl::vector<MixerAudioBuffer*> mVoices; // null for the free voices
+
+	eastl::vector<float> mAccumulator;
+	eastl::vector<float> mScratch;
+	eastl::vector<short> mBlock;
+
+	std::recursive_mutex mMutex;
+	std::thread mThread;
+	std::atomic<bool> mIsRunning;
+};
+
+#endif
@@ -47,10 +47,13 @@
 //
 // SoundProcess::SoundProcess				- Chapter 13, page 428
 //
-SoundProcess::SoundProcess(eastl::shared_ptr<ResHandle> resource, int volume, bool looping) :
+SoundProcess::SoundProcess(eastl::shared_ptr<ResHandle> resource, int volume, bool looping, int priority) :
 	mHandle(resource),
 	mVolume(volume),
-	mIsLooping(looping)
+	mIsLooping(looping),
+	mPriority(priority),
+	mDistance(0.f),
+	mPan(0.f)
 {
 	InitializeVolume();
 }
@@ -118,6 +121,11 @@ void SoundProcess::OnInit()
 
 	mAudioBuffer.reset(buffer);	
 
+	// the placement decides whether the sound gets a voice, so it goes first
+	mAudioBuffer->SetPriority(mPriority);
+	mAudioBuffer->SetDistance(mDistance);
+	mAudioBuffer->SetPan(mPan);
+
 	Play(mVolume, mIsLooping);
 }
 
@@ -129,6 +137,9 @@ void SoundProcess::OnInit()
 */
 void SoundProcess::OnUpdate(unsigned long deltaMs)
 {
+	if (mAudioBuffer)
+		mAudioBuffer->OnUpdate();
+
     if (!IsPlaying())
     {
         Succeed();
@@ -161,6 +172,36 @@ void SoundProcess::SetVolume(int volume)
 	mAudioBuffer->SetVolume(volume);
 }
 
+//
+// SoundProcess::SetPriority
+//
+void SoundProcess::SetPriority(int priority)
+{
+	mPriority = priority;
+	if (mAudioBuffer)
+		mAudioBuffer->SetPriority(priority);
+}
+
+//
+// SoundProcess::SetDistance
+//
+void SoundProcess::SetDistance(float distance)
+{
+	mDistance = distance;
+	if (mAudioBuffer)
+		mAudioBuffer->SetDistance(distance);
+}
+
+//
+// SoundProcess::SetPan
+//
+void SoundProcess::SetPan(float pan)
+{
+	mPan = pan;
+	if (mAudioBuffer)
+		mAudioBuffer->SetPan(pan);
+}
+
 //
 // SoundProcess::GetVolume						- Chapter 13, page 430
 //
@@ -68,9 +68,13 @@ protected:
 	// these hold the initial setting until the sound is actually launched.
     int mVolume;
     bool mIsLooping;
+	int mPriority;
+	float mDistance;
+	float mPan;
 
 public:
-	SoundProcess(eastl::shared_ptr<ResHandle> soundResource, int volume=100, bool looping=false);
+	SoundProcess(eastl::shared_ptr<ResHandle> soundResource, 
+		int volume=100, bool looping=false, int priority=0);
 	virtual ~SoundProcess();
 
     void Play(const int volume, const bool looping);
@@ -78,6 +82,12 @@ public:
 
     void SetVolume(int volume);
     int GetVolume();
+
+	// placement of the sound for audio systems which mix their own voices
+	void SetPriority(int priority);
+	void SetDistance(float distance);
+	void SetPan(float pan);
+	int GetPriority() const { return mPriority; }
     int GetLengthMilli();
     bool IsSoundValid() { return mHandle != NULL; }
     bool IsPlaying();
@@ -89,6 +99,9 @@ protected:
 	virtual void OnInit();
     virtual void OnUpdate(unsigned long deltaMs);
 
+	// the update only refills the stream of its own buffer
+	virtual bool IsParallelSafe(void) const { return true; }
+
     void InitializeVolume();
 };
 
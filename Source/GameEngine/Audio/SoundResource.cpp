@@ -36,11 +36,6 @@
 //
 //========================================================================
 
-#include <io.h>
-#include <fcntl.h>
-#include <sys/stat.h>
-#include <sys/types.h>
-
 #include <vorbis/codec.h>            // from the vorbis sdk
 #include <vorbis/vorbisfile.h>       
 
@@ -49,6 +44,10 @@
 #include "SoundResource.h"
 #include "Audio.h"
 
+// converts four chars into the 4 byte code of a riff chunk, as mmioFOURCC does
+#define SOUND_FOURCC(c0, c1, c2, c3) \
+	((unsigned long)(unsigned char)(c0) | ((unsigned long)(unsigned char)(c1) << 8) | \
+	((unsigned long)(unsigned char)(c2) << 16) | ((unsigned long)(unsigned char)(c3) << 24))
 	
 //
 // SoundResource::SoundResource			- Chapter X, page 362
@@ -56,6 +55,7 @@
 SoundResourceExtraData::SoundResourceExtraData()
 :	mSoundType(SOUND_TYPE_UNKNOWN),
 	mIsInitialized(false),
+	mIsStreaming(false),
 	mLength(0)
 {	
 	// don't do anything yet - timing sound Initialization is important!
@@ -71,12 +71,12 @@ unsigned int WaveResourceLoader::GetLoadedResourceSize(void *rawBuffer, unsigned
 
 	unsigned long pos = 0;
 
-	// mmioFOURCC -- converts four chars into a 4 byte integer code.
+	// SOUND_FOURCC -- converts four chars into a 4 byte integer code.
 	// The first 4 bytes of a valid .wav file is 'R','I','F','F'
 
 	type = *((unsigned long *)((char *)rawBuffer+pos));		
 	pos+=sizeof(unsigned long);
-	if(type != mmioFOURCC('R', 'I', 'F', 'F'))
+	if(type != SOUND_FOURCC('R', 'I', 'F', 'F'))
 		return false;	
 	
 	length = *((unsigned long *)((char *)rawBuffer+pos));	
@@ -85,7 +85,7 @@ unsigned int WaveResourceLoader::GetLoadedResourceSize(void *rawBuffer, unsigned
 	pos+=sizeof(unsigned long);
 
 	// 'W','A','V','E' for a legal .wav file
-	if(type != mmioFOURCC('W', 'A', 'V', 'E'))
+	if(type != SOUND_FOURCC('W', 'A', 'V', 'E'))
 		return false;		//not a WAV
 
 	// Find the end of the file
@@ -107,19 +107,19 @@ unsigned int WaveResourceLoader::GetLoadedResourceSize(void *rawBuffer, unsigned
 
 		switch(type)
 		{
-			case mmioFOURCC('f', 'a', 'c', 't'):
+			case SOUND_FOURCC('f', 'a', 'c', 't'):
 			{
 				LogError("This wav file is compressed. We don't handle compressed wav at this time");
 				break;
 			}
 
-			case mmioFOURCC('f', 'm', 't', ' '):
+			case SOUND_FOURCC('f', 'm', 't', ' '):
 			{
 				pos+=length;   
 				break;
 			}
 
-			case mmioFOURCC('d', 'a', 't', 'a'):
+			case SOUND_FOURCC('d', 'a', 't', 'a'):
 			{
 				return length;
 			}
@@ -179,11 +179,11 @@ bool WaveResourceLoader::ParseWave(char *wavStream, size_t bufferLength, eastl::
 
 	unsigned long pos = 0;
 
-	// mmioFOURCC -- converts four chars into a 4 byte integer code.
+	// SOUND_FOURCC -- converts four chars into a 4 byte integer code.
 	// The first 4 bytes of a valid .wav file is 'R','I','F','F'
 	type = *((unsigned long *)(wavStream+pos));		
 	pos+=sizeof(unsigned long);
-	if(type != mmioFOURCC('R', 'I', 'F', 'F'))
+	if(type != SOUND_FOURCC('R', 'I', 'F', 'F'))
 		return false;	
 	
 	length = *((unsigned long *)(wavStream+pos));	
@@ -192,13 +192,13 @@ bool WaveResourceLoader::ParseWave(char *wavStream, size_t bufferLength, eastl::
 	pos+=sizeof(unsigned long);
 
 	// 'W','A','V','E' for a legal .wav file
-	if(type != mmioFOURCC('W', 'A', 'V', 'E'))
+	if(type != SOUND_FOURCC('W', 'A', 'V', 'E'))
 		return false;		//not a WAV
 
 	// Find the end of the file
 	fileEnd = length - 4;
 	
-	memset(&extra->mWavFormatEx, 0, sizeof(WAVEFORMATEX));
+	memset(&extra->mFormat, 0, sizeof(SoundFormat));
 
 	bool copiedBuffer = false;
 
@@ -216,21 +216,28 @@ bool WaveResourceLoader::ParseWave(char *wavStream, size_t bufferLength, eastl::
 
 		switch(type)
 		{
-			case mmioFOURCC('f', 'a', 'c', 't'):
+			case SOUND_FOURCC('f', 'a', 'c', 't'):
 			{
 				LogError("This wav file is compressed. We don't handle compressed wav at this time");
 				break;
 			}
 
-			case mmioFOURCC('f', 'm', 't', ' '):
+			case SOUND_FOURCC('f', 'm', 't', ' '):
 			{
-				memcpy(&extra->mWavFormatEx, wavStream+pos, length);		
+				// the fields of the chunk up to the bits per sample, the size
+				// of the extension which may follow is not needed
+				char const* chunk = wavStream + pos;
+				memcpy(&extra->mFormat.mFormatTag, chunk, 2);
+				memcpy(&extra->mFormat.mChannels, chunk + 2, 2);
+				memcpy(&extra->mFormat.mSamplesPerSec, chunk + 4, 4);
+				memcpy(&extra->mFormat.mAvgBytesPerSec, chunk + 8, 4);
+				memcpy(&extra->mFormat.mBlockAlign, chunk + 12, 2);
+				memcpy(&extra->mFormat.mBitsPerSample, chunk + 14, 2);
 				pos+=length;   
-				extra->mWavFormatEx.cbSize = (WORD)length;
 				break;
 			}
 
-			case mmioFOURCC('d', 'a', 't', 'a'):
+			case SOUND_FOURCC('d', 'a', 't', 'a'):
 			{
 				copiedBuffer = true;
 				if (length != handle->Size())
@@ -249,7 +256,7 @@ bool WaveResourceLoader::ParseWave(char *wavStream, size_t bufferLength, eastl::
 		// If both blocks have been seen, we can return true.
 		if( copiedBuffer )
 		{
-			extra->mLength = ( handle->Size() * 1000 ) / extra->GetFormat()->nAvgBytesPerSec;
+			extra->mLength = ( handle->Size() * 1000 ) / extra->GetFormat()->mAvgBytesPerSec;
 			return true;
 		}
 
@@ -394,6 +401,12 @@ eastl::shared_ptr<BaseResourceLoader> CreateOGGResourceLoader()
 	return eastl::shared_ptr<BaseResourceLoader>(new OggResourceLoader());
 }
 
+OggResourceLoader::OggResourceLoader(unsigned int streamThreshold)
+	: mStreamThreshold(streamThreshold)
+{
+
+}
+
 
 unsigned int OggResourceLoader::GetLoadedResourceSize(void *rawBuffer, unsigned int rawSize)
 {
@@ -431,6 +444,10 @@ unsigned int OggResourceLoader::GetLoadedResourceSize(void *rawBuffer, unsigned
 
 	delete vorbisMemoryFile;
 
+	// long sounds keep the compressed stream and are decoded while playing
+	if (bytes > mStreamThreshold)
+		return rawSize;
+
 	return bytes;
 }
 
@@ -488,15 +505,14 @@ bool OggResourceLoader::ParseOgg(char *oggStream, size_t length, eastl::shared_p
     // the vorbis_info struct keeps the most of the interesting format info
     vorbis_info *vi = ov_info(&vf,-1);
 
-    memset(&(extra->mWavFormatEx), 0, sizeof(extra->mWavFormatEx));
+    memset(&(extra->mFormat), 0, sizeof(extra->mFormat));
 
-    extra->mWavFormatEx.cbSize = sizeof(extra->mWavFormatEx);
-    extra->mWavFormatEx.nChannels = vi->channels;
-    extra->mWavFormatEx.wBitsPerSample = 16;                    // ogg vorbis is always 16 bit
-    extra->mWavFormatEx.nSamplesPerSec = vi->rate;
-    extra->mWavFormatEx.nAvgBytesPerSec = extra->mWavFormatEx.nSamplesPerSec*extra->mWavFormatEx.nChannels*2;
-    extra->mWavFormatEx.nBlockAlign = 2*extra->mWavFormatEx.nChannels;
-    extra->mWavFormatEx.wFormatTag = 1;
+    extra->mFormat.mChannels = vi->channels;
+    extra->mFormat.mBitsPerSample = 16;                    // ogg vorbis is always 16 bit
+    extra->mFormat.mSamplesPerSec = vi->rate;
+    extra->mFormat.mAvgBytesPerSec = extra->mFormat.mSamplesPerSec*extra->mFormat.mChannels*2;
+    extra->mFormat.mBlockAlign = 2*extra->mFormat.mChannels;
+    extra->mFormat.mFormatTag = 1;
 
 	DWORD   size = 4096 * 16;
 	DWORD   pos = 0;
@@ -506,6 +522,25 @@ bool OggResourceLoader::ParseOgg(char *oggStream, size_t length, eastl::shared_p
 	DWORD bytes = (DWORD)ov_pcm_total(&vf, -1);
 	bytes *= 2 * vi->channels;
 
+	extra->mLength = (int)(1000.f * ov_time_total(&vf, -1));
+
+	if (bytes > mStreamThreshold)
+	{
+		// copy the compressed stream, an OggStream decodes it while the sound plays
+		ov_clear(&vf);
+		delete vorbisMemoryFile;
+
+		if (handle->Size() != length)
+		{
+			LogAssert(0, "The Ogg size does not match the memory buffer size!");
+			return false;
+		}
+
+		memcpy(handle->WritableBuffer(), oggStream, length);
+		extra->mIsStreaming = true;
+		return true;
+	}
+
 	if (handle->Size() != bytes)
 	{
 		LogAssert(0, "The Ogg size does not match the memory buffer size!");
@@ -525,9 +560,250 @@ bool OggResourceLoader::ParseOgg(char *oggStream, size_t length, eastl::shared_p
 		}
 	}
 
-	extra->mLength = (int)(1000.f * ov_time_total(&vf, -1));
-
 	ov_clear(&vf);
 	delete vorbisMemoryFile;
 	return true;
-}
\ No newline at end of file
+}
+
+
+//
+// OggStream::OggStream
+//
+OggStream::OggStream(eastl::shared_ptr<ResHandle> handle, unsigned int bufferSize, unsigned int numBuffers)
+:	mHandle(handle),
+	mMemoryFile(new OggMemoryFile()),
+	mFile(new OggVorbis_File()),
+	mIsValid(false),
+	mSize(0),
+	mBlockAlign(1),
+	mBufferSize(bufferSize),
+	mReadIndex(0),
+	mReadOffset(0),
+	mWriteIndex(0),
+	mGeneration(0),
+	mSeekPosition(-1),
+	mEndOfStream(false),
+	mIsStopping(false),
+	mIsLooping(false)
+{
+	mMemoryFile->dataRead = 0;
+	mMemoryFile->dataSize = mHandle->Size();
+	mMemoryFile->dataPtr = (unsigned char *)mHandle->Buffer();
+
+	ov_callbacks oggCallbacks;
+	oggCallbacks.read_func = VorbisRead;
+	oggCallbacks.close_func = VorbisClose;
+	oggCallbacks.seek_func = VorbisSeek;
+	oggCallbacks.tell_func = VorbisTell;
+
+	if (ov_open_callbacks(mMemoryFile, mFile, NULL, 0, oggCallbacks) < 0)
+	{
+		LogError("Ogg stream open failed");
+		return;
+	}
+
+	vorbis_info *vi = ov_info(mFile, -1);
+	mBlockAlign = 2 * vi->channels;
+	mSize = (unsigned int)ov_pcm_total(mFile, -1) * mBlockAlign;
+
+	// whole samples in every buffer
+	mBufferSize -= mBufferSize % mBlockAlign;
+	mBuffers.resize(numBuffers);
+	for (Buffer& buffer : mBuffers)
+	{
+		buffer.mData.resize(mBufferSize);
+		buffer.mSize = 0;
+		buffer.mReady = false;
+	}
+
+	mIsValid = true;
+	mThread = std::thread(&OggStream::DecodeLoop, this);
+}
+
+//
+// OggStream::~OggStream
+//
+OggStream::~OggStream()
+{
+	if (mThread.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mIsStopping = true;
+		}
+		mCondition.notify_all();
+		mThread.join();
+	}
+
+	if (mIsValid)
+		ov_clear(mFile);
+
+	delete mFile;
+	delete mMemoryFile;
+}
+
+//
+// OggStream::Seek
+//
+void OggStream::Seek(unsigned int position)
+{
+	if (!mIsValid)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (Buffer& buffer : mBuffers)
+			buffer.mReady = false;
+
+		mReadIndex = 0;
+		mReadOffset = 0;
+		mWriteIndex = 0;
+		mEndOfStream = false;
+		mSeekPosition = eastl::min(position, mSize) / mBlockAlign;
+		++mGeneration;
+	}
+	mCondition.notify_all();
+}
+
+//
+// OggStream::Read
+//
+unsigned int OggStream::Read(void* dest, unsigned int bytes)
+{
+	bool ended;
+	return Copy(dest, bytes, true, ended);
+}
+
+//
+// OggStream::TryRead
+//
+unsigned int OggStream::TryRead(void* dest, unsigned int bytes, bool& ended)
+{
+	return Copy(dest, bytes, false, ended);
+}
+
+//
+// OggStream::Copy
+//    Copies from the decoded buffers, waiting for the decoder if asked to
+//
+unsigned int OggStream::Copy(void* dest, unsigned int bytes, bool wait, bool& ended)
+{
+	ended = false;
+	if (!mIsValid)
+	{
+		ended = true;
+		return 0;
+	}
+
+	char* output = (char*)dest;
+	unsigned int copied = 0;
+
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (copied < bytes)
+	{
+		Buffer& buffer = mBuffers[mReadIndex];
+		if (!buffer.mReady)
+		{
+			// the decoder marks the last buffer ready together with the end of stream
+			if (mEndOfStream)
+			{
+				ended = true;
+				break;
+			}
+
+			if (!wait)
+				break;
+
+			mCondition.wait(lock);
+			continue;
+		}
+
+		unsigned int count = eastl::min(bytes - copied, buffer.mSize - mReadOffset);
+		memcpy(output + copied, buffer.mData.data() + mReadOffset, count);
+		copied += count;
+		mReadOffset += count;
+
+		if (mReadOffset == buffer.mSize)
+		{
+			// hand the buffer back to the decoder
+			buffer.mReady = false;
+			mReadIndex = (mReadIndex + 1) % mBuffers.size();
+			mReadOffset = 0;
+			mCondition.notify_all();
+		}
+	}
+
+	return copied;
+}
+
+//
+// OggStream::DecodeLoop
+//
+void OggStream::DecodeLoop()
+{
+	for (;;)
+	{
+		unsigned int index;
+		unsigned int generation;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCondition.wait(lock, [this]() 
+			{ 
+				return mIsStopping || mSeekPosition >= 0 || 
+					(!mEndOfStream && !mBuffers[mWriteIndex].mReady);
+			});
+
+			if (mIsStopping)
+				return;
+
+			if (mSeekPosition >= 0)
+			{
+				ov_pcm_seek(mFile, mSeekPosition);
+				mSeekPosition = -1;
+			}
+
+			index = mWriteIndex;
+			generation = mGeneration;
+		}
+
+		// decode outside the lock, the reader never touches a buffer which isn't ready
+		Buffer& buffer = mBuffers[index];
+		unsigned int size = 0;
+		bool endOfStream = false;
+		bool wrapped = false;
+		while (size < mBufferSize)
+		{
+			int sec = 0;
+			long ret = ov_read(mFile, buffer.mData.data() + size, mBufferSize - size, 0, 2, 1, &sec);
+			if (ret > 0)
+			{
+				size += ret;
+				wrapped = false;
+			}
+			else if (ret == 0 && mIsLooping.load() && !wrapped)
+			{
+				ov_pcm_seek(mFile, 0);
+				wrapped = true;
+			}
+			else if (ret != OV_HOLE)
+			{
+				endOfStream = true;
+				break;
+			}
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			// a seek while decoding dropped this buffer
+			if (generation != mGeneration)
+				continue;
+
+			buffer.mSize = size;
+			buffer.mReady = true;
+			mWriteIndex = (mWriteIndex + 1) % mBuffers.size();
+			mEndOfStream = endOfStream;
+		}
+		mCondition.notify_all();
+	}
+}
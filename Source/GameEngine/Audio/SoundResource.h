@@ -43,7 +43,10 @@
 
 #include "Core/IO/ResourceCache.h"
 
-#include <mmsystem.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 /*
 	A Resource encapsulates sound data, presumably loaded from a file or resource cache.
@@ -57,6 +60,20 @@
 	is being played multiple times.
 */
 
+/*
+	SoundFormat describes the PCM data of a sound with the fields of the format chunk of a
+	wav file. The platform layers convert it into their own description.
+*/
+struct SoundFormat
+{
+	unsigned short mFormatTag; // 1 for PCM
+	unsigned short mChannels;
+	unsigned int mSamplesPerSec;
+	unsigned int mAvgBytesPerSec;
+	unsigned short mBlockAlign;
+	unsigned short mBitsPerSample;
+};
+
 /*
 	SoundResourceExtraData class stores data that will be used by DirectSound. It is 
 	initialized when the resource cache loads the sound. The member data describes
@@ -78,13 +95,15 @@ public:
 	virtual eastl::wstring ToString() { return L"SoundResourceExtraData"; }
 
 	enum SoundType GetSoundType() { return mSoundType; }
-	WAVEFORMATEX const *GetFormat() { return &mWavFormatEx; }
+	SoundFormat const *GetFormat() { return &mFormat; }
 	int GetLength() const { return mLength; }
+	bool IsStreaming() const { return mIsStreaming; }
 
 protected:
 	enum SoundType mSoundType; // is this an Ogg, WAV, etc.?
 	bool mIsInitialized; // has the sound been initialized
-	WAVEFORMATEX mWavFormatEx; // description of the PCM format
+	bool mIsStreaming; // does the resource hold compressed data decoded while playing
+	SoundFormat mFormat; // description of the PCM format
 	int mLength; // how long the sound is in milliseconds
 };
 
@@ -124,10 +143,14 @@ protected:
 	ratio with only a barely perceptible loss in sound quality.
 	ParseOgg() method decompresses an OGG memory buffer using the Vorbis API. The method will
 	decompress the OGG stream into a PCM buffer.
+	Sounds which decode to more than the streaming threshold, typically music, keep the
+	compressed stream in the cache instead and are decoded by an OggStream while playing.
 */
 class OggResourceLoader : public BaseResourceLoader
 {
 public:
+	OggResourceLoader(unsigned int streamThreshold = 1024 * 1024);
+
 	virtual bool UseRawFile() { return true; }
 	virtual bool DiscardRawBufferAfterLoad() { return true; }
 	virtual unsigned int GetLoadedResourceSize(void *rawBuffer, unsigned int rawSize);
@@ -140,6 +163,77 @@ protected:
 	bool IsALoadableFileExtension(const eastl::wstring& filename) const;
 
 	bool ParseOgg(char *oggStream, size_t length, eastl::shared_ptr<ResHandle> handle);
+
+	unsigned int mStreamThreshold; // decoded size in bytes above which the sound is streamed
+};
+
+struct OggMemoryFile;
+struct OggVorbis_File;
+
+/*
+	OggStream decodes a streaming ogg resource while it plays. A decoder thread fills a small
+	set of rotating PCM buffers ahead of the reader, so only the compressed stream and a few
+	buffers of PCM data are held in memory. The stream keeps the resource handle alive.
+*/
+class OggStream
+{
+public:
+	OggStream(eastl::shared_ptr<ResHandle> handle,
+		unsigned int bufferSize = 4096 * 8, unsigned int numBuffers = 4);
+	~OggStream();
+
+	bool IsValid() const { return mIsValid; }
+
+	// Size of the whole decoded sound in bytes
+	unsigned int GetSize() const { return mSize; }
+
+	// Wraps around to the beginning instead of ending the stream
+	void SetLooping(bool looping) { mIsLooping.store(looping); }
+
+	// Restarts decoding at the PCM byte position
+	void Seek(unsigned int position);
+
+	// Copies decoded bytes, waiting for the decoder if it fell behind. It returns fewer bytes 
+	// than requested only at the end of a stream which doesn't loop.
+	unsigned int Read(void* dest, unsigned int bytes);
+
+	// Copies the bytes decoded so far without waiting for the decoder. The flag tells whether
+	// a short read is the end of the stream rather than the decoder falling behind.
+	unsigned int TryRead(void* dest, unsigned int bytes, bool& ended);
+
+protected:
+
+	struct Buffer
+	{
+		eastl::vector<char> mData;
+		unsigned int mSize;
+		bool mReady;
+	};
+
+	unsigned int Copy(void* dest, unsigned int bytes, bool wait, bool& ended);
+	void DecodeLoop();
+
+	eastl::shared_ptr<ResHandle> mHandle;
+	OggMemoryFile* mMemoryFile;
+	OggVorbis_File* mFile;
+	bool mIsValid;
+	unsigned int mSize;
+	unsigned int mBlockAlign;
+	unsigned int mBufferSize;
+
+	eastl::vector<Buffer> mBuffers;
+	unsigned int mReadIndex;
+	unsigned int mReadOffset;
+	unsigned int mWriteIndex;
+	unsigned int mGeneration; // bumped by a seek to drop the buffer being decoded
+	long long mSeekPosition; // pending seek in samples, negative if none
+	bool mEndOfStream;
+	bool mIsStopping;
+	std::atomic<bool> mIsLooping;
+
+	std::mutex mMutex;
+	std::condition_variable mCondition;
+	std::thread mThread;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "WaveOutAudioDevice.h"
+
+#include "Core/Logger/Logger.h"
+
+#pragma comment( lib, "winmm" )
+
+WaveOutAudioDevice::WaveOutAudioDevice(unsigned int numBlocks)
+	: mWaveOut(NULL), mEvent(NULL), mNumBlocks(eastl::max(numBlocks, 2u)), mNextBlock(0), mBlockFrames(0)
+{
+
+}
+
+WaveOutAudioDevice::~WaveOutAudioDevice()
+{
+	Close();
+}
+
+bool WaveOutAudioDevice::Open(unsigned int sampleRate, unsigned int blockFrames)
+{
+	WAVEFORMATEX wfx;
+	ZeroMemory(&wfx, sizeof(WAVEFORMATEX));
+	wfx.wFormatTag = WAVE_FORMAT_PCM;
+	wfx.nChannels = 2;
+	wfx.nSamplesPerSec = sampleRate;
+	wfx.wBitsPerSample = 16;
+	wfx.nBlockAlign = wfx.nChannels * wfx.wBitsPerSample / 8;
+	wfx.nAvgBytesPerSec = wfx.nSamplesPerSec * wfx.nBlockAlign;
+
+	mEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (!mEvent)
+	{
+		LogError("Couldn't create the waveOut event");
+		return false;
+	}
+
+	if (waveOutOpen(&mWaveOut, WAVE_MAPPER, &wfx,
+		(DWORD_PTR)mEvent, 0, CALLBACK_EVENT) != MMSYSERR_NOERROR)
+	{
+		LogError("Couldn't open the waveOut device");
+		CloseHandle(mEvent);
+		mEvent = NULL;
+		mWaveOut = NULL;
+		return false;
+	}
+
+	// the headers point into the samples, neither moves until the device is closed
+	mBlockFrames = blockFrames;
+	mNextBlock = 0;
+	mSamples.resize(mNumBlocks * 2 * blockFrames);
+	mHeaders.resize(mNumBlocks);
+	for (unsigned int b = 0; b < mNumBlocks; ++b)
+	{
+		WAVEHDR& header = mHeaders[b];
+		ZeroMemory(&header, sizeof(WAVEHDR));
+		header.lpData = (LPSTR)(mSamples.data() + b * 2 * blockFrames);
+		header.dwBufferLength = blockFrames * 2 * sizeof(short);
+		waveOutPrepareHeader(mWaveOut, &header, sizeof(WAVEHDR));
+	}
+	return true;
+}
+
+void WaveOutAudioDevice::Close()
+{
+	if (!mWaveOut)
+		return;
+
+	// returns the queued blocks so they can be unprepared
+	waveOutReset(mWaveOut);
+	for (WAVEHDR& header : mHeaders)
+		waveOutUnprepareHeader(mWaveOut, &header, sizeof(WAVEHDR));
+	waveOutClose(mWaveOut);
+	CloseHandle(mEvent);
+
+	mWaveOut = NULL;
+	mEvent = NULL;
+	mHeaders.clear();
+	mSamples.clear();
+}
+
+void WaveOutAudioDevice::Write(short const* block, unsigned int frames)
+{
+	if (!mWaveOut)
+		return;
+
+	// wait until the driver is done with the oldest block
+	WAVEHDR& header = mHeaders[mNextBlock];
+	while (header.dwFlags & WHDR_INQUEUE)
+		WaitForSingleObject(mEvent, INFINITE);
+
+	frames = eastl::min(frames, mBlockFrames);
+	memcpy(header.lpData, block, frames * 2 * sizeof(short));
+	header.dwBufferLength = frames * 2 * sizeof(short);
+	header.dwFlags &= ~WHDR_DONE;
+	waveOutWrite(mWaveOut, &header, sizeof(WAVEHDR));
+
+	mNextBlock = (mNextBlock + 1) % mNumBlocks;
+}
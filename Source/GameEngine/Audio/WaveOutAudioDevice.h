@@ -0,0 +1,34 @@
+#ifndef WAVEOUTAUDIODEVICE_H
+#define WAVEOUTAUDIODEVICE_H
+
+#include "AudioDevice.h"
+
+#include <mmsystem.h>
+
+/*
+	WaveOutAudioDevice plays the mixed blocks on the sound card through the Windows
+	waveOut interface. It queues a few blocks ahead and Write waits for the oldest one
+	to finish playing before reusing it, which paces the mixing thread.
+*/
+class WaveOutAudioDevice : public BaseAudioDevice
+{
+public:
+	WaveOutAudioDevice(unsigned int numBlocks = 4);
+	virtual ~WaveOutAudioDevice();
+
+	virtual bool Open(unsigned int sampleRate, unsigned int blockFrames);
+	virtual void Close();
+	virtual void Write(short const* block, unsigned int frames);
+
+protected:
+	HWAVEOUT mWaveOut;
+	HANDLE mEvent; // signaled by the driver each time a block is done
+	unsigned int mNumBlocks;
+	unsigned int mNextBlock;
+	unsigned int mBlockFrames;
+
+	eastl::vector<WAVEHDR> mHeaders;
+	eastl::vector<short> mSamples; // the blocks one after another
+};
+
+#endif
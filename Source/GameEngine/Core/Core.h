@@ -38,6 +38,9 @@
 //OS
 #include "OS/OS.h"
 
+//Profiler
+#include "Profiler/Profiler.h"
+
 //Process
 #include "Process/Process.h"
 #include "Process/ProcessManager.h"
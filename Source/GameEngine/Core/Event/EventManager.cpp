@@ -39,6 +39,7 @@
 #include "EventManager.h"
 
 #include "Core/Logger/Logger.h"
+#include "Core/Profiler/Profiler.h"
 
 BaseEventManager* BaseEventManager::mEventMgr = NULL;
 GenericObjectFactory<BaseEventData, BaseEventType> mEventFactory;
@@ -198,6 +199,7 @@ bool EventManager::QueueEvent(const BaseEventDataPtr& pEvent)
 	if (findIt != mEventListeners.end())
 	{
 		mQueues[mActiveQueue].push_back(pEvent);
+		PROFILE_COUNTER("Events queued", 1);
 		//LogInformation("Events " + eastl::string("Successfully queued event: ") + eastl::string(pEvent->GetName()));
 		return true;
 	}
@@ -9,6 +9,8 @@
 
 LogReporter::~LogReporter()
 {
+    Logger::Stop();
+
     if (mLogToStdout)
     {
         Logger::Unsubscribe(mLogToStdout.get());
@@ -68,4 +70,7 @@ LogReporter::LogReporter(eastl::string const& logFile, int logFileFlags,
         Logger::Subscribe(mLogToOutputWindow.get());
     }
 #endif
+
+    // The listeners are called from the logging thread from now on.
+    Logger::Start();
 }
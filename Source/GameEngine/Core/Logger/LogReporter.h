@@ -23,6 +23,7 @@ public:
     // application for logging.  The GenerateProject tool creates such code.
     // If you do not want a particular logger, set the flags to
     // LISTEN_FOR_NOTHING and set logFile to "" if you do not want a file.
+    // The reporter runs the logging thread for its lifetime.
     ~LogReporter();
 
     LogReporter(eastl::string const& logFile, int logFileFlags, int logStdoutFlags,
@@ -8,90 +8,381 @@
 #include "Logger.h"
 #include "Core/Utility/StringUtil.h"
 
-eastl::string Logger::mMessage;
+// Single producer, single consumer byte ring.  The producer is the thread
+// which owns it, the consumer is whoever holds msMutex in Drain.  The
+// positions only grow, the capacity is a power of two so they wrap with the
+// unsigned arithmetic.
+struct Logger::Ring
+{
+	struct Record
+	{
+		int flag;
+		int line;
+		char const* file;
+		char const* function;
+		unsigned int length;
+	};
+
+	Ring(unsigned int capacity)
+		:
+		mBuffer(capacity),
+		mMask(capacity - 1),
+		mHead(0),
+		mTail(0),
+		mOrphaned(false)
+	{
+	}
+
+	void Write(unsigned int position, void const* data, unsigned int size)
+	{
+		unsigned int offset = position & mMask;
+		unsigned int first = eastl::min(size, (unsigned int)mBuffer.size() - offset);
+		memcpy(mBuffer.data() + offset, data, first);
+		memcpy(mBuffer.data(), static_cast<char const*>(data) + first, size - first);
+	}
+
+	void Read(unsigned int position, void* data, unsigned int size) const
+	{
+		unsigned int offset = position & mMask;
+		unsigned int first = eastl::min(size, (unsigned int)mBuffer.size() - offset);
+		memcpy(data, mBuffer.data() + offset, first);
+		memcpy(static_cast<char*>(data) + first, mBuffer.data(), size - first);
+	}
+
+	eastl::vector<char> mBuffer;
+	unsigned int mMask;
+	std::atomic<unsigned int> mHead;
+	std::atomic<unsigned int> mTail;
+	std::atomic<bool> mOrphaned;
+};
+
+// Ring of the calling thread.  The generation tells apart a ring which Stop
+// already released.  When the thread ends the ring is left to the logging
+// thread, which releases it once it is drained.
+struct LoggerThreadRing
+{
+	LoggerThreadRing() : ring(nullptr), generation(0) {}
+
+	~LoggerThreadRing()
+	{
+		if (ring && generation == Logger::msGeneration.load(std::memory_order_acquire))
+			ring->mOrphaned.store(true, std::memory_order_release);
+	}
+
+	Logger::Ring* ring;
+	unsigned int generation;
+};
+
+static thread_local LoggerThreadRing tlsRing;
+
 std::mutex Logger::msMutex;
 eastl::set<Logger::Listener*> Logger::msListeners;
+int Logger::msLevel = LOGGER_LEVEL_INFORMATION;
+std::atomic<int> Logger::msEnabled(0);
+
+eastl::vector<Logger::Ring*> Logger::msRings;
+unsigned int Logger::msRingSize = 0;
+std::atomic<unsigned int> Logger::msGeneration(0);
+unsigned int Logger::msReportedDropped = 0;
+std::atomic<unsigned int> Logger::msDropped(0);
+std::atomic<bool> Logger::msRunning(false);
+std::mutex Logger::msWakeMutex;
+std::condition_variable Logger::msWake;
+std::thread Logger::msThread;
 
 Logger::Logger(char const* file, char const* function, int line, eastl::string const& message)
+	:
+	mFile(file),
+	mFunction(function),
+	mLine(line),
+	mMessage(message)
 {
-	mMessage =
-		"File: " + eastl::string(file) + "\n" +
-		"Func: " + eastl::string(function) + "\n" +
-		"Line: " + eastl::to_string(line) + "\n" +
-		message + "\n\n";
 }
 
 Logger::Logger(char const* file, char const* function, int line, eastl::wstring const& message)
+	:
+	Logger(file, function, line, ToString(message.c_str()))
 {
-	Logger(file, function, line, ToString(message.c_str()));
 }
 
 void Logger::Assertion()
 {
+	Send(Listener::LISTEN_FOR_ASSERTION);
+}
+
+void Logger::Error()
+{
+	Send(Listener::LISTEN_FOR_ERROR);
+}
+
+void Logger::Warning()
+{
+	Post(Listener::LISTEN_FOR_WARNING);
+}
+
+void Logger::Information()
+{
+	Post(Listener::LISTEN_FOR_INFORMATION);
+}
+
+void Logger::Send(int flag)
+{
+	// The queued messages of all threads go first, so a crash right after an
+	// error still finds the warnings which led to it in the log.
+	eastl::string message = Format(mFile, mFunction, mLine, mMessage.c_str(), mMessage.size());
 	msMutex.lock();
-	for (auto listener : msListeners)
+	Drain();
+	Deliver(flag, message);
+	msMutex.unlock();
+}
+
+void Logger::Post(int flag)
+{
+	Ring* ring = msRunning.load(std::memory_order_acquire) ? GetThreadRing() : nullptr;
+	if (!ring)
 	{
-		if (listener->GetFlags() & Listener::LISTEN_FOR_ASSERTION)
-		{
-			listener->Assertion(mMessage);
-		}
+		Send(flag);
+		return;
 	}
-	msMutex.unlock();
+
+	Ring::Record record;
+	record.flag = flag;
+	record.line = mLine;
+	record.file = mFile;
+	record.function = mFunction;
+	record.length = (unsigned int)mMessage.size();
+
+	unsigned int const capacity = (unsigned int)ring->mBuffer.size();
+	unsigned int const size = (unsigned int)sizeof(record) + record.length;
+	unsigned int const head = ring->mHead.load(std::memory_order_relaxed);
+	unsigned int const used = head - ring->mTail.load(std::memory_order_acquire);
+	if (size > capacity - used)
+	{
+		msDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	ring->Write(head, &record, sizeof(record));
+	ring->Write(head + sizeof(record), mMessage.c_str(), record.length);
+	ring->mHead.store(head + size, std::memory_order_release);
+
+	// The logging thread wakes up on its own every few milliseconds, it is
+	// only woken here when the ring is filling up.
+	if (used + size > capacity / 2)
+		msWake.notify_one();
 }
 
-void Logger::Error()
+eastl::string Logger::Format(char const* file, char const* function,
+	int line, char const* message, size_t length)
+{
+	return
+		"File: " + eastl::string(file) + "\n" +
+		"Func: " + eastl::string(function) + "\n" +
+		"Line: " + eastl::to_string(line) + "\n" +
+		eastl::string(message, length) + "\n\n";
+}
+
+void Logger::Deliver(int flag, eastl::string const& message)
 {
-	msMutex.lock();
 	for (auto listener : msListeners)
 	{
-		if (listener->GetFlags() & Listener::LISTEN_FOR_ERROR)
+		if (listener->GetFlags() & flag)
 		{
-			listener->Error(mMessage);
+			switch (flag)
+			{
+			case Listener::LISTEN_FOR_ASSERTION:
+				listener->Assertion(message);
+				break;
+			case Listener::LISTEN_FOR_ERROR:
+				listener->Error(message);
+				break;
+			case Listener::LISTEN_FOR_WARNING:
+				listener->Warning(message);
+				break;
+			default:
+				listener->Information(message);
+				break;
+			}
 		}
 	}
+}
+
+void Logger::Subscribe(Listener* listener)
+{
+	msMutex.lock();
+	msListeners.insert(listener);
+	UpdateEnabled();
 	msMutex.unlock();
 }
 
-void Logger::Warning()
+void Logger::Unsubscribe(Listener* listener)
 {
 	msMutex.lock();
-	for (auto listener : msListeners)
-	{
-		if (listener->GetFlags() & Listener::LISTEN_FOR_WARNING)
-		{
-			listener->Warning(mMessage);
-		}
-	}
+	msListeners.erase(listener);
+	UpdateEnabled();
 	msMutex.unlock();
 }
 
-void Logger::Information()
+void Logger::SetLevel(int level)
 {
 	msMutex.lock();
+	msLevel = level;
+	UpdateEnabled();
+	msMutex.unlock();
+}
+
+int Logger::GetLevel()
+{
+	return msLevel;
+}
+
+void Logger::UpdateEnabled()
+{
+	int enabled = 0;
 	for (auto listener : msListeners)
+		enabled |= listener->GetFlags();
+
+	switch (msLevel)
+	{
+	case LOGGER_LEVEL_INFORMATION:
+		break;
+	case LOGGER_LEVEL_WARNING:
+		enabled &= ~Listener::LISTEN_FOR_INFORMATION;
+		break;
+	case LOGGER_LEVEL_ERROR:
+		enabled &= Listener::LISTEN_FOR_ASSERTION | Listener::LISTEN_FOR_ERROR;
+		break;
+	default:
+		enabled &= Listener::LISTEN_FOR_ASSERTION;
+		break;
+	}
+	msEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+Logger::Ring* Logger::GetThreadRing()
+{
+	if (!tlsRing.ring || tlsRing.generation != msGeneration.load(std::memory_order_acquire))
 	{
-		if (listener->GetFlags() & Listener::LISTEN_FOR_INFORMATION)
+		msMutex.lock();
+		if (msRunning.load(std::memory_order_relaxed))
 		{
-			listener->Information(mMessage);
+			tlsRing.ring = new Ring(msRingSize);
+			tlsRing.generation = msGeneration.load(std::memory_order_relaxed);
+			msRings.push_back(tlsRing.ring);
 		}
+		else
+		{
+			tlsRing.ring = nullptr;
+		}
+		msMutex.unlock();
 	}
+	return tlsRing.ring;
+}
+
+void Logger::Start(unsigned int ringSize)
+{
+	if (msRunning.load())
+		return;
+
+	unsigned int capacity = 1024;
+	while (capacity < ringSize)
+		capacity <<= 1;
+
+	msMutex.lock();
+	msRingSize = capacity;
+	msGeneration.fetch_add(1, std::memory_order_release);
+	msRunning.store(true, std::memory_order_release);
 	msMutex.unlock();
+
+	msThread = std::thread(&Logger::Run);
 }
 
-void Logger::Subscribe(Listener* listener)
+void Logger::Stop()
 {
+	if (!msRunning.load())
+		return;
+
+	msRunning.store(false, std::memory_order_release);
+	msWake.notify_one();
+	msThread.join();
+
+	// The thread drained the rings before it returned.
 	msMutex.lock();
-	msListeners.insert(listener);
+	for (Ring* ring : msRings)
+		delete ring;
+	msRings.clear();
+	msGeneration.fetch_add(1, std::memory_order_release);
 	msMutex.unlock();
 }
 
-void Logger::Unsubscribe(Listener* listener)
+void Logger::Flush()
 {
 	msMutex.lock();
-	msListeners.erase(listener);
+	Drain();
 	msMutex.unlock();
 }
 
+unsigned int Logger::GetNumDropped()
+{
+	return msDropped.load(std::memory_order_relaxed);
+}
+
+void Logger::Drain()
+{
+	eastl::vector<char> text;
+	for (auto it = msRings.begin(); it != msRings.end();)
+	{
+		Ring* ring = *it;
+		bool orphaned = ring->mOrphaned.load(std::memory_order_acquire);
+		unsigned int tail = ring->mTail.load(std::memory_order_relaxed);
+		unsigned int const head = ring->mHead.load(std::memory_order_acquire);
+		while (tail != head)
+		{
+			Ring::Record record;
+			ring->Read(tail, &record, sizeof(record));
+			text.resize(record.length + 1);
+			ring->Read(tail + sizeof(record), text.data(), record.length);
+			tail += (unsigned int)sizeof(record) + record.length;
+			ring->mTail.store(tail, std::memory_order_release);
+
+			Deliver(record.flag, Format(record.file, record.function,
+				record.line, text.data(), record.length));
+		}
+
+		if (orphaned)
+		{
+			delete ring;
+			it = msRings.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	unsigned int dropped = msDropped.load(std::memory_order_relaxed);
+	if (dropped != msReportedDropped)
+	{
+		Deliver(Listener::LISTEN_FOR_WARNING, Format(__FILE__, __FUNCTION__, __LINE__, "", 0) +
+			eastl::to_string(dropped - msReportedDropped) + " messages dropped, the log rings are full\n\n");
+		msReportedDropped = dropped;
+	}
+}
+
+void Logger::Run()
+{
+	std::unique_lock<std::mutex> lock(msWakeMutex);
+	while (msRunning.load(std::memory_order_acquire))
+	{
+		msWake.wait_for(lock, std::chrono::milliseconds(10));
+
+		lock.unlock();
+		Flush();
+		lock.lock();
+	}
+	Flush();
+}
+
 
 // Logger::Listener
 Logger::Listener::~Listener()
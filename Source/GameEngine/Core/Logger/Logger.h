@@ -10,18 +10,38 @@
 
 #include "Core/CoreStd.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
+
+// Severity levels, lowest first.  Defining LOGGER_LEVEL compiles out the
+// macros below that level, Logger::SetLevel filters the others at run time.
+#define LOGGER_LEVEL_INFORMATION 0
+#define LOGGER_LEVEL_WARNING 1
+#define LOGGER_LEVEL_ERROR 2
+#define LOGGER_LEVEL_ASSERTION 3
+
+#if !defined(LOGGER_LEVEL)
+#define LOGGER_LEVEL LOGGER_LEVEL_INFORMATION
+#endif
 
 class CORE_ITEM Logger
 {
 public:
 	// Construction.  The Logger object is designed to exist only for a
-	// single-line call.  A string is generated from the input parameters and
-	// is used for reporting.
+	// single-line call.  The file and function must be string literals, as
+	// __FILE__ and __FUNCTION__ are, because they are queued by pointer.
 	Logger(char const* file, char const* function, int line, eastl::string const& message);
 	Logger(char const* file, char const* function, int line, eastl::wstring const& message);
 
-	// Notify current listeners about the logged information.
+	// Notify current listeners about the logged information.  While the
+	// logging thread runs, warnings and information are copied into a ring
+	// buffer owned by the calling thread without taking any lock, and the
+	// thread delivers them to the listeners.  The messages of a thread keep
+	// their order, the messages of different threads may interleave.
+	// Assertions and errors flush the rings and are delivered on the calling
+	// thread before the call returns.
 	void Assertion();
 	void Error();
 	void Warning();
@@ -63,38 +83,107 @@ public:
 	static void Subscribe(Listener* listener);
 	static void Unsubscribe(Listener* listener);
 
+	// Run-time filter, one of the LOGGER_LEVEL values.  A message is built
+	// only if its level passes and some listener wants it.
+	static void SetLevel(int level);
+	static int GetLevel();
+	inline static bool IsEnabled(int flag);
+
+	// Start launches the logging thread, each producer thread gets a ring
+	// of ringSize bytes (rounded up to a power of two) on its first message.
+	// A message which does not fit in its ring is dropped and counted, the
+	// logging thread reports the count as a warning.  Stop delivers what is
+	// queued and joins the thread, the loggers are synchronous again.  Do not
+	// log from other threads while Start or Stop run.  Flush delivers the
+	// queued messages on the calling thread.
+	static void Start(unsigned int ringSize = 65536);
+	static void Stop();
+	static void Flush();
+	static unsigned int GetNumDropped();
+
 private:
-	static eastl::string mMessage;
+	friend struct LoggerThreadRing;
+	struct Ring;
+
+	void Send(int flag);
+	void Post(int flag);
+
+	static eastl::string Format(char const* file, char const* function,
+		int line, char const* message, size_t length);
+	static void Deliver(int flag, eastl::string const& message);
+	static void UpdateEnabled();
+	static Ring* GetThreadRing();
+	static void Drain();
+	static void Run();
+
+	char const* mFile;
+	char const* mFunction;
+	int mLine;
+	eastl::string mMessage;
 
 	static std::mutex msMutex;
 	static eastl::set<Listener*> msListeners;
+	static int msLevel;
+	static std::atomic<int> msEnabled;
+
+	static eastl::vector<Ring*> msRings;
+	static unsigned int msRingSize;
+	static std::atomic<unsigned int> msGeneration;
+	static unsigned int msReportedDropped;
+	static std::atomic<unsigned int> msDropped;
+	static std::atomic<bool> msRunning;
+	static std::mutex msWakeMutex;
+	static std::condition_variable msWake;
+	static std::thread msThread;
 };
 
+inline bool Logger::IsEnabled(int flag)
+{
+	return (msEnabled.load(std::memory_order_relaxed) & flag) != 0;
+}
+
 
 #if !defined(NO_LOGGER)
 
+// The message argument is only evaluated when the level is enabled.
 #define LogAssert(condition, message) \
-    if (!(condition)) \
+    do \
     { \
-        Logger(__FILE__, __FUNCTION__, __LINE__, message).Assertion(); \
-    }
+        if (!(condition) && Logger::IsEnabled(Logger::Listener::LISTEN_FOR_ASSERTION)) \
+            Logger(__FILE__, __FUNCTION__, __LINE__, message).Assertion(); \
+    } while (0)
 
+#if LOGGER_LEVEL <= LOGGER_LEVEL_ERROR
 #define LogError(message) \
-    Logger(__FILE__, __FUNCTION__, __LINE__, message).Error()
+    (Logger::IsEnabled(Logger::Listener::LISTEN_FOR_ERROR) ? \
+        Logger(__FILE__, __FUNCTION__, __LINE__, message).Error() : (void)0)
+#else
+#define LogError(message) ((void)0)
+#endif
 
+#if LOGGER_LEVEL <= LOGGER_LEVEL_WARNING
 #define LogWarning(message) \
-    Logger(__FILE__, __FUNCTION__, __LINE__, message).Warning()
+    (Logger::IsEnabled(Logger::Listener::LISTEN_FOR_WARNING) ? \
+        Logger(__FILE__, __FUNCTION__, __LINE__, message).Warning() : (void)0)
+#else
+#define LogWarning(message) ((void)0)
+#endif
 
+#if LOGGER_LEVEL <= LOGGER_LEVEL_INFORMATION
 #define LogInformation(message) \
-    Logger(__FILE__, __FUNCTION__, __LINE__, message).Information()
+    (Logger::IsEnabled(Logger::Listener::LISTEN_FOR_INFORMATION) ? \
+        Logger(__FILE__, __FUNCTION__, __LINE__, message).Information() : (void)0)
+#else
+#define LogInformation(message) ((void)0)
+#endif
 
 #else
 
 // No logging of assertions, warnings, errors, or information.
-#define LogAssert(condition, message)
-#define LogError(message)
-#define LogWarning(message)
-#define LogInformation(message)
+#define LogAssert(condition, message) ((void)0)
+#define LogError(message) ((void)0)
+#define LogWarning(message) ((void)0)
+#define LogInformation(message) ((void)0)
 
 #endif
 
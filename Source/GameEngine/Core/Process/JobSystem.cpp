@@ -0,0 +1,282 @@
+#include "JobSystem.h"
+
+#include "Core/Logger/Logger.h"
+#include "Core/Profiler/Profiler.h"
+
+namespace
+{
+	// Queue of the calling thread in the job system which owns it, the
+	// shared queue 0 for threads which are not workers.
+	thread_local JobSystem const* tlsJobSystem = nullptr;
+	thread_local unsigned int tlsQueue = 0;
+}
+
+JobCounter::JobCounter()
+	: mValue(0)
+{
+
+}
+
+JobCounter::~JobCounter()
+{
+	// the last job may still hold the lock after a waiter saw the counter done
+	std::lock_guard<std::mutex> lock(mMutex);
+}
+
+JobSystem* JobSystem::mJobSystem = nullptr;
+
+JobSystem* JobSystem::Get(void)
+{
+	return JobSystem::mJobSystem;
+}
+
+JobSystem::JobSystem(unsigned int numThreads)
+	: mNumQueued(0), mNumSleeping(0), mRunning(true)
+{
+	if (numThreads == 0)
+	{
+		unsigned int hardware = std::thread::hardware_concurrency();
+		numThreads = hardware > 1 ? hardware - 1 : 1;
+	}
+
+	for (unsigned int queue = 0; queue <= numThreads; ++queue)
+		mQueues.push_back(eastl::make_unique<Queue>());
+
+	for (unsigned int thread = 0; thread < numThreads; ++thread)
+		mThreads.push_back(std::thread(&JobSystem::WorkerLoop, this, thread + 1));
+
+	if (JobSystem::mJobSystem)
+	{
+		LogError("Attempting to create two global job systems! \
+					The old one will be destroyed and overwritten with this one.");
+		delete JobSystem::mJobSystem;
+	}
+
+	JobSystem::mJobSystem = this;
+}
+
+JobSystem::~JobSystem()
+{
+	if (JobSystem::mJobSystem == this)
+		JobSystem::mJobSystem = nullptr;
+
+	// the workers finish the jobs already queued before they stop
+	{
+		std::lock_guard<std::mutex> lock(mSleepMutex);
+		mRunning.store(false);
+	}
+	mSleep.notify_all();
+
+	for (std::thread& thread : mThreads)
+		thread.join();
+}
+
+void JobSystem::Submit(eastl::function<void()> const& job, JobCounter* counter)
+{
+	if (counter)
+		counter->mValue.fetch_add(1, std::memory_order_relaxed);
+
+	Job entry;
+	entry.mFunction = job;
+	entry.mCounter = counter;
+	Push(entry);
+}
+
+void JobSystem::Submit(eastl::function<void()> const& job,
+	JobCounter* counter, JobCounter* dependency)
+{
+	if (!dependency)
+	{
+		Submit(job, counter);
+		return;
+	}
+
+	if (counter)
+		counter->mValue.fetch_add(1, std::memory_order_relaxed);
+
+	// the job is parked in the dependency unless it already finished, the
+	// last job of the dependency pushes the parked ones under the same lock
+	{
+		std::lock_guard<std::mutex> lock(dependency->mMutex);
+		if (!dependency->IsDone())
+		{
+			JobCounter::Continuation continuation;
+			continuation.mFunction = job;
+			continuation.mCounter = counter;
+			dependency->mContinuations.push_back(continuation);
+			return;
+		}
+	}
+
+	Job entry;
+	entry.mFunction = job;
+	entry.mCounter = counter;
+	Push(entry);
+}
+
+void JobSystem::Wait(JobCounter* counter)
+{
+	while (!counter->IsDone())
+	{
+		if (!RunPending())
+			std::this_thread::yield();
+	}
+}
+
+void JobSystem::ParallelFor(unsigned int count, unsigned int grain,
+	eastl::function<void(unsigned int, unsigned int)> const& body)
+{
+	if (grain == 0)
+		grain = 1;
+
+	// ranges so that every thread gets a few of them to balance the load
+	unsigned int const numThreads = GetNumThreads() + 1;
+	unsigned int rangeSize = eastl::max(grain, (count + numThreads * 4 - 1) / (numThreads * 4));
+	if (count <= rangeSize)
+	{
+		if (count > 0)
+			body(0, count);
+		return;
+	}
+
+	JobCounter counter;
+	auto const* bodyPtr = &body;
+	for (unsigned int begin = rangeSize; begin < count; begin += rangeSize)
+	{
+		unsigned int end = eastl::min(count, begin + rangeSize);
+		Submit([bodyPtr, begin, end]() { (*bodyPtr)(begin, end); }, &counter);
+	}
+
+	// the calling thread takes the first range itself
+	body(0, rangeSize);
+	Wait(&counter);
+}
+
+void JobSystem::Push(Job const& job)
+{
+	unsigned int queue = (tlsJobSystem == this) ? tlsQueue : 0;
+	{
+		std::lock_guard<std::mutex> lock(mQueues[queue]->mMutex);
+		mQueues[queue]->mJobs.push_back(job);
+	}
+	mNumQueued.fetch_add(1);
+
+	// a worker which is about to sleep checks mNumQueued after it counted
+	// itself as sleeping, so one of the two always sees the other
+	if (mNumSleeping.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mSleepMutex);
+		}
+		mSleep.notify_one();
+	}
+}
+
+bool JobSystem::Pop(unsigned int queue, Job& job)
+{
+	Queue& owned = *mQueues[queue];
+	std::lock_guard<std::mutex> lock(owned.mMutex);
+	if (owned.mJobs.empty())
+		return false;
+
+	job = owned.mJobs.back();
+	owned.mJobs.pop_back();
+	mNumQueued.fetch_sub(1);
+	return true;
+}
+
+bool JobSystem::Steal(unsigned int queue, Job& job)
+{
+	unsigned int const numQueues = (unsigned int)mQueues.size();
+	for (unsigned int offset = 1; offset < numQueues; ++offset)
+	{
+		Queue& victim = *mQueues[(queue + offset) % numQueues];
+		std::unique_lock<std::mutex> lock(victim.mMutex, std::try_to_lock);
+		if (!lock.owns_lock() || victim.mJobs.empty())
+			continue;
+
+		job = victim.mJobs.front();
+		victim.mJobs.pop_front();
+		mNumQueued.fetch_sub(1);
+		return true;
+	}
+	return false;
+}
+
+bool JobSystem::RunPending()
+{
+	unsigned int queue = (tlsJobSystem == this) ? tlsQueue : 0;
+
+	Job job;
+	if (!Pop(queue, job) && !Steal(queue, job))
+		return false;
+
+	Execute(job);
+	return true;
+}
+
+void JobSystem::Execute(Job& job)
+{
+	{
+		PROFILE_ZONE("Job");
+		job.mFunction();
+	}
+
+	if (job.mCounter)
+		Complete(job.mCounter);
+}
+
+void JobSystem::Complete(JobCounter* counter)
+{
+	// jobs which are not the last one only decrement the counter
+	int value = counter->mValue.load(std::memory_order_relaxed);
+	while (value > 1)
+	{
+		if (counter->mValue.compare_exchange_weak(value, value - 1, std::memory_order_acq_rel))
+			return;
+	}
+
+	// the last job takes the continuations out under the lock before the counter
+	// reads as done, and doesn't touch the counter once it released the lock. A
+	// waiter may destroy the counter as soon as it is done, its destructor waits
+	// for the lock.
+	eastl::vector<JobCounter::Continuation> continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter->mMutex);
+		if (counter->mValue.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			continuations.swap(counter->mContinuations);
+	}
+
+	for (JobCounter::Continuation& continuation : continuations)
+	{
+		Job next;
+		next.mFunction = continuation.mFunction;
+		next.mCounter = continuation.mCounter;
+		Push(next);
+	}
+}
+
+void JobSystem::WorkerLoop(unsigned int queue)
+{
+	tlsJobSystem = this;
+	tlsQueue = queue;
+	PROFILE_THREAD("Job worker");
+
+	for (;;)
+	{
+		Job job;
+		if (Pop(queue, job) || Steal(queue, job))
+		{
+			Execute(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mSleepMutex);
+		mNumSleeping.fetch_add(1);
+		mSleep.wait(lock, [this]() { return !mRunning.load() || mNumQueued.load() > 0; });
+		mNumSleeping.fetch_sub(1);
+
+		if (!mRunning.load() && mNumQueued.load() == 0)
+			break;
+	}
+}
@@ -0,0 +1,121 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include "GameEngineStd.h"
+
+#include <EASTL/deque.h>
+#include <EASTL/functional.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*
+	Counts the jobs submitted against it which have not finished yet. Wait on
+	a counter to join a group of jobs, or submit a job with a counter as its
+	dependency to run it once the counter drops to zero. A counter must
+	outlive the jobs which reference it.
+*/
+class JobCounter
+{
+public:
+
+	JobCounter();
+	~JobCounter();
+
+	bool IsDone() const { return mValue.load(std::memory_order_acquire) == 0; }
+
+private:
+
+	friend class JobSystem;
+
+	struct Continuation
+	{
+		eastl::function<void()> mFunction;
+		JobCounter* mCounter;
+	};
+
+	std::atomic<int> mValue;
+	std::mutex mMutex;
+	eastl::vector<Continuation> mContinuations;
+};
+
+/*
+	Work-stealing job system sized to the hardware. Each worker thread owns a
+	queue, it runs its own jobs last in first out and steals the oldest jobs
+	of the other queues when its own is empty. Jobs submitted from threads
+	which are not workers go to a shared queue which the workers steal from.
+	Waiting on a counter runs pending jobs instead of blocking, so a job may
+	submit and wait on other jobs.
+
+	The engine creates a single instance at startup. Systems which want to
+	split their work use Get and fall back to running serially when it
+	returns null.
+*/
+class JobSystem
+{
+public:
+
+	//! Starts numThreads workers, the hardware concurrency minus one (the
+	//! submitting thread helps while waiting) when it is zero.
+	JobSystem(unsigned int numThreads = 0);
+	~JobSystem();
+
+	static JobSystem* Get(void);
+
+	unsigned int GetNumThreads() const { return (unsigned int)mThreads.size(); }
+
+	//! Queues a job. The counter, if any, is incremented now and decremented
+	//! when the job finishes.
+	void Submit(eastl::function<void()> const& job, JobCounter* counter = nullptr);
+
+	//! Queues a job once the dependency is done.
+	void Submit(eastl::function<void()> const& job, JobCounter* counter, JobCounter* dependency);
+
+	//! Runs pending jobs until the counter is done.
+	void Wait(JobCounter* counter);
+
+	//! Calls body(begin, end) over [0, count) in ranges of at least grain
+	//! elements and returns when all of them finished.
+	void ParallelFor(unsigned int count, unsigned int grain,
+		eastl::function<void(unsigned int, unsigned int)> const& body);
+
+protected:
+
+	static JobSystem* mJobSystem;
+
+private:
+
+	struct Job
+	{
+		eastl::function<void()> mFunction;
+		JobCounter* mCounter;
+	};
+
+	struct Queue
+	{
+		std::mutex mMutex;
+		eastl::deque<Job> mJobs;
+	};
+
+	void Push(Job const& job);
+	bool Pop(unsigned int queue, Job& job);
+	bool Steal(unsigned int queue, Job& job);
+	bool RunPending();
+	void Execute(Job& job);
+	void Complete(JobCounter* counter);
+	void WorkerLoop(unsigned int queue);
+
+	//! Queue 0 is shared by the threads which are not workers.
+	eastl::vector<eastl::unique_ptr<Queue>> mQueues;
+	eastl::vector<std::thread> mThreads;
+
+	std::atomic<unsigned int> mNumQueued;
+	std::atomic<unsigned int> mNumSleeping;
+	std::atomic<bool> mRunning;
+	std::mutex mSleepMutex;
+	std::condition_variable mSleep;
+};
+
+#endif
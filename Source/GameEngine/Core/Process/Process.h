@@ -96,6 +96,11 @@ protected:
 	virtual void OnFail(void) { }  // called if the process fails (see below)
 	virtual void OnAbort(void) { }  // called if the process is aborted (see below)
 
+	// return true if OnUpdate may run on a job thread, concurrently with the other parallel safe processes. It
+	// must then only touch state owned by the process; OnInit and the exit functions still run on the main thread,
+	// and the other processes are ticked once all the parallel updates are done.
+	virtual bool IsParallelSafe(void) const { return false; }
+
 public:
 	// Functions for ending the process.
 	inline void Succeed(void);
@@ -39,6 +39,8 @@
 
 #include "ProcessManager.h"
 
+#include "Core/Profiler/Profiler.h"
+
 //---------------------------------------------------------------------------------------------------------------------
 // Destructor
 //---------------------------------------------------------------------------------------------------------------------
@@ -51,12 +53,39 @@ ProcessManager::~ProcessManager(void)
 //---------------------------------------------------------------------------------------------------------------------
 // The process update tick.  Called every logic tick.  This function returns the number of process chains that 
 // succeeded in the upper 32 bits and the number of process chains that failed or were aborted in the lower 32 bits.
+// Processes which are parallel safe are ticked as jobs first, the calling thread runs jobs too while it waits
+// for them. The other processes are ticked afterwards, so they may read the state of the parallel ones.
 //---------------------------------------------------------------------------------------------------------------------
 unsigned int ProcessManager::UpdateProcesses(unsigned long deltaMs)
 {
+    PROFILE_ZONE("UpdateProcesses");
+
     unsigned short int successCount = 0;
     unsigned short int failCount = 0;
 
+    JobSystem* jobSystem = JobSystem::Get();
+    bool const parallel = jobSystem && jobSystem->GetNumThreads() > 0;
+
+    if (parallel)
+    {
+        JobCounter parallelUpdates;
+        for (eastl::shared_ptr<Process> const& process : mProcesses)
+        {
+            if (!process->IsParallelSafe())
+                continue;
+
+            if (process->GetState() == Process::STATE_UNINITIALIZED)
+                process->OnInit();
+
+            if (process->GetState() == Process::STATE_RUNNING)
+            {
+                Process* currProcess = process.get();
+                jobSystem->Submit([currProcess, deltaMs]() { currProcess->OnUpdate(deltaMs); }, &parallelUpdates);
+            }
+        }
+        jobSystem->Wait(&parallelUpdates);
+    }
+
     ProcessList::iterator it = mProcesses.begin();
     while (it != mProcesses.end())
     {
@@ -67,52 +96,65 @@ unsigned int ProcessManager::UpdateProcesses(unsigned long deltaMs)
         ProcessList::iterator thisIt = it;
         ++it;
 
-        // process is uninitialized, so initialize it
-        if (currProcess->GetState() == Process::STATE_UNINITIALIZED)
-            currProcess->OnInit();
+        // parallel processes were already ticked by the jobs
+        if (!parallel || !currProcess->IsParallelSafe())
+        {
+            // process is uninitialized, so initialize it
+            if (currProcess->GetState() == Process::STATE_UNINITIALIZED)
+                currProcess->OnInit();
 
-        // give the process an update tick if it's running
-        if (currProcess->GetState() == Process::STATE_RUNNING)
-            currProcess->OnUpdate(deltaMs);
+            // give the process an update tick if it's running
+            if (currProcess->GetState() == Process::STATE_RUNNING)
+                currProcess->OnUpdate(deltaMs);
+        }
 
         // check to see if the process is dead
         if (currProcess->IsDead())
+            ReapProcess(thisIt, successCount, failCount);
+    }
+
+    return ((successCount << 16) | failCount);
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+// Runs the exit function of a dead process.  The child of a process which succeeded is attached in its place.
+//---------------------------------------------------------------------------------------------------------------------
+void ProcessManager::ReapProcess(ProcessList::iterator processIt,
+    unsigned short int& successCount, unsigned short int& failCount)
+{
+    eastl::shared_ptr<Process> currProcess = (*processIt);
+
+    // run the appropriate exit function
+    switch (currProcess->GetState())
+    {
+        case Process::STATE_SUCCEEDED :
         {
-            // run the appropriate exit function
-            switch (currProcess->GetState())
-            {
-                case Process::STATE_SUCCEEDED :
-                {
-                    currProcess->OnSuccess();
-                    eastl::shared_ptr<Process> child = currProcess->RemoveChild();
-                    if (child)
-                        AttachProcess(child);
-                    else
-                        ++successCount;  // only counts if the whole chain completed
-                    break;
-                }
-
-                case Process::STATE_FAILED :
-                {
-                    currProcess->OnFail();
-                    ++failCount;
-                    break;
-                }
-
-                case Process::STATE_ABORTED :
-                {
-                    currProcess->OnAbort();
-                    ++failCount;
-                    break;
-                }
-            }
+            currProcess->OnSuccess();
+            eastl::shared_ptr<Process> child = currProcess->RemoveChild();
+            if (child)
+                AttachProcess(child);
+            else
+                ++successCount;  // only counts if the whole chain completed
+            break;
+        }
+
+        case Process::STATE_FAILED :
+        {
+            currProcess->OnFail();
+            ++failCount;
+            break;
+        }
 
-            // remove the process and destroy it
-            mProcesses.erase(thisIt);
+        case Process::STATE_ABORTED :
+        {
+            currProcess->OnAbort();
+            ++failCount;
+            break;
         }
     }
 
-    return ((successCount << 16) | failCount);
+    // remove the process and destroy it
+    mProcesses.erase(processIt);
 }
 
 
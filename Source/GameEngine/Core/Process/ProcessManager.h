@@ -42,6 +42,7 @@
 #include "GameEngineStd.h"
 
 #include "Process.h"
+#include "JobSystem.h"
 
 class ProcessManager
 {
@@ -64,6 +65,9 @@ public:
 
 private:
 	void ClearAllProcesses(void);  // should only be called by the destructor
+
+	// runs the exit function of a dead process, attaches its child and removes it from the list
+	void ReapProcess(ProcessList::iterator processIt, unsigned short int& successCount, unsigned short int& failCount);
 };
 
 
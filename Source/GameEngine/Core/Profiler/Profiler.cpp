@@ -0,0 +1,432 @@
+#include "Profiler.h"
+
+#include "Core/Logger/Logger.h"
+
+#include <chrono>
+
+namespace
+{
+	enum
+	{
+		EVENT_BEGIN,
+		EVENT_END,
+		EVENT_COUNTER,
+		EVENT_FRAME,
+		EVENT_NAME,
+		EVENT_THREAD
+	};
+
+	char const gCaptureTag[8] = { 'G', 'E', 'P', 'R', 'O', 'F', '0', '1' };
+	unsigned int const gNoName = 0xFFFFFFFF;
+
+	unsigned long long GetTime()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Capture file record, the characters of a name follow its record
+	struct CaptureRecord
+	{
+		unsigned int mType;
+		unsigned int mThread;
+		unsigned int mName;
+		unsigned long long mTime;
+		long long mValue;
+	};
+
+	void WriteRecord(std::ofstream& file, CaptureRecord const& record)
+	{
+		file.write((char const*)&record.mType, sizeof(record.mType));
+		file.write((char const*)&record.mThread, sizeof(record.mThread));
+		file.write((char const*)&record.mName, sizeof(record.mName));
+		file.write((char const*)&record.mTime, sizeof(record.mTime));
+		file.write((char const*)&record.mValue, sizeof(record.mValue));
+	}
+
+	bool ReadRecord(std::ifstream& file, CaptureRecord& record)
+	{
+		file.read((char*)&record.mType, sizeof(record.mType));
+		file.read((char*)&record.mThread, sizeof(record.mThread));
+		file.read((char*)&record.mName, sizeof(record.mName));
+		file.read((char*)&record.mTime, sizeof(record.mTime));
+		file.read((char*)&record.mValue, sizeof(record.mValue));
+		return (bool)file;
+	}
+
+	// State of the capture, owned by whoever holds msMutex
+	std::ofstream gCaptureFile;
+	eastl::hash_map<char const*, unsigned int> gCaptureNames;
+	unsigned int gRingSize = 0;
+	unsigned int gNextThread = 0;
+	unsigned int gDropped = 0;
+}
+
+// Single producer, single consumer event ring.  The producer is the thread
+// which owns it, the consumer is whoever holds msMutex in Drain.  The
+// positions only grow, the capacity is a power of two so they wrap with the
+// unsigned arithmetic.
+struct Profiler::Ring
+{
+	Ring(unsigned int capacity, unsigned int thread, char const* name)
+		:
+		mEvents(capacity),
+		mMask(capacity - 1),
+		mHead(0),
+		mTail(0),
+		mDropped(0),
+		mOrphaned(false),
+		mThread(thread),
+		mName(name),
+		mCapturedName(nullptr),
+		mIsCaptured(false)
+	{
+	}
+
+	eastl::vector<Event> mEvents;
+	unsigned int mMask;
+	std::atomic<unsigned int> mHead;
+	std::atomic<unsigned int> mTail;
+	std::atomic<unsigned int> mDropped;
+	std::atomic<bool> mOrphaned;
+
+	unsigned int mThread;
+	std::atomic<char const*> mName;
+
+	// the last name written to the capture
+	char const* mCapturedName;
+	bool mIsCaptured;
+};
+
+// Ring of the calling thread.  When the thread ends the ring is left to the
+// consumer, which releases it once it is drained.
+struct ProfilerThreadRing
+{
+	ProfilerThreadRing() : ring(nullptr), name(nullptr) {}
+
+	~ProfilerThreadRing()
+	{
+		if (ring)
+			ring->mOrphaned.store(true, std::memory_order_release);
+	}
+
+	Profiler::Ring* ring;
+	char const* name;
+};
+
+static thread_local ProfilerThreadRing tlsRing;
+
+eastl::vector<Profiler::Ring*> Profiler::msRings;
+std::atomic<bool> Profiler::msCapturing(false);
+std::atomic<Profiler::Counter*> Profiler::msCounters(nullptr);
+std::mutex Profiler::msMutex;
+std::condition_variable Profiler::msCondition;
+std::thread Profiler::msThread;
+bool Profiler::msStopping = false;
+
+Profiler::Counter::Counter(char const* name)
+	:
+	mName(name),
+	mValue(0),
+	mNext(msCounters.load())
+{
+	while (!msCounters.compare_exchange_weak(mNext, this))
+	{
+	}
+}
+
+bool Profiler::StartCapture(eastl::string const& filename, unsigned int ringSize)
+{
+	std::lock_guard<std::mutex> lock(msMutex);
+	if (msThread.joinable())
+	{
+		LogWarning("A profiler capture is already running");
+		return false;
+	}
+
+	gCaptureFile.open(filename.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (!gCaptureFile)
+	{
+		LogError("Couldn't open profiler capture " + filename);
+		return false;
+	}
+
+	unsigned long long startTime = GetTime();
+	gCaptureFile.write(gCaptureTag, sizeof(gCaptureTag));
+	gCaptureFile.write((char const*)&startTime, sizeof(startTime));
+	gCaptureNames.clear();
+	gDropped = 0;
+
+	// threads recording for the first time get rings of this size
+	gRingSize = 1;
+	while (gRingSize < ringSize)
+		gRingSize <<= 1;
+
+	// discard what the rings kept since the last capture
+	for (Ring* ring : msRings)
+	{
+		ring->mTail.store(ring->mHead.load(std::memory_order_acquire), std::memory_order_release);
+		ring->mDropped.store(0);
+		ring->mIsCaptured = false;
+	}
+
+	for (Counter* counter = msCounters.load(); counter; counter = counter->mNext)
+		counter->mValue.store(0);
+
+	msStopping = false;
+	msCapturing.store(true);
+	msThread = std::thread(&Profiler::Run);
+	return true;
+}
+
+void Profiler::StopCapture()
+{
+	if (!msThread.joinable())
+		return;
+
+	msCapturing.store(false);
+	{
+		std::lock_guard<std::mutex> lock(msMutex);
+		msStopping = true;
+	}
+	msCondition.notify_one();
+	msThread.join();
+
+	std::lock_guard<std::mutex> lock(msMutex);
+	Drain();
+	gCaptureFile.close();
+
+	if (gDropped > 0)
+	{
+		LogWarning("The profiler dropped " + eastl::to_string(gDropped) +
+			" events, capture with larger rings");
+	}
+}
+
+void Profiler::BeginZone(char const* name)
+{
+	Record(EVENT_BEGIN, name, 0);
+}
+
+void Profiler::EndZone(char const* name)
+{
+	Record(EVENT_END, name, 0);
+}
+
+void Profiler::OnFrame()
+{
+	if (!IsCapturing())
+		return;
+
+	Record(EVENT_FRAME, "Frame", 0);
+	for (Counter* counter = msCounters.load(); counter; counter = counter->mNext)
+		Record(EVENT_COUNTER, counter->mName, counter->mValue.exchange(0, std::memory_order_relaxed));
+}
+
+void Profiler::SetThreadName(char const* name)
+{
+	tlsRing.name = name;
+	if (tlsRing.ring)
+		tlsRing.ring->mName.store(name, std::memory_order_relaxed);
+}
+
+Profiler::Ring* Profiler::GetRing()
+{
+	if (!tlsRing.ring)
+	{
+		std::lock_guard<std::mutex> lock(msMutex);
+		tlsRing.ring = new Ring(gRingSize, gNextThread++, tlsRing.name);
+		msRings.push_back(tlsRing.ring);
+	}
+	return tlsRing.ring;
+}
+
+void Profiler::Record(unsigned int type, char const* name, long long value)
+{
+	Ring* ring = GetRing();
+
+	unsigned int head = ring->mHead.load(std::memory_order_relaxed);
+	if (head - ring->mTail.load(std::memory_order_acquire) > ring->mMask)
+	{
+		ring->mDropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	Event& event = ring->mEvents[head & ring->mMask];
+	event.mTime = GetTime();
+	event.mName = name;
+	event.mValue = value;
+	event.mType = type;
+	ring->mHead.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::Drain()
+{
+	auto WriteName = [](char const* name)
+	{
+		if (!name)
+			return gNoName;
+
+		auto found = gCaptureNames.find(name);
+		if (found != gCaptureNames.end())
+			return found->second;
+
+		unsigned int id = (unsigned int)gCaptureNames.size();
+		gCaptureNames[name] = id;
+
+		CaptureRecord record = { EVENT_NAME, 0, id, 0, (long long)strlen(name) };
+		WriteRecord(gCaptureFile, record);
+		gCaptureFile.write(name, record.mValue);
+		return id;
+	};
+
+	for (auto it = msRings.begin(); it != msRings.end();)
+	{
+		Ring* ring = *it;
+
+		// read the flag before the head, an orphaned ring gets no more events
+		bool orphaned = ring->mOrphaned.load(std::memory_order_acquire);
+		unsigned int head = ring->mHead.load(std::memory_order_acquire);
+		unsigned int tail = ring->mTail.load(std::memory_order_relaxed);
+
+		char const* name = ring->mName.load(std::memory_order_relaxed);
+		if (head != tail && (!ring->mIsCaptured || name != ring->mCapturedName))
+		{
+			CaptureRecord record = { EVENT_THREAD, ring->mThread, WriteName(name), 0, 0 };
+			WriteRecord(gCaptureFile, record);
+			ring->mCapturedName = name;
+			ring->mIsCaptured = true;
+		}
+
+		for (; tail != head; ++tail)
+		{
+			Event const& event = ring->mEvents[tail & ring->mMask];
+			CaptureRecord record = { event.mType, ring->mThread, WriteName(event.mName), event.mTime, event.mValue };
+			WriteRecord(gCaptureFile, record);
+		}
+		ring->mTail.store(tail, std::memory_order_release);
+		gDropped += ring->mDropped.exchange(0, std::memory_order_relaxed);
+
+		if (orphaned)
+		{
+			delete ring;
+			it = msRings.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+void Profiler::Run()
+{
+	std::unique_lock<std::mutex> lock(msMutex);
+	while (!msStopping)
+	{
+		msCondition.wait_for(lock, std::chrono::milliseconds(10));
+		Drain();
+	}
+}
+
+namespace
+{
+	void WriteJsonString(std::ofstream& file, eastl::string const& text)
+	{
+		file << '"';
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				file << '\\' << c;
+			else if ((unsigned char)c < 0x20)
+				file << ' ';
+			else
+				file << c;
+		}
+		file << '"';
+	}
+}
+
+bool Profiler::ExportChromeTrace(eastl::string const& captureFile, eastl::string const& traceFile)
+{
+	std::ifstream input(captureFile.c_str(), std::ios_base::in | std::ios_base::binary);
+	char tag[sizeof(gCaptureTag)];
+	unsigned long long startTime = 0;
+	input.read(tag, sizeof(tag));
+	input.read((char*)&startTime, sizeof(startTime));
+	if (!input || memcmp(tag, gCaptureTag, sizeof(tag)) != 0)
+	{
+		LogError("Invalid profiler capture " + captureFile);
+		return false;
+	}
+
+	std::ofstream output(traceFile.c_str(), std::ios_base::out | std::ios_base::trunc);
+	if (!output)
+	{
+		LogError("Couldn't open trace file " + traceFile);
+		return false;
+	}
+
+	eastl::vector<eastl::string> names;
+	auto GetName = [&names](unsigned int id)
+	{
+		return id < names.size() ? names[id] : eastl::string("Unnamed");
+	};
+
+	output << "{\"traceEvents\":[";
+	bool first = true;
+
+	CaptureRecord record;
+	while (ReadRecord(input, record))
+	{
+		if (record.mType == EVENT_NAME)
+		{
+			eastl::string name((eastl_size_t)record.mValue, '\0');
+			input.read(&name[0], record.mValue);
+			if (names.size() <= record.mName)
+				names.resize(record.mName + 1);
+			names[record.mName] = name;
+			continue;
+		}
+
+		output << (first ? "\n" : ",\n");
+		first = false;
+
+		char timestamp[32];
+		snprintf(timestamp, sizeof(timestamp), "%.3f", (record.mTime - startTime) / 1000.0);
+
+		switch (record.mType)
+		{
+			case EVENT_THREAD:
+				output << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << record.mThread <<
+					",\"args\":{\"name\":";
+				WriteJsonString(output, record.mName == gNoName ?
+					"Thread " + eastl::to_string(record.mThread) : GetName(record.mName));
+				output << "}}";
+				break;
+
+			case EVENT_BEGIN:
+			case EVENT_END:
+				output << "{\"name\":";
+				WriteJsonString(output, GetName(record.mName));
+				output << ",\"ph\":\"" << (record.mType == EVENT_BEGIN ? 'B' : 'E') << "\",\"ts\":" <<
+					timestamp << ",\"pid\":0,\"tid\":" << record.mThread << "}";
+				break;
+
+			case EVENT_COUNTER:
+				output << "{\"name\":";
+				WriteJsonString(output, GetName(record.mName));
+				output << ",\"ph\":\"C\",\"ts\":" << timestamp << ",\"pid\":0,\"tid\":" << record.mThread <<
+					",\"args\":{\"value\":" << record.mValue << "}}";
+				break;
+
+			default:
+				output << "{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"ts\":" << timestamp <<
+					",\"pid\":0,\"tid\":" << record.mThread << "}";
+				break;
+		}
+	}
+
+	output << "\n]}\n";
+	return true;
+}
@@ -0,0 +1,139 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "Core/CoreStd.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+/*
+	Frame profiler built into the engine. Code is instrumented with scoped zones, counters
+	and a frame marker, which cost a relaxed atomic load while no capture runs. During a
+	capture every thread records its events into a ring buffer it owns, without locks, and
+	a writer thread drains the rings into a binary capture file. ExportChromeTrace converts
+	a capture into the JSON format of chrome://tracing and other trace viewers.
+
+	The names of zones, counters and threads must be string literals, they are recorded by
+	pointer. Define PROFILER_DISABLE to compile the macros out.
+*/
+class CORE_ITEM Profiler
+{
+public:
+	static bool IsCapturing() { return msCapturing.load(std::memory_order_relaxed); }
+
+	// Starts writing events into the capture file. Every thread which records events gets
+	// a ring of ringSize events, rings which fill up before the writer drains them drop
+	// the new events.
+	static bool StartCapture(eastl::string const& filename, unsigned int ringSize = 32768);
+	static void StopCapture();
+
+	// Converts a capture file into a Chrome trace JSON file
+	static bool ExportChromeTrace(eastl::string const& captureFile, eastl::string const& traceFile);
+
+	static void BeginZone(char const* name);
+	static void EndZone(char const* name);
+
+	// Marks the end of a frame and records the counters accumulated during it
+	static void OnFrame();
+
+	// Names the calling thread in the capture
+	static void SetThreadName(char const* name);
+
+	// Scoped zone, it ends where it is destroyed
+	class Zone
+	{
+	public:
+		Zone(char const* name)
+			: mName(IsCapturing() ? name : nullptr)
+		{
+			if (mName)
+				BeginZone(mName);
+		}
+
+		~Zone()
+		{
+			if (mName && IsCapturing())
+				EndZone(mName);
+		}
+
+	private:
+		char const* mName;
+	};
+
+	// Value summed over a frame by any thread, such as draw calls or rays cast
+	class CORE_ITEM Counter
+	{
+	public:
+		Counter(char const* name);
+
+		void Add(long long value)
+		{
+			if (IsCapturing())
+				mValue.fetch_add(value, std::memory_order_relaxed);
+		}
+
+	private:
+		friend class Profiler;
+
+		char const* mName;
+		std::atomic<long long> mValue;
+		Counter* mNext;
+	};
+
+private:
+	friend struct ProfilerThreadRing;
+
+	struct Event
+	{
+		unsigned long long mTime;
+		char const* mName;
+		long long mValue;
+		unsigned int mType;
+	};
+
+	struct Ring;
+
+	static void Record(unsigned int type, char const* name, long long value);
+	static Ring* GetRing();
+	static void Drain();
+	static void Run();
+
+	static eastl::vector<Ring*> msRings;
+	static std::atomic<bool> msCapturing;
+	static std::atomic<Counter*> msCounters;
+	static std::mutex msMutex;
+	static std::condition_variable msCondition;
+	static std::thread msThread;
+	static bool msStopping;
+};
+
+#if !defined(PROFILER_DISABLE)
+
+#define PROFILE_CONCATENATE_(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_(a, b)
+
+#define PROFILE_ZONE(name) \
+	Profiler::Zone PROFILE_CONCATENATE(profilerZone, __LINE__)(name)
+
+#define PROFILE_COUNTER(name, value) \
+	do { static Profiler::Counter profilerCounter(name); profilerCounter.Add(value); } while (0)
+
+#define PROFILE_FRAME() \
+	Profiler::OnFrame()
+
+#define PROFILE_THREAD(name) \
+	Profiler::SetThreadName(name)
+
+#else
+
+// statements of their own, so 'if (x) PROFILE_FRAME();' doesn't leave an empty body
+#define PROFILE_ZONE(name) do { } while (0)
+#define PROFILE_COUNTER(name, value) do { } while (0)
+#define PROFILE_FRAME() ((void)0)
+#define PROFILE_THREAD(name) ((void)0)
+
+#endif
+
+#endif
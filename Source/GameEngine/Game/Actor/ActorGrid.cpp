@@ -0,0 +1,140 @@
+#include "ActorGrid.h"
+
+namespace
+{
+	// cell coordinates are packed in 21 bits each around the origin
+	int const CellBits = 21;
+	int const CellOffset = 1 << (CellBits - 1);
+	int const CellMask = (1 << CellBits) - 1;
+}
+
+ActorGrid::ActorGrid(float cellSize)
+	: mCellSize(cellSize)
+{
+
+}
+
+int ActorGrid::GetCoordinate(float value) const
+{
+	int coordinate = (int)floor(value / mCellSize);
+	return eastl::min(eastl::max(coordinate, -CellOffset), CellOffset - 1);
+}
+
+ActorGrid::CellKey ActorGrid::GetCell(int x, int y, int z) const
+{
+	return ((CellKey)((x + CellOffset) & CellMask) << (2 * CellBits)) |
+		((CellKey)((y + CellOffset) & CellMask) << CellBits) |
+		(CellKey)((z + CellOffset) & CellMask);
+}
+
+ActorGrid::CellKey ActorGrid::GetCell(Vector3<float> const& position) const
+{
+	return GetCell(
+		GetCoordinate(position[0]), GetCoordinate(position[1]), GetCoordinate(position[2]));
+}
+
+void ActorGrid::Move(ActorId id, Vector3<float> const& position)
+{
+	CellKey cell = GetCell(position);
+
+	auto findIt = mActors.find(id);
+	if (findIt != mActors.end())
+	{
+		Entry& entry = findIt->second;
+		entry.mPosition = position;
+		if (entry.mCell == cell)
+			return;
+
+		RemoveFromCell(entry.mCell, id);
+		entry.mCell = cell;
+	}
+	else
+	{
+		Entry entry;
+		entry.mPosition = position;
+		entry.mCell = cell;
+		mActors[id] = entry;
+	}
+	mCells[cell].push_back(id);
+}
+
+void ActorGrid::Remove(ActorId id)
+{
+	auto findIt = mActors.find(id);
+	if (findIt == mActors.end())
+		return;
+
+	RemoveFromCell(findIt->second.mCell, id);
+	mActors.erase(findIt);
+}
+
+void ActorGrid::Clear()
+{
+	mCells.clear();
+	mActors.clear();
+}
+
+void ActorGrid::RemoveFromCell(CellKey cell, ActorId id)
+{
+	auto cellIt = mCells.find(cell);
+	if (cellIt == mCells.end())
+		return;
+
+	eastl::vector<ActorId>& actors = cellIt->second;
+	auto it = eastl::find(actors.begin(), actors.end(), id);
+	if (it != actors.end())
+	{
+		*it = actors.back();
+		actors.pop_back();
+	}
+
+	if (actors.empty())
+		mCells.erase(cellIt);
+}
+
+void ActorGrid::Query(Vector3<float> const& center, float radius, eastl::vector<ActorId>& actors) const
+{
+	size_t first = actors.size();
+	float const radiusSquared = radius * radius;
+
+	int x0 = GetCoordinate(center[0] - radius), x1 = GetCoordinate(center[0] + radius);
+	int y0 = GetCoordinate(center[1] - radius), y1 = GetCoordinate(center[1] + radius);
+	int z0 = GetCoordinate(center[2] - radius), z1 = GetCoordinate(center[2] + radius);
+
+	// a sphere covering more cells than there are actors is cheaper to test actor by actor
+	unsigned long long numCells =
+		(unsigned long long)(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1);
+	if (numCells > mActors.size())
+	{
+		for (auto const& actor : mActors)
+		{
+			Vector3<float> delta = actor.second.mPosition - center;
+			if (Dot(delta, delta) <= radiusSquared)
+				actors.push_back(actor.first);
+		}
+	}
+	else
+	{
+		for (int x = x0; x <= x1; x++)
+		{
+			for (int y = y0; y <= y1; y++)
+			{
+				for (int z = z0; z <= z1; z++)
+				{
+					auto cellIt = mCells.find(GetCell(x, y, z));
+					if (cellIt == mCells.end())
+						continue;
+
+					for (ActorId id : cellIt->second)
+					{
+						Vector3<float> delta = mActors.find(id)->second.mPosition - center;
+						if (Dot(delta, delta) <= radiusSquared)
+							actors.push_back(id);
+					}
+				}
+			}
+		}
+	}
+
+	eastl::sort(actors.begin() + first, actors.end());
+}
@@ -0,0 +1,53 @@
+#ifndef ACTORGRID_H
+#define ACTORGRID_H
+
+#include "GameEngineStd.h"
+
+#include "Game/GameStd.h"
+
+#include "Mathematic/Algebra/Vector3.h"
+
+/*
+	ActorGrid is a loose grid over the positions of the actors, used to find the actors
+	around a point without going through all of them. An actor is kept only in the cell
+	which contains its position, whatever its size, and moving inside a cell only updates
+	the position. Cells are hashed by their coordinates so the grid has no bounds and only
+	the cells with actors take memory. The game logic keeps the grid up to date with the
+	transforms synchronized from the physics.
+*/
+class ActorGrid
+{
+public:
+	ActorGrid(float cellSize = 128.f);
+
+	// Places the actor at the position, adding it if it isn't in the grid
+	void Move(ActorId id, Vector3<float> const& position);
+	void Remove(ActorId id);
+	void Clear();
+
+	// Actors whose position is within the radius of the center, in increasing id order
+	void Query(Vector3<float> const& center, float radius, eastl::vector<ActorId>& actors) const;
+
+	unsigned int GetNumActors() const { return (unsigned int)mActors.size(); }
+
+private:
+	typedef unsigned long long CellKey;
+
+	struct Entry
+	{
+		Vector3<float> mPosition;
+		CellKey mCell;
+	};
+
+	int GetCoordinate(float value) const;
+	CellKey GetCell(int x, int y, int z) const;
+	CellKey GetCell(Vector3<float> const& position) const;
+
+	void RemoveFromCell(CellKey cell, ActorId id);
+
+	float mCellSize;
+	eastl::hash_map<CellKey, eastl::vector<ActorId>> mCells;
+	eastl::hash_map<ActorId, Entry> mActors;
+};
+
+#endif
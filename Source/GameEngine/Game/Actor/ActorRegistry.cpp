@@ -0,0 +1,88 @@
+#include "ActorRegistry.h"
+
+namespace
+{
+	ActorRegistry::ActorList const EmptyList;
+
+	bool CompareActorId(eastl::shared_ptr<Actor> const& pActor, ActorId id)
+	{
+		return pActor->GetId() < id;
+	}
+}
+
+eastl::map<ActorType, ActorTypeId> ActorRegistry::msTypeIds;
+std::mutex ActorRegistry::msTypeIdsMutex;
+
+ActorTypeId ActorRegistry::GetTypeId(ActorType const& type)
+{
+	std::lock_guard<std::mutex> lock(msTypeIdsMutex);
+
+	auto findIt = msTypeIds.find(type);
+	if (findIt != msTypeIds.end())
+		return findIt->second;
+
+	ActorTypeId typeId = (ActorTypeId)msTypeIds.size();
+	msTypeIds[type] = typeId;
+	return typeId;
+}
+
+void ActorRegistry::Add(eastl::shared_ptr<Actor> const& pActor)
+{
+	Insert(mTypes[GetTypeId(pActor->GetType())], pActor);
+
+	for (auto const& component : *pActor->GetComponents())
+		Insert(mComponents[component.first], pActor);
+}
+
+void ActorRegistry::Remove(eastl::shared_ptr<Actor> const& pActor)
+{
+	auto typeIt = mTypes.find(GetTypeId(pActor->GetType()));
+	if (typeIt != mTypes.end())
+		Erase(typeIt->second, pActor->GetId());
+
+	for (auto const& component : *pActor->GetComponents())
+	{
+		auto componentIt = mComponents.find(component.first);
+		if (componentIt != mComponents.end())
+			Erase(componentIt->second, pActor->GetId());
+	}
+}
+
+void ActorRegistry::Clear()
+{
+	mTypes.clear();
+	mComponents.clear();
+}
+
+ActorRegistry::ActorList const& ActorRegistry::GetActors(ActorTypeId type) const
+{
+	auto findIt = mTypes.find(type);
+	return findIt != mTypes.end() ? findIt->second : EmptyList;
+}
+
+ActorRegistry::ActorList const& ActorRegistry::GetActorsWithComponent(ComponentId id) const
+{
+	auto findIt = mComponents.find(id);
+	return findIt != mComponents.end() ? findIt->second : EmptyList;
+}
+
+void ActorRegistry::Insert(ActorList& actors, eastl::shared_ptr<Actor> const& pActor)
+{
+	// actors are created with increasing ids so they are almost always appended
+	if (actors.empty() || actors.back()->GetId() < pActor->GetId())
+	{
+		actors.push_back(pActor);
+		return;
+	}
+
+	auto it = eastl::lower_bound(actors.begin(), actors.end(), pActor->GetId(), CompareActorId);
+	if (it == actors.end() || (*it)->GetId() != pActor->GetId())
+		actors.insert(it, pActor);
+}
+
+void ActorRegistry::Erase(ActorList& actors, ActorId id)
+{
+	auto it = eastl::lower_bound(actors.begin(), actors.end(), id, CompareActorId);
+	if (it != actors.end() && (*it)->GetId() == id)
+		actors.erase(it);
+}
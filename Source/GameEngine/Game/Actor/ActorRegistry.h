@@ -0,0 +1,47 @@
+#ifndef ACTORREGISTRY_H
+#define ACTORREGISTRY_H
+
+#include "GameEngineStd.h"
+
+#include "Game/GameStd.h"
+
+#include "Actor.h"
+
+#include <mutex>
+
+typedef unsigned int ActorTypeId;
+
+/*
+	ActorRegistry indexes the actors of the game logic by type and by component, so the game
+	finds all the actors of a kind without going through every actor and comparing type
+	names. Type names are interned into ids once, the lists are kept in increasing actor id
+	order, the same order in which the actor map is iterated. The game logic adds the actors
+	when they are created and removes them when they are destroyed.
+*/
+class ActorRegistry
+{
+public:
+	typedef eastl::vector<eastl::shared_ptr<Actor>> ActorList;
+
+	// Id of the actor type, the same name always gives the same id
+	static ActorTypeId GetTypeId(ActorType const& type);
+
+	void Add(eastl::shared_ptr<Actor> const& pActor);
+	void Remove(eastl::shared_ptr<Actor> const& pActor);
+	void Clear();
+
+	ActorList const& GetActors(ActorTypeId type) const;
+	ActorList const& GetActorsWithComponent(ComponentId id) const;
+
+private:
+	static void Insert(ActorList& actors, eastl::shared_ptr<Actor> const& pActor);
+	static void Erase(ActorList& actors, ActorId id);
+
+	eastl::hash_map<ActorTypeId, ActorList> mTypes;
+	eastl::hash_map<ComponentId, ActorList> mComponents;
+
+	static eastl::map<ActorType, ActorTypeId> msTypeIds;
+	static std::mutex msTypeIdsMutex;
+};
+
+#endif
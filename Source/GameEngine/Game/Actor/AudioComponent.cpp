@@ -52,6 +52,7 @@ AudioComponent::AudioComponent()
 	mLooping = false;
 	mFadeTime = 0;
 	mVolume = 80;
+	mPriority = 0;
 }
 
 bool AudioComponent::Init(tinyxml2::XMLElement* pData)
@@ -101,6 +102,13 @@ bool AudioComponent::Init(tinyxml2::XMLElement* pData)
 		mVolume = atoi(value.c_str());
 	}
 
+	tinyxml2::XMLElement* pPriority = pData->FirstChildElement("Priority");
+	if (pPriority)
+	{
+		eastl::string value = pPriority->FirstChild()->Value();
+		mPriority = atoi(value.c_str());
+	}
+
 	return true;
 }
 
@@ -138,6 +146,11 @@ tinyxml2::XMLElement* AudioComponent::GenerateXml(void)
     pVolumeNode->LinkEndChild(pVolumeText);
     pBaseElement->LinkEndChild(pVolumeNode);
 
+	tinyxml2::XMLElement* pPriorityNode = doc.NewElement("Priority");
+	tinyxml2::XMLText* pPriorityText = doc.NewText(eastl::to_string(mPriority).c_str());
+	pPriorityNode->LinkEndChild(pPriorityText);
+	pBaseElement->LinkEndChild(pPriorityNode);
+
 	return pBaseElement;
 }
 
@@ -168,7 +181,7 @@ void AudioComponent::PostInit()
 				BaseResource resource(ToWideString(audio.c_str()));
 				eastl::shared_ptr<ResHandle> rh = ResCache::Get()->GetHandle(&resource);
 
-				eastl::shared_ptr<SoundProcess> sound(new SoundProcess(rh, mVolume, mLooping));
+				eastl::shared_ptr<SoundProcess> sound(new SoundProcess(rh, mVolume, mLooping, mPriority));
 				processManager->AttachProcess(sound);
 
 				// fade process
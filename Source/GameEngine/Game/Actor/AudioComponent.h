@@ -53,6 +53,7 @@ class AudioComponent : public ActorComponent
 	bool mLooping;
 	int mFadeTime;
 	int mVolume;
+	int mPriority;
 
 public:
 	static const char *Name;
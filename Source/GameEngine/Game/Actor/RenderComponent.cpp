@@ -65,6 +65,7 @@ MeshRenderComponent::MeshRenderComponent(void)
 {
 	mMaterialType = 0;
 	mAnimatorType = 0;
+	mHardwareMorphing = false;
 }
 
 bool MeshRenderComponent::DelegateInit(tinyxml2::XMLElement* pData)
@@ -107,6 +108,13 @@ bool MeshRenderComponent::DelegateInit(tinyxml2::XMLElement* pData)
 		}
 	}
 
+	tinyxml2::XMLElement* pMorphing = pData->FirstChildElement("Morphing");
+	if (pMorphing)
+	{
+		bool hardware = false;
+		mHardwareMorphing = pMorphing->BoolAttribute("hardware", hardware);
+	}
+
     return true;
 }
 
@@ -217,6 +225,14 @@ eastl::shared_ptr<Node> MeshRenderComponent::CreateSceneNode(void)
 		}
 		else
 		{
+			// the frames of the md3 meshes are blended by the vertex shader. It
+			// applies to every node of the mesh, so it is set before the node
+			// is created
+			eastl::shared_ptr<AnimateMeshMD3> meshMD3 =
+				eastl::dynamic_shared_pointer_cast<AnimateMeshMD3>(mesh);
+			if (meshMD3 && mHardwareMorphing)
+				meshMD3->GetMD3Mesh()->SetHardwareMorphing(true);
+
 			// create an animated mesh scene node with specified animated mesh.
 			meshNode = pScene->AddAnimatedMeshNode(
 				wbrcp, 0, eastl::dynamic_shared_pointer_cast<BaseAnimatedMesh>(mesh), mOwner->GetId());
@@ -272,6 +288,10 @@ void MeshRenderComponent::CreateInheritedXMLElements(
 	pAnimatorElement->LinkEndChild(pAnimation);
 
 	pBaseElement->LinkEndChild(pAnimatorElement);
+
+	tinyxml2::XMLElement* pMorphing = doc.NewElement("Morphing");
+	pMorphing->SetAttribute("hardware", mHardwareMorphing);
+	pBaseElement->LinkEndChild(pMorphing);
 }
 
 //---------------------------------------------------------------------------------------------------------------------
@@ -59,6 +59,7 @@ class MeshRenderComponent : public BaseRenderComponent
 	unsigned int mMaterialType;
 
 	int mAnimatorType;
+	bool mHardwareMorphing;
 
 public:
 	static const char *Name;
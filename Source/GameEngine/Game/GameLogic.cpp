@@ -49,6 +49,7 @@
 #include "Game/GameOption.h"
 #include "Game/Actor/Actor.h"
 #include "Game/Actor/ActorFactory.h"
+#include "Game/Actor/TransformComponent.h"
 #include "Game/Level/LevelManager.h"
 
 #include "AI/AIManager.h"
@@ -127,6 +128,8 @@ GameLogic::~GameLogic()
     for (auto it = mActors.begin(); it != mActors.end(); ++it)
         it->second->Destroy();
     mActors.clear();
+	mActorRegistry.Clear();
+	mActorGrid.Clear();
 
    BaseEventManager::Get()->RemoveListener(
 	   MakeDelegate(this, &GameLogic::RequestDestroyActorDelegate), 
@@ -259,7 +262,7 @@ eastl::shared_ptr<Actor> GameLogic::CreateActor(const eastl::string &actorResour
 		ToWideString(actorResource.c_str()).c_str(), overrides, initialTransform, serversActorId);
     if (pActor)
     {
-        mActors.insert(eastl::make_pair(pActor->GetId(), pActor));
+		AddActor(pActor);
 		if (!mIsProxy && (mGameState==BGS_SPAWNINGPLAYERACTORS || mGameState==BGS_RUNNING))
 		{
 			eastl::shared_ptr<EventDataRequestNewActor> pNewActor(
@@ -285,11 +288,25 @@ void GameLogic::DestroyActor(const ActorId actorId)
     auto findIt = mActors.find(actorId);
     if (findIt != mActors.end())
     {
+		mActorRegistry.Remove(findIt->second);
+		mActorGrid.Remove(actorId);
+
         findIt->second->Destroy();
         mActors.erase(findIt);
     }
 }
 
+void GameLogic::AddActor(const eastl::shared_ptr<Actor>& pActor)
+{
+	mActors.insert(eastl::make_pair(pActor->GetId(), pActor));
+	mActorRegistry.Add(pActor);
+
+	eastl::shared_ptr<TransformComponent> pTransformComponent(
+		pActor->GetComponent<TransformComponent>(TransformComponent::Name).lock());
+	if (pTransformComponent)
+		mActorGrid.Move(pActor->GetId(), pTransformComponent->GetPosition());
+}
+
 eastl::weak_ptr<Actor> GameLogic::GetActor(const ActorId actorId)
 {
     ActorMap::iterator findIt = mActors.find(actorId);
@@ -308,7 +325,10 @@ void GameLogic::ModifyActor(const ActorId actorId, tinyxml2::XMLElement* overrid
 	auto findIt = mActors.find(actorId);
     if (findIt != mActors.end())
     {
+		// the overrides may add components
+		mActorRegistry.Remove(findIt->second);
 		mActorFactory->ModifyActor(findIt->second, overrides);
+		mActorRegistry.Add(findIt->second);
 	}
 }
 
@@ -491,6 +511,12 @@ void GameLogic::RequestDestroyActorDelegate(BaseEventDataPtr pEventData)
     DestroyActor(pCastEventData->GetActorId());
 }
 
+void GameLogic::SyncActor(const ActorId id, Transform const &transform)
+{
+	if (mActors.find(id) != mActors.end())
+		mActorGrid.Move(id, transform.GetTranslation());
+}
+
 void GameLogic::SyncActorDelegate(BaseEventDataPtr pEventData)
 {
 	eastl::shared_ptr<EventDataSyncActor> pCastEventData =
@@ -44,6 +44,8 @@
 #include "Core/Process/ProcessManager.h"
 #include "Core/Event/EventManager.h"
 #include "Game/Actor/Actor.h"
+#include "Game/Actor/ActorGrid.h"
+#include "Game/Actor/ActorRegistry.h"
 
 #include "Mathematic/Algebra/Transform.h"
 #include "Mathematic/Algebra/Matrix4x4.h"
@@ -117,7 +119,11 @@ public:
 	virtual eastl::weak_ptr<Actor> GetActor(const ActorId actorId);
 	virtual void ModifyActor(const ActorId actorId, tinyxml2::XMLElement *overrides);
 
-	virtual void SyncActor(const ActorId id, Transform const &transform) {}
+	virtual void SyncActor(const ActorId id, Transform const &transform);
+
+	// actors by type and component, and by position
+	const ActorRegistry& GetActorRegistry() const { return mActorRegistry; }
+	const ActorGrid& GetActorGrid() const { return mActorGrid; }
 
 	// editor functions
 	eastl::string GetActorXml(const ActorId id);
@@ -171,9 +177,14 @@ protected:
 	void SyncActorDelegate(BaseEventDataPtr pEventData);
 	void RequestNewActorDelegate(BaseEventDataPtr pEventData);
 
+	// adds a created actor to the actor map and to the actor indices
+	void AddActor(const eastl::shared_ptr<Actor>& pActor);
+
 	float mLifetime;								//indicates how long this game has been in session
 
 	ActorMap mActors;
+	ActorRegistry mActorRegistry;
+	ActorGrid mActorGrid;							// positions synchronized from the physics
 	ActorId mLastActorId;
 	BaseGameState mGameState;							// game state: loading, running, etc.
 	int mExpectedPlayers;							// how many local human players
@@ -52,6 +52,8 @@ GameOption::GameOption()
 
 	mSoundEffectsVolume = 1.0f;			
 	mMusicVolume = 1.0f;	
+	mAudioSystem = "DirectSound";
+	mAudioVoices = 32;
 
 	mGameHost = "GameHost";
 	mExpectedPlayers = 1;
@@ -96,6 +98,12 @@ void GameOption::Init(const wchar_t* xmlFileName)
 		{
 			mMusicVolume = atoi(pNode->Attribute("MusicVolume")) / 100.0f;
 			mSoundEffectsVolume = atoi(pNode->Attribute("SFXVolume")) / 100.0f;
+
+			if (pNode->Attribute("System"))
+				mAudioSystem = pNode->Attribute("System");
+			mAudioVoices = pNode->UnsignedAttribute("Voices", mAudioVoices);
+			if (pNode->Attribute("Capture"))
+				mAudioCapture = pNode->Attribute("Capture");
 		}
 
 		pNode = mRoot->FirstChildElement("Multiplayer"); 
@@ -109,5 +117,12 @@ void GameOption::Init(const wchar_t* xmlFileName)
 			mListenPort = atoi(pNode->Attribute("ListenPort"));
 			mGameHost = pNode->Attribute("GameHost");
 		}
+
+		pNode = mRoot->FirstChildElement("Profiler");
+		if (pNode)
+		{
+			if (pNode->Attribute("Capture"))
+				mProfilerCapture = pNode->Attribute("Capture");
+		}
 	}
 }
\ No newline at end of file
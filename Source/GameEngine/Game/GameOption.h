@@ -68,6 +68,16 @@ struct GameOption
 	float mSoundEffectsVolume;			
 	float mMusicVolume;				
 
+	//! Audio system which plays the sounds, "DirectSound" or the software "Mixer"
+	/* Default value: DirectSound */
+	eastl::string mAudioSystem;
+	//! Voices of the software mixer, the least important sounds are stolen past it
+	/* Default value: 32 */
+	unsigned int mAudioVoices;
+	//! Wav file the software mixer writes to instead of the sound card.
+	//! Default: empty, the mixer plays on the sound card
+	eastl::string mAudioCapture;
+
 	// Multiplayer options				
 	eastl::string mGameHost;
 	eastl::string mGameHostListenPort;
@@ -79,6 +89,12 @@ struct GameOption
 	int mMaxAIs;
 	int mMaxPlayers;
 
+	// Profiler options
+	
+	//! Capture file written while the game runs, and exported as a Chrome trace
+	//! next to it on exit. Default: empty, no capture
+	eastl::string mProfilerCapture;
+
 	// XMLElement - look at this to find other options added by the developer
 	tinyxml2::XMLElement *mRoot;
 
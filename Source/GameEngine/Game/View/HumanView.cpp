@@ -43,7 +43,9 @@
 
 //events related
 #include "Audio/DirectSoundAudio.h"
+#include "Audio/MixerAudio.h"
 #include "Audio/SoundProcess.h"
+#include "Audio/WaveOutAudioDevice.h"
 
 #include "Application/GameApplication.h"
 #include "Application/System/System.h"
@@ -194,7 +196,21 @@ bool HumanView::InitAudio()
 {
 	Audio* audioSystem = Audio::Get();
 	if (!audioSystem)
-		audioSystem = new DirectSoundAudio();		// use this line for DirectSound
+	{
+		GameApplication* gameApp = (GameApplication*)Application::App;
+		if (gameApp->mOption.mAudioSystem == "Mixer")
+		{
+			// the software mixer plays on the sound card, or records into a wav file
+			eastl::shared_ptr<BaseAudioDevice> device;
+			if (!gameApp->mOption.mAudioCapture.empty())
+				device = eastl::make_shared<WaveFileAudioDevice>(gameApp->mOption.mAudioCapture);
+			else
+				device = eastl::make_shared<WaveOutAudioDevice>();
+			audioSystem = new MixerAudio(device, gameApp->mOption.mAudioVoices);
+		}
+		else
+			audioSystem = new DirectSoundAudio();
+	}
 
 	if (!audioSystem)
 		return false;
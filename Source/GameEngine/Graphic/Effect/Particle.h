@@ -46,5 +46,128 @@ struct GRAPHIC_ITEM Particle
 	Vector2<float> mStartSize;
 };
 
+//! Particles stored as a structure of arrays.
+/** Every member of Particle is split into one array per component, so that the
+affectors and the particle system stream through the members they touch and
+process several particles at once. Particles are removed by moving the last
+one into their slot, their order is not preserved. */
+struct GRAPHIC_ITEM ParticleArray
+{
+	eastl::vector<float> mPos[3];
+	eastl::vector<float> mVector[3];
+	eastl::vector<unsigned int> mStartTime;
+	eastl::vector<unsigned int> mEndTime;
+	eastl::vector<float> mColor[4];
+	eastl::vector<float> mStartColor[4];
+	eastl::vector<float> mStartVector[3];
+	eastl::vector<float> mSize[2];
+	eastl::vector<float> mStartSize[2];
+
+	//! Returns the amount of particles.
+	unsigned int Size() const { return (unsigned int)mStartTime.size(); }
+
+	//! Changes the amount of particles, new particles are undefined.
+	void Resize(unsigned int size)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			mPos[i].resize(size);
+			mVector[i].resize(size);
+			mStartVector[i].resize(size);
+		}
+		for (int i = 0; i < 4; ++i)
+		{
+			mColor[i].resize(size);
+			mStartColor[i].resize(size);
+		}
+		for (int i = 0; i < 2; ++i)
+		{
+			mSize[i].resize(size);
+			mStartSize[i].resize(size);
+		}
+		mStartTime.resize(size);
+		mEndTime.resize(size);
+	}
+
+	//! Removes all particles.
+	void Clear() { Resize(0); }
+
+	//! Stores the particle at index i.
+	void Set(unsigned int i, const Particle& particle)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			mPos[j][i] = particle.mPos[j];
+			mVector[j][i] = particle.mVector[j];
+			mStartVector[j][i] = particle.mStartVector[j];
+		}
+		for (int j = 0; j < 4; ++j)
+		{
+			mColor[j][i] = particle.mColor[j];
+			mStartColor[j][i] = particle.mStartColor[j];
+		}
+		for (int j = 0; j < 2; ++j)
+		{
+			mSize[j][i] = particle.mSize[j];
+			mStartSize[j][i] = particle.mStartSize[j];
+		}
+		mStartTime[i] = particle.mStartTime;
+		mEndTime[i] = particle.mEndTime;
+	}
+
+	//! Gathers the particle at index i.
+	Particle Get(unsigned int i) const
+	{
+		Particle particle;
+		for (int j = 0; j < 3; ++j)
+		{
+			particle.mPos[j] = mPos[j][i];
+			particle.mVector[j] = mVector[j][i];
+			particle.mStartVector[j] = mStartVector[j][i];
+		}
+		for (int j = 0; j < 4; ++j)
+		{
+			particle.mColor[j] = mColor[j][i];
+			particle.mStartColor[j] = mStartColor[j][i];
+		}
+		for (int j = 0; j < 2; ++j)
+		{
+			particle.mSize[j] = mSize[j][i];
+			particle.mStartSize[j] = mStartSize[j][i];
+		}
+		particle.mStartTime = mStartTime[i];
+		particle.mEndTime = mEndTime[i];
+		return particle;
+	}
+
+	//! Removes the particle at index i by moving the last particle into it.
+	void Remove(unsigned int i)
+	{
+		unsigned int last = Size() - 1;
+		if (i != last)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				mPos[j][i] = mPos[j][last];
+				mVector[j][i] = mVector[j][last];
+				mStartVector[j][i] = mStartVector[j][last];
+			}
+			for (int j = 0; j < 4; ++j)
+			{
+				mColor[j][i] = mColor[j][last];
+				mStartColor[j][i] = mStartColor[j][last];
+			}
+			for (int j = 0; j < 2; ++j)
+			{
+				mSize[j][i] = mSize[j][last];
+				mStartSize[j][i] = mStartSize[j][last];
+			}
+			mStartTime[i] = mStartTime[last];
+			mEndTime[i] = mEndTime[last];
+		}
+		Resize(last);
+	}
+};
+
 #endif
 
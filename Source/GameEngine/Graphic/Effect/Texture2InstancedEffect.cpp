@@ -0,0 +1,55 @@
+#include "Texture2InstancedEffect.h"
+
+Texture2InstancedEffect::Texture2InstancedEffect(eastl::shared_ptr<ProgramFactory> const& factory,
+    eastl::vector<eastl::string> path, eastl::shared_ptr<Texture2> const& texture,
+    SamplerState::Filter filter, SamplerState::Mode mode0, SamplerState::Mode mode1)
+    :
+    mPVMatrix(nullptr),
+    mInstances(nullptr)
+{
+    eastl::string vsPath = path[0];
+    eastl::string psPath = path[1];
+    eastl::string gsPath = "";
+    mProgram = factory->CreateFromFiles(vsPath, psPath, gsPath);
+    if (mProgram)
+    {
+        mPVMatrixConstant = eastl::make_shared<ConstantBuffer>(sizeof(Matrix4x4<float>), true);
+        mPVMatrix = mPVMatrixConstant->Get<Matrix4x4<float>>();
+        *mPVMatrix = Matrix4x4<float>::Identity();
+
+        mInstancesConstant = eastl::make_shared<ConstantBuffer>(sizeof(InstanceData), true);
+        mInstances = mInstancesConstant->Get<InstanceData>();
+        for (unsigned int i = 0; i < MAX_INSTANCES; ++i)
+        {
+            mInstances->worldMatrix[i] = Matrix4x4<float>::Identity();
+            mInstances->color[i] = Vector4<float>{ 1.0f, 1.0f, 1.0f, 1.0f };
+        }
+
+        mSampler = eastl::make_shared<SamplerState>();
+        mSampler->mFilter = filter;
+        mSampler->mMode[0] = mode0;
+        mSampler->mMode[1] = mode1;
+
+        mProgram->GetVShader()->Set("PVMatrix", mPVMatrixConstant);
+        mProgram->GetVShader()->Set("Instances", mInstancesConstant);
+        SetTexture(texture);
+    }
+}
+
+void Texture2InstancedEffect::SetTexture(eastl::shared_ptr<Texture2> const& texture)
+{
+    mTexture = texture;
+#if defined(_OPENGL_)
+    mProgram->GetPShader()->Set("baseSampler", mTexture);
+    mProgram->GetPShader()->Set("baseSampler", mSampler);
+#else
+    mProgram->GetPShader()->Set("baseTexture", mTexture);
+    mProgram->GetPShader()->Set("baseSampler", mSampler);
+#endif
+}
+
+void Texture2InstancedEffect::SetSampler(eastl::shared_ptr<SamplerState> const& sampler)
+{
+    mSampler = sampler;
+    mProgram->GetPShader()->Set("baseSampler", mSampler);
+}
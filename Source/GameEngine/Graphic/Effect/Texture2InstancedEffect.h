@@ -0,0 +1,97 @@
+#ifndef TEXTURE2INSTANCEDEFFECT_H
+#define TEXTURE2INSTANCEDEFFECT_H
+
+#include "Mathematic/Algebra/Matrix4x4.h"
+
+#include "Graphic/Resource/Texture/Texture2.h"
+#include "Graphic/Effect/VisualEffect.h"
+
+// Instanced version of Texture2Effect.  The projection-view matrix is
+// shared by every instance and the world matrix and color of each instance
+// live in a dynamic constant buffer which the shaders index by instance id,
+// so one DrawInstanced call renders up to MAX_INSTANCES copies of a mesh.
+class GRAPHIC_ITEM Texture2InstancedEffect : public VisualEffect
+{
+public:
+    enum { MAX_INSTANCES = 128 };
+
+    // Construction.
+    Texture2InstancedEffect(eastl::shared_ptr<ProgramFactory> const& factory,
+        eastl::vector<eastl::string> path, eastl::shared_ptr<Texture2> const& texture,
+        SamplerState::Filter filter, SamplerState::Mode mode0, SamplerState::Mode mode1);
+
+    // Member access.  The instance index must be smaller than MAX_INSTANCES.
+    inline void SetPVMatrix(Matrix4x4<float> const& pvMatrix);
+    inline Matrix4x4<float> const& GetPVMatrix() const;
+    inline void SetInstance(unsigned int i,
+        Matrix4x4<float> const& worldMatrix, Vector4<float> const& color);
+
+    // Required to bind and update resources.
+    inline eastl::shared_ptr<ConstantBuffer> const& GetPVMatrixConstant() const;
+    inline eastl::shared_ptr<ConstantBuffer> const& GetInstancesConstant() const;
+    inline eastl::shared_ptr<Texture2> const& GetTexture() const;
+    inline eastl::shared_ptr<SamplerState> const& GetSampler() const;
+
+    void SetTexture(eastl::shared_ptr<Texture2> const& texture);
+    void SetSampler(eastl::shared_ptr<SamplerState> const& sampler);
+
+private:
+    struct InstanceData
+    {
+        Matrix4x4<float> worldMatrix[MAX_INSTANCES];
+        Vector4<float> color[MAX_INSTANCES];
+    };
+
+    // Vertex shader parameters.
+    eastl::shared_ptr<ConstantBuffer> mPVMatrixConstant;
+    eastl::shared_ptr<ConstantBuffer> mInstancesConstant;
+
+    // Pixel shader parameters.
+    eastl::shared_ptr<Texture2> mTexture;
+    eastl::shared_ptr<SamplerState> mSampler;
+
+    // Convenience pointers.
+    Matrix4x4<float>* mPVMatrix;
+    InstanceData* mInstances;
+};
+
+
+inline void Texture2InstancedEffect::SetPVMatrix(Matrix4x4<float> const& pvMatrix)
+{
+    *mPVMatrix = pvMatrix;
+}
+
+inline Matrix4x4<float> const& Texture2InstancedEffect::GetPVMatrix() const
+{
+    return *mPVMatrix;
+}
+
+inline void Texture2InstancedEffect::SetInstance(unsigned int i,
+    Matrix4x4<float> const& worldMatrix, Vector4<float> const& color)
+{
+    LogAssert(i < MAX_INSTANCES, "Invalid instance index.");
+    mInstances->worldMatrix[i] = worldMatrix;
+    mInstances->color[i] = color;
+}
+
+inline eastl::shared_ptr<ConstantBuffer> const& Texture2InstancedEffect::GetPVMatrixConstant() const
+{
+    return mPVMatrixConstant;
+}
+
+inline eastl::shared_ptr<ConstantBuffer> const& Texture2InstancedEffect::GetInstancesConstant() const
+{
+    return mInstancesConstant;
+}
+
+inline eastl::shared_ptr<Texture2> const& Texture2InstancedEffect::GetTexture() const
+{
+    return mTexture;
+}
+
+inline eastl::shared_ptr<SamplerState> const& Texture2InstancedEffect::GetSampler() const
+{
+    return mSampler;
+}
+
+#endif
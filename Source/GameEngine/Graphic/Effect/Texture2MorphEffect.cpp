@@ -0,0 +1,18 @@
+#include "Texture2MorphEffect.h"
+
+Texture2MorphEffect::Texture2MorphEffect(eastl::shared_ptr<ProgramFactory> const& factory,
+    eastl::vector<eastl::string> path, eastl::shared_ptr<Texture2> const& texture,
+    SamplerState::Filter filter, SamplerState::Mode mode0, SamplerState::Mode mode1)
+    :
+    Texture2Effect(factory, path, texture, filter, mode0, mode1),
+    mMorph(nullptr)
+{
+    if (mProgram)
+    {
+        mMorphConstant = eastl::make_shared<ConstantBuffer>(sizeof(Vector4<float>), true);
+        mMorph = mMorphConstant->Get<Vector4<float>>();
+        *mMorph = Vector4<float>::Zero();
+
+        mProgram->GetVShader()->Set("Morph", mMorphConstant);
+    }
+}
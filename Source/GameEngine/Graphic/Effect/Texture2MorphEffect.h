@@ -0,0 +1,50 @@
+#ifndef TEXTURE2MORPHEFFECT_H
+#define TEXTURE2MORPHEFFECT_H
+
+#include "Graphic/Effect/Texture2Effect.h"
+
+// Morph target version of Texture2Effect.  The vertex buffer carries the
+// positions of two key frames, the first as POSITION and the second as
+// TEXCOORD1, and the vertex shader blends them with the interpolation factor
+// of the Morph constant buffer.  Moving between two frames then only updates
+// a constant buffer instead of the vertices.
+class GRAPHIC_ITEM Texture2MorphEffect : public Texture2Effect
+{
+public:
+    // Construction.
+    Texture2MorphEffect(eastl::shared_ptr<ProgramFactory> const& factory,
+        eastl::vector<eastl::string> path, eastl::shared_ptr<Texture2> const& texture,
+        SamplerState::Filter filter, SamplerState::Mode mode0, SamplerState::Mode mode1);
+
+    // Member access.  The factor is 0 at the first frame, 1 at the second.
+    inline void SetInterpolation(float interpolation);
+    inline float GetInterpolation() const;
+
+    // Required to bind and update resources.
+    inline eastl::shared_ptr<ConstantBuffer> const& GetMorphConstant() const;
+
+private:
+    // Vertex shader parameters.
+    eastl::shared_ptr<ConstantBuffer> mMorphConstant;
+
+    // Convenience pointer.
+    Vector4<float>* mMorph;
+};
+
+
+inline void Texture2MorphEffect::SetInterpolation(float interpolation)
+{
+    (*mMorph)[0] = interpolation;
+}
+
+inline float Texture2MorphEffect::GetInterpolation() const
+{
+    return (*mMorph)[0];
+}
+
+inline eastl::shared_ptr<ConstantBuffer> const& Texture2MorphEffect::GetMorphConstant() const
+{
+    return mMorphConstant;
+}
+
+#endif
@@ -638,7 +638,7 @@ bool Dx11Renderer::DestroyBackBuffer()
 		&& FinalRelease(mDepthStencilBuffer) == 0;
 }
 
-uint64_t Dx11Renderer::DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer const* ibuffer)
+uint64_t Dx11Renderer::DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer const* ibuffer, unsigned int numInstances)
 {
 	UINT numActiveVertices = vbuffer->GetNumActiveElements();
 	UINT vertexOffset = vbuffer->GetOffset();
@@ -689,14 +689,28 @@ uint64_t Dx11Renderer::DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer co
 	{
 		if (numActiveIndices > 0)
 		{
-			mDeviceContext->DrawIndexed(numActiveIndices, firstIndex, vertexOffset);
+			if (numInstances > 1)
+			{
+				mDeviceContext->DrawIndexedInstanced(numActiveIndices, numInstances, firstIndex, vertexOffset, 0);
+			}
+			else
+			{
+				mDeviceContext->DrawIndexed(numActiveIndices, firstIndex, vertexOffset);
+			}
 		}
 	}
 	else
 	{
 		if (numActiveVertices > 0)
 		{
-			mDeviceContext->Draw(numActiveVertices, vertexOffset);
+			if (numInstances > 1)
+			{
+				mDeviceContext->DrawInstanced(numActiveVertices, numInstances, vertexOffset, 0);
+			}
+			else
+			{
+				mDeviceContext->Draw(numActiveVertices, vertexOffset);
+			}
 		}
 	}
 
@@ -1135,7 +1149,8 @@ bool Dx11Renderer::Update(eastl::shared_ptr<TextureArray> const& textureArray,
 }
 
 uint64_t Dx11Renderer::DrawPrimitive(eastl::shared_ptr<VertexBuffer> const& vbuffer,
-	eastl::shared_ptr<IndexBuffer> const& ibuffer, eastl::shared_ptr<VisualEffect> const& effect)
+	eastl::shared_ptr<IndexBuffer> const& ibuffer, eastl::shared_ptr<VisualEffect> const& effect,
+	unsigned int numInstances)
 {
 	uint64_t numPixelsDrawn = 0;
 	DX11VertexShader* dxVShader;
@@ -1167,7 +1182,7 @@ uint64_t Dx11Renderer::DrawPrimitive(eastl::shared_ptr<VertexBuffer> const& vbuf
 			dxIBuffer->Enable(mDeviceContext);
 		}
 
-		numPixelsDrawn = DrawPrimitive(vbuffer.get(), ibuffer.get());
+		numPixelsDrawn = DrawPrimitive(vbuffer.get(), ibuffer.get(), numInstances);
 
 		// Disable the vertex buffer and input layout.
 		if (vbuffer->StandardUsage())
@@ -102,7 +102,7 @@ public:
 	virtual void DisplayColorBuffer(unsigned int syncInterval) override;
 
 	// Support for drawing.
-	uint64_t DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer const* ibuffer);
+	uint64_t DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer const* ibuffer, unsigned int numInstances);
 
 	// Support for enabling and disabling resources used by shaders.
 	bool EnableShaders(eastl::shared_ptr<VisualEffect> const& effect,
@@ -156,7 +156,8 @@ protected:
 	virtual uint64_t DrawPrimitive(
 		eastl::shared_ptr<VertexBuffer> const& vbuffer,
 		eastl::shared_ptr<IndexBuffer> const& ibuffer,
-		eastl::shared_ptr<VisualEffect> const& effect) override;
+		eastl::shared_ptr<VisualEffect> const& effect,
+		unsigned int numInstances) override;
 
 private:
 	// Helpers for construction and destruction.
@@ -0,0 +1,428 @@
+#include "Graphic/Graphic.h"
+
+#include "NullRenderer.h"
+
+#include "Graphic/InputLayout/InputLayoutManager.h"
+
+// There are no device objects, so there are no input layouts to manage.
+class NullInputLayoutManager : public InputLayoutManager
+{
+public:
+    virtual bool Unbind(VertexBuffer const*) override { return false; }
+    virtual bool Unbind(Shader const*) override { return false; }
+    virtual void UnbindAll() override { }
+    virtual bool HasElements() const override { return false; }
+};
+
+//----------------------------------------------------------------------------
+// Interface specific to the null renderer.
+//----------------------------------------------------------------------------
+NullRenderer::~NullRenderer()
+{
+    if (mDefaultFont)
+    {
+        mDefaultFont = nullptr;
+        mActiveFont = nullptr;
+    }
+    DestroyDefaultGlobalState();
+
+    GraphicObject::UnsubscribeForDestruction(mGOListener);
+    mGOListener = nullptr;
+
+    DrawTarget::UnsubscribeForDestruction(mDTListener);
+    mDTListener = nullptr;
+
+    mInputLayouts = nullptr;
+}
+
+NullRenderer::NullRenderer(unsigned int width, unsigned int height)
+    :
+    mViewportX(0),
+    mViewportY(0),
+    mViewportWidth(0),
+    mViewportHeight(0),
+    mDepthRangeMin(0.0f),
+    mDepthRangeMax(1.0f),
+    mRecording(true),
+    mActiveProgram(nullptr),
+    mActiveVBuffer(nullptr),
+    mActiveIBuffer(nullptr)
+{
+    // The creation functions are left null, Bind returns nullptr for every
+    // graphics object because there is no device to create them on.
+    mInputLayouts = eastl::make_unique<NullInputLayoutManager>();
+    mScreenSize = Vector2<unsigned int>{ width, height };
+    mNumMultisamples = 0;
+
+    memset(&mCounters, 0, sizeof(mCounters));
+
+    SetViewport(0, 0, width, height);
+    SetDepthRange(0.0f, 1.0f);
+    CreateDefaultGlobalState();
+    ResetRecording();
+}
+
+void NullRenderer::ResetRecording()
+{
+    mCommands.clear();
+    memset(&mCounters, 0, sizeof(mCounters));
+}
+
+void NullRenderer::Record(CommandType type, unsigned int count, void const* object, void const* effect)
+{
+    if (mRecording)
+    {
+        Command command;
+        command.type = type;
+        command.count = count;
+        command.object = object;
+        command.effect = effect;
+        mCommands.push_back(command);
+    }
+}
+
+void NullRenderer::InvalidateBindings()
+{
+    mActiveProgram = nullptr;
+    mActiveVBuffer = nullptr;
+    mActiveIBuffer = nullptr;
+    mActiveTextures.clear();
+    mActiveSamplers.clear();
+}
+
+void NullRenderer::BindSlot(eastl::vector<void const*>& slots, int slot,
+    void const* object, unsigned int& binds)
+{
+    if (slot < 0)
+    {
+        return;
+    }
+
+    if (slot >= static_cast<int>(slots.size()))
+    {
+        slots.resize(slot + 1, nullptr);
+    }
+
+    if (slots[slot] == object)
+    {
+        ++mCounters.redundantBinds;
+    }
+    else
+    {
+        slots[slot] = object;
+        ++binds;
+    }
+}
+
+void NullRenderer::BindShader(Shader const* shader)
+{
+    for (auto const& ts : shader->GetData(TextureSingle::mShaderDataLookup))
+    {
+        BindSlot(mActiveTextures, ts.bindPoint, ts.object.get(), mCounters.textureBinds);
+    }
+    for (auto const& ta : shader->GetData(TextureArray::mShaderDataLookup))
+    {
+        BindSlot(mActiveTextures, ta.bindPoint, ta.object.get(), mCounters.textureBinds);
+    }
+    for (auto const& ss : shader->GetData(SamplerState::mShaderDataLookup))
+    {
+        BindSlot(mActiveSamplers, ss.bindPoint, ss.object.get(), mCounters.samplerBinds);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Overrides from Renderer.
+//----------------------------------------------------------------------------
+void NullRenderer::SetViewport(int x, int y, int w, int h)
+{
+    mViewportX = x;
+    mViewportY = y;
+    mViewportWidth = w;
+    mViewportHeight = h;
+    Record(RC_SET_VIEWPORT, static_cast<unsigned int>(w * h));
+}
+
+void NullRenderer::GetViewport(int& x, int& y, int& w, int& h) const
+{
+    x = mViewportX;
+    y = mViewportY;
+    w = mViewportWidth;
+    h = mViewportHeight;
+}
+
+void NullRenderer::SetDepthRange(float zmin, float zmax)
+{
+    mDepthRangeMin = zmin;
+    mDepthRangeMax = zmax;
+    Record(RC_SET_DEPTH_RANGE, 0);
+}
+
+void NullRenderer::GetDepthRange(float& zmin, float& zmax) const
+{
+    zmin = mDepthRangeMin;
+    zmax = mDepthRangeMax;
+}
+
+bool NullRenderer::Resize(unsigned int w, unsigned int h)
+{
+    mScreenSize = Vector2<unsigned int>{ w, h };
+    SetViewport(0, 0, w, h);
+    Record(RC_RESIZE, w * h);
+    return true;
+}
+
+void NullRenderer::ClearColorBuffer()
+{
+    ++mCounters.clears;
+    Record(RC_CLEAR, CLEAR_COLOR);
+}
+
+void NullRenderer::ClearDepthBuffer()
+{
+    ++mCounters.clears;
+    Record(RC_CLEAR, CLEAR_DEPTH);
+}
+
+void NullRenderer::ClearStencilBuffer()
+{
+    ++mCounters.clears;
+    Record(RC_CLEAR, CLEAR_STENCIL);
+}
+
+void NullRenderer::ClearBuffers()
+{
+    ++mCounters.clears;
+    Record(RC_CLEAR, CLEAR_COLOR | CLEAR_DEPTH | CLEAR_STENCIL);
+}
+
+void NullRenderer::DisplayColorBuffer(unsigned int syncInterval)
+{
+    ++mCounters.frames;
+    Record(RC_DISPLAY, syncInterval);
+}
+
+void NullRenderer::SetBlendState(eastl::shared_ptr<BlendState> const& state)
+{
+    if (state)
+    {
+        if (state != mActiveBlendState)
+        {
+            mActiveBlendState = state;
+            ++mCounters.stateChanges;
+            Record(RC_SET_BLEND_STATE, 0, state.get());
+        }
+        else
+        {
+            ++mCounters.redundantStateChanges;
+        }
+    }
+    else
+    {
+        LogError("Input state is null.");
+    }
+}
+
+void NullRenderer::SetDepthStencilState(eastl::shared_ptr<DepthStencilState> const& state)
+{
+    if (state)
+    {
+        if (state != mActiveDepthStencilState)
+        {
+            mActiveDepthStencilState = state;
+            ++mCounters.stateChanges;
+            Record(RC_SET_DEPTH_STENCIL_STATE, 0, state.get());
+        }
+        else
+        {
+            ++mCounters.redundantStateChanges;
+        }
+    }
+    else
+    {
+        LogError("Input state is null.");
+    }
+}
+
+void NullRenderer::SetRasterizerState(eastl::shared_ptr<RasterizerState> const& state)
+{
+    if (state)
+    {
+        if (state != mActiveRasterizerState)
+        {
+            mActiveRasterizerState = state;
+            ++mCounters.stateChanges;
+            Record(RC_SET_RASTERIZER_STATE, 0, state.get());
+        }
+        else
+        {
+            ++mCounters.redundantStateChanges;
+        }
+    }
+    else
+    {
+        LogError("Input state is null.");
+    }
+}
+
+void NullRenderer::Enable(eastl::shared_ptr<DrawTarget> const& target)
+{
+    // The textures are released from their units when the target changes.
+    mActiveTextures.clear();
+    mActiveSamplers.clear();
+    ++mCounters.targetChanges;
+    Record(RC_ENABLE_TARGET, target->GetNumTargets(), target.get());
+}
+
+void NullRenderer::Disable(eastl::shared_ptr<DrawTarget> const& target)
+{
+    mActiveTextures.clear();
+    mActiveSamplers.clear();
+    ++mCounters.targetChanges;
+    Record(RC_DISABLE_TARGET, target->GetNumTargets(), target.get());
+}
+
+bool NullRenderer::Update(eastl::shared_ptr<Buffer> const& buffer)
+{
+    if (!buffer->GetData())
+    {
+        LogWarning("Buffer does not have system memory, creating it.");
+        buffer->CreateStorage();
+    }
+
+    unsigned int const numBytes = buffer->GetNumActiveBytes();
+    ++mCounters.bufferUpdates;
+    mCounters.updatedBytes += numBytes;
+    Record(RC_UPDATE_BUFFER, numBytes, buffer.get());
+    return true;
+}
+
+bool NullRenderer::Update(eastl::shared_ptr<TextureSingle> const& texture)
+{
+    if (!texture->GetData())
+    {
+        LogWarning("Texture does not have system memory, creating it.");
+        texture->CreateStorage();
+    }
+
+    unsigned int const numBytes = texture->GetNumBytes();
+    ++mCounters.textureUpdates;
+    mCounters.updatedBytes += numBytes;
+    Record(RC_UPDATE_TEXTURE, numBytes, texture.get());
+    return true;
+}
+
+bool NullRenderer::Update(eastl::shared_ptr<TextureSingle> const& texture, unsigned int level)
+{
+    if (!texture->GetData())
+    {
+        LogWarning("Texture does not have system memory, creating it.");
+        texture->CreateStorage();
+    }
+
+    unsigned int const numBytes = texture->GetNumBytesFor(level);
+    ++mCounters.textureUpdates;
+    mCounters.updatedBytes += numBytes;
+    Record(RC_UPDATE_TEXTURE, numBytes, texture.get());
+    return true;
+}
+
+bool NullRenderer::Update(eastl::shared_ptr<TextureArray> const& textureArray)
+{
+    if (!textureArray->GetData())
+    {
+        LogWarning("Texture array does not have system memory, creating it.");
+        textureArray->CreateStorage();
+    }
+
+    unsigned int const numBytes = textureArray->GetNumBytes();
+    ++mCounters.textureUpdates;
+    mCounters.updatedBytes += numBytes;
+    Record(RC_UPDATE_TEXTURE_ARRAY, numBytes, textureArray.get());
+    return true;
+}
+
+bool NullRenderer::Update(eastl::shared_ptr<TextureArray> const& textureArray, unsigned int item, unsigned int level)
+{
+    if (!textureArray->GetData())
+    {
+        LogWarning("Texture array does not have system memory, creating it.");
+        textureArray->CreateStorage();
+    }
+
+    unsigned int const numBytes = textureArray->GetNumBytesFor(level);
+    ++mCounters.textureUpdates;
+    mCounters.updatedBytes += numBytes;
+    Record(RC_UPDATE_TEXTURE_ARRAY, numBytes, textureArray.get());
+    return true;
+}
+
+uint64_t NullRenderer::DrawPrimitive(eastl::shared_ptr<VertexBuffer> const& vbuffer,
+    eastl::shared_ptr<IndexBuffer> const& ibuffer, eastl::shared_ptr<VisualEffect> const& effect,
+    unsigned int numInstances)
+{
+    unsigned int const numElements = ibuffer->IsIndexed() ?
+        ibuffer->GetNumActiveIndices() : vbuffer->GetNumActiveElements();
+
+    // Account for the binds the same way GL4Renderer caches them.  The
+    // shader slots stand in for the texture and sampler units.
+    if (effect->GetProgram().get() != mActiveProgram)
+    {
+        mActiveProgram = effect->GetProgram().get();
+        mActiveVBuffer = nullptr;
+        ++mCounters.programBinds;
+    }
+    else
+    {
+        ++mCounters.redundantBinds;
+    }
+
+    if (vbuffer.get() != mActiveVBuffer)
+    {
+        mActiveVBuffer = vbuffer.get();
+        mActiveIBuffer = nullptr;
+        ++mCounters.vertexBufferBinds;
+    }
+    else
+    {
+        ++mCounters.redundantBinds;
+    }
+
+    if (ibuffer->IsIndexed())
+    {
+        if (ibuffer.get() != mActiveIBuffer)
+        {
+            mActiveIBuffer = ibuffer.get();
+            ++mCounters.indexBufferBinds;
+        }
+        else
+        {
+            ++mCounters.redundantBinds;
+        }
+    }
+
+    if (effect->GetVertexShader())
+    {
+        BindShader(effect->GetVertexShader().get());
+    }
+    if (effect->GetGeometryShader())
+    {
+        BindShader(effect->GetGeometryShader().get());
+    }
+    if (effect->GetPixelShader())
+    {
+        BindShader(effect->GetPixelShader().get());
+    }
+
+    ++mCounters.draws;
+    mCounters.drawnInstances += numInstances;
+    mCounters.drawnElements += static_cast<uint64_t>(numElements) * numInstances;
+    if (numInstances > 1)
+    {
+        Record(RC_DRAW_INSTANCED, numInstances, vbuffer.get(), effect.get());
+    }
+    else
+    {
+        Record(RC_DRAW, numElements, vbuffer.get(), effect.get());
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+#ifndef NULLRENDERER_H
+#define NULLRENDERER_H
+
+#include "Graphic/Renderer/Renderer.h"
+
+// Renderer without device which doesn't draw anything.  It implements the
+// whole Renderer interface on the CPU so that the scene, the updaters and
+// the draw submission can run without creating a Direct3D or OpenGL
+// context.  The calls that would reach the graphics API are recorded as a
+// compact stream of commands together with counters, which is what
+// benchmarks and draw call regression tests inspect.
+class GRAPHIC_ITEM NullRenderer : public Renderer
+{
+public:
+    // Construction and destruction.
+    virtual ~NullRenderer();
+    NullRenderer(unsigned int width, unsigned int height);
+
+    // Recorded commands.  The meaning of the count and the object depends on
+    // the command type:
+    //   RC_ENABLE_TARGET/RC_DISABLE_TARGET: object is the DrawTarget.
+    //   RC_SET_VIEWPORT: count is width * height of the viewport.
+    //   RC_CLEAR: count is a combination of ClearFlag bits.
+    //   RC_SET_*_STATE: object is the state.
+    //   RC_UPDATE_*: object is the resource, count is the number of bytes.
+    //   RC_DRAW: object is the vertex buffer, effect is the visual effect,
+    //     count is the number of indices (or vertices when not indexed).
+    //   RC_DRAW_INSTANCED: as RC_DRAW, count is the number of instances.
+    //   RC_DISPLAY: count is the sync interval.
+    enum CommandType
+    {
+        RC_ENABLE_TARGET,
+        RC_DISABLE_TARGET,
+        RC_SET_VIEWPORT,
+        RC_SET_DEPTH_RANGE,
+        RC_RESIZE,
+        RC_CLEAR,
+        RC_SET_BLEND_STATE,
+        RC_SET_DEPTH_STENCIL_STATE,
+        RC_SET_RASTERIZER_STATE,
+        RC_UPDATE_BUFFER,
+        RC_UPDATE_TEXTURE,
+        RC_UPDATE_TEXTURE_ARRAY,
+        RC_DRAW,
+        RC_DRAW_INSTANCED,
+        RC_DISPLAY
+    };
+
+    enum ClearFlag
+    {
+        CLEAR_COLOR = 1,
+        CLEAR_DEPTH = 2,
+        CLEAR_STENCIL = 4
+    };
+
+    struct Command
+    {
+        CommandType type;
+        unsigned int count;
+        void const* object;
+        void const* effect;
+    };
+
+    struct Counters
+    {
+        unsigned int frames;
+        unsigned int draws;
+        unsigned int drawnInstances;
+        uint64_t drawnElements;
+        unsigned int stateChanges;
+        unsigned int redundantStateChanges;
+        unsigned int targetChanges;
+        unsigned int bufferUpdates;
+        unsigned int textureUpdates;
+        uint64_t updatedBytes;
+        unsigned int clears;
+
+        // Binds a draw needs after the binding cache of the GL4 renderer is
+        // applied, and the binds the cache skipped.
+        unsigned int programBinds;
+        unsigned int vertexBufferBinds;
+        unsigned int indexBufferBinds;
+        unsigned int textureBinds;
+        unsigned int samplerBinds;
+        unsigned int redundantBinds;
+    };
+
+    // Access to the recording.  The counters are always updated, the
+    // command stream only when recording is enabled (the default).  Neither
+    // is cleared by the renderer, call ResetRecording between frames or
+    // tests.  The emulated bindings persist across ResetRecording, as they
+    // would in a device context.
+    inline eastl::vector<Command> const& GetCommands() const;
+    inline Counters const& GetCounters() const;
+    inline void SetRecording(bool recording);
+    inline bool IsRecording() const;
+    void ResetRecording();
+
+// Overrides from Renderer.
+public:
+    virtual void SetViewport(int x, int y, int w, int h) override;
+    virtual void GetViewport(int& x, int& y, int& w, int& h) const override;
+    virtual void SetDepthRange(float zmin, float zmax) override;
+    virtual void GetDepthRange(float& zmin, float& zmax) const override;
+
+    virtual bool Resize(unsigned int w, unsigned int h) override;
+
+    virtual void ClearColorBuffer() override;
+    virtual void ClearDepthBuffer() override;
+    virtual void ClearStencilBuffer() override;
+    virtual void ClearBuffers() override;
+    virtual void DisplayColorBuffer(unsigned int syncInterval) override;
+
+    virtual void SetBlendState(eastl::shared_ptr<BlendState> const& state) override;
+    virtual void SetDepthStencilState(eastl::shared_ptr<DepthStencilState> const& state) override;
+    virtual void SetRasterizerState(eastl::shared_ptr<RasterizerState> const& state) override;
+
+    virtual void Enable(eastl::shared_ptr<DrawTarget> const& target) override;
+    virtual void Disable(eastl::shared_ptr<DrawTarget> const& target) override;
+
+    virtual bool Update(eastl::shared_ptr<Buffer> const& buffer) override;
+    virtual bool Update(eastl::shared_ptr<TextureSingle> const& texture) override;
+    virtual bool Update(eastl::shared_ptr<TextureSingle> const& texture, unsigned int level) override;
+    virtual bool Update(eastl::shared_ptr<TextureArray> const& textureArray) override;
+    virtual bool Update(eastl::shared_ptr<TextureArray> const& textureArray, unsigned int item, unsigned int level) override;
+
+protected:
+    virtual uint64_t DrawPrimitive(
+        eastl::shared_ptr<VertexBuffer> const& vbuffer,
+        eastl::shared_ptr<IndexBuffer> const& ibuffer,
+        eastl::shared_ptr<VisualEffect> const& effect,
+        unsigned int numInstances) override;
+
+    virtual void InvalidateBindings() override;
+
+private:
+    void Record(CommandType type, unsigned int count,
+        void const* object = nullptr, void const* effect = nullptr);
+
+    void BindShader(Shader const* shader);
+    void BindSlot(eastl::vector<void const*>& slots, int slot,
+        void const* object, unsigned int& binds);
+
+    int mViewportX, mViewportY, mViewportWidth, mViewportHeight;
+    float mDepthRangeMin, mDepthRangeMax;
+
+    eastl::vector<Command> mCommands;
+    Counters mCounters;
+    bool mRecording;
+
+    void const* mActiveProgram;
+    void const* mActiveVBuffer;
+    void const* mActiveIBuffer;
+    eastl::vector<void const*> mActiveTextures;
+    eastl::vector<void const*> mActiveSamplers;
+};
+
+
+inline eastl::vector<NullRenderer::Command> const& NullRenderer::GetCommands() const
+{
+    return mCommands;
+}
+
+inline NullRenderer::Counters const& NullRenderer::GetCounters() const
+{
+    return mCounters;
+}
+
+inline void NullRenderer::SetRecording(bool recording)
+{
+    mRecording = recording;
+}
+
+inline bool NullRenderer::IsRecording() const
+{
+    return mRecording;
+}
+
+#endif
@@ -12,6 +12,7 @@
 #include "Resource/Buffer/GL4AtomicCounterBuffer.h"
 #include "Resource/Buffer/GL4ConstantBuffer.h"
 #include "Resource/Buffer/GL4IndexBuffer.h"
+#include "Resource/Buffer/GL4StreamBuffer.h"
 #include "Resource/Buffer/GL4StructuredBuffer.h"
 #include "Resource/Buffer/GL4VertexBuffer.h"
 
@@ -54,7 +55,10 @@ GL4Renderer::GL4Renderer()
     :
     mMajor(0),
     mMinor(0),
-    mMeetsRequirements(false)
+    mMeetsRequirements(false),
+    mActiveProgram(0),
+    mActiveLayout(nullptr),
+    mActiveIBuffer(nullptr)
 {
     // Initialization of GraphicsEngine members that depend on GL4.
 	mInputLayouts = eastl::make_unique<GL4InputLayoutManager>();
@@ -110,6 +114,16 @@ bool GL4Renderer::Initialize(int requiredMajor, int requiredMinor)
         SetViewport(0, 0, mScreenSize[0], mScreenSize[1]);
         SetDepthRange(0.0f, 1.0f);
         CreateDefaultGlobalState();
+
+        // Three regions of 4MB, one per frame in flight.
+        if (mMajor > 4 || (mMajor == 4 && mMinor >= 4))
+        {
+            mStreamBuffer = eastl::make_unique<GL4StreamBuffer>(4 * 1024 * 1024, 3);
+            if (!mStreamBuffer->IsValid())
+            {
+                mStreamBuffer = nullptr;
+            }
+        }
     }
 	
 #if defined(NDEBUG)
@@ -135,6 +149,20 @@ void GL4Renderer::Terminate()
 	}
     DestroyDefaultGlobalState();
 
+    ReleaseTextureUnits();
+    if (mActiveLayout)
+    {
+        mActiveLayout->Disable();
+        mActiveLayout = nullptr;
+    }
+    mActiveIBuffer = nullptr;
+    if (mActiveProgram)
+    {
+        glUseProgram(0);
+        mActiveProgram = 0;
+    }
+    mStreamBuffer = nullptr;
+
     // Need to remove all the RawBuffer objects used to manage atomic
     // counter buffers.
     mAtomicCounterRawBuffers.clear();
@@ -177,7 +205,34 @@ void GL4Renderer::Terminate()
     mInputLayouts = nullptr;
 }
 
-uint64_t GL4Renderer::DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer const* ibuffer)
+void GL4Renderer::NextStreamFrame()
+{
+    if (mStreamBuffer)
+    {
+        mStreamBuffer->NextFrame();
+    }
+}
+
+bool GL4Renderer::StreamVertexBuffer(GL4VertexBuffer* gl4VBuffer)
+{
+    // The copy starts at the first vertex so that the vertex offset and
+    // the indices of the buffer stay valid relative to the copy.
+    VertexBuffer* vbuffer = gl4VBuffer->GetVertexBuffer();
+    GLsizeiptr numBytes = static_cast<GLsizeiptr>(vbuffer->GetOffset() +
+        vbuffer->GetNumActiveElements()) * vbuffer->GetElementSize();
+
+    GLintptr offset = 0;
+    if (mStreamBuffer && mStreamBuffer->Write(vbuffer->GetData(), numBytes, offset))
+    {
+        gl4VBuffer->SetStream(mStreamBuffer->GetFrame(), offset);
+        return true;
+    }
+
+    gl4VBuffer->ClearStream();
+    return false;
+}
+
+uint64_t GL4Renderer::DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer const* ibuffer, unsigned int numInstances)
 {
     unsigned int numActiveVertices = vbuffer->GetNumActiveElements();
     unsigned int vertexOffset = vbuffer->GetOffset();
@@ -226,8 +281,16 @@ uint64_t GL4Renderer::DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer con
     if (ibuffer->IsIndexed())
     {
         void const* data = (char*)0 + indexSize * offset;
-        glDrawRangeElements(topology, 0, numActiveVertices - 1,
-            static_cast<GLsizei>(numActiveIndices), indexType, data);
+        if (numInstances > 1)
+        {
+            glDrawElementsInstanced(topology, static_cast<GLsizei>(numActiveIndices),
+                indexType, data, static_cast<GLsizei>(numInstances));
+        }
+        else
+        {
+            glDrawRangeElements(topology, 0, numActiveVertices - 1,
+                static_cast<GLsizei>(numActiveIndices), indexType, data);
+        }
     }
     else
     {
@@ -237,8 +300,16 @@ uint64_t GL4Renderer::DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer con
         // commands that do not reference the content of the GL_ELEMENT_ARRAY_BUFFER,
         // or explicitly generated from the content of the GL_ELEMENT_ARRAY_BUFFER
         // by commands such as glDrawElements."
-        glDrawArrays(topology, static_cast<GLint>(vertexOffset),
-            static_cast<GLint>(numActiveVertices));
+        if (numInstances > 1)
+        {
+            glDrawArraysInstanced(topology, static_cast<GLint>(vertexOffset),
+                static_cast<GLint>(numActiveVertices), static_cast<GLsizei>(numInstances));
+        }
+        else
+        {
+            glDrawArrays(topology, static_cast<GLint>(vertexOffset),
+                static_cast<GLint>(numActiveVertices));
+        }
     }
     return 0;
 }
@@ -577,8 +648,7 @@ void GL4Renderer::EnableTextures(Shader const* shader, GLuint program)
         {
             GLint unit = mTextureSamplerUnitMap.AcquireUnit(program, ts.bindPoint);
             glUniform1i(ts.bindPoint, unit);
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(texture->GetTarget(), handle);
+            BindTextureUnit(unit, texture->GetTarget(), handle);
         }
     }
 }
@@ -616,9 +686,9 @@ void GL4Renderer::DisableTextures(Shader const* shader, GLuint program)
         }
         else
         {
+            // The texture stays bound to the unit for the next draw, see
+            // BindTextureUnit.
             GLint unit = mTextureSamplerUnitMap.GetUnit(program, ts.bindPoint);
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(texture->GetTarget(), 0);
             mTextureSamplerUnitMap.ReleaseUnit(unit);
         }
     }
@@ -661,8 +731,7 @@ void GL4Renderer::EnableTextureArrays(Shader const* shader, GLuint program)
         {
             GLint unit = mTextureSamplerUnitMap.AcquireUnit(program, ta.bindPoint);
             glUniform1i(ta.bindPoint, unit);
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(texture->GetTarget(), handle);
+            BindTextureUnit(unit, texture->GetTarget(), handle);
         }
     }
 }
@@ -700,9 +769,9 @@ void GL4Renderer::DisableTextureArrays(Shader const* shader, GLuint program)
         }
         else
         {
+            // The texture array stays bound to the unit for the next draw,
+            // see BindTextureUnit.
             GLint unit = mTextureSamplerUnitMap.GetUnit(program, ta.bindPoint);
-            glActiveTexture(GL_TEXTURE0 + unit);
-            glBindTexture(texture->GetTarget(), 0);
             mTextureSamplerUnitMap.ReleaseUnit(unit);
         }
     }
@@ -720,7 +789,7 @@ void GL4Renderer::EnableSamplers(Shader const* shader, GLuint program)
             {
                 auto const location = ts.bindPoint;
                 auto const unit = mTextureSamplerUnitMap.AcquireUnit(program, location);
-                glBindSampler(unit, gl4Sampler->GetGLHandle());
+                BindSamplerUnit(unit, gl4Sampler->GetGLHandle());
             }
             else
             {
@@ -747,7 +816,6 @@ void GL4Renderer::DisableSamplers(Shader const* shader, GLuint program)
             {
                 auto const location = ts.bindPoint;
                 auto const unit = mTextureSamplerUnitMap.GetUnit(program, location);
-                glBindSampler(unit, 0);
                 mTextureSamplerUnitMap.ReleaseUnit(unit);
             }
             else
@@ -762,6 +830,101 @@ void GL4Renderer::DisableSamplers(Shader const* shader, GLuint program)
     }
 }
 
+void GL4Renderer::InvalidateBindings()
+{
+    // The program is not a bridge object and a program in use is never
+    // deleted by OpenGL, so its binding remains valid.
+    mActiveLayout = nullptr;
+    mActiveIBuffer = nullptr;
+    for (auto& binding : mActiveTextures)
+    {
+        binding.valid = false;
+    }
+    for (auto& binding : mActiveSamplers)
+    {
+        binding.valid = false;
+    }
+}
+
+void GL4Renderer::ReleaseTextureUnits()
+{
+    // Textures left bound to the units must not be sampled while they are
+    // attached to a draw target, so they are unbound when targets change.
+    for (unsigned int unit = 0; unit < mActiveTextures.size(); ++unit)
+    {
+        auto& binding = mActiveTextures[unit];
+        if (binding.target != 0)
+        {
+            glActiveTexture(GL_TEXTURE0 + unit);
+            glBindTexture(binding.target, 0);
+            binding.target = 0;
+            binding.handle = 0;
+            binding.valid = false;
+        }
+    }
+
+    for (unsigned int unit = 0; unit < mActiveSamplers.size(); ++unit)
+    {
+        auto& binding = mActiveSamplers[unit];
+        if (binding.handle != 0 || !binding.valid)
+        {
+            glBindSampler(unit, 0);
+            binding.handle = 0;
+            binding.valid = true;
+        }
+    }
+}
+
+void GL4Renderer::BindTextureUnit(GLint unit, GLenum target, GLuint handle)
+{
+    if (unit < 0)
+    {
+        return;
+    }
+
+    if (unit >= static_cast<GLint>(mActiveTextures.size()))
+    {
+        UnitBinding unbound = { 0, 0, false };
+        mActiveTextures.resize(unit + 1, unbound);
+    }
+
+    auto& binding = mActiveTextures[unit];
+    if (binding.valid && binding.target == target && binding.handle == handle)
+    {
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0 + unit);
+    glBindTexture(target, handle);
+    binding.target = target;
+    binding.handle = handle;
+    binding.valid = true;
+}
+
+void GL4Renderer::BindSamplerUnit(GLint unit, GLuint handle)
+{
+    if (unit < 0)
+    {
+        return;
+    }
+
+    if (unit >= static_cast<GLint>(mActiveSamplers.size()))
+    {
+        UnitBinding unbound = { 0, 0, false };
+        mActiveSamplers.resize(unit + 1, unbound);
+    }
+
+    auto& binding = mActiveSamplers[unit];
+    if (binding.valid && binding.handle == handle)
+    {
+        return;
+    }
+
+    glBindSampler(unit, handle);
+    binding.handle = handle;
+    binding.valid = true;
+}
+
 GL4Renderer::ProgramIndexUnitMap::~ProgramIndexUnitMap()
 {
 }
@@ -1001,6 +1164,7 @@ void GL4Renderer::SetRasterizerState(eastl::shared_ptr<RasterizerState> const& s
 void GL4Renderer::Enable(eastl::shared_ptr<DrawTarget> const& target)
 {
     auto gl4Target = static_cast<GL4DrawTarget*>(Bind(target));
+    ReleaseTextureUnits();
     gl4Target->Enable();
 }
 
@@ -1009,6 +1173,7 @@ void GL4Renderer::Disable(eastl::shared_ptr<DrawTarget> const& target)
     auto gl4Target = static_cast<GL4DrawTarget*>(Get(target));
     if (gl4Target)
     {
+        ReleaseTextureUnits();
         gl4Target->Disable();
     }
 }
@@ -1022,6 +1187,20 @@ bool GL4Renderer::Update(eastl::shared_ptr<Buffer> const& buffer)
     }
 
     auto glBuffer = static_cast<GL4Buffer*>(Bind(buffer));
+
+    // The copy of an index buffer unbinds it from the active vertex array.
+    if (buffer->GetType() == GE_INDEX_BUFFER)
+    {
+        mActiveIBuffer = nullptr;
+    }
+    else if (buffer->GetType() == GE_VERTEX_BUFFER && mStreamBuffer &&
+        buffer->GetUsage() == Resource::DYNAMIC_UPDATE)
+    {
+        if (StreamVertexBuffer(static_cast<GL4VertexBuffer*>(glBuffer)))
+        {
+            return true;
+        }
+    }
     return glBuffer->Update();
 }
 
@@ -1034,6 +1213,9 @@ bool GL4Renderer::Update(eastl::shared_ptr<TextureSingle> const& texture)
     }
 
     auto glTexture = static_cast<GL4TextureSingle*>(Bind(texture));
+
+    // The copy binds the texture to the active unit and then unbinds it.
+    InvalidateBindings();
     return glTexture->Update();
 }
 
@@ -1046,6 +1228,9 @@ bool GL4Renderer::Update(eastl::shared_ptr<TextureSingle> const& texture, unsign
     }
 
     auto glTexture = static_cast<GL4TextureSingle*>(Bind(texture));
+
+    // The copy binds the texture to the active unit and then unbinds it.
+    InvalidateBindings();
     return glTexture->Update(level);
 }
 
@@ -1058,6 +1243,9 @@ bool GL4Renderer::Update(eastl::shared_ptr<TextureArray> const& textureArray)
     }
 
     auto glTextureArray = static_cast<GL4TextureArray*>(Bind(textureArray));
+
+    // The copy binds the texture to the active unit and then unbinds it.
+    InvalidateBindings();
     return glTextureArray->Update();
 }
 
@@ -1070,11 +1258,15 @@ bool GL4Renderer::Update(eastl::shared_ptr<TextureArray> const& textureArray, un
     }
 
     auto glTextureArray = static_cast<GL4TextureArray*>(Bind(textureArray));
+
+    // The copy binds the texture to the active unit and then unbinds it.
+    InvalidateBindings();
     return glTextureArray->Update(item, level);
 }
 
 uint64_t GL4Renderer::DrawPrimitive(eastl::shared_ptr<VertexBuffer> const& vbuffer,
-    eastl::shared_ptr<IndexBuffer> const& ibuffer, eastl::shared_ptr<VisualEffect> const& effect)
+    eastl::shared_ptr<IndexBuffer> const& ibuffer, eastl::shared_ptr<VisualEffect> const& effect,
+    unsigned int numInstances)
 {
     GLSLVisualProgram* gl4program = dynamic_cast<GLSLVisualProgram*>(effect->GetProgram().get());
     if (!gl4program)
@@ -1085,11 +1277,17 @@ uint64_t GL4Renderer::DrawPrimitive(eastl::shared_ptr<VertexBuffer> const& vbuff
 
     uint64_t numPixelsDrawn = 0;
     auto programHandle = gl4program->GetProgramHandle();
-    glUseProgram(programHandle);
+    if (programHandle != mActiveProgram)
+    {
+        glUseProgram(programHandle);
+        mActiveProgram = programHandle;
+    }
 
     if (EnableShaders(effect, programHandle))
     {
-        // Enable the vertex buffer and input layout.
+        // Enable the vertex buffer and input layout.  The vertex array stays
+        // bound after the draw, so the next draw of the same buffer with the
+        // same program does not bind it again.
         GL4VertexBuffer* gl4VBuffer = nullptr;
         GL4InputLayout* gl4Layout = nullptr;
         if (vbuffer->StandardUsage())
@@ -1097,35 +1295,64 @@ uint64_t GL4Renderer::DrawPrimitive(eastl::shared_ptr<VertexBuffer> const& vbuff
             gl4VBuffer = static_cast<GL4VertexBuffer*>(Bind(vbuffer));
             GL4InputLayoutManager* manager = static_cast<GL4InputLayoutManager*>(mInputLayouts.get());
             gl4Layout = manager->Bind(programHandle, gl4VBuffer->GetGLHandle(), vbuffer.get());
-            gl4Layout->Enable();
         }
 
-        // Enable the index buffer.
+        // Binding the index buffer could create it, which invalidates the
+        // cached bindings, so it happens before the vertex array is chosen.
         GL4IndexBuffer* gl4IBuffer = nullptr;
         if (ibuffer->IsIndexed())
         {
             gl4IBuffer = static_cast<GL4IndexBuffer*>(Bind(ibuffer));
-            gl4IBuffer->Enable();
         }
 
-        numPixelsDrawn = DrawPrimitive(vbuffer.get(), ibuffer.get());
+        if (!gl4Layout)
+        {
+            glBindVertexArray(0);
+            mActiveLayout = nullptr;
+            mActiveIBuffer = nullptr;
+        }
+        else if (gl4Layout != mActiveLayout)
+        {
+            gl4Layout->Enable();
+            mActiveLayout = gl4Layout;
+            mActiveIBuffer = nullptr;
+        }
 
-        // Disable the vertex buffer and input layout.
-        if (vbuffer->StandardUsage())
+        // A streamed copy from an earlier frame may have been overwritten
+        // by the ring, so it is streamed again or, if the region is full,
+        // the data goes to the storage of the buffer.
+        if (gl4Layout)
         {
-            gl4Layout->Disable();
+            if (gl4VBuffer->IsStreamed() &&
+                gl4VBuffer->GetStreamFrame() != mStreamBuffer->GetFrame() &&
+                !StreamVertexBuffer(gl4VBuffer))
+            {
+                gl4VBuffer->Update();
+            }
+
+            if (gl4VBuffer->IsStreamed())
+            {
+                gl4Layout->SetVertexBuffer(mStreamBuffer->GetGLHandle(),
+                    gl4VBuffer->GetStreamOffset());
+            }
+            else
+            {
+                gl4Layout->SetVertexBuffer(gl4VBuffer->GetGLHandle(), 0);
+            }
         }
 
-        // Disable the index buffer.
-        if (gl4IBuffer)
+        // Enable the index buffer.  Its binding is part of the vertex array
+        // state.
+        if (gl4IBuffer && gl4IBuffer != mActiveIBuffer)
         {
-            gl4IBuffer->Disable();
+            gl4IBuffer->Enable();
+            mActiveIBuffer = gl4IBuffer;
         }
 
+        numPixelsDrawn = DrawPrimitive(vbuffer.get(), ibuffer.get(), numInstances);
+
         DisableShaders(effect, programHandle);
     }
 
-    glUseProgram(0);
-
     return numPixelsDrawn;
 }
@@ -13,6 +13,9 @@
 
 class GL4GraphicObject;
 class GL4DrawTarget;
+class GL4IndexBuffer;
+class GL4VertexBuffer;
+class GL4StreamBuffer;
 
 class GRAPHIC_ITEM GL4Renderer : public Renderer
 {
@@ -45,9 +48,13 @@ protected:
     int mMajor, mMinor;
     bool mMeetsRequirements;
 
+    // The platform renderers call this after presenting a frame, so that
+    // the stream buffer fences the region written this frame and moves on.
+    void NextStreamFrame();
+
 private:
     // Support for drawing.
-    uint64_t DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer const* ibuffer);
+    uint64_t DrawPrimitive(VertexBuffer const* vbuffer, IndexBuffer const* ibuffer, unsigned int numInstances);
 
     // Support for enabling and disabling resources used by shaders.
     bool EnableShaders(eastl::shared_ptr<VisualEffect> const& effect, GLuint program);
@@ -109,6 +116,40 @@ private:
     ProgramIndexUnitMap mUniformUnitMap;
     ProgramIndexUnitMap mShaderStorageUnitMap;
 
+    // Cache of the bindings left in the OpenGL context by the last draw.
+    // Consecutive draws that share the program, the vertex array and index
+    // buffer, or the texture and sampler of a unit skip those binds, so the
+    // render lists sorted by program and texture submit far fewer calls.
+    // The uniform buffers are still attached for each draw because their
+    // contents differ for every visual.
+    virtual void InvalidateBindings() override;
+    void ReleaseTextureUnits();
+    void BindTextureUnit(GLint unit, GLenum target, GLuint handle);
+    void BindSamplerUnit(GLint unit, GLuint handle);
+
+    struct UnitBinding
+    {
+        GLenum target;
+        GLuint handle;
+        bool valid;
+    };
+
+    GLuint mActiveProgram;
+    GL4InputLayout* mActiveLayout;
+    GL4IndexBuffer* mActiveIBuffer;
+    eastl::vector<UnitBinding> mActiveTextures;
+    eastl::vector<UnitBinding> mActiveSamplers;
+
+    // Dynamic vertex buffers (particles, skinned and morphed meshes, shadow
+    // volumes, text) are rewritten every frame.  With OpenGL 4.4 their
+    // updates are copied to a persistently mapped ring instead of their own
+    // storage, and the input layout is pointed at the copy when drawing.
+    // Without it, or when the region of the frame is full, a buffer is
+    // updated through its own storage as before.
+    bool StreamVertexBuffer(GL4VertexBuffer* gl4VBuffer);
+
+    eastl::unique_ptr<GL4StreamBuffer> mStreamBuffer;
+
 
 // Overrides from GraphicsEngine.
 public:
@@ -159,7 +200,8 @@ protected:
     virtual uint64_t DrawPrimitive(
         eastl::shared_ptr<VertexBuffer> const& vbuffer,
         eastl::shared_ptr<IndexBuffer> const& ibuffer,
-        eastl::shared_ptr<VisualEffect> const& effect) override;
+        eastl::shared_ptr<VisualEffect> const& effect,
+        unsigned int numInstances) override;
 };
 
 
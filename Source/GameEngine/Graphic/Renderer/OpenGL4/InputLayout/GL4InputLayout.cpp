@@ -19,6 +19,8 @@ GL4InputLayout::GL4InputLayout(GLuint programHandle, GLuint vbufferHandle,
     :
     mProgramHandle(programHandle),
     mVBufferHandle(vbufferHandle),
+    mBoundHandle(vbufferHandle),
+    mBoundOffset(0),
     mNumAttributes(0)
 {
     glGenVertexArrays(1, &mVArrayHandle);
@@ -73,6 +75,23 @@ void GL4InputLayout::Disable()
     glBindVertexArray(0);
 }
 
+void GL4InputLayout::SetVertexBuffer(GLuint vbufferHandle, GLintptr baseOffset)
+{
+    if (vbufferHandle == mBoundHandle && baseOffset == mBoundOffset)
+    {
+        return;
+    }
+
+    for (int i = 0; i < mNumAttributes; ++i)
+    {
+        Attribute const& attribute = mAttributes[i];
+        glBindVertexBuffer(i, vbufferHandle, baseOffset + attribute.offset,
+            attribute.stride);
+    }
+    mBoundHandle = vbufferHandle;
+    mBoundOffset = baseOffset;
+}
+
 
 GLenum const GL4InputLayout::msChannelType[] =
 {
@@ -23,10 +23,18 @@ public:
     void Enable();
     void Disable();
 
+    // Point the attributes at another buffer, or another place of the same
+    // buffer, as the stream buffer does for dynamic vertex data.  The input
+    // layout must be enabled.  Nothing is done when the binding is the
+    // current one.
+    void SetVertexBuffer(GLuint vbufferHandle, GLintptr baseOffset);
+
 private:
     GLuint mProgramHandle;
     GLuint mVBufferHandle;
     GLuint mVArrayHandle;
+    GLuint mBoundHandle;
+    GLintptr mBoundOffset;
 
     struct Attribute
     {
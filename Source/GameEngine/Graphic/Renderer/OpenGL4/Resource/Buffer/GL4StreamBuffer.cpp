@@ -0,0 +1,91 @@
+#include "Core/Logger/Logger.h"
+#include "GL4StreamBuffer.h"
+
+GL4StreamBuffer::~GL4StreamBuffer()
+{
+    for (auto fence : mFences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+
+    if (mMapped)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, mGLHandle);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &mGLHandle);
+}
+
+GL4StreamBuffer::GL4StreamBuffer(GLsizeiptr regionBytes, unsigned int numRegions)
+    :
+    mGLHandle(0),
+    mMapped(nullptr),
+    mRegionBytes(regionBytes),
+    mRegionUsed(0),
+    mRegion(0),
+    mFences(numRegions > 0 ? numRegions : 1, nullptr),
+    mFrame(1)
+{
+    GLsizeiptr numBytes = mRegionBytes * static_cast<GLsizeiptr>(mFences.size());
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    glGenBuffers(1, &mGLHandle);
+    glBindBuffer(GL_ARRAY_BUFFER, mGLHandle);
+    glBufferStorage(GL_ARRAY_BUFFER, numBytes, nullptr, flags);
+    mMapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, numBytes, flags));
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (!mMapped)
+    {
+        LogWarning("Cannot map the stream buffer, dynamic vertex buffers are copied individually.");
+    }
+}
+
+bool GL4StreamBuffer::Write(void const* data, GLsizeiptr numBytes, GLintptr& offset)
+{
+    GLsizeiptr start = (mRegionUsed + ALIGNMENT - 1) & ~static_cast<GLsizeiptr>(ALIGNMENT - 1);
+    if (!mMapped || numBytes <= 0 || start + numBytes > mRegionBytes)
+    {
+        return false;
+    }
+
+    offset = static_cast<GLintptr>(mRegion) * mRegionBytes + start;
+    memcpy(mMapped + offset, data, numBytes);
+    mRegionUsed = start + numBytes;
+    return true;
+}
+
+void GL4StreamBuffer::NextFrame()
+{
+    if (!mMapped)
+    {
+        return;
+    }
+
+    mFences[mRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    mRegion = (mRegion + 1) % static_cast<unsigned int>(mFences.size());
+    mRegionUsed = 0;
+    ++mFrame;
+
+    // The draws that read the region were submitted numRegions frames ago.
+    GLsync fence = mFences[mRegion];
+    if (fence)
+    {
+        GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (result == GL_TIMEOUT_EXPIRED)
+        {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        if (result == GL_WAIT_FAILED)
+        {
+            LogWarning("Failed to wait for the stream buffer region.");
+        }
+        glDeleteSync(fence);
+        mFences[mRegion] = nullptr;
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef GL4STREAMBUFFER_H
+#define GL4STREAMBUFFER_H
+
+#include "Graphic/GraphicStd.h"
+#include "Graphic/Renderer/OpenGL4/OpenGL.h"
+
+// Ring of GPU memory for vertex data rewritten every frame.  The storage is
+// created with glBufferStorage and stays mapped (persistent and coherent),
+// so a write is a memcpy into GPU visible memory without a map, unmap or
+// driver staging copy.  The ring is split into one region per frame in
+// flight.  Each region is fenced when its frame is presented and the CPU
+// waits on the fence only when it wraps around to that region again, which
+// normally has completed long before.  Requires OpenGL 4.4.
+class GRAPHIC_ITEM GL4StreamBuffer
+{
+public:
+    // Construction and destruction.
+    ~GL4StreamBuffer();
+    GL4StreamBuffer(GLsizeiptr regionBytes, unsigned int numRegions);
+
+    // The storage is valid when it was created and mapped.
+    inline bool IsValid() const;
+    inline GLuint GetGLHandle() const;
+
+    // Frames are counted from 1, so 0 never matches the current frame.
+    inline uint64_t GetFrame() const;
+
+    // Copy the data to the region of the current frame.  The return value
+    // is 'false' when the region has no room left, otherwise 'offset' is
+    // the offset of the copy from the start of the ring.
+    bool Write(void const* data, GLsizeiptr numBytes, GLintptr& offset);
+
+    // Fence the region of the current frame and move to the next one,
+    // waiting for the GPU to release it if needed.
+    void NextFrame();
+
+private:
+    enum { ALIGNMENT = 256 };
+
+    GLuint mGLHandle;
+    char* mMapped;
+    GLsizeiptr mRegionBytes;
+    GLsizeiptr mRegionUsed;
+    unsigned int mRegion;
+    eastl::vector<GLsync> mFences;
+    uint64_t mFrame;
+};
+
+
+inline bool GL4StreamBuffer::IsValid() const
+{
+    return mMapped != nullptr;
+}
+
+inline GLuint GL4StreamBuffer::GetGLHandle() const
+{
+    return mGLHandle;
+}
+
+inline uint64_t GL4StreamBuffer::GetFrame() const
+{
+    return mFrame;
+}
+
+#endif
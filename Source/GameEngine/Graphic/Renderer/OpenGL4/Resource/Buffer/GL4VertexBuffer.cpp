@@ -12,7 +12,9 @@
 
 GL4VertexBuffer::GL4VertexBuffer(VertexBuffer const* vbuffer)
     :
-    GL4Buffer(vbuffer, GL_ARRAY_BUFFER)
+    GL4Buffer(vbuffer, GL_ARRAY_BUFFER),
+    mStreamFrame(0),
+    mStreamOffset(0)
 {
     Initialize();
 }
@@ -21,10 +21,24 @@ public:
     // Member access.
     inline VertexBuffer* GetVertexBuffer() const;
 
+    // A dynamic vertex buffer whose latest data was written to the stream
+    // buffer of the renderer instead of its own storage.  The frame tells
+    // whether that copy is still valid; once the ring wraps the data must
+    // be streamed again.
+    inline void SetStream(uint64_t frame, GLintptr offset);
+    inline void ClearStream();
+    inline bool IsStreamed() const;
+    inline uint64_t GetStreamFrame() const;
+    inline GLintptr GetStreamOffset() const;
+
     // TODO: Drawing support?  Currently, the enable/disable is in the
     // GL4InputLayout class, which assumes OpenGL 4.3 or later.  What if the
     // application machine does not have OpenGL 4.3?  Fall back to the
     // glBindBuffer paradigm?
+
+private:
+    uint64_t mStreamFrame;
+    GLintptr mStreamOffset;
 };
 
 inline VertexBuffer* GL4VertexBuffer::GetVertexBuffer() const
@@ -32,4 +46,31 @@ inline VertexBuffer* GL4VertexBuffer::GetVertexBuffer() const
     return static_cast<VertexBuffer*>(mGObject);
 }
 
+inline void GL4VertexBuffer::SetStream(uint64_t frame, GLintptr offset)
+{
+    mStreamFrame = frame;
+    mStreamOffset = offset;
+}
+
+inline void GL4VertexBuffer::ClearStream()
+{
+    mStreamFrame = 0;
+    mStreamOffset = 0;
+}
+
+inline bool GL4VertexBuffer::IsStreamed() const
+{
+    return mStreamFrame != 0;
+}
+
+inline uint64_t GL4VertexBuffer::GetStreamFrame() const
+{
+    return mStreamFrame;
+}
+
+inline GLintptr GL4VertexBuffer::GetStreamOffset() const
+{
+    return mStreamOffset;
+}
+
 #endif
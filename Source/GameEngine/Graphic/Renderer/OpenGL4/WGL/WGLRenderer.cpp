@@ -48,6 +48,7 @@ void WGLRenderer::DisplayColorBuffer(unsigned int syncInterval)
 {
     wglSwapIntervalEXT(syncInterval > 0 ? 1 : 0);
     SwapBuffers(mDevice);
+    NextStreamFrame();
 }
 
 bool WGLRenderer::Initialize(int requiredMajor, int requiredMinor)
@@ -10,6 +10,8 @@
 
 #include "Renderer.h"
 
+#include "Core/Profiler/Profiler.h"
+
 Renderer* Renderer::mRenderer = NULL;
 
 Renderer* Renderer::Get(void)
@@ -134,7 +136,8 @@ uint64_t Renderer::Draw(Visual* visual)
 		auto const& effect = visual->GetEffect();
 		if (vbuffer && ibuffer && effect)
 		{
-			return DrawPrimitive(vbuffer, ibuffer, effect);
+			PROFILE_COUNTER("Draws", 1);
+			return DrawPrimitive(vbuffer, ibuffer, effect, 1);
 		}
 	}
 
@@ -167,6 +170,27 @@ uint64_t Renderer::Draw(eastl::vector<eastl::shared_ptr<Visual>> const& visuals)
 	return numPixelsDrawn;
 }
 
+uint64_t Renderer::DrawInstanced(eastl::shared_ptr<Visual> const& visual, unsigned int numInstances)
+{
+	if (visual)
+	{
+		auto const& vbuffer = visual->GetVertexBuffer();
+		auto const& ibuffer = visual->GetIndexBuffer();
+		auto const& effect = visual->GetEffect();
+		if (vbuffer && ibuffer && effect)
+		{
+			if (numInstances == 0)
+				return 0;
+
+			PROFILE_COUNTER("Draws", 1);
+			return DrawPrimitive(vbuffer, ibuffer, effect, numInstances);
+		}
+	}
+
+	LogError("Null input to DrawInstanced.");
+	return 0;
+}
+
 uint64_t Renderer::Draw(int x, int y, eastl::array<float, 4> const& color, eastl::wstring const& message)
 {
 	uint64_t numPixelsDrawn;
@@ -191,7 +215,7 @@ uint64_t Renderer::Draw(int x, int y, eastl::array<float, 4> const& color, eastl
 		SetDefaultRasterizerState();
 
 		numPixelsDrawn = DrawPrimitive(mActiveFont->GetVertexBuffer(),
-			mActiveFont->GetIndexBuffer(), mActiveFont->GetTextEffect());
+			mActiveFont->GetIndexBuffer(), mActiveFont->GetTextEffect(), 1);
 
 		SetBlendState(bState);
 		SetDepthStencilState(dState);
@@ -232,6 +256,7 @@ GraphicObject* Renderer::Bind(eastl::shared_ptr<GraphicObject> const& object)
 		LogAssert(gObject, "Null object.  Out of memory?");
 
 		mGraphicObjects.Insert(gObject, geObject);
+		InvalidateBindings();
 	}
 	return geObject.get();
 }
@@ -305,6 +330,7 @@ bool Renderer::Unbind(GraphicObject const* object)
 
 		if (mGraphicObjects.Remove(object, gxObject))
 		{
+			InvalidateBindings();
 			return true;
 		}
 	}
@@ -138,6 +138,11 @@ public:
 	uint64_t Draw(eastl::shared_ptr<Visual> const& visual);
 	uint64_t Draw(eastl::vector<eastl::shared_ptr<Visual>> const& visuals);
 
+	// Draw the geometric primitives of a visual numInstances times in a
+	// single call.  The effect tells the instances apart with gl_InstanceID
+	// (GLSL) or SV_InstanceID (HLSL), see Texture2ArrayInstancedEffect.
+	uint64_t DrawInstanced(eastl::shared_ptr<Visual> const& visual, unsigned int numInstances);
+
 	// Draw 2D text
 	uint64_t Draw(int x, int y, eastl::array<float, 4> const& color, eastl::wstring const& message);
 
@@ -215,11 +220,13 @@ protected:
 	// Support for drawing.  If occlusion queries are enabled, the return
 	// values are the number of samples that passed the depth and stencil
 	// tests, effectively the number of pixels drawn.  If occlusion queries
-	// are disabled, the functions return 0.
+	// are disabled, the functions return 0.  The primitives are drawn once
+	// for each of the numInstances instances.
 	virtual uint64_t DrawPrimitive(
 		eastl::shared_ptr<VertexBuffer> const& vbuffer,
 		eastl::shared_ptr<IndexBuffer> const& ibuffer,
-		eastl::shared_ptr<VisualEffect> const& effect) = 0;
+		eastl::shared_ptr<VisualEffect> const& effect,
+		unsigned int numInstances) = 0;
 
 	// Support for GOListener::OnDestroy and DTListener::OnDestroy, because
 	// they are passed raw pointers from resource destructors.  These are
@@ -227,6 +234,12 @@ protected:
 	bool Unbind(GraphicObject const* object);
 	bool Unbind(DrawTarget const* target);
 
+	// Support for renderers that cache the bindings of the graphics API
+	// between draws.  The cache is invalidated whenever a graphics object is
+	// created or destroyed, because creation changes the active bindings and
+	// the API may reuse the handles of destroyed objects.
+	virtual void InvalidateBindings() { }
+
 	// Bridge pattern to create graphics API-specific objects that correspond
 	// to front-end objects. The Bind, Get, and Unbind operations act on
 	// these maps.
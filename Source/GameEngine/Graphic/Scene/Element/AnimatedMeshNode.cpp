@@ -6,6 +6,7 @@
 
 #include "Graphic/Renderer/Renderer.h"
 #include "Graphic/Effect/Material.h"
+#include "Graphic/Effect/Texture2MorphEffect.h"
 
 #include "Core/OS/OS.h"
 
@@ -36,6 +37,7 @@ void AnimatedMeshNode::SetMesh(const eastl::shared_ptr<BaseAnimatedMesh>& mesh)
 
 	mMesh = mesh;
 	eastl::vector<eastl::shared_ptr<BaseMeshBuffer>> meshBuffers;
+	eastl::vector<eastl::shared_ptr<VertexBuffer>> morphVertices;
 	if (dynamic_cast<AnimateMeshMD3*>(mMesh.get()))
 	{
 		AnimateMeshMD3* animMeshMD3 = dynamic_cast<AnimateMeshMD3*>(mMesh.get());
@@ -44,13 +46,22 @@ void AnimatedMeshNode::SetMesh(const eastl::shared_ptr<BaseAnimatedMesh>& mesh)
 		animMeshMD3->GetMD3Mesh()->GetMeshes(meshes);
 
 		for (eastl::shared_ptr<MD3Mesh> mesh : meshes)
+		{
 			for (unsigned int i = 0; i < mesh->GetMeshBufferCount(); ++i)
+			{
 				meshBuffers.push_back(mesh->GetMeshBuffer(i));
+				morphVertices.push_back(
+					mesh->IsHardwareMorphing() ? mesh->GetMorphVertices(i) : nullptr);
+			}
+		}
 	}
 	else
 	{
 		for (unsigned int i = 0; i<mMesh->GetMeshBufferCount(); ++i)
+		{
 			meshBuffers.push_back(mMesh->GetMeshBuffer(i));
+			morphVertices.push_back(nullptr);
+		}
 	}
 		
 	mVisuals.clear();
@@ -63,7 +74,32 @@ void AnimatedMeshNode::SetMesh(const eastl::shared_ptr<BaseAnimatedMesh>& mesh)
 			mDepthStencilStates.push_back(eastl::make_shared<DepthStencilState>());
 
 			eastl::shared_ptr<Texture2> textureDiffuse = meshBuffer->GetMaterial()->GetTexture(TT_DIFFUSE);
-			if (textureDiffuse)
+			if (textureDiffuse && morphVertices[i])
+			{
+				// the vertex shader blends the two frames of the morph vertices
+				eastl::vector<eastl::string> path;
+#if defined(_OPENGL_)
+				path.push_back("Effects/Texture2MorphEffectVS.glsl");
+				path.push_back("Effects/Texture2EffectPS.glsl");
+#else
+				path.push_back("Effects/Texture2MorphEffectVS.hlsl");
+				path.push_back("Effects/Texture2EffectPS.hlsl");
+#endif
+
+				eastl::shared_ptr<Texture2MorphEffect> effect = eastl::make_shared<Texture2MorphEffect>(
+					ProgramFactory::Get(), path, textureDiffuse,
+					meshBuffer->GetMaterial()->mTextureLayer[TT_DIFFUSE].mFilter,
+					meshBuffer->GetMaterial()->mTextureLayer[TT_DIFFUSE].mModeU,
+					meshBuffer->GetMaterial()->mTextureLayer[TT_DIFFUSE].mModeV);
+
+				eastl::shared_ptr<Visual> visual = eastl::make_shared<Visual>(
+					morphVertices[i], meshBuffer->GetIndice(), effect);
+				visual->UpdateModelBound();
+				MarkBoundDirty();
+				mVisuals.push_back(visual);
+				mPVWUpdater->Subscribe(this, effect->GetPVWMatrixConstant());
+			}
+			else if (textureDiffuse)
 			{
 				eastl::vector<eastl::string> path;
 #if defined(_OPENGL_)
@@ -83,8 +119,9 @@ void AnimatedMeshNode::SetMesh(const eastl::shared_ptr<BaseAnimatedMesh>& mesh)
 				eastl::shared_ptr<Visual> visual = eastl::make_shared<Visual>(
 					meshBuffer->GetVertice(), meshBuffer->GetIndice(), effect);
 				visual->UpdateModelBound();
+				MarkBoundDirty();
 				mVisuals.push_back(visual);
-				mPVWUpdater->Subscribe(mWorldTransform, effect->GetPVWMatrixConstant());
+				mPVWUpdater->Subscribe(this, effect->GetPVWMatrixConstant());
 			}
 			else
 			{
@@ -102,12 +139,21 @@ void AnimatedMeshNode::SetMesh(const eastl::shared_ptr<BaseAnimatedMesh>& mesh)
 				eastl::shared_ptr<Visual> visual = eastl::make_shared<Visual>(
 					meshBuffer->GetVertice(), meshBuffer->GetIndice(), effect);
 				visual->UpdateModelBound();
+				MarkBoundDirty();
 				mVisuals.push_back(visual);
-				mPVWUpdater->Subscribe(mWorldTransform, effect->GetPVWMatrixConstant());
+				mPVWUpdater->Subscribe(this, effect->GetPVWMatrixConstant());
 			}
 		}
 	}
 
+	// the md3 parts are drawn with the pvw-matrix of their tags, which Render
+	// computes, or by the instance batcher
+	if (dynamic_cast<AnimateMeshMD3*>(mMesh.get()))
+	{
+		for (auto const& visual : mVisuals)
+			mPVWUpdater->Defer(visual->GetEffect()->GetVertexShader()->Get<ConstantBuffer>("PVWMatrix"));
+	}
+
 	// clean up joint nodes
 	if (mJointsUsed)
 	{
@@ -301,10 +347,6 @@ bool AnimatedMeshNode::PreRender(Scene* pScene)
 	{
 		mCurrentFrameMesh = GetMeshForCurrentFrame();
 
-		// update bbox
-		for (auto visual : mVisuals)
-			visual->UpdateModelBound();
-
 		// because this node supports rendering of mixed mode meshes consisting of
 		// transparent and solid material at the same time, we need to go through all
 		// materials, check of what type they are and register this node for the right
@@ -323,11 +365,21 @@ bool AnimatedMeshNode::PreRender(Scene* pScene)
 			animMeshMD3->GetMD3Mesh()->GetMeshes(meshes);
 
 			for (eastl::shared_ptr<MD3Mesh> mesh : meshes)
+			{
+				// the vertices of the selected frames are built by the scene
+				pScene->GetMorphUpdater().Add(mesh.get());
+
 				for (unsigned int i = 0; i < mesh->GetMeshBufferCount(); ++i)
 					materials.push_back(mesh->GetMeshBuffer(i)->GetMaterial());
+			}
+
+			// and the bound once they are built
+			pScene->GetMorphUpdater().Add(this);
 		}
 		else
 		{
+			UpdateBound();
+
 			for (unsigned int i = 0; i<GetMaterialCount(); ++i)
 				materials.push_back(GetMaterial(i));
 		}
@@ -358,6 +410,32 @@ bool AnimatedMeshNode::PreRender(Scene* pScene)
 	return Node::PreRender(pScene);
 }
 
+void AnimatedMeshNode::UpdateBound()
+{
+	// update bbox
+	for (auto visual : mVisuals)
+	{
+		visual->UpdateModelBound();
+
+		// the morph vertices hold the position of the next frame as well
+		if (eastl::dynamic_shared_pointer_cast<Texture2MorphEffect>(visual->GetEffect()))
+		{
+			eastl::set<DFType> required;
+			required.insert(DF_R32G32B32_FLOAT);
+			eastl::shared_ptr<VertexBuffer> const& vbuffer = visual->GetVertexBuffer();
+			char const* positions = vbuffer->GetChannel(VA_TEXCOORD, 1, required);
+			if (positions)
+			{
+				BoundingSphere nextBound;
+				nextBound.ComputeFromData(vbuffer->GetNumElements(),
+					(int)vbuffer->GetElementSize(), positions);
+				visual->mModelBound.GrowToContain(nextBound);
+			}
+		}
+	}
+	MarkBoundDirty();
+}
+
 void AnimatedMeshNode::Render(unsigned int& visual, bool isTransparentPass,
 	Scene *pScene, eastl::vector<Transform> interpolations, eastl::shared_ptr<MD3Mesh> pMesh)
 {
@@ -390,14 +468,6 @@ void AnimatedMeshNode::Render(unsigned int& visual, bool isTransparentPass,
 					if (material->Update(mRasterizerState))
 						Renderer::Get()->Unbind(mRasterizerState);
 
-					Renderer::Get()->SetBlendState(mBlendStates[i]);
-					Renderer::Get()->SetDepthStencilState(mDepthStencilStates[i]);
-					Renderer::Get()->SetRasterizerState(mRasterizerState);
-
-					eastl::shared_ptr<ConstantBuffer> cbuffer;
-					Matrix4x4<float> pvMatrix = pScene->GetActiveCamera()->Get()->GetProjectionViewMatrix();
-					cbuffer = mVisuals[visual]->GetEffect()->GetVertexShader()->Get<ConstantBuffer>("PVWMatrix");
-
 					Matrix4x4<float> interpolation = Matrix4x4<float>::Identity();
 					eastl::vector<Transform>::reverse_iterator it;
 					for (it = interpolations.rbegin(); it != interpolations.rend(); it++)
@@ -409,6 +479,25 @@ void AnimatedMeshNode::Render(unsigned int& visual, bool isTransparentPass,
 #endif
 					}
 
+					// the solid parts of models without animation, as pickups and
+					// projectiles, share the mesh buffer of the model and are drawn
+					// instanced when the pass is over
+					if (!transparent && pMesh->GetFrameCount() <= 1 &&
+						pScene->GetInstanceBatcher().Add(meshBuffer.get(), 0, material, mVisuals[visual],
+						mBlendStates[i], mDepthStencilStates[i], mRasterizerState,
+						interpolation, Vector4<float>{ 1.f, 1.f, 1.f, 1.f }, true))
+					{
+						continue;
+					}
+
+					Renderer::Get()->SetBlendState(mBlendStates[i]);
+					Renderer::Get()->SetDepthStencilState(mDepthStencilStates[i]);
+					Renderer::Get()->SetRasterizerState(mRasterizerState);
+
+					eastl::shared_ptr<ConstantBuffer> cbuffer;
+					Matrix4x4<float> pvMatrix = pScene->GetActiveCamera()->Get()->GetProjectionViewMatrix();
+					cbuffer = mVisuals[visual]->GetEffect()->GetVertexShader()->Get<ConstantBuffer>("PVWMatrix");
+
 #if defined(GE_USE_MAT_VEC)
 					*cbuffer->Get<Matrix4x4<float>>() = pvMatrix * interpolation;
 #else
@@ -417,7 +506,21 @@ void AnimatedMeshNode::Render(unsigned int& visual, bool isTransparentPass,
 
 					Renderer* renderer = Renderer::Get();
 					renderer->Update(cbuffer);
-					renderer->Update(meshBuffer->GetVertice());
+
+					eastl::shared_ptr<Texture2MorphEffect> morphEffect =
+						eastl::dynamic_shared_pointer_cast<Texture2MorphEffect>(mVisuals[visual]->GetEffect());
+					if (morphEffect)
+					{
+						// the vertices only change with the pair of frames
+						morphEffect->SetInterpolation(pMesh->GetMorphInterpolation());
+						renderer->Update(morphEffect->GetMorphConstant());
+						if (pMesh->ConsumeMorphChange(i))
+							renderer->Update(mVisuals[visual]->GetVertexBuffer());
+					}
+					else
+					{
+						renderer->Update(meshBuffer->GetVertice());
+					}
 					renderer->Draw(mVisuals[visual]);
 
 					Renderer::Get()->SetDefaultBlendState();
@@ -750,7 +853,10 @@ void AnimatedMeshNode::BeginTransition()
 
 		//Copy the position of joints
 		for (unsigned int n = 0; n<mJointChildSceneNodes.size(); ++n)
-			mPretransitingSave[n] = mJointChildSceneNodes[n]->GetRelativeTransform();
+		{
+			const BoneNode* joint = mJointChildSceneNodes[n].get();
+			mPretransitingSave[n] = joint->GetRelativeTransform();
+		}
 
 		mTransiting = mTransitionTime != 0 ? 1.f / (float)mTransitionTime : 0;
 	}
@@ -123,6 +123,9 @@ public:
 
 	virtual bool PreRender(Scene *pScene);
 	virtual bool Render(Scene *pScene);
+
+	//! updates the bound from the vertices of the current frame
+	void UpdateBound();
 	
 	//! Removes a child from this scene node.
 	//! Implemented here, to be able to remove the shadow properly, if there is one,
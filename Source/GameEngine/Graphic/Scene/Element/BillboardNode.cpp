@@ -83,7 +83,7 @@ BillboardNode::BillboardNode(const ActorId actorId,
 	mEffect = effect;
 	mVisual = eastl::make_shared<Visual>(
 		mMeshBuffer->GetVertice(), mMeshBuffer->GetIndice(), mEffect);
-	mPVWUpdater->Subscribe(mWorldTransform, effect->GetPVWMatrixConstant());
+	mPVWUpdater->Subscribe(this, effect->GetPVWMatrixConstant());
 }
 
 //! prerender
@@ -188,6 +188,7 @@ void BillboardNode::DoBillboardBuffers(Scene *pScene)
 	mMeshBuffer->Color(0, 3) = mMeshBuffer->GetMaterial()->mDiffuse;
 
 	mVisual->UpdateModelBound();
+	MarkBoundDirty();
 }
 
 //! sets the size of the billboard
@@ -69,7 +69,8 @@ CubeNode::CubeNode(const ActorId actorId, PVWUpdater* updater, WeakBaseRenderCom
 		texture, SamplerState::MIN_L_MAG_L_MIP_L, SamplerState::WRAP, SamplerState::WRAP);
 	mVisual->SetEffect(mEffect);
 	mVisual->UpdateModelBound();
-	mPVWUpdater->Subscribe(mWorldTransform, mEffect->GetPVWMatrixConstant());
+	MarkBoundDirty();
+	mPVWUpdater->Subscribe(this, mEffect->GetPVWMatrixConstant());
 }
 
 
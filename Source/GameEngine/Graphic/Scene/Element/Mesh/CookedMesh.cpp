@@ -0,0 +1,888 @@
+#include "CookedMesh.h"
+
+#include "Graphic/Scene/Element/Mesh/SkinnedMesh.h"
+#include "Graphic/Scene/Element/Mesh/StandardMesh.h"
+
+#include "Core/Logger/Logger.h"
+#include "Core/IO/FileSystem.h"
+#include "Core/Utility/StringUtil.h"
+
+#include <fstream>
+
+namespace
+{
+	char const gCookedTag[8] = { 'G', 'E', 'M', 'E', 'S', 'H', 0, 0 };
+
+	// Bytes of the data block, located from its start
+	struct CookedRange
+	{
+		unsigned int mOffset;
+		unsigned int mSize;
+	};
+
+	// The header is followed by the tables of dependencies, textures, buffers and joints,
+	// and then by the data block at mDataOffset
+	struct CookedHeader
+	{
+		char mTag[8];
+		unsigned int mVersion;
+		unsigned int mMeshType;
+		unsigned long long mSourceSize;
+		unsigned long long mSourceHash;
+		unsigned int mNumTextures;
+		unsigned int mNumBuffers;
+		unsigned int mNumJoints;
+		unsigned int mDataOffset;
+		unsigned int mDataSize;
+		unsigned int mNumDependencies;
+	};
+
+	// A texture file read by the import, named as the material references it
+	struct CookedDependency
+	{
+		CookedRange mPath;
+		unsigned long long mSize;
+		unsigned long long mHash;
+	};
+
+	struct CookedTexture
+	{
+		CookedRange mName;
+		CookedRange mTexels; // first level, the others are generated again
+		unsigned int mFormat;
+		unsigned int mWidth;
+		unsigned int mHeight;
+		unsigned int mHasMipmaps;
+	};
+
+	struct CookedLayer
+	{
+		int mTexture; // index of the texture, -1 for none
+		unsigned int mModeU;
+		unsigned int mModeV;
+		unsigned int mFilter;
+		unsigned int mLODBias;
+	};
+
+	enum CookedMaterialFlag
+	{
+		CMF_LIGHTING = 0x1,
+		CMF_DEPTH_BUFFER = 0x2,
+		CMF_ANTIALIASING = 0x4,
+		CMF_MULTISAMPLING = 0x8,
+		CMF_BLEND = 0x10
+	};
+
+	struct CookedMaterial
+	{
+		CookedLayer mLayers[MATERIAL_MAX_TEXTURES];
+		float mEmissive[4];
+		float mAmbient[4];
+		float mDiffuse[4];
+		float mSpecular[4];
+		float mShininess;
+		float mThickness;
+		unsigned int mType;
+		unsigned int mFlags;
+		unsigned int mDepthMask;
+		unsigned int mBlendColor[3]; // source, destination and operation
+		unsigned int mBlendAlpha[3];
+		unsigned int mBlendMask;
+		unsigned int mCullMode;
+		unsigned int mFillMode;
+		unsigned int mShadingModel;
+	};
+
+	struct CookedAttribute
+	{
+		unsigned int mSemantic;
+		unsigned int mType;
+		unsigned int mUnit;
+	};
+
+	struct CookedBuffer
+	{
+		CookedRange mName;
+		CookedRange mVertices;
+		CookedRange mIndices;
+		CookedAttribute mAttributes[VA_MAX_ATTRIBUTES];
+		unsigned int mNumAttributes;
+		unsigned int mVertexSize;
+		unsigned int mNumVertices;
+		unsigned int mNumPrimitives;
+		unsigned int mIndexSize;
+		CookedMaterial mMaterial;
+	};
+
+	enum CookedTransformFlag
+	{
+		CTF_IDENTITY = 0x1,
+		CTF_RS_MATRIX = 0x2,
+		CTF_UNIFORM_SCALE = 0x4
+	};
+
+	struct CookedTransform
+	{
+		float mMatrix[16];
+		float mTranslation[3];
+		float mScale[3];
+		unsigned int mFlags;
+	};
+
+	// Keys are stored as their frame followed by the components of their value
+	struct CookedJoint
+	{
+		CookedRange mName;
+		CookedRange mChildren;
+		CookedRange mAttachedMeshes;
+		CookedRange mPositionKeys;
+		CookedRange mScaleKeys;
+		CookedRange mRotationKeys;
+		CookedRange mWeights;
+		int mParent; // index of the parent joint, -1 for the roots
+		CookedTransform mLocalTransform;
+		CookedTransform mGlobalInversedTransform;
+	};
+
+	struct CookedWeight
+	{
+		unsigned int mBufferId;
+		unsigned int mVertexId;
+		float mStrength;
+	};
+
+	// Collects the data block while the tables are filled
+	class CookedWriter
+	{
+	public:
+		CookedRange Add(void const* data, unsigned int size)
+		{
+			CookedRange range;
+			range.mOffset = (unsigned int)mData.size();
+			range.mSize = size;
+			mData.insert(mData.end(), (char const*)data, (char const*)data + size);
+
+			// keeps the following data aligned for the loads
+			mData.resize((mData.size() + 15) & ~15);
+			return range;
+		}
+
+		CookedRange Add(eastl::string const& text)
+		{
+			return Add(text.c_str(), (unsigned int)text.size());
+		}
+
+		template <typename T>
+		CookedRange Add(eastl::vector<T> const& values)
+		{
+			return Add(values.data(), (unsigned int)(values.size() * sizeof(T)));
+		}
+
+		eastl::vector<char> mData;
+	};
+
+	// Resolves the ranges into pointers to the data block, failing for ranges outside it
+	class CookedReader
+	{
+	public:
+		CookedReader(char const* data, unsigned int size)
+			: mData(data), mSize(size)
+		{
+		}
+
+		template <typename T>
+		bool Resolve(CookedRange const& range, T const*& values, unsigned int& count) const
+		{
+			if (range.mOffset > mSize || range.mSize > mSize - range.mOffset ||
+				range.mSize % sizeof(T) != 0)
+			{
+				return false;
+			}
+
+			values = reinterpret_cast<T const*>(mData + range.mOffset);
+			count = range.mSize / sizeof(T);
+			return true;
+		}
+
+		bool Resolve(CookedRange const& range, eastl::string& text) const
+		{
+			char const* characters;
+			unsigned int count;
+			if (!Resolve(range, characters, count))
+				return false;
+
+			text.assign(characters, characters + count);
+			return true;
+		}
+
+	private:
+		char const* mData;
+		unsigned int mSize;
+	};
+
+	// Texture names are relative to the directory of the mesh unless they are absolute
+	eastl::wstring GetDependencyPath(eastl::wstring const& meshDirectory, eastl::wstring const& name)
+	{
+		bool isAbsolute = name[0] == L'/' || name[0] == L'\\' ||
+			(name.size() > 1 && name[1] == L':');
+		return isAbsolute ? name : meshDirectory + L"/" + name;
+	}
+
+	bool GetDependencySource(eastl::wstring const& path, CookedMesh::Source& source)
+	{
+		if (!FileSystem::Get()->ExistFile(path))
+			return false;
+
+		BaseReadFile* file = FileSystem::Get()->CreateReadFile(path);
+		if (!file)
+			return false;
+
+		source = CookedMesh::GetSource(file);
+		delete file;
+		return true;
+	}
+
+	CookedTransform CookTransform(Transform const& transform)
+	{
+		CookedTransform cooked;
+		memset(&cooked, 0, sizeof(cooked));
+
+		Matrix4x4<float> const& matrix = transform.GetMatrix();
+		for (int row = 0; row < 4; ++row)
+			for (int column = 0; column < 4; ++column)
+				cooked.mMatrix[row * 4 + column] = matrix(row, column);
+
+		Vector3<float> translation = transform.GetTranslation();
+		for (int i = 0; i < 3; ++i)
+			cooked.mTranslation[i] = translation[i];
+
+		if (transform.IsRSMatrix())
+		{
+			Vector3<float> scale = transform.GetScale();
+			for (int i = 0; i < 3; ++i)
+				cooked.mScale[i] = scale[i];
+			cooked.mFlags |= CTF_RS_MATRIX;
+			if (transform.IsUniformScale())
+				cooked.mFlags |= CTF_UNIFORM_SCALE;
+		}
+
+		if (transform.IsIdentity())
+			cooked.mFlags |= CTF_IDENTITY;
+		return cooked;
+	}
+
+	Transform UncookTransform(CookedTransform const& cooked)
+	{
+		Transform transform;
+		if (cooked.mFlags & CTF_IDENTITY)
+			return transform;
+
+		Matrix4x4<float> matrix;
+		for (int row = 0; row < 4; ++row)
+			for (int column = 0; column < 4; ++column)
+				matrix(row, column) = cooked.mMatrix[row * 4 + column];
+
+		if (cooked.mFlags & CTF_RS_MATRIX)
+		{
+			transform.SetRotation(matrix);
+			if (!(cooked.mFlags & CTF_UNIFORM_SCALE))
+				transform.SetScale(cooked.mScale[0], cooked.mScale[1], cooked.mScale[2]);
+			else if (cooked.mScale[0] != 1.0f)
+				transform.SetUniformScale(cooked.mScale[0]);
+		}
+		else transform.SetMatrix(matrix);
+
+		transform.SetTranslation(
+			cooked.mTranslation[0], cooked.mTranslation[1], cooked.mTranslation[2]);
+		return transform;
+	}
+
+	void CookColor(Vector4<float> const& color, float* cooked)
+	{
+		for (int i = 0; i < 4; ++i)
+			cooked[i] = color[i];
+	}
+
+	Vector4<float> UncookColor(float const* cooked)
+	{
+		return Vector4<float>{ cooked[0], cooked[1], cooked[2], cooked[3] };
+	}
+
+	void CookMaterial(Material const& material, CookedMaterial& cooked, CookedWriter& writer,
+		eastl::vector<CookedTexture>& textures, eastl::map<Texture2 const*, int>& textureIndices)
+	{
+		for (unsigned int layer = 0; layer < MATERIAL_MAX_TEXTURES; ++layer)
+		{
+			MaterialLayer const& materialLayer = material.mTextureLayer[layer];
+			CookedLayer& cookedLayer = cooked.mLayers[layer];
+			cookedLayer.mTexture = -1;
+			cookedLayer.mModeU = materialLayer.mModeU;
+			cookedLayer.mModeV = materialLayer.mModeV;
+			cookedLayer.mFilter = materialLayer.mFilter;
+			cookedLayer.mLODBias = materialLayer.mLODBias;
+
+			Texture2 const* texture = materialLayer.mTexture.get();
+			if (!texture)
+				continue;
+
+			// textures shared by several layers or buffers are cooked once
+			auto textureIndex = textureIndices.find(texture);
+			if (textureIndex == textureIndices.end())
+			{
+				CookedTexture cookedTexture;
+				cookedTexture.mName = writer.Add(ToString(texture->GetName().c_str()));
+				cookedTexture.mTexels = writer.Add(texture->GetData(), texture->GetNumBytesFor(0));
+				cookedTexture.mFormat = texture->GetFormat();
+				cookedTexture.mWidth = texture->GetWidth();
+				cookedTexture.mHeight = texture->GetHeight();
+				cookedTexture.mHasMipmaps = texture->HasMipmaps();
+
+				textureIndex = textureIndices.insert(
+					eastl::make_pair(texture, (int)textures.size())).first;
+				textures.push_back(cookedTexture);
+			}
+			cookedLayer.mTexture = textureIndex->second;
+		}
+
+		CookColor(material.mEmissive, cooked.mEmissive);
+		CookColor(material.mAmbient, cooked.mAmbient);
+		CookColor(material.mDiffuse, cooked.mDiffuse);
+		CookColor(material.mSpecular, cooked.mSpecular);
+		cooked.mShininess = material.mShininess;
+		cooked.mThickness = material.mThickness;
+		cooked.mType = material.mType;
+
+		cooked.mFlags = 0;
+		if (material.mLighting)
+			cooked.mFlags |= CMF_LIGHTING;
+		if (material.mDepthBuffer)
+			cooked.mFlags |= CMF_DEPTH_BUFFER;
+		if (material.mAntiAliasing)
+			cooked.mFlags |= CMF_ANTIALIASING;
+		if (material.mMultisampling)
+			cooked.mFlags |= CMF_MULTISAMPLING;
+		if (material.mBlendTarget.enable)
+			cooked.mFlags |= CMF_BLEND;
+
+		cooked.mDepthMask = material.mDepthMask;
+		cooked.mBlendColor[0] = material.mBlendTarget.srcColor;
+		cooked.mBlendColor[1] = material.mBlendTarget.dstColor;
+		cooked.mBlendColor[2] = material.mBlendTarget.opColor;
+		cooked.mBlendAlpha[0] = material.mBlendTarget.srcAlpha;
+		cooked.mBlendAlpha[1] = material.mBlendTarget.dstAlpha;
+		cooked.mBlendAlpha[2] = material.mBlendTarget.opAlpha;
+		cooked.mBlendMask = material.mBlendTarget.mask;
+		cooked.mCullMode = material.mCullMode;
+		cooked.mFillMode = material.mFillMode;
+		cooked.mShadingModel = material.mShadingModel;
+	}
+
+	bool UncookMaterial(CookedMaterial const& cooked, Material& material,
+		eastl::vector<eastl::shared_ptr<Texture2>> const& textures)
+	{
+		for (unsigned int layer = 0; layer < MATERIAL_MAX_TEXTURES; ++layer)
+		{
+			CookedLayer const& cookedLayer = cooked.mLayers[layer];
+			if (cookedLayer.mTexture >= (int)textures.size())
+				return false;
+
+			MaterialLayer& materialLayer = material.mTextureLayer[layer];
+			if (cookedLayer.mTexture >= 0)
+				materialLayer.mTexture = textures[cookedLayer.mTexture];
+			materialLayer.mModeU = (SamplerState::Mode)cookedLayer.mModeU;
+			materialLayer.mModeV = (SamplerState::Mode)cookedLayer.mModeV;
+			materialLayer.mFilter = (SamplerState::Filter)cookedLayer.mFilter;
+			materialLayer.mLODBias = cookedLayer.mLODBias != 0;
+		}
+
+		material.mEmissive = UncookColor(cooked.mEmissive);
+		material.mAmbient = UncookColor(cooked.mAmbient);
+		material.mDiffuse = UncookColor(cooked.mDiffuse);
+		material.mSpecular = UncookColor(cooked.mSpecular);
+		material.mShininess = cooked.mShininess;
+		material.mThickness = cooked.mThickness;
+		material.mType = (MaterialType)cooked.mType;
+
+		material.mLighting = (cooked.mFlags & CMF_LIGHTING) != 0;
+		material.mDepthBuffer = (cooked.mFlags & CMF_DEPTH_BUFFER) != 0;
+		material.mAntiAliasing = (cooked.mFlags & CMF_ANTIALIASING) != 0;
+		material.mMultisampling = (cooked.mFlags & CMF_MULTISAMPLING) != 0;
+		material.mBlendTarget.enable = (cooked.mFlags & CMF_BLEND) != 0;
+
+		material.mDepthMask = (DepthStencilState::WriteMask)cooked.mDepthMask;
+		material.mBlendTarget.srcColor = (BlendState::Mode)cooked.mBlendColor[0];
+		material.mBlendTarget.dstColor = (BlendState::Mode)cooked.mBlendColor[1];
+		material.mBlendTarget.opColor = (BlendState::Operation)cooked.mBlendColor[2];
+		material.mBlendTarget.srcAlpha = (BlendState::Mode)cooked.mBlendAlpha[0];
+		material.mBlendTarget.dstAlpha = (BlendState::Mode)cooked.mBlendAlpha[1];
+		material.mBlendTarget.opAlpha = (BlendState::Operation)cooked.mBlendAlpha[2];
+		material.mBlendTarget.mask = (unsigned char)cooked.mBlendMask;
+		material.mCullMode = (RasterizerState::CullMode)cooked.mCullMode;
+		material.mFillMode = (RasterizerState::FillMode)cooked.mFillMode;
+		material.mShadingModel = (ShadingModel)cooked.mShadingModel;
+		return true;
+	}
+}
+
+CookedMesh::Source CookedMesh::GetSource(BaseReadFile* file)
+{
+	Source source;
+	source.mSize = file->GetSize();
+
+	// 64-bit FNV-1a of the contents
+	source.mHash = 14695981039346656037ULL;
+	eastl::vector<unsigned char> chunk(65536);
+
+	file->Seek(0);
+	int read;
+	while ((read = file->Read(chunk.data(), (unsigned int)chunk.size())) > 0)
+	{
+		for (int i = 0; i < read; ++i)
+		{
+			source.mHash ^= chunk[i];
+			source.mHash *= 1099511628211ULL;
+		}
+	}
+	file->Seek(0);
+
+	return source;
+}
+
+bool CookedMesh::Save(BaseMesh* mesh, Source const& source, eastl::wstring const& filename)
+{
+	MeshType meshType = mesh->GetMeshType();
+	if (meshType != MT_STANDARD && meshType != MT_SKINNED)
+		return false;
+
+	CookedWriter writer;
+	eastl::vector<CookedTexture> textures;
+	eastl::map<Texture2 const*, int> textureIndices;
+
+	eastl::vector<CookedBuffer> buffers(mesh->GetMeshBufferCount());
+	for (unsigned int b = 0; b < mesh->GetMeshBufferCount(); ++b)
+	{
+		eastl::shared_ptr<BaseMeshBuffer> meshBuffer = mesh->GetMeshBuffer(b);
+		eastl::shared_ptr<VertexBuffer> const& vertices = meshBuffer->GetVertice();
+		eastl::shared_ptr<IndexBuffer> const& indices = meshBuffer->GetIndice();
+
+		CookedBuffer& buffer = buffers[b];
+		memset(&buffer, 0, sizeof(buffer));
+		buffer.mName = writer.Add(ToString(meshBuffer->GetName().c_str()));
+		buffer.mVertices = writer.Add(vertices->GetData(), vertices->GetNumBytes());
+		buffer.mIndices = writer.Add(indices->GetData(), indices->GetNumBytes());
+
+		VertexFormat const& vformat = vertices->GetFormat();
+		buffer.mNumAttributes = vformat.GetNumAttributes();
+		for (unsigned int a = 0; a < buffer.mNumAttributes; ++a)
+		{
+			VASemantic semantic;
+			DFType type;
+			unsigned int unit, offset;
+			vformat.GetAttribute(a, semantic, type, unit, offset);
+
+			buffer.mAttributes[a].mSemantic = semantic;
+			buffer.mAttributes[a].mType = type;
+			buffer.mAttributes[a].mUnit = unit;
+		}
+		buffer.mVertexSize = vformat.GetVertexSize();
+		buffer.mNumVertices = vertices->GetNumElements();
+		buffer.mNumPrimitives = indices->GetNumPrimitives();
+		buffer.mIndexSize = indices->GetElementSize();
+
+		CookMaterial(*meshBuffer->GetMaterial(), buffer.mMaterial, writer, textures, textureIndices);
+	}
+
+	eastl::vector<CookedJoint> joints;
+	if (meshType == MT_SKINNED)
+	{
+		SkinnedMesh* skinnedMesh = static_cast<SkinnedMesh*>(mesh);
+		eastl::vector<BaseSkinnedMesh::Joint*> const& allJoints = skinnedMesh->GetAllJoints();
+
+		eastl::map<BaseSkinnedMesh::Joint const*, int> jointIndices;
+		for (unsigned int j = 0; j < allJoints.size(); ++j)
+			jointIndices[allJoints[j]] = j;
+
+		joints.resize(allJoints.size());
+		for (unsigned int j = 0; j < allJoints.size(); ++j)
+		{
+			BaseSkinnedMesh::Joint const* joint = allJoints[j];
+			CookedJoint& cooked = joints[j];
+
+			cooked.mName = writer.Add(joint->mName);
+			cooked.mParent = joint->mParent ? jointIndices[joint->mParent] : -1;
+
+			eastl::vector<unsigned int> children;
+			for (BaseSkinnedMesh::Joint const* child : joint->mChildren)
+				children.push_back(jointIndices[child]);
+			cooked.mChildren = writer.Add(children);
+			cooked.mAttachedMeshes = writer.Add(joint->mAttachedMeshes);
+
+			eastl::vector<float> keys;
+			for (BaseSkinnedMesh::PositionKey const& key : joint->mPositionKeys)
+			{
+				keys.push_back(key.mFrame);
+				keys.insert(keys.end(), &key.mPosition[0], &key.mPosition[0] + 3);
+			}
+			cooked.mPositionKeys = writer.Add(keys);
+
+			keys.clear();
+			for (BaseSkinnedMesh::ScaleKey const& key : joint->mScaleKeys)
+			{
+				keys.push_back(key.mFrame);
+				keys.insert(keys.end(), &key.mScale[0], &key.mScale[0] + 3);
+			}
+			cooked.mScaleKeys = writer.Add(keys);
+
+			keys.clear();
+			for (BaseSkinnedMesh::RotationKey const& key : joint->mRotationKeys)
+			{
+				keys.push_back(key.mFrame);
+				keys.insert(keys.end(), &key.mRotation[0], &key.mRotation[0] + 4);
+			}
+			cooked.mRotationKeys = writer.Add(keys);
+
+			eastl::vector<CookedWeight> weights;
+			for (BaseSkinnedMesh::Weight const& weight : joint->mWeights)
+			{
+				CookedWeight cookedWeight;
+				cookedWeight.mBufferId = weight.mBufferId;
+				cookedWeight.mVertexId = weight.mVertexId;
+				cookedWeight.mStrength = weight.mStrength;
+				weights.push_back(cookedWeight);
+			}
+			cooked.mWeights = writer.Add(weights);
+
+			cooked.mLocalTransform = CookTransform(joint->mLocalTransform);
+			cooked.mGlobalInversedTransform = CookTransform(joint->mGlobalInversedTransform);
+		}
+	}
+
+	// the textures read from files are checked when loading, the embedded ones are part
+	// of the source
+	eastl::wstring meshDirectory = FileSystem::Get()->GetFileDir(filename);
+	eastl::set<eastl::wstring> dependencyNames;
+	eastl::vector<CookedDependency> dependencies;
+	for (auto const& textureIndex : textureIndices)
+	{
+		eastl::wstring const& name = textureIndex.first->GetName();
+		if (name.empty() || name[0] == L'*' || !dependencyNames.insert(name).second)
+			continue;
+
+		CookedMesh::Source dependencySource;
+		if (!GetDependencySource(GetDependencyPath(meshDirectory, name), dependencySource))
+		{
+			LogWarning(L"Couldn't read texture " + name + L" of cooked mesh " + filename);
+			return false;
+		}
+
+		CookedDependency dependency;
+		dependency.mPath = writer.Add(ToString(name.c_str()));
+		dependency.mSize = dependencySource.mSize;
+		dependency.mHash = dependencySource.mHash;
+		dependencies.push_back(dependency);
+	}
+
+	CookedHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.mTag, gCookedTag, sizeof(gCookedTag));
+	header.mVersion = Version;
+	header.mMeshType = meshType;
+	header.mSourceSize = source.mSize;
+	header.mSourceHash = source.mHash;
+	header.mNumTextures = (unsigned int)textures.size();
+	header.mNumBuffers = (unsigned int)buffers.size();
+	header.mNumJoints = (unsigned int)joints.size();
+	header.mNumDependencies = (unsigned int)dependencies.size();
+
+	size_t tablesEnd = sizeof(CookedHeader) + dependencies.size() * sizeof(CookedDependency) +
+		textures.size() * sizeof(CookedTexture) + buffers.size() * sizeof(CookedBuffer) +
+		joints.size() * sizeof(CookedJoint);
+	header.mDataOffset = (unsigned int)((tablesEnd + 15) & ~15);
+	header.mDataSize = (unsigned int)writer.mData.size();
+
+	std::ofstream file(filename.c_str(), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+	if (!file)
+	{
+		LogWarning(L"Couldn't write cooked mesh " + filename);
+		return false;
+	}
+
+	char const padding[16] = { 0 };
+	file.write((char const*)&header, sizeof(header));
+	file.write((char const*)dependencies.data(), dependencies.size() * sizeof(CookedDependency));
+	file.write((char const*)textures.data(), textures.size() * sizeof(CookedTexture));
+	file.write((char const*)buffers.data(), buffers.size() * sizeof(CookedBuffer));
+	file.write((char const*)joints.data(), joints.size() * sizeof(CookedJoint));
+	file.write(padding, header.mDataOffset - tablesEnd);
+	file.write(writer.mData.data(), writer.mData.size());
+	return file.good();
+}
+
+eastl::shared_ptr<BaseMesh> CookedMesh::Load(eastl::wstring const& filename, Source const& source)
+{
+	if (!FileSystem::Get()->ExistFile(filename))
+		return nullptr;
+
+	BaseReadFile* file = FileSystem::Get()->CreateReadFile(filename);
+	if (!file)
+		return nullptr;
+
+	eastl::vector<char> data(file->GetSize());
+	int size = file->Read(data.data(), (unsigned int)data.size());
+	delete file;
+
+	CookedHeader header;
+	if (size != (int)data.size() || data.size() < sizeof(header))
+	{
+		LogWarning(L"Invalid cooked mesh " + filename);
+		return nullptr;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+
+	// files cooked from another source or by another version are imported again
+	if (memcmp(header.mTag, gCookedTag, sizeof(gCookedTag)) != 0 || header.mVersion != Version ||
+		header.mSourceSize != source.mSize || header.mSourceHash != source.mHash)
+	{
+		return nullptr;
+	}
+
+	unsigned long long tablesEnd = sizeof(CookedHeader) +
+		(unsigned long long)header.mNumDependencies * sizeof(CookedDependency) +
+		(unsigned long long)header.mNumTextures * sizeof(CookedTexture) +
+		(unsigned long long)header.mNumBuffers * sizeof(CookedBuffer) +
+		(unsigned long long)header.mNumJoints * sizeof(CookedJoint);
+	if ((header.mMeshType != MT_STANDARD && header.mMeshType != MT_SKINNED) ||
+		tablesEnd > header.mDataOffset ||
+		(unsigned long long)header.mDataOffset + header.mDataSize > data.size())
+	{
+		LogWarning(L"Invalid cooked mesh " + filename);
+		return nullptr;
+	}
+
+	CookedDependency const* dependencyTable =
+		reinterpret_cast<CookedDependency const*>(data.data() + sizeof(CookedHeader));
+	CookedTexture const* textureTable =
+		reinterpret_cast<CookedTexture const*>(dependencyTable + header.mNumDependencies);
+	CookedBuffer const* bufferTable =
+		reinterpret_cast<CookedBuffer const*>(textureTable + header.mNumTextures);
+	CookedJoint const* jointTable =
+		reinterpret_cast<CookedJoint const*>(bufferTable + header.mNumBuffers);
+	CookedReader reader(data.data() + header.mDataOffset, header.mDataSize);
+
+	// a texture file changed since the mesh was cooked also imports the mesh again
+	eastl::wstring meshDirectory = FileSystem::Get()->GetFileDir(filename);
+	for (unsigned int d = 0; d < header.mNumDependencies; ++d)
+	{
+		eastl::string name;
+		if (!reader.Resolve(dependencyTable[d].mPath, name) || name.empty())
+		{
+			LogWarning(L"Invalid cooked mesh " + filename);
+			return nullptr;
+		}
+
+		CookedMesh::Source dependencySource;
+		eastl::wstring path = GetDependencyPath(meshDirectory, ToWideString(name.c_str()));
+		if (!GetDependencySource(path, dependencySource) ||
+			dependencySource.mSize != dependencyTable[d].mSize ||
+			dependencySource.mHash != dependencyTable[d].mHash)
+		{
+			return nullptr;
+		}
+	}
+
+	eastl::vector<eastl::shared_ptr<Texture2>> textures;
+	for (unsigned int t = 0; t < header.mNumTextures; ++t)
+	{
+		CookedTexture const& cooked = textureTable[t];
+
+		eastl::string name;
+		char const* texels;
+		unsigned int numBytes;
+		if (!reader.Resolve(cooked.mName, name) || !reader.Resolve(cooked.mTexels, texels, numBytes))
+		{
+			LogWarning(L"Invalid cooked mesh " + filename);
+			return nullptr;
+		}
+
+		eastl::shared_ptr<Texture2> texture = eastl::make_shared<Texture2>(
+			(DFType)cooked.mFormat, cooked.mWidth, cooked.mHeight, cooked.mHasMipmaps != 0);
+		if (texture->GetNumBytesFor(0) != numBytes)
+		{
+			LogWarning(L"Invalid cooked mesh " + filename);
+			return nullptr;
+		}
+		texture->SetName(ToWideString(name.c_str()));
+		memcpy(texture->GetData(), texels, numBytes);
+		if (texture->HasMipmaps())
+			texture->AutogenerateMipmaps();
+		textures.push_back(texture);
+	}
+
+	bool isSkinned = header.mMeshType == MT_SKINNED;
+	eastl::shared_ptr<BaseMesh> mesh;
+	if (isSkinned)
+		mesh = eastl::make_shared<SkinnedMesh>();
+	else
+		mesh = eastl::make_shared<StandardMesh>();
+
+	for (unsigned int b = 0; b < header.mNumBuffers; ++b)
+	{
+		CookedBuffer const& cooked = bufferTable[b];
+
+		VertexFormat vformat;
+		for (unsigned int a = 0; a < cooked.mNumAttributes && a < VA_MAX_ATTRIBUTES; ++a)
+		{
+			vformat.Bind((VASemantic)cooked.mAttributes[a].mSemantic,
+				(DFType)cooked.mAttributes[a].mType, cooked.mAttributes[a].mUnit);
+		}
+
+		eastl::string name;
+		char const* vertices;
+		char const* indices;
+		unsigned int numVertexBytes, numIndexBytes;
+		if (vformat.GetNumAttributes() != (int)cooked.mNumAttributes ||
+			vformat.GetVertexSize() != cooked.mVertexSize ||
+			!reader.Resolve(cooked.mName, name) ||
+			!reader.Resolve(cooked.mVertices, vertices, numVertexBytes) ||
+			!reader.Resolve(cooked.mIndices, indices, numIndexBytes))
+		{
+			LogWarning(L"Invalid cooked mesh " + filename);
+			return nullptr;
+		}
+
+		// the mesh owns the buffer from here on
+		BaseMeshBuffer* meshBuffer = NULL;
+		if (isSkinned)
+		{
+			meshBuffer = new SkinMeshBuffer(
+				vformat, cooked.mNumVertices, cooked.mNumPrimitives, cooked.mIndexSize);
+		}
+		else
+		{
+			meshBuffer = new MeshBuffer(
+				vformat, cooked.mNumVertices, cooked.mNumPrimitives, cooked.mIndexSize);
+		}
+		mesh->AddMeshBuffer(meshBuffer);
+
+		eastl::shared_ptr<VertexBuffer> const& vertexBuffer = meshBuffer->GetVertice();
+		eastl::shared_ptr<IndexBuffer> const& indexBuffer = meshBuffer->GetIndice();
+		if (vertexBuffer->GetNumBytes() != numVertexBytes ||
+			indexBuffer->GetNumBytes() != numIndexBytes ||
+			!UncookMaterial(cooked.mMaterial, *meshBuffer->GetMaterial(), textures))
+		{
+			LogWarning(L"Invalid cooked mesh " + filename);
+			return nullptr;
+		}
+
+		meshBuffer->SetName(ToWideString(name.c_str()));
+		memcpy(vertexBuffer->GetData(), vertices, numVertexBytes);
+		memcpy(indexBuffer->GetData(), indices, numIndexBytes);
+	}
+
+	if (isSkinned)
+	{
+		SkinnedMesh* skinnedMesh = static_cast<SkinnedMesh*>(mesh.get());
+		for (unsigned int j = 0; j < header.mNumJoints; ++j)
+			skinnedMesh->AddJoint();
+
+		eastl::vector<BaseSkinnedMesh::Joint*>& allJoints = skinnedMesh->GetAllJoints();
+		for (unsigned int j = 0; j < header.mNumJoints; ++j)
+		{
+			CookedJoint const& cooked = jointTable[j];
+			BaseSkinnedMesh::Joint* joint = allJoints[j];
+
+			unsigned int const* children;
+			unsigned int const* attachedMeshes;
+			float const* positionKeys;
+			float const* scaleKeys;
+			float const* rotationKeys;
+			CookedWeight const* weights;
+			unsigned int numChildren, numAttachedMeshes, numWeights;
+			unsigned int numPositionKeys, numScaleKeys, numRotationKeys;
+			if (cooked.mParent >= (int)header.mNumJoints ||
+				!reader.Resolve(cooked.mName, joint->mName) ||
+				!reader.Resolve(cooked.mChildren, children, numChildren) ||
+				!reader.Resolve(cooked.mAttachedMeshes, attachedMeshes, numAttachedMeshes) ||
+				!reader.Resolve(cooked.mPositionKeys, positionKeys, numPositionKeys) ||
+				!reader.Resolve(cooked.mScaleKeys, scaleKeys, numScaleKeys) ||
+				!reader.Resolve(cooked.mRotationKeys, rotationKeys, numRotationKeys) ||
+				!reader.Resolve(cooked.mWeights, weights, numWeights) ||
+				numPositionKeys % 4 != 0 || numScaleKeys % 4 != 0 || numRotationKeys % 5 != 0)
+			{
+				LogWarning(L"Invalid cooked mesh " + filename);
+				return nullptr;
+			}
+
+			if (cooked.mParent >= 0)
+				joint->mParent = allJoints[cooked.mParent];
+
+			for (unsigned int c = 0; c < numChildren; ++c)
+			{
+				if (children[c] >= header.mNumJoints)
+				{
+					LogWarning(L"Invalid cooked mesh " + filename);
+					return nullptr;
+				}
+				joint->mChildren.push_back(allJoints[children[c]]);
+			}
+
+			// the skinning indexes the buffers and their vertices with these
+			for (unsigned int m = 0; m < numAttachedMeshes; ++m)
+			{
+				if (attachedMeshes[m] >= header.mNumBuffers)
+				{
+					LogWarning(L"Invalid cooked mesh " + filename);
+					return nullptr;
+				}
+			}
+			joint->mAttachedMeshes.assign(attachedMeshes, attachedMeshes + numAttachedMeshes);
+
+			for (unsigned int k = 0; k < numPositionKeys; k += 4)
+			{
+				BaseSkinnedMesh::PositionKey* positionKey = skinnedMesh->AddPositionKey(joint);
+				positionKey->mFrame = positionKeys[k];
+				positionKey->mPosition = Vector3<float>{
+					positionKeys[k + 1], positionKeys[k + 2], positionKeys[k + 3] };
+			}
+
+			for (unsigned int k = 0; k < numScaleKeys; k += 4)
+			{
+				BaseSkinnedMesh::ScaleKey* scaleKey = skinnedMesh->AddScaleKey(joint);
+				scaleKey->mFrame = scaleKeys[k];
+				scaleKey->mScale = Vector3<float>{
+					scaleKeys[k + 1], scaleKeys[k + 2], scaleKeys[k + 3] };
+			}
+
+			for (unsigned int k = 0; k < numRotationKeys; k += 5)
+			{
+				BaseSkinnedMesh::RotationKey* rotationKey = skinnedMesh->AddRotationKey(joint);
+				rotationKey->mFrame = rotationKeys[k];
+				rotationKey->mRotation.Set(rotationKeys[k + 1],
+					rotationKeys[k + 2], rotationKeys[k + 3], rotationKeys[k + 4]);
+			}
+
+			for (unsigned int w = 0; w < numWeights; ++w)
+			{
+				if (weights[w].mBufferId >= header.mNumBuffers ||
+					weights[w].mVertexId >= bufferTable[weights[w].mBufferId].mNumVertices)
+				{
+					LogWarning(L"Invalid cooked mesh " + filename);
+					return nullptr;
+				}
+
+				BaseSkinnedMesh::Weight weight;
+				weight.mBufferId = weights[w].mBufferId;
+				weight.mVertexId = weights[w].mVertexId;
+				weight.mStrength = weights[w].mStrength;
+				joint->mWeights.push_back(weight);
+			}
+
+			joint->mLocalTransform = UncookTransform(cooked.mLocalTransform);
+			joint->mGlobalInversedTransform = UncookTransform(cooked.mGlobalInversedTransform);
+		}
+
+		skinnedMesh->Finalize();
+	}
+
+	return mesh;
+}
@@ -0,0 +1,46 @@
+#ifndef COOKEDMESH_H
+#define COOKEDMESH_H
+
+#include "GameEngineStd.h"
+
+#include "Graphic/Scene/Element/Mesh/Mesh.h"
+
+#include "Core/IO/BaseReadFile.h"
+
+/*
+	CookedMesh writes and reads the binary cache of the meshes imported by assimp. A cooked
+	file keeps what the import produced: the vertex and index buffers, materials with the
+	decoded textures, and for skinned meshes the joints with their weights and animation
+	keys. The file is a header followed by fixed size tables whose records locate their
+	data by offsets into one data block, so it loads with a single read, the offsets are
+	checked against the block and resolved to pointers, and the buffers are copied out.
+
+	A cooked file identifies its source, and each texture file the import read, by size
+	and hash. A file cooked from another version of the source, of one of its textures or
+	of the format is ignored so the mesh is imported again.
+*/
+class CookedMesh
+{
+public:
+	// Changes whenever the layout of the cooked files changes
+	static unsigned int const Version = 2;
+
+	// Identity of the source file a mesh is cooked from
+	struct Source
+	{
+		unsigned long long mSize;
+		unsigned long long mHash;
+	};
+
+	// Hashes the contents of the source file and rewinds it
+	static Source GetSource(BaseReadFile* file);
+
+	// Writes the mesh as imported, skinned meshes must not be finalized yet
+	static bool Save(BaseMesh* mesh, Source const& source, eastl::wstring const& filename);
+
+	// Creates the mesh from a cooked file, finalized and ready to use. Returns null if the
+	// file doesn't exist, is damaged or doesn't match the source.
+	static eastl::shared_ptr<BaseMesh> Load(eastl::wstring const& filename, Source const& source);
+};
+
+#endif
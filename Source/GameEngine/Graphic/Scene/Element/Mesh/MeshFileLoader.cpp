@@ -7,6 +7,7 @@
 #include "MeshFileLoader.h"
 
 #include "Graphic/Image/ImageResource.h"
+#include "Graphic/Scene/Element/Mesh/CookedMesh.h"
 #include "Graphic/Scene/Element/Mesh/MeshMD3.h"
 #include "Graphic/Scene/Element/Mesh/SkinnedMesh.h"
 #include "Graphic/Scene/Element/Mesh/StandardMesh.h"
@@ -23,7 +24,8 @@
 
 
 //! Constructor
-MeshFileLoader::MeshFileLoader( )
+MeshFileLoader::MeshFileLoader(bool useCookedMeshes)
+	: mUseCookedMeshes(useCookedMeshes)
 {
 }
 
@@ -766,6 +768,22 @@ void ReadNodeMesh(const aiScene* pScene,
 // -------------------------------------------------------------------------------
 eastl::shared_ptr<BaseMesh> MeshFileLoader::CreateMesh(BaseReadFile* file)
 {
+	eastl::wstring fileExtension =
+		file->GetFileName().substr(file->GetFileName().rfind('.') + 1);
+
+	// the md3 models read their own binary files, every other format is imported
+	// only when its cooked mesh is missing or out of date
+	bool cookMesh = mUseCookedMeshes && fileExtension != L"md3";
+	eastl::wstring cookedFile = file->GetFileName() + L".cooked";
+	CookedMesh::Source source;
+	if (cookMesh)
+	{
+		source = CookedMesh::GetSource(file);
+		eastl::shared_ptr<BaseMesh> cookedMesh = CookedMesh::Load(cookedFile, source);
+		if (cookedMesh)
+			return cookedMesh;
+	}
+
 	// Create an instance of the Importer class
 	Assimp::Importer importer;
 
@@ -786,8 +804,6 @@ eastl::shared_ptr<BaseMesh> MeshFileLoader::CreateMesh(BaseReadFile* file)
 	eastl::wstring saveDir = FileSystem::Get()->GetWorkingDirectory();
 	FileSystem::Get()->ChangeWorkingDirectoryTo(
 		FileSystem::Get()->GetFileDir(file->GetFileName()));
-	eastl::wstring fileExtension = 
-		file->GetFileName().substr(file->GetFileName().rfind('.') + 1);
 
 	BaseMesh * mesh = NULL;
 	if (pScene->HasAnimations())
@@ -843,9 +859,16 @@ eastl::shared_ptr<BaseMesh> MeshFileLoader::CreateMesh(BaseReadFile* file)
 		SkinnedMesh* skinnedMesh = dynamic_cast<SkinnedMesh*>(mesh);
 
 		ReadNodeSkinMesh(pScene, pScene->mRootNode, nullptr, skinnedMesh);
-		skinnedMesh->Finalize();
 	}
 
 	FileSystem::Get()->ChangeWorkingDirectoryTo(saveDir);
+
+	// the mesh is cooked as imported, before the skinned meshes are finalized
+	if (cookMesh)
+		CookedMesh::Save(mesh, source, cookedFile);
+
+	if (mesh->GetMeshType() == MT_SKINNED)
+		dynamic_cast<SkinnedMesh*>(mesh)->Finalize();
+
 	return eastl::shared_ptr<BaseMesh>(mesh);
 }
\ No newline at end of file
@@ -13,7 +13,9 @@ class MeshFileLoader : public BaseResourceLoader
 public:
 
 	//! Constructor
-	MeshFileLoader( );
+	/** \param useCookedMeshes Imported meshes are cooked into a binary file next to
+	their source, which later loads replace the import with. */
+	MeshFileLoader(bool useCookedMeshes = true);
 
 	//! destructor
 	virtual ~MeshFileLoader();
@@ -33,6 +35,8 @@ protected:
 	//! creates/loads an animated mesh from the file.
 	//! \return Pointer to the created mesh. Returns 0 if loading failed.
 	eastl::shared_ptr<BaseMesh> CreateMesh(BaseReadFile* file);
+
+	bool mUseCookedMeshes;
 };
 
 #endif
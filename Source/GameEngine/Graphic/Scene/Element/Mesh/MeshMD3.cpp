@@ -8,6 +8,19 @@
 #include "Core/IO/Filesystem.h"
 #include "Core/Utility/StringUtil.h"
 
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define MD3_SSE
+#endif
+
+//! vertex of the hardware morphing with the positions of both frames
+struct MD3MorphVertex
+{
+	Vector3<float> mPosition;
+	Vector2<float> mTCoord;
+	Vector3<float> mNextPosition;
+};
+
 void MD3Mesh::SetInterpolationShift(unsigned int shift, unsigned int loopMode)
 {
 	mInterPolShift = shift;
@@ -297,9 +310,11 @@ bool MD3Mesh::UpdateMesh(int frame, int detailLevel, int startFrameLoop, int end
 		frameB = eastl::min(frameA + 1, endFrameLoop);
 	}
 
-	// build current vertex
-	for (unsigned int i = 0; i != mBufferInterpol.size(); ++i)
-		BuildVertexArray(i, frameA, frameB, interpolation);
+	// the vertices are built later on by BuildVertices
+	mVerticesPending = true;
+	mFrameA = frameA;
+	mFrameB = frameB;
+	mInterpolation = interpolation;
 
 	// build current tags
 	BuildTagArray(frameA, frameB, interpolation);
@@ -308,38 +323,164 @@ bool MD3Mesh::UpdateMesh(int frame, int detailLevel, int startFrameLoop, int end
 	return true;
 }
 
+//! builds the vertices of the frames selected by the last UpdateMesh
+void MD3Mesh::BuildVertices()
+{
+	if (!mVerticesPending)
+		return;
+
+	mVerticesPending = false;
+	if (mHardwareMorphing)
+	{
+		// the shader interpolates, the vertices only change with the frames
+		if (mFrameA != mMorphFrameA || mFrameB != mMorphFrameB)
+		{
+			for (unsigned int i = 0; i != mMorphVertices.size(); ++i)
+			{
+				BuildMorphArray(i, mFrameA, mFrameB);
+				mMorphChanged[i] = true;
+			}
+			mMorphFrameA = mFrameA;
+			mMorphFrameB = mFrameB;
+		}
+	}
+	else
+	{
+		for (unsigned int i = 0; i != mBufferInterpol.size(); ++i)
+			BuildVertexArray(i, mFrameA, mFrameB, mInterpolation);
+	}
+}
+
+unsigned int MD3Mesh::GetVertexCount() const
+{
+	unsigned int numVertices = 0;
+	for (unsigned int i = 0; i != mBufferInterpol.size(); ++i)
+		numVertices += mBufferInterpol[i]->GetVertice()->GetNumElements();
+	return numVertices;
+}
+
+//! interpolates the vectors of two frames into the vertices of target. The
+//! vectors of a frame are contiguous, so four vertices fit in three SSE lanes.
+static void InterpolateFrames(char* target, unsigned int stride,
+	float const* frameA, float const* frameB, float interpolate, unsigned int numVertices)
+{
+	unsigned int i = 0;
+#if defined(MD3_SSE)
+	__m128 const factor = _mm_set1_ps(interpolate);
+	float result[12];
+	for (; i + 4 <= numVertices; i += 4, frameA += 12, frameB += 12)
+	{
+		for (unsigned int k = 0; k < 3; ++k)
+		{
+			__m128 a = _mm_loadu_ps(frameA + 4 * k);
+			__m128 b = _mm_loadu_ps(frameB + 4 * k);
+			_mm_storeu_ps(result + 4 * k, _mm_add_ps(a, _mm_mul_ps(factor, _mm_sub_ps(b, a))));
+		}
+
+		for (unsigned int k = 0; k < 4; ++k)
+			memcpy(target + (i + k) * stride, result + 3 * k, 3 * sizeof(float));
+	}
+#endif
+	for (; i < numVertices; ++i, frameA += 3, frameB += 3)
+	{
+		float* vertex = reinterpret_cast<float*>(target + i * stride);
+		vertex[0] = frameA[0] + interpolate * (frameB[0] - frameA[0]);
+		vertex[1] = frameA[1] + interpolate * (frameB[1] - frameA[1]);
+		vertex[2] = frameA[2] + interpolate * (frameB[2] - frameA[2]);
+	}
+}
+
 //! build final mesh's vertices from frames frameA and frameB with linear interpolation.
 void MD3Mesh::BuildVertexArray(unsigned int meshId,
 	unsigned int frameA, unsigned int frameB, float interpolate)
 {
-	const unsigned int frameOffsetA = frameA * mBufferInterpol[meshId]->GetVertice()->GetNumElements();
-	const unsigned int frameOffsetB = frameB * mBufferInterpol[meshId]->GetVertice()->GetNumElements();
+	const eastl::shared_ptr<MeshBuffer>& meshBuffer = mBufferInterpol[meshId];
+	const eastl::shared_ptr<MD3MeshBuffer>& buffer = mBuffer[meshId];
 
-	for (unsigned int i = 0; i != mBuffer[meshId]->mMeshHeader.numTriangles; ++i)
-	{
-		for (unsigned int idx = 0; idx < 3; idx++)
-		{
-			int index = mBuffer[meshId]->mFaces[i].index[idx];
+	// every vertex is interpolated once, straight from the frame arrays
+	const unsigned int numVertices = meshBuffer->GetVertice()->GetNumElements();
+	const unsigned int stride = meshBuffer->GetVertice()->GetElementSize();
+	const unsigned int frameOffsetA = frameA * numVertices;
+	const unsigned int frameOffsetB = frameB * numVertices;
 
-			const Vector3<float> &vA = mBuffer[meshId]->mPositions[frameOffsetA + index];
-			const Vector3<float> &vB = mBuffer[meshId]->mPositions[frameOffsetB + index];
+	InterpolateFrames(reinterpret_cast<char*>(&meshBuffer->Position(0)), stride,
+		&buffer->mPositions[frameOffsetA][0], &buffer->mPositions[frameOffsetB][0],
+		interpolate, numVertices);
+	InterpolateFrames(reinterpret_cast<char*>(&meshBuffer->Normal(0)), stride,
+		&buffer->mNormals[frameOffsetA][0], &buffer->mNormals[frameOffsetB][0],
+		interpolate, numVertices);
 
-			// position
-			mBufferInterpol[meshId]->Position(index)[0] = vA[0] + interpolate * (vB[0] - vA[0]);
-			mBufferInterpol[meshId]->Position(index)[1] = vA[1] + interpolate * (vB[1] - vA[1]);
-			mBufferInterpol[meshId]->Position(index)[2] = vA[2] + interpolate * (vB[2] - vA[2]);
+	//dest->recalculateBoundingBox();
+}
+
+//! copies the positions of frames frameA and frameB to the morph vertices.
+void MD3Mesh::BuildMorphArray(unsigned int meshId, unsigned int frameA, unsigned int frameB)
+{
+	const eastl::shared_ptr<VertexBuffer>& vbuffer = mMorphVertices[meshId];
+	const eastl::shared_ptr<MD3MeshBuffer>& buffer = mBuffer[meshId];
+
+	const unsigned int numVertices = vbuffer->GetNumElements();
+	const Vector3<float>* positionsA = &buffer->mPositions[frameA * numVertices];
+	const Vector3<float>* positionsB = &buffer->mPositions[frameB * numVertices];
+
+	MD3MorphVertex* vertex = vbuffer->Get<MD3MorphVertex>();
+	for (unsigned int i = 0; i < numVertices; ++i, ++vertex)
+	{
+		vertex->mPosition = positionsA[i];
+		vertex->mNextPosition = positionsB[i];
+	}
+}
+
+void MD3Mesh::SetHardwareMorphing(bool morphing)
+{
+	mHardwareMorphing = morphing;
+	if (mHardwareMorphing && mMorphVertices.empty())
+	{
+		VertexFormat vformat;
+		vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+		vformat.Bind(VA_TEXCOORD, DF_R32G32_FLOAT, 0);
+		vformat.Bind(VA_TEXCOORD, DF_R32G32B32_FLOAT, 1);
 
-			// normal
-			const Vector3<float> &nA = mBuffer[meshId]->mNormals[frameOffsetA + index];
-			const Vector3<float> &nB = mBuffer[meshId]->mNormals[frameOffsetB + index];
+		for (unsigned int i = 0; i != mBuffer.size(); ++i)
+		{
+			const unsigned int numVertices = mBuffer[i]->mMeshHeader.numVertices;
+			eastl::shared_ptr<VertexBuffer> vbuffer =
+				eastl::make_shared<VertexBuffer>(vformat, numVertices);
+			vbuffer->SetUsage(Resource::DYNAMIC_UPDATE);
 
-			mBufferInterpol[meshId]->Normal(index)[0] = nA[0] + interpolate * (nB[0] - nA[0]);
-			mBufferInterpol[meshId]->Normal(index)[1] = nA[1] + interpolate * (nB[1] - nA[1]);
-			mBufferInterpol[meshId]->Normal(index)[2] = nA[2] + interpolate * (nB[2] - nA[2]);
+			MD3MorphVertex* vertex = vbuffer->Get<MD3MorphVertex>();
+			for (unsigned int v = 0; v < numVertices; ++v, ++vertex)
+			{
+				vertex->mTCoord = Vector2<float>{
+					mBuffer[i]->mTexCoords[v].u, mBuffer[i]->mTexCoords[v].v };
+			}
+			mMorphVertices.push_back(vbuffer);
 		}
+		mMorphChanged.resize(mMorphVertices.size(), true);
+
+		mMorphFrameA = -1;
+		mMorphFrameB = -1;
+		for (unsigned int i = 0; i != mMorphVertices.size(); ++i)
+			BuildMorphArray(i, mFrameA, mFrameB);
 	}
 
-	//dest->recalculateBoundingBox();
+	for (unsigned int n = 0; n < mChildren.size(); n++)
+		mChildren[n]->SetHardwareMorphing(morphing);
+}
+
+eastl::shared_ptr<VertexBuffer> const& MD3Mesh::GetMorphVertices(unsigned int nr) const
+{
+	LogAssert(nr < mMorphVertices.size(), "Invalid morph vertex buffer.");
+	return mMorphVertices[nr];
+}
+
+bool MD3Mesh::ConsumeMorphChange(unsigned int nr)
+{
+	if (nr >= mMorphChanged.size() || !mMorphChanged[nr])
+		return false;
+
+	mMorphChanged[nr] = false;
+	return true;
 }
 
 //! build final mesh's tag from frames frameA and frameB with linear interpolation.
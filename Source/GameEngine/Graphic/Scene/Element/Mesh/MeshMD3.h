@@ -154,6 +154,9 @@ struct MD3MeshBuffer
 
 	eastl::vector<MD3Face> mFaces;
 	eastl::vector<MD3TexCoord> mTexCoords;
+
+	//! positions and normals of all the frames, one array each with the
+	//! vertices of a frame contiguous, frame after frame
 	eastl::vector<Vector3<float>> mNormals;
 	eastl::vector<Vector3<float>> mPositions;
 };
@@ -271,14 +274,18 @@ class MD3Mesh : public eastl::enable_shared_from_this<MD3Mesh>
 {
 public:
 	MD3Mesh() : mInterPolShift(0), mLoopMode(0), mParent(nullptr), mMeshRender(true),
-		mNumTags(0), mNumFrames(0), mCurrentFrame(0), mCurrentAnimation(0)
+		mNumTags(0), mNumFrames(0), mCurrentFrame(0), mCurrentAnimation(0),
+		mVerticesPending(false), mFrameA(0), mFrameB(0), mInterpolation(0.f),
+		mHardwareMorphing(false), mMorphFrameA(-1), mMorphFrameB(-1)
 	{
 
 	}
 
 	MD3Mesh(eastl::string name) : 
 		mName(name), mInterPolShift(0), mLoopMode(0), mParent(nullptr), mMeshRender(true),
-		mNumTags(0), mNumFrames(0), mCurrentFrame(0), mCurrentAnimation(0)
+		mNumTags(0), mNumFrames(0), mCurrentFrame(0), mCurrentAnimation(0),
+		mVerticesPending(false), mFrameA(0), mFrameB(0), mInterpolation(0.f),
+		mHardwareMorphing(false), mMorphFrameA(-1), mMorphFrameB(-1)
 	{
 
 	}
@@ -300,7 +307,15 @@ public:
 	eastl::shared_ptr<MD3Mesh> GetMesh(eastl::string meshName);
 	void GetMeshes(eastl::vector<eastl::shared_ptr<MD3Mesh>>& meshes);
 
+	//! selects the frames to interpolate and builds the tags. The vertices
+	//! are left pending until BuildVertices is called, which lets the scene
+	//! build the vertices of all its animated meshes together.
 	bool UpdateMesh(int frame, int detailLevel, int startFrameLoop, int endFrameLoop);
+
+	//! builds the pending vertices of the last UpdateMesh
+	void BuildVertices();
+	bool IsVerticesPending() const { return mVerticesPending; }
+	unsigned int GetVertexCount() const;
 	eastl::shared_ptr<MD3Mesh> CreateMesh(eastl::string parentMesh, eastl::string newMesh);
 
 	eastl::shared_ptr<MD3Mesh> GetParent() { return mParent; }
@@ -329,6 +344,7 @@ public:
 
 	void BuildFrameNr(bool loop, unsigned int timeMs);
 	void BuildVertexArray(unsigned int meshId, unsigned int frameA, unsigned int frameB, float interpolate);
+	void BuildMorphArray(unsigned int meshId, unsigned int frameA, unsigned int frameB);
 	void BuildTagArray(unsigned int frameA, unsigned int frameB, float interpolate);
 
 	//! tags
@@ -340,7 +356,21 @@ public:
 	void SetRenderMesh(bool render);
 	bool IsRenderMesh() { return mMeshRender; }
 
+	//! hardware morphing. The frames are copied to a vertex buffer with both
+	//! positions which the vertex shader blends, so the vertices are only
+	//! built when the pair of frames changes. The mesh buffers keep the
+	//! vertices of the last software build and are not animated meanwhile,
+	//! it has to be set before the mesh is given to a node.
+	void SetHardwareMorphing(bool morphing);
+	bool IsHardwareMorphing() const { return mHardwareMorphing; }
+	float GetMorphInterpolation() const { return mInterpolation; }
+	eastl::shared_ptr<VertexBuffer> const& GetMorphVertices(unsigned int nr) const;
+
+	//! returns true once after the frames of the morph vertices changed
+	bool ConsumeMorphChange(unsigned int nr);
+
 	//! animations
+	int GetFrameCount() const { return mNumFrames; }
 	float GetCurrentFrame() { return mCurrentFrame; }
 	void SetCurrentFrame(float currentFrame) { mCurrentFrame = currentFrame; }
 	void SetCurrentAnimation( unsigned int currentAnim) { mCurrentAnimation = currentAnim; }
@@ -418,6 +448,19 @@ private:
 
 	eastl::vector<eastl::shared_ptr<MD3MeshBuffer>> mBuffer;
 	eastl::vector<eastl::shared_ptr<MeshBuffer>> mBufferInterpol;
+
+	//! frames selected by the last UpdateMesh
+	bool mVerticesPending;
+	int mFrameA;
+	int mFrameB;
+	float mInterpolation;
+
+	//! morph vertices with the positions of the frames mMorphFrameA and B
+	bool mHardwareMorphing;
+	int mMorphFrameA;
+	int mMorphFrameB;
+	eastl::vector<eastl::shared_ptr<VertexBuffer>> mMorphVertices;
+	eastl::vector<bool> mMorphChanged;
 };
 
 class AnimateMeshMD3 : public BaseAnimatedMesh
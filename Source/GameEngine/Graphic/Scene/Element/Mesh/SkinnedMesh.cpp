@@ -11,6 +11,13 @@
 #include "Graphic/Scene/Element/BoneNode.h"
 #include "Graphic/Scene/Element/AnimatedMeshNode.h"
 
+#include "Core/Process/JobSystem.h"
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define SKINNING_SSE
+#endif
+
 //! constructor
 SkinnedMesh::SkinnedMesh()
 : mAnimationFrames(0.f), mFramesPerSecond(25.f), mLastAnimatedFrame(-1), 
@@ -478,118 +485,213 @@ void SkinnedMesh::SkinMesh()
 			}
 		}
 
-		//clear skinning helper array
-		for (i=0; i<mVerticesMoved.size(); ++i)
-			for (unsigned int j=0; j<mVerticesMoved[i].size(); ++j)
-				mVerticesMoved[i][j]=false;
+		//skinning matrices of the joints with weights
+		mSkinMatrices.resize(mAllJoints.size());
+		for (i=0; i<mAllJoints.size(); ++i)
+		{
+			Joint* joint = mAllJoints[i];
+			if (joint->mWeights.empty())
+				continue;
+
+			Transform jointTransform =
+				joint->mGlobalAnimatedTransform *
+				joint->mGlobalInversedTransform;
+
+			// the rows are taken from the table as the vertices are
+			// transformed by it, position * rotation
+			SkinMatrix& matrix = mSkinMatrices[i];
+			float const* rotation =
+				reinterpret_cast<float const*>(&jointTransform.GetRotation());
+			memcpy(matrix.mRows, rotation, 3 * sizeof(matrix.mRows[0]));
+
+			Vector3<float> translation = jointTransform.GetTranslation();
+			matrix.mRows[3][0] = translation[0];
+			matrix.mRows[3][1] = translation[1];
+			matrix.mRows[3][2] = translation[2];
+			matrix.mRows[3][3] = 0.f;
+		}
 
-		//skin starting with the root joints
-		for (i=0; i<mRootJoints.size(); ++i)
-			SkinJoint(mRootJoints[i], 0);
+		//skin the vertices, split in jobs when the mesh is large enough
+		//to pay for them
+		unsigned int const numVertices = (unsigned int)mSkinVertices.size();
+		unsigned int const minPerJob = 4096;
+		JobSystem* jobSystem = JobSystem::Get();
+		if (jobSystem && numVertices >= 2 * minPerJob)
+		{
+			jobSystem->ParallelFor(numVertices, minPerJob,
+				[this](unsigned int begin, unsigned int end)
+			{
+				SkinVertices(begin, end);
+			});
+		}
+		else
+		{
+			SkinVertices(0, numVertices);
+		}
 	}
 }
 
 
-void SkinnedMesh::SkinJoint(Joint *joint, Joint *parentJoint)
+void SkinnedMesh::SkinVertices(unsigned int begin, unsigned int end)
 {
-	if (joint->mWeights.size())
+	for (unsigned int v = begin; v < end; ++v)
 	{
-		//Find this joints pull on vertices...
-		Transform jointTransform = 
-			joint->mGlobalAnimatedTransform *
-			joint->mGlobalInversedTransform;
-
-		float* vertexPostion = 
-			reinterpret_cast<float*>(&jointTransform.GetTranslation());
-		Matrix4x4<float> jointVertexPull = jointTransform.GetRotation();
-		float* vertexRotation = reinterpret_cast<float*>(&jointVertexPull);
-
-		Vector4<float> jointVertexMove;
-		Vector4<float> jointNormalMove;
-		Vector4<float> jointWeightNormal;
-		Vector4<float> jointWeightPosition;
-		float* vertexMove = reinterpret_cast<float*>(&jointVertexMove);
-		float* normalMove = reinterpret_cast<float*>(&jointNormalMove);
-		float* weightNormal = reinterpret_cast<float*>(&jointWeightNormal);
-		float* weightPosition = reinterpret_cast<float*>(&jointWeightPosition);
-
-		//Skin Vertices Positions and Normals...
-		for (unsigned int i=0; i<joint->mWeights.size(); ++i)
+		SkinVertex const& vertex = mSkinVertices[v];
+
+		// blend the matrices of the influences and transform the vertex
+		// once, which is the sum of the weighted transforms
+		float position[4], normal[4];
+#if defined(SKINNING_SSE)
+		__m128 row0 = _mm_setzero_ps();
+		__m128 row1 = _mm_setzero_ps();
+		__m128 row2 = _mm_setzero_ps();
+		__m128 row3 = _mm_setzero_ps();
+		for (unsigned int k = 0; k < 4 && vertex.mWeights[k] > 0.f; ++k)
 		{
-			Weight& weight = joint->mWeights[i];
-			float* position = reinterpret_cast<float*>(&weight.mStaticPos);
-			weightPosition[0] = position[0];
-			weightPosition[1] = position[1];
-			weightPosition[2] = position[2];
-			weightPosition[3] = 0;
-
-			// Pull this vertex...
-			jointVertexPull.Transformation(jointWeightPosition, jointVertexMove);
-			vertexMove[0] += vertexPostion[0];
-			vertexMove[1] += vertexPostion[1];
-			vertexMove[2] += vertexPostion[2];
-
-			//swapping Y and Z axis
-			eastl::swap(vertexMove[2], vertexMove[1]);
-
-			if (mAnimateNormals)
-			{
-				float* normal = reinterpret_cast<float*>(&weight.mStaticNormal);
-				weightNormal[0] = normal[0];
-				weightNormal[1] = normal[2];
-				weightNormal[2] = normal[1];
-				weightNormal[3] = 0;
+			SkinMatrix const& matrix = mSkinMatrices[vertex.mJoints[k]];
+			__m128 weight = _mm_set1_ps(vertex.mWeights[k]);
+			row0 = _mm_add_ps(row0, _mm_mul_ps(weight, _mm_loadu_ps(matrix.mRows[0])));
+			row1 = _mm_add_ps(row1, _mm_mul_ps(weight, _mm_loadu_ps(matrix.mRows[1])));
+			row2 = _mm_add_ps(row2, _mm_mul_ps(weight, _mm_loadu_ps(matrix.mRows[2])));
+			row3 = _mm_add_ps(row3, _mm_mul_ps(weight, _mm_loadu_ps(matrix.mRows[3])));
+		}
 
-				jointVertexPull.Transformation(jointWeightNormal, jointNormalMove);
+		__m128 result = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(vertex.mPosition[0]), row0),
+				_mm_mul_ps(_mm_set1_ps(vertex.mPosition[1]), row1)),
+			_mm_add_ps(_mm_mul_ps(_mm_set1_ps(vertex.mPosition[2]), row2), row3));
+		_mm_storeu_ps(position, result);
 
-				//swapping Y and Z axis
-				eastl::swap(normalMove[2], normalMove[1]);
-			}
+		if (mAnimateNormals)
+		{
+			result = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(_mm_set1_ps(vertex.mNormal[0]), row0),
+					_mm_mul_ps(_mm_set1_ps(vertex.mNormal[1]), row1)),
+				_mm_mul_ps(_mm_set1_ps(vertex.mNormal[2]), row2));
+			_mm_storeu_ps(normal, result);
+		}
+#else
+		float rows[4][4] = { 0.f };
+		for (unsigned int k = 0; k < 4 && vertex.mWeights[k] > 0.f; ++k)
+		{
+			SkinMatrix const& matrix = mSkinMatrices[vertex.mJoints[k]];
+			for (unsigned int r = 0; r < 4; ++r)
+				for (unsigned int c = 0; c < 4; ++c)
+					rows[r][c] += vertex.mWeights[k] * matrix.mRows[r][c];
+		}
 
-			if (! (*(weight.mMoved)) )
-			{
-				*(weight.mMoved) = true;
+		for (unsigned int c = 0; c < 4; ++c)
+		{
+			position[c] = vertex.mPosition[0] * rows[0][c] +
+				vertex.mPosition[1] * rows[1][c] + vertex.mPosition[2] * rows[2][c] + rows[3][c];
+			normal[c] = vertex.mNormal[0] * rows[0][c] +
+				vertex.mNormal[1] * rows[1][c] + vertex.mNormal[2] * rows[2][c];
+		}
+#endif
 
-				float* target = reinterpret_cast<float*>(
-					&mSkinningBuffers[weight.mBufferId]->Position(weight.mVertexId));
-				target[0] = vertexMove[0] * weight.mStrength;
-				target[1] = vertexMove[1] * weight.mStrength;
-				target[2] = vertexMove[2] * weight.mStrength;
+		//swapping Y and Z axis
+		SkinMeshBuffer* buffer = mSkinningBuffers[vertex.mBufferId];
+		float* target = reinterpret_cast<float*>(&buffer->Position(vertex.mVertexId));
+		target[0] = position[0];
+		target[1] = position[2];
+		target[2] = position[1];
 
-				if (mAnimateNormals)
-				{
-					target = reinterpret_cast<float*>(
-						&mSkinningBuffers[weight.mBufferId]->Normal(weight.mVertexId));
-					target[0] = normalMove[0] * weight.mStrength;
-					target[1] = normalMove[1] * weight.mStrength;
-					target[2] = normalMove[2] * weight.mStrength;
-				}
-				//*(weight.mPos) = thisVertexMove * weight.mStrength;
+		if (mAnimateNormals)
+		{
+			target = reinterpret_cast<float*>(&buffer->Normal(vertex.mVertexId));
+			target[0] = normal[0];
+			target[1] = normal[2];
+			target[2] = normal[1];
+		}
+	}
+}
+
+
+//! Gathers the weights of the joints by vertex, keeping the four strongest
+void SkinnedMesh::BuildSkinVertices()
+{
+	mSkinVertices.clear();
+
+	eastl::vector<unsigned int> firstVertex(mLocalBuffers.size() + 1, 0);
+	for (unsigned int i = 0; i < mLocalBuffers.size(); ++i)
+		firstVertex[i + 1] = firstVertex[i] + mLocalBuffers[i]->GetVertice()->GetNumElements();
+
+	eastl::vector<int> vertexSlots(firstVertex.back(), -1);
+	bool truncated = false;
+	for (unsigned int i = 0; i < mAllJoints.size(); ++i)
+	{
+		Joint* joint = mAllJoints[i];
+		for (unsigned int j = 0; j < joint->mWeights.size(); ++j)
+		{
+			Weight const& weight = joint->mWeights[j];
+			int& slot = vertexSlots[firstVertex[weight.mBufferId] + weight.mVertexId];
+			if (slot < 0)
+			{
+				slot = (int)mSkinVertices.size();
+
+				SkinVertex vertex;
+				memset(&vertex, 0, sizeof(vertex));
+				vertex.mBufferId = weight.mBufferId;
+				vertex.mVertexId = weight.mVertexId;
+				vertex.mPosition[0] = weight.mStaticPos[0];
+				vertex.mPosition[1] = weight.mStaticPos[1];
+				vertex.mPosition[2] = weight.mStaticPos[2];
+				vertex.mNormal[0] = weight.mStaticNormal[0];
+				vertex.mNormal[1] = weight.mStaticNormal[2];
+				vertex.mNormal[2] = weight.mStaticNormal[1];
+				mSkinVertices.push_back(vertex);
 			}
-			else
+
+			// fill a free influence or replace the weakest one
+			SkinVertex& vertex = mSkinVertices[slot];
+			unsigned int weakest = 0;
+			for (unsigned int k = 1; k < 4; ++k)
+				if (vertex.mWeights[k] < vertex.mWeights[weakest])
+					weakest = k;
+
+			if (vertex.mWeights[weakest] > 0.f)
+				truncated = true;
+			if (weight.mStrength > vertex.mWeights[weakest])
 			{
-				float* target = reinterpret_cast<float*>(
-					&mSkinningBuffers[weight.mBufferId]->Position(weight.mVertexId));
-				target[0] += vertexMove[0] * weight.mStrength;
-				target[1] += vertexMove[1] * weight.mStrength;
-				target[2] += vertexMove[2] * weight.mStrength;
+				vertex.mWeights[weakest] = weight.mStrength;
+				vertex.mJoints[weakest] = (unsigned short)i;
+			}
+		}
+	}
 
-				if (mAnimateNormals)
-				{
-					target = reinterpret_cast<float*>(
-						&mSkinningBuffers[weight.mBufferId]->Normal(weight.mVertexId));
-					target[0] += normalMove[0] * weight.mStrength;
-					target[1] += normalMove[1] * weight.mStrength;
-					target[2] += normalMove[2] * weight.mStrength;
-				}
-				//*(weight.mPos) += thisVertexMove * weight.mStrength;
+	for (SkinVertex& vertex : mSkinVertices)
+	{
+		// the influences are kept strongest first with the unused ones last,
+		// and renormalized when some were dropped
+		for (unsigned int k = 1; k < 4; ++k)
+		{
+			for (unsigned int m = k; m > 0 && vertex.mWeights[m] > vertex.mWeights[m - 1]; --m)
+			{
+				eastl::swap(vertex.mWeights[m], vertex.mWeights[m - 1]);
+				eastl::swap(vertex.mJoints[m], vertex.mJoints[m - 1]);
 			}
 		}
+
+		if (truncated)
+		{
+			float total = vertex.mWeights[0] + vertex.mWeights[1] +
+				vertex.mWeights[2] + vertex.mWeights[3];
+			if (total > 0.f && total != 1.f)
+				for (unsigned int k = 0; k < 4; ++k)
+					vertex.mWeights[k] /= total;
+		}
 	}
 
-	//Skin all children
-	for (unsigned int j=0; j<joint->mChildren.size(); ++j)
-		SkinJoint(joint->mChildren[j], joint);
+	if (truncated)
+		LogWarning("Skinned Mesh: vertices with more than 4 weights, the weakest are dropped");
+
+	// skin in memory order of the mesh buffers
+	eastl::sort(mSkinVertices.begin(), mSkinVertices.end(),
+		[](SkinVertex const& a, SkinVertex const& b)
+		{
+			return a.mBufferId != b.mBufferId ?
+				a.mBufferId < b.mBufferId : a.mVertexId < b.mVertexId;
+		});
 }
 
 
@@ -868,12 +970,6 @@ void SkinnedMesh::CheckForAnimation()
 			}
 		}
 
-		//An array used in skinning
-
-		for (i=0; i<mVerticesMoved.size(); ++i)
-			for (j=0; j<mVerticesMoved[i].size(); ++j)
-				mVerticesMoved[i][j] = false;
-
 		// For skinning: cache weight values for speed
 
 		for (i=0; i<mAllJoints.size(); ++i)
@@ -884,8 +980,6 @@ void SkinnedMesh::CheckForAnimation()
 				const unsigned int bufferId=joint->mWeights[j].mBufferId;
 				const unsigned int vertexId=joint->mWeights[j].mVertexId;
 
-				joint->mWeights[j].mMoved = &mVerticesMoved[bufferId] [vertexId];
-
 				Vector3<float>& position = mLocalBuffers[bufferId]->Position(vertexId);
 				Vector3<float>& normal = mLocalBuffers[bufferId]->Normal(vertexId);
 				joint->mWeights[j].mStaticPos = { position[0], position[2], position[1] };
@@ -897,6 +991,8 @@ void SkinnedMesh::CheckForAnimation()
 
 		// normalize weights
 		NormalizeWeights();
+
+		BuildSkinVertices();
 	}
 	mSkinnedLastFrame=false;
 }
@@ -926,14 +1022,6 @@ void SkinnedMesh::Finalize()
 	for(i=0; i < mAllJoints.size(); ++i)
 		mAllJoints[i]->mUseAnimationFrom=mAllJoints[i];
 
-	//Set array sizes...
-
-	for (i=0; i<mLocalBuffers.size(); ++i)
-	{
-		mVerticesMoved.push_back(eastl::vector<bool>());
-		mVerticesMoved[i].resize(mLocalBuffers[i]->GetVertice()->GetNumElements());
-	}
-
 	//Todo: optimise keys here...
 
 	CheckForAnimation();
@@ -1252,7 +1340,7 @@ void SkinnedMesh::TransferJointsToMesh(const eastl::vector<eastl::shared_ptr<Bon
 {
 	for (unsigned int i=0; i<mAllJoints.size(); ++i)
 	{
-		eastl::shared_ptr<BoneNode> const node=jointChildSceneNodes[i];
+		const BoneNode* node=jointChildSceneNodes[i].get();
 		Joint *joint=mAllJoints[i];
 
 		joint->mLocalAnimatedTransform.SetRotation(node->GetRelativeTransform().GetRotation());
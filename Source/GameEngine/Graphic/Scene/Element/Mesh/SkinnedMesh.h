@@ -90,7 +90,6 @@ public:
 		private:
 			//! Internal members used by SkinnedMesh
 			friend class SkinnedMesh;
-			bool *mMoved;
 			Vector3<float> mStaticPos;
 			Vector3<float> mStaticNormal;
 	};
@@ -349,7 +348,28 @@ private:
 		Vector3<float> &scale, int &scaleHint,
 		Quaternion<float> &rotation, int &rotationHint);
 
-	void SkinJoint(Joint *joint, Joint *parentJoint);
+	//! A vertex of the software skinning with up to four joint influences,
+	//! stored vertex after vertex. The position and normal are the static
+	//! ones, ready to be transformed by the skinning matrices.
+	struct SkinVertex
+	{
+		float mPosition[3];
+		float mNormal[3];
+		float mWeights[4];
+		unsigned short mJoints[4];
+		unsigned int mBufferId;
+		unsigned int mVertexId;
+	};
+
+	//! Skinning matrix of a joint, the first three rows of its rotation
+	//! followed by its translation.
+	struct SkinMatrix
+	{
+		float mRows[4][4];
+	};
+
+	void BuildSkinVertices();
+	void SkinVertices(unsigned int begin, unsigned int end);
 
 	void CalculateTangents(Vector3<float>& normal,
 		Vector3<float>& tangent, Vector3<float>& binormal,
@@ -363,7 +383,8 @@ private:
 	eastl::vector<Joint*> mAllJoints;
 	eastl::vector<Joint*> mRootJoints;
 
-	eastl::vector<eastl::vector<bool>> mVerticesMoved;
+	eastl::vector<SkinVertex> mSkinVertices;
+	eastl::vector<SkinMatrix> mSkinMatrices;
 
 	float mAnimationFrames;
 	float mFramesPerSecond;
@@ -182,8 +182,11 @@ void MeshNode::SetMesh(const eastl::shared_ptr<BaseMesh>& mesh)
 
 		eastl::shared_ptr<Visual> visual = eastl::make_shared<Visual>(vBuffer, iBuffer, effect);
 		visual->UpdateModelBound();
+		MarkBoundDirty();
 		mVisuals.push_back(visual);
-		mPVWUpdater->Subscribe(mWorldTransform, effect->GetPVWMatrixConstant());
+		mPVWUpdater->Subscribe(this, effect->GetPVWMatrixConstant());
+		// the batcher or Render computes the pvw-matrix of the drawn buffers
+		mPVWUpdater->Defer(effect->GetPVWMatrixConstant());
 	}
 
 	for (it = meshBufferTransparentDiffuse.begin(); it != meshBufferTransparentDiffuse.end(); it++)
@@ -274,8 +277,11 @@ void MeshNode::SetMesh(const eastl::shared_ptr<BaseMesh>& mesh)
 
 		eastl::shared_ptr<Visual> visual = eastl::make_shared<Visual>(vBuffer, iBuffer, effect);
 		visual->UpdateModelBound();
+		MarkBoundDirty();
 		mVisuals.push_back(visual);
-		mPVWUpdater->Subscribe(mWorldTransform, effect->GetPVWMatrixConstant());
+		mPVWUpdater->Subscribe(this, effect->GetPVWMatrixConstant());
+		// the batcher or Render computes the pvw-matrix of the drawn buffers
+		mPVWUpdater->Defer(effect->GetPVWMatrixConstant());
 	}
 
 	if (meshBuffers.size() > 0)
@@ -345,8 +351,9 @@ void MeshNode::SetMesh(const eastl::shared_ptr<BaseMesh>& mesh)
 
 		eastl::shared_ptr<Visual> visual = eastl::make_shared<Visual>(vBuffer, iBuffer, effect);
 		visual->UpdateModelBound();
+		MarkBoundDirty();
 		mVisuals.push_back(visual);
-		mPVWUpdater->Subscribe(mWorldTransform, effect->GetPVWMatrixConstant());
+		mPVWUpdater->Subscribe(this, effect->GetPVWMatrixConstant());
 	}
 }
 
@@ -419,10 +426,19 @@ bool MeshNode::Render(Scene *pScene)
 			if (mMaterials[i]->Update(mRasterizerState))
 				Renderer::Get()->Unbind(mRasterizerState);
 
+			// solid buffers repeated across nodes are drawn instanced
+			// when the pass is over
+			if (!transparent && pScene->GetInstanceBatcher().Add(mMesh.get(), i,
+				mMaterials[i], mVisuals[i], mBlendStates[i], mDepthStencilStates[i],
+				mRasterizerState, mWorldTransform.GetHMatrix(), Vector4<float>{ 1.f, 1.f, 1.f, 1.f }))
+				continue;
+
 			Renderer::Get()->SetBlendState(mBlendStates[i]);
 			Renderer::Get()->SetDepthStencilState(mDepthStencilStates[i]);
 			Renderer::Get()->SetRasterizerState(mRasterizerState);
 
+			// the deferred buffers get their pvw-matrix when drawn
+			mPVWUpdater->Update(mVisuals[i]->GetEffect()->GetVertexShader()->Get<ConstantBuffer>("PVWMatrix"));
 			Renderer::Get()->Draw(mVisuals[i]);
 
 			Renderer::Get()->SetDefaultBlendState();
@@ -7,6 +7,11 @@
 
 #include "Graphic/Effect/Particle.h"
 
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLE_SSE
+#endif
+
 //! Types of built in particle affectors
 enum GRAPHIC_ITEM ParticleAffectorType
 {
@@ -29,11 +34,21 @@ public:
 	//! constructor
 	BaseParticleAffector() : mEnabled(true) {}
 
-	//! Affects an array of particles.
-	/** \param now Current time. (Same as ITimer::getTime() would return)
-	\param particlearray Array of particles.
-	\param count Amount of particles in array. */
-	virtual void Affect(unsigned int now, Particle* particlearray, unsigned int count) = 0;
+	//! Prepares the affector for an update of the particle system.
+	/** Called once per update before the particles are affected. Affectors
+	which depend on the time elapsed between updates keep it here.
+	\param now Current time. (Same as ITimer::getTime() would return) */
+	virtual void Prepare(unsigned int now) { }
+
+	//! Affects a range of particles.
+	/** The particle system splits its particles into ranges which may be
+	affected from several threads at once, so the affector must not change
+	its own state here.
+	\param now Current time. (Same as ITimer::getTime() would return)
+	\param particles Array of particles.
+	\param begin First particle of the range.
+	\param end One past the last particle of the range. */
+	virtual void Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end) = 0;
 
 	//! Sets whether or not the affector is currently enabled.
 	virtual void SetEnabled(bool enabled) { mEnabled = enabled; }
@@ -8,43 +8,71 @@
 ParticleAttractionAffector::ParticleAttractionAffector( const Vector3<float>& point, 
 	float speed, bool attract, bool affectX, bool affectY, bool affectZ )
 :	mPoint(point), mSpeed(speed), mAffectX(affectX), mAffectY(affectY),
-	mAffectZ(affectZ), mAttract(attract), mLastTime(0)
+	mAffectZ(affectZ), mAttract(attract), mLastTime(0), mTimeDelta(0.f)
 {
 
 }
 
 
-//! Affects an array of particles.
-void ParticleAttractionAffector::Affect(unsigned int now, Particle* particlearray, unsigned int count)
+//! Keeps the time elapsed since the last update.
+void ParticleAttractionAffector::Prepare(unsigned int now)
 {
-	if( mLastTime == 0 )
+	if (mLastTime == 0)
 	{
 		mLastTime = now;
+		mTimeDelta = 0.f;
 		return;
 	}
 
-	float timeDelta = ( now - mLastTime ) / 1000.0f;
+	mTimeDelta = (now - mLastTime) / 1000.0f;
 	mLastTime = now;
+}
 
-	if( !mEnabled )
-		return;
 
-	for(unsigned int i=0; i<count; ++i)
-	{
-		Vector3<float> direction(mPoint - particlearray[i].mPos);
-		Normalize(direction);
-		direction *= mSpeed * timeDelta;
+//! Affects a range of particles.
+void ParticleAttractionAffector::Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end)
+{
+	if (!mEnabled || mTimeDelta == 0.f)
+		return;
 
-		if( !mAttract )
-			direction *= -1.0f;
+	// every particle moves a fixed step towards (or away from) the point,
+	// only along the affected axes
+	float* pos[3] = { particles.mPos[0].data(), particles.mPos[1].data(), particles.mPos[2].data() };
+	const float step = mSpeed * mTimeDelta * (mAttract ? 1.0f : -1.0f);
+	const float affect[3] = { mAffectX ? step : 0.f, mAffectY ? step : 0.f, mAffectZ ? step : 0.f };
 
-		if( mAffectX )
-			particlearray[i].mPos[0] += direction[0];
+	unsigned int i = begin;
+#if defined(PARTICLE_SSE)
+	const __m128 point[3] = { _mm_set1_ps(mPoint[0]), _mm_set1_ps(mPoint[1]), _mm_set1_ps(mPoint[2]) };
+	const __m128 affect4[3] = { _mm_set1_ps(affect[0]), _mm_set1_ps(affect[1]), _mm_set1_ps(affect[2]) };
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 position[3], direction[3];
+		for (int j = 0; j < 3; ++j)
+		{
+			position[j] = _mm_loadu_ps(pos[j] + i);
+			direction[j] = _mm_sub_ps(point[j], position[j]);
+		}
+		__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(direction[0], direction[0]), _mm_mul_ps(direction[1], direction[1])),
+			_mm_mul_ps(direction[2], direction[2])));
 
-		if( mAffectY )
-			particlearray[i].mPos[1] += direction[1];
+		// a particle on the point has no direction and stays where it is
+		__m128 invLength = _mm_and_ps(_mm_cmpgt_ps(length, zero), _mm_div_ps(_mm_set1_ps(1.0f), length));
+		for (int j = 0; j < 3; ++j)
+		{
+			_mm_storeu_ps(pos[j] + i, _mm_add_ps(position[j],
+				_mm_mul_ps(_mm_mul_ps(direction[j], invLength), affect4[j])));
+		}
+	}
+#endif
+	for (; i < end; ++i)
+	{
+		Vector3<float> direction{ mPoint[0] - pos[0][i], mPoint[1] - pos[1][i], mPoint[2] - pos[2][i] };
+		Normalize(direction);
 
-		if( mAffectZ )
-			particlearray[i].mPos[2] += direction[2];
+		for (int j = 0; j < 3; ++j)
+			pos[j][i] += direction[j] * affect[j];
 	}
-}
\ No newline at end of file
+}
@@ -17,8 +17,11 @@ public:
 		bool attract = true, bool affectX = true,
 		bool affectY = true, bool affectZ = true );
 
-	//! Affects a particle.
-	virtual void Affect(unsigned int now, Particle* particlearray, unsigned int count);
+	//! Keeps the time elapsed since the last update.
+	virtual void Prepare(unsigned int now);
+
+	//! Affects a range of particles.
+	virtual void Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end);
 
 	//! Set the point that particles will attract to
 	virtual void SetPoint( const Vector3<float>& point ) { mPoint = point; }
@@ -68,6 +71,7 @@ private:
 	bool mAffectZ;
 	bool mAttract;
 	unsigned int mLastTime;
+	float mTimeDelta;
 };
 
 #endif
@@ -15,20 +15,56 @@ ParticleFadeOutAffector::ParticleFadeOutAffector(
 }
 
 
-//! Affects an array of particles.
-void ParticleFadeOutAffector::Affect(unsigned int now, Particle* particlearray, unsigned int count)
+//! Affects a range of particles.
+void ParticleFadeOutAffector::Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end)
 {
 	if (!mEnabled)
 		return;
 
-	float d;
+	// the color goes from the start color to the target color in the last
+	// fade out time of the life of the particle
+	const unsigned int* endTime = particles.mEndTime.data();
+	float* color[4] = { particles.mColor[0].data(), particles.mColor[1].data(),
+		particles.mColor[2].data(), particles.mColor[3].data() };
+	const float* startColor[4] = { particles.mStartColor[0].data(), particles.mStartColor[1].data(),
+		particles.mStartColor[2].data(), particles.mStartColor[3].data() };
+	const float invFadeOutTime = 1.0f / mFadeOutTime;
 
-	for (unsigned int i=0; i<count; ++i)
+	unsigned int i = begin;
+#if defined(PARTICLE_SSE)
+	const __m128i now4 = _mm_set1_epi32((int)now);
+	const __m128 fadeOutTime4 = _mm_set1_ps(mFadeOutTime);
+	const __m128 invTime4 = _mm_set1_ps(invFadeOutTime);
+	const __m128 target[4] = { _mm_set1_ps(mTargetColor[0]), _mm_set1_ps(mTargetColor[1]),
+		_mm_set1_ps(mTargetColor[2]), _mm_set1_ps(mTargetColor[3]) };
+	for (; i + 4 <= end; i += 4)
 	{
-		if (particlearray[i].mEndTime - now < mFadeOutTime)
+		// dead particles are removed before they are affected, so the time
+		// left is never negative
+		__m128 left = _mm_cvtepi32_ps(
+			_mm_sub_epi32(_mm_loadu_si128((const __m128i*)(endTime + i)), now4));
+		__m128 fading = _mm_cmplt_ps(left, fadeOutTime4);
+		if (!_mm_movemask_ps(fading))
+			continue;
+
+		__m128 d = _mm_mul_ps(left, invTime4);
+		for (int j = 0; j < 4; ++j)
+		{
+			__m128 start = _mm_loadu_ps(startColor[j] + i);
+			__m128 faded = _mm_add_ps(target[j], _mm_mul_ps(_mm_sub_ps(start, target[j]), d));
+			__m128 current = _mm_loadu_ps(color[j] + i);
+			_mm_storeu_ps(color[j] + i,
+				_mm_or_ps(_mm_and_ps(fading, faded), _mm_andnot_ps(fading, current)));
+		}
+	}
+#endif
+	for (; i < end; ++i)
+	{
+		if (endTime[i] - now < mFadeOutTime)
 		{
-			d = (particlearray[i].mEndTime - now) / mFadeOutTime;	// FadeOutTime probably float to save casts here (just guessing)
-			particlearray[i].mColor = Function<float>::Lerp(particlearray[i].mStartColor, mTargetColor, d);
+			float d = (endTime[i] - now) * invFadeOutTime;
+			for (int j = 0; j < 4; ++j)
+				color[j][i] = mTargetColor[j] + (startColor[j][i] - mTargetColor[j]) * d;
 		}
 	}
-}
\ No newline at end of file
+}
@@ -14,8 +14,8 @@ public:
 
 	ParticleFadeOutAffector(const eastl::array<float, 4>& targetColor, unsigned int fadeOutTime);
 
-	//! Affects a particle.
-	virtual void Affect(unsigned int now, Particle* particlearray, unsigned int count);
+	//! Affects a range of particles.
+	virtual void Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end);
 
 	//! Sets the targetColor, i.e. the color the particles will interpolate
 	//! to over time.
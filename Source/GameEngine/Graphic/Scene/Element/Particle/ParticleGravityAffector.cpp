@@ -15,23 +15,50 @@ ParticleGravityAffector::ParticleGravityAffector(
 }
 
 
-//! Affects an array of particles.
-void ParticleGravityAffector::Affect(unsigned int now, Particle* particlearray, unsigned int count)
+//! Affects a range of particles.
+void ParticleGravityAffector::Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end)
 {
 	if (!mEnabled)
 		return;
 
-	float d;
+	// the vector goes from the start vector to the gravity as the force is lost
+	const unsigned int* startTime = particles.mStartTime.data();
+	float* vector[3] = { particles.mVector[0].data(), particles.mVector[1].data(), particles.mVector[2].data() };
+	const float* startVector[3] = {
+		particles.mStartVector[0].data(), particles.mStartVector[1].data(), particles.mStartVector[2].data() };
+	const float invTimeForceLost = 1.0f / mTimeForceLost;
 
-	for (unsigned int i=0; i<count; ++i)
+	unsigned int i = begin;
+#if defined(PARTICLE_SSE)
+	const __m128i now4 = _mm_set1_epi32((int)now);
+	const __m128 invTime4 = _mm_set1_ps(invTimeForceLost);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 gravity[3] = {
+		_mm_set1_ps(mGravity[0]), _mm_set1_ps(mGravity[1]), _mm_set1_ps(mGravity[2]) };
+	for (; i + 4 <= end; i += 4)
 	{
-		d = (now - particlearray[i].mStartTime) / mTimeForceLost;
+		__m128i age = _mm_sub_epi32(now4, _mm_loadu_si128((const __m128i*)(startTime + i)));
+		__m128 d = _mm_mul_ps(_mm_cvtepi32_ps(age), invTime4);
+		d = _mm_sub_ps(one, _mm_min_ps(_mm_max_ps(d, zero), one));
+		for (int j = 0; j < 3; ++j)
+		{
+			__m128 start = _mm_loadu_ps(startVector[j] + i);
+			_mm_storeu_ps(vector[j] + i,
+				_mm_add_ps(gravity[j], _mm_mul_ps(_mm_sub_ps(start, gravity[j]), d)));
+		}
+	}
+#endif
+	for (; i < end; ++i)
+	{
+		float d = (now - startTime[i]) * invTimeForceLost;
 		if (d > 1.0f)
 			d = 1.0f;
 		if (d < 0.0f)
 			d = 0.0f;
 		d = 1.0f - d;
 
-		particlearray[i].mVector = Function<float>::Lerp(particlearray[i].mStartVector, mGravity, d);
+		for (int j = 0; j < 3; ++j)
+			vector[j][i] = mGravity[j] + (startVector[j][i] - mGravity[j]) * d;
 	}
-}
\ No newline at end of file
+}
@@ -16,8 +16,8 @@ public:
 	ParticleGravityAffector( 
 		const Vector3<float>& gravity = Vector3<float>{ 0.f, -0.03f, 0.f }, unsigned int timeForceLost = 1000);
 
-	//! Affects a particle.
-	virtual void Affect(unsigned int now, Particle* particlearray, unsigned int count);
+	//! Affects a range of particles.
+	virtual void Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end);
 
 	//! Set the time in milliseconds when the gravity force is totally
 	//! lost and the particle does not move any more.
@@ -13,15 +13,16 @@
 
 //! constructor
 ParticleRotationAffector::ParticleRotationAffector( const Vector3<float>& speed, const Vector3<float>& pivotPoint )
-: mPivotPoint(pivotPoint), mSpeed(speed), mLastTime(0)
+: mPivotPoint(pivotPoint), mSpeed(speed), mLastTime(0), mRotate(false)
 {
 
 }
 
 
-//! Affects an array of particles.
-void ParticleRotationAffector::Affect(unsigned int now, Particle* particlearray, unsigned int count)
+//! Computes the rotation for the time elapsed since the last update.
+void ParticleRotationAffector::Prepare(unsigned int now)
 {
+	mRotate = false;
 	if( mLastTime == 0 )
 	{
 		mLastTime = now;
@@ -31,33 +32,61 @@ void ParticleRotationAffector::Affect(unsigned int now, Particle* particlearray,
 	float timeDelta = ( now - mLastTime ) / 1000.0f;
 	mLastTime = now;
 
-	if( !mEnabled )
-		return;
+	for (int i = 0; i < 3; ++i)
+	{
+		float angle = timeDelta * mSpeed[i] * (float)GE_C_DEG_TO_RAD;
+		mCos[i] = cos(angle);
+		mSin[i] = sin(angle);
+		if (angle != 0.f)
+			mRotate = true;
+	}
+}
 
-	for(unsigned int i=0; i<count; ++i)
+
+//! Rotates the points of a range in the plane of the axes a and b about the
+//! pivot (pivotA, pivotB).
+static void RotatePlane(float* a, float* b, float pivotA, float pivotB,
+	float cs, float sn, unsigned int begin, unsigned int end)
+{
+	unsigned int i = begin;
+#if defined(PARTICLE_SSE)
+	const __m128 pivotA4 = _mm_set1_ps(pivotA);
+	const __m128 pivotB4 = _mm_set1_ps(pivotB);
+	const __m128 cs4 = _mm_set1_ps(cs);
+	const __m128 sn4 = _mm_set1_ps(sn);
+	for (; i + 4 <= end; i += 4)
+	{
+		__m128 da = _mm_sub_ps(_mm_loadu_ps(a + i), pivotA4);
+		__m128 db = _mm_sub_ps(_mm_loadu_ps(b + i), pivotB4);
+		_mm_storeu_ps(a + i, _mm_add_ps(pivotA4,
+			_mm_sub_ps(_mm_mul_ps(da, cs4), _mm_mul_ps(db, sn4))));
+		_mm_storeu_ps(b + i, _mm_add_ps(pivotB4,
+			_mm_add_ps(_mm_mul_ps(da, sn4), _mm_mul_ps(db, cs4))));
+	}
+#endif
+	for (; i < end; ++i)
 	{
-		if (mSpeed[0] != 0.0f)
-		{
-			Quaternion<float> tgt = Rotation<3, float>(
-				AxisAngle<3, float>(particlearray[i].mPos, timeDelta * mSpeed[0] * (float)GE_C_DEG_TO_RAD));
-			particlearray[i].mPos = HProject(Rotate(tgt, Vector4<float>::Unit(0)));
-			//particlearray[i].mPos.RotateYZBy(timeDelta * mSpeed.X, mPivotPoint);
-		}
-
-		if (mSpeed[1] != 0.0f)
-		{
-			Quaternion<float> tgt = Rotation<3, float>(
-				AxisAngle<3, float>(particlearray[i].mPos, timeDelta * mSpeed[2] * (float)GE_C_DEG_TO_RAD));
-			particlearray[i].mPos = HProject(Rotate(tgt, Vector4<float>::Unit(2)));
-			//particlearray[i].mPos.RotateXZBy(timeDelta * mSpeed.Y, mPivotPoint);
-		}
-
-		if (mSpeed[2] != 0.0f)
-		{
-			Quaternion<float> tgt = Rotation<3, float>(
-				AxisAngle<3, float>(particlearray[i].mPos, timeDelta * mSpeed[1] * (float)GE_C_DEG_TO_RAD));
-			particlearray[i].mPos = HProject(Rotate(tgt, Vector4<float>::Unit(1)));
-			//particlearray[i].mPos.RotateXYBy(timeDelta * mSpeed.Z, mPivotPoint);
-		}
+		float da = a[i] - pivotA;
+		float db = b[i] - pivotB;
+		a[i] = pivotA + da * cs - db * sn;
+		b[i] = pivotB + da * sn + db * cs;
 	}
 }
+
+
+//! Affects a range of particles.
+void ParticleRotationAffector::Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end)
+{
+	if( !mEnabled || !mRotate )
+		return;
+
+	// the speed about the x axis rotates in the YZ plane, about the y axis
+	// in the XZ plane and about the z axis in the XY plane
+	float* pos[3] = { particles.mPos[0].data(), particles.mPos[1].data(), particles.mPos[2].data() };
+	if (mSpeed[0] != 0.0f)
+		RotatePlane(pos[1], pos[2], mPivotPoint[1], mPivotPoint[2], mCos[0], mSin[0], begin, end);
+	if (mSpeed[1] != 0.0f)
+		RotatePlane(pos[0], pos[2], mPivotPoint[0], mPivotPoint[2], mCos[1], mSin[1], begin, end);
+	if (mSpeed[2] != 0.0f)
+		RotatePlane(pos[0], pos[1], mPivotPoint[0], mPivotPoint[1], mCos[2], mSin[2], begin, end);
+}
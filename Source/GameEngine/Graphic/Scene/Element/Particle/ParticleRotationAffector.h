@@ -17,8 +17,11 @@ public:
 		const Vector3<float>& point = Vector3<float>() 
 	);
 
-	//! Affects a particle.
-	virtual void Affect(unsigned int now, Particle* particlearray, unsigned int count);
+	//! Computes the rotation for the time elapsed since the last update.
+	virtual void Prepare(unsigned int now);
+
+	//! Affects a range of particles.
+	virtual void Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end);
 
 	//! Set the point that particles will attract to
 	virtual void SetPivotPoint( const Vector3<float>& point ) { mPivotPoint = point; }
@@ -40,6 +43,11 @@ private:
 	Vector3<float> mPivotPoint;
 	Vector3<float> mSpeed;
 	unsigned int mLastTime;
+
+	//! cosine and sine of the rotations in the YZ, XZ and XY planes
+	float mCos[3];
+	float mSin[3];
+	bool mRotate;
 };
 
 #endif
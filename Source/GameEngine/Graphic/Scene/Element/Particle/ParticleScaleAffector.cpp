@@ -10,14 +10,40 @@ ParticleScaleAffector::ParticleScaleAffector(const Vector2<float>& scaleTo)
 
 }
 
-void ParticleScaleAffector::Affect (unsigned int now, Particle *particlearray, unsigned int count)
+void ParticleScaleAffector::Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end)
 {
-	for(unsigned int i=0;i<count;i++)
+	if (!mEnabled)
+		return;
+
+	const unsigned int* startTime = particles.mStartTime.data();
+	const unsigned int* endTime = particles.mEndTime.data();
+	float* size[2] = { particles.mSize[0].data(), particles.mSize[1].data() };
+	const float* startSize[2] = { particles.mStartSize[0].data(), particles.mStartSize[1].data() };
+
+	unsigned int i = begin;
+#if defined(PARTICLE_SSE)
+	const __m128i now4 = _mm_set1_epi32((int)now);
+	const __m128 scaleTo[2] = { _mm_set1_ps(mScaleTo[0]), _mm_set1_ps(mScaleTo[1]) };
+	for (; i + 4 <= end; i += 4)
 	{
-		const unsigned int maxdiff = particlearray[i].mEndTime - particlearray[i].mStartTime;
-		const unsigned int curdiff = now - particlearray[i].mStartTime;
+		__m128i start = _mm_loadu_si128((const __m128i*)(startTime + i));
+		__m128 maxdiff = _mm_cvtepi32_ps(
+			_mm_sub_epi32(_mm_loadu_si128((const __m128i*)(endTime + i)), start));
+		__m128 curdiff = _mm_cvtepi32_ps(_mm_sub_epi32(now4, start));
+		__m128 newscale = _mm_div_ps(curdiff, maxdiff);
+		for (int j = 0; j < 2; ++j)
+		{
+			_mm_storeu_ps(size[j] + i, _mm_add_ps(
+				_mm_loadu_ps(startSize[j] + i), _mm_mul_ps(scaleTo[j], newscale)));
+		}
+	}
+#endif
+	for (; i < end; ++i)
+	{
+		const unsigned int maxdiff = endTime[i] - startTime[i];
+		const unsigned int curdiff = now - startTime[i];
 		const float newscale = (float)curdiff / maxdiff;
-		particlearray[i].mSize = particlearray[i].mStartSize + mScaleTo*newscale;
+		for (int j = 0; j < 2; ++j)
+			size[j][i] = startSize[j][i] + mScaleTo[j] * newscale;
 	}
 }
-
@@ -14,7 +14,8 @@ public:
 
 	ParticleScaleAffector(const Vector2<float>& scaleTo = Vector2<float>{ 1.f, 1.f });
 
-	virtual void Affect(unsigned int now, Particle *particlearray, unsigned int count);
+	//! Affects a range of particles.
+	virtual void Affect(unsigned int now, ParticleArray& particles, unsigned int begin, unsigned int end);
 
 	//! Get affector type
 	virtual ParticleAffectorType GetType() const { return PAT_SCALE; }
@@ -13,6 +13,10 @@
 
 #include "ParticleAnimatedMeshNodeEmitter.h"
 
+#include "Core/Process/JobSystem.h"
+
+#include <mutex>
+
 //#include "Utilities/ViewFrustum.h"
 
 //! constructor
@@ -20,7 +24,7 @@ ParticleSystemNode::ParticleSystemNode(const ActorId actorId, PVWUpdater* update
 	WeakBaseRenderComponentPtr renderComponent, bool createDefaultEmitter)
 :	Node(actorId, renderComponent, NT_PARTICLE_SYSTEM),
 	mEmitter(0), mParticleSize(Vector2<float>{5.f, 5.f}), mLastEmitTime(0),
-	mMaxParticles(0xffff), mParticlesAreGlobal(true)
+	mMaxParticles(262144), mParticleCapacity(0), mParticlesAreGlobal(true)
 {
 	mPVWUpdater = updater;
 	mMeshBuffer = eastl::make_shared<MeshBuffer>();
@@ -52,6 +56,7 @@ void ParticleSystemNode::SetEffect(int size)
 	for (unsigned int i = 0; i < GetMaterialCount(); ++i)
 		meshBuffer->GetMaterial() = GetMaterial(i);
 	mMeshBuffer.reset(meshBuffer);
+	mParticleCapacity = 0;
 
 	eastl::vector<eastl::string> path;
 #if defined(_OPENGL_)
@@ -67,7 +72,7 @@ void ParticleSystemNode::SetEffect(int size)
 	mEffect = effect;
 	mVisual = eastl::make_shared<Visual>(
 		meshBuffer->GetVertice(), meshBuffer->GetIndice(), mEffect);
-	mPVWUpdater->Subscribe(mWorldTransform, effect->GetPVWMatrixConstant());
+	mPVWUpdater->Subscribe(this, effect->GetPVWMatrixConstant());
 }
 
 //! destructor
@@ -81,14 +86,9 @@ bool ParticleSystemNode::PreRender(Scene *pScene)
 {
 	if (IsVisible())
 	{
-		DoParticleSystem(Timer::GetTime());
-
-		// reallocate arrays, if they are too small
-		ReallocateBuffers();
-
-		DoParticleBuffers(pScene);
+		UpdateParticles(Timer::GetTime(), pScene->GetActiveCamera());
 
-		if (mParticles.size() != 0)
+		if (mParticles.Size() != 0)
 		{
 			int transparentCount = 0;
 			int solidCount = 0;
@@ -153,6 +153,11 @@ bool ParticleSystemNode::Render(Scene *pScene)
 }
 
 void ParticleSystemNode::DoParticleSystem(unsigned int time)
+{
+	UpdateParticles(time, nullptr);
+}
+
+void ParticleSystemNode::UpdateParticles(unsigned int time, const eastl::shared_ptr<CameraNode>& cameraNode)
 {
 	if (mLastEmitTime==0)
 	{
@@ -164,77 +169,200 @@ void ParticleSystemNode::DoParticleSystem(unsigned int time)
 	unsigned int timediff = time - mLastEmitTime;
 	mLastEmitTime = time;
 
-	// run emitter
+	EmitParticles(now, timediff);
 
-	if (mEmitter)
+	// Particle order does not matter, so dead particles are removed by moving
+	// the last particle into their slot before they are affected.
+	for (unsigned int i = 0; i < mParticles.Size();)
 	{
-		Particle* array = 0;
-		int newParticles = mEmitter->Emitt(now, timediff, array);
+		if (now > mParticles.mEndTime[i])
+			mParticles.Remove(i);
+		else
+			++i;
+	}
+
+	eastl::list<eastl::shared_ptr<BaseParticleAffector>>::iterator ait = mAffectorList.begin();
+	for (; ait != mAffectorList.end(); ++ait)
+		(*ait)->Prepare(now);
+
+	// reallocate arrays, if they are too small
+	ParticleVertex* vertices = nullptr;
+	Vector3<float> right, up;
+	if (cameraNode)
+	{
+		ReallocateBuffers();
+		if (mParticles.Size() != 0)
+			vertices = mMeshBuffer->GetVertice()->Get<ParticleVertex>();
 
-		if (newParticles && array)
+		right = HProject(cameraNode->Get()->GetRVector());
+		up = HProject(cameraNode->Get()->GetUVector());
+	}
+
+	// The particles are independent, big systems are split into jobs over
+	// contiguous ranges which are affected, moved and turned into quads. The
+	// ranges are made of groups of four particles for the SSE loops.
+	unsigned int const numParticles = mParticles.Size();
+	float bounds[7] = { FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, 0.f };
+	unsigned int const minPerJob = 16384;
+	JobSystem* jobSystem = JobSystem::Get();
+	if (jobSystem && numParticles >= 2 * minPerJob)
+	{
+		std::mutex boundsMutex;
+		jobSystem->ParallelFor((numParticles + 3) / 4, minPerJob / 4,
+			[this, now, timediff, numParticles, vertices, &right, &up, &bounds, &boundsMutex](
+				unsigned int begin, unsigned int end)
 		{
-			int j = mParticles.size();
-			if (newParticles > 16250 - j)
-				newParticles = 16250 - j;
+			float rangeBounds[7] = { FLT_MAX, FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, 0.f };
+			UpdateRange(now, (float)timediff, 4 * begin, eastl::min(4 * end, numParticles),
+				vertices, right, up, rangeBounds);
 
-			mParticles.resize(j + newParticles);
-			for (int i = j; i<j + newParticles; ++i)
+			std::lock_guard<std::mutex> lock(boundsMutex);
+			for (int j = 0; j < 3; ++j)
 			{
-				mParticles[i] = array[i - j];
-
-				Vector4<float> startVector;
-				GetAbsoluteTransform().GetRotation().Transformation(
-					HLift(mParticles[i].mStartVector, 0.f), startVector);
-				mParticles[i].mStartVector = HProject(startVector);
-				if (mParticlesAreGlobal)
-				{
-					Vector4<float> positionVector;
-					GetAbsoluteTransform().GetRotation().Transformation(
-						HLift(mParticles[i].mPos, 0.f), positionVector);
-					mParticles[i].mPos = HProject(positionVector);
-				}
+				bounds[j] = eastl::min(bounds[j], rangeBounds[j]);
+				bounds[j + 3] = eastl::max(bounds[j + 3], rangeBounds[j + 3]);
 			}
-		}
+			bounds[6] = eastl::max(bounds[6], rangeBounds[6]);
+		});
+	}
+	else
+	{
+		UpdateRange(now, (float)timediff, 0, numParticles, vertices, right, up, bounds);
 	}
 
-	// run affectors
-	eastl::list<eastl::shared_ptr<BaseParticleAffector>>::iterator ait = mAffectorList.begin();
-	for (; ait != mAffectorList.end(); ++ait)
-		(*ait)->Affect(now, mParticles.data(), mParticles.size());
+	// Only the active vertices are meaningful, so the bound is made from the
+	// particle centers grown by the largest quad instead of from the buffer.
+	if (vertices)
+	{
+		Vector3<float> minimum{ bounds[0], bounds[1], bounds[2] };
+		Vector3<float> maximum{ bounds[3], bounds[4], bounds[5] };
+		Vector3<float> center = (minimum + maximum) * 0.5f;
+		mVisual->mModelBound.SetCenter(HLift(center, 1.f));
+		mVisual->mModelBound.SetRadius(Length(maximum - center) + sqrt(bounds[6]));
+		MarkBoundDirty();
+	}
+}
 
-	// animate all particles
-	float scale = (float)timediff;
+void ParticleSystemNode::UpdateRange(unsigned int now, float timediff, unsigned int begin, unsigned int end,
+	ParticleVertex* vertices, const Vector3<float>& right, const Vector3<float>& up, float bounds[7])
+{
+	float* pos[3] = { mParticles.mPos[0].data(), mParticles.mPos[1].data(), mParticles.mPos[2].data() };
+	const float* vector[3] = {
+		mParticles.mVector[0].data(), mParticles.mVector[1].data(), mParticles.mVector[2].data() };
+	const float* size[2] = { mParticles.mSize[0].data(), mParticles.mSize[1].data() };
+	const float* color[4] = { mParticles.mColor[0].data(), mParticles.mColor[1].data(),
+		mParticles.mColor[2].data(), mParticles.mColor[3].data() };
 
-	for (unsigned int i=0; i<mParticles.size();)
+	// The range is swept in blocks which stay in the cache while the
+	// affectors, the movement and the quads go through them.
+	unsigned int const blockSize = 512;
+	for (unsigned int first = begin; first < end; first += blockSize)
 	{
-		// erase is pretty expensive!
-		if (now > mParticles[i].mEndTime)
+		unsigned int last = eastl::min(first + blockSize, end);
+
+		// run affectors
+		eastl::list<eastl::shared_ptr<BaseParticleAffector>>::iterator ait = mAffectorList.begin();
+		for (; ait != mAffectorList.end(); ++ait)
+			(*ait)->Affect(now, mParticles, first, last);
+
+		// animate particles
+		unsigned int i = first;
+#if defined(PARTICLE_SSE)
+		const __m128 scale = _mm_set1_ps(timediff);
+		for (; i + 4 <= last; i += 4)
 		{
-			// Particle order does not seem to matter.
-			// So we can delete by switching with last particle and deleting that one.
-			// This is a lot faster and speed is very important here as the erase otherwise
-			// can cause noticable freezes.
-			mParticles[i] = mParticles[mParticles.size()-1];
-			mParticles.pop_back();
+			for (int j = 0; j < 3; ++j)
+			{
+				_mm_storeu_ps(pos[j] + i, _mm_add_ps(
+					_mm_loadu_ps(pos[j] + i), _mm_mul_ps(_mm_loadu_ps(vector[j] + i), scale)));
+			}
 		}
-		else
+#endif
+		for (; i < last; ++i)
 		{
-			mParticles[i].mPos += (mParticles[i].mVector * scale);
-			++i;
+			for (int j = 0; j < 3; ++j)
+				pos[j][i] += vector[j][i] * timediff;
+		}
+
+		if (!vertices)
+			continue;
+
+		// fill vertices of the quads facing the camera
+		for (i = first; i < last; ++i)
+		{
+			const Vector3<float> position{ pos[0][i], pos[1][i], pos[2][i] };
+			const Vector3<float> horizontal = right * (0.5f * size[0][i]);
+			const Vector3<float> vertical = up * (0.5f * size[1][i]);
+			const Vector4<float> particleColor{ color[0][i], color[1][i], color[2][i], color[3][i] };
+
+			ParticleVertex* quad = vertices + 4 * i;
+			quad[0].position = position + horizontal + vertical;
+			quad[1].position = position + horizontal - vertical;
+			quad[2].position = position - horizontal - vertical;
+			quad[3].position = position - horizontal + vertical;
+			for (int k = 0; k < 4; ++k)
+				quad[k].color = particleColor;
+
+			for (int j = 0; j < 3; ++j)
+			{
+				bounds[j] = eastl::min(bounds[j], position[j]);
+				bounds[j + 3] = eastl::max(bounds[j + 3], position[j]);
+			}
+			bounds[6] = eastl::max(bounds[6], Dot(horizontal, horizontal) + Dot(vertical, vertical));
 		}
 	}
 }
 
+void ParticleSystemNode::EmitParticles(unsigned int now, unsigned int timediff)
+{
+	if (!mEmitter)
+		return;
+
+	Particle* array = 0;
+	int newParticles = mEmitter->Emitt(now, timediff, array);
+	if (newParticles <= 0 || !array)
+		return;
+
+	unsigned int j = mParticles.Size();
+	if (j >= mMaxParticles)
+		return;
+
+	unsigned int count = eastl::min((unsigned int)newParticles, mMaxParticles - j);
+	mParticles.Resize(j + count);
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		Particle particle = array[i];
+
+		Vector4<float> startVector;
+		GetAbsoluteTransform().GetRotation().Transformation(
+			HLift(particle.mStartVector, 0.f), startVector);
+		particle.mStartVector = HProject(startVector);
+		if (mParticlesAreGlobal)
+		{
+			Vector4<float> positionVector;
+			GetAbsoluteTransform().GetRotation().Transformation(
+				HLift(particle.mPos, 0.f), positionVector);
+			particle.mPos = HProject(positionVector);
+		}
+		mParticles.Set(j + i, particle);
+	}
+}
+
 void ParticleSystemNode::ReallocateBuffers()
 {
-	if (mParticles.size() * 4 != mMeshBuffer->GetVertice()->GetNumElements() ||
-		mParticles.size() * 2 != mMeshBuffer->GetIndice()->GetNumPrimitives())
+	// The buffers grow geometrically and only the part used by the alive
+	// particles is active, so they are not rebuilt whenever the amount of
+	// particles changes.
+	unsigned int const numParticles = mParticles.Size();
+	if (numParticles > mParticleCapacity)
 	{
+		unsigned int capacity = eastl::max(eastl::max(numParticles, 2 * mParticleCapacity), 64u);
 		MeshBuffer* meshBuffer = new MeshBuffer(mMeshBuffer->GetVertice()->GetFormat(),
-			mParticles.size() * 4, mParticles.size() * 2, sizeof(unsigned int));
+			capacity * 4, capacity * 2, sizeof(unsigned int));
 		for (unsigned int i = 0; i < GetMaterialCount(); ++i)
 			meshBuffer->GetMaterial() = GetMaterial(i);
 		mMeshBuffer.reset(meshBuffer);
+		mParticleCapacity = capacity;
 
 		// fill vertices
 		for (unsigned int i = 0; i<mMeshBuffer->GetVertice()->GetNumElements(); i += 4)
@@ -261,42 +389,9 @@ void ParticleSystemNode::ReallocateBuffers()
 				mMeshBuffer->GetVertice(), mMeshBuffer->GetIndice(), mEffect));
 		}
 	}
-}
-
-void ParticleSystemNode::DoParticleBuffers(Scene *pScene)
-{
-	const eastl::shared_ptr<CameraNode>& cameraNode = pScene->GetActiveCamera();
-
-	if (!cameraNode) return;
-
-	//fill vertices
-	if (mParticles.size() != 0)
-	{
-		int idx = 0;
-		for (unsigned int i = 0; i < mParticles.size(); ++i)
-		{
-			const Particle& particle = mParticles[i];
-
-			float f = 0.5f * particle.mSize[0];
-			const Vector4<float> horizontal = cameraNode->Get()->GetRVector() * f;
-
-			f = 0.5f * particle.mSize[1];
-			const Vector4<float> vertical = cameraNode->Get()->GetUVector() * f;
-
-			mMeshBuffer->Position(0 + idx) = particle.mPos + HProject(horizontal + vertical);
-			mMeshBuffer->Color(0, 0 + idx) = particle.mColor;
-			mMeshBuffer->Position(1 + idx) = particle.mPos + HProject(horizontal - vertical);
-			mMeshBuffer->Color(0, 1 + idx) = particle.mColor;
-			mMeshBuffer->Position(2 + idx) = particle.mPos + HProject(-horizontal - vertical);
-			mMeshBuffer->Color(0, 2 + idx) = particle.mColor;
-			mMeshBuffer->Position(3 + idx) = particle.mPos + HProject(-horizontal + vertical);
-			mMeshBuffer->Color(0, 3 + idx) = particle.mColor;
-
-			idx += 4;
-		}
-	}
 
-	mVisual->UpdateModelBound();
+	mMeshBuffer->GetVertice()->SetNumActiveElements(numParticles * 4);
+	mMeshBuffer->GetIndice()->SetNumActivePrimitives(numParticles * 2);
 }
 
 //! Sets if the particles should be global. If it is, the particles are affected by
@@ -310,7 +405,7 @@ void ParticleSystemNode::SetParticlesAreGlobal(bool global)
 //! Remove all currently visible particles
 void ParticleSystemNode::ClearParticles()
 {
-	mParticles.clear();
+	mParticles.Clear();
 }
 
 //! Gets the particle emitter, which creates the particles.
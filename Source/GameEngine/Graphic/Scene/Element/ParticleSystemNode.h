@@ -26,6 +26,7 @@
 #include "Particle/ParticleRotationAffector.h"
 #include "Particle/ParticleAttractionAffector.h"
 
+class CameraNode;
 class ParticleAnimatedMeshNodeEmitter;
 
 //! A particle system scene node.
@@ -79,6 +80,14 @@ public:
 	//! as the node will care about this otherwise automatically.
 	void DoParticleSystem(unsigned int time);
 
+	//! Sets the maximum amount of alive particles, new particles are not
+	//! emitted while the system is full. Default is 262144.
+	void SetMaxParticles(unsigned int maxParticles) { mMaxParticles = maxParticles; }
+	unsigned int GetMaxParticles() const { return mMaxParticles; }
+
+	//! Gets the amount of alive particles.
+	unsigned int GetParticleCount() const { return mParticles.Size(); }
+
 	//! Returns type of the scene node
 	virtual NodeType GetType() const { return NT_PARTICLE_SYSTEM; }
 
@@ -219,8 +228,25 @@ public:
 
 private:
 
+	//! Vertex of the particle quads
+	struct ParticleVertex
+	{
+		Vector3<float> position;
+		Vector2<float> tcoord;
+		Vector4<float> color;
+	};
+
+	//! Emits, removes and moves the particles. The quads are built in the
+	//! same pass when a camera is given.
+	void UpdateParticles(unsigned int time, const eastl::shared_ptr<CameraNode>& cameraNode);
+
+	//! Affects, moves and builds the quads of the particles [begin, end).
+	//! The bounds are min xyz, max xyz and the largest squared quad half diagonal.
+	void UpdateRange(unsigned int now, float timediff, unsigned int begin, unsigned int end,
+		ParticleVertex* vertices, const Vector3<float>& right, const Vector3<float>& up, float bounds[7]);
+
+	void EmitParticles(unsigned int now, unsigned int timediff);
 	void ReallocateBuffers();
-	void DoParticleBuffers(Scene *pScene);
 
 	eastl::shared_ptr<BlendState> mBlendState;
 	eastl::shared_ptr<DepthStencilState> mDepthStencilState;
@@ -231,10 +257,11 @@ private:
 	eastl::shared_ptr<VisualEffect> mEffect;
 	eastl::list<eastl::shared_ptr<BaseParticleAffector>> mAffectorList;
 	eastl::shared_ptr<BaseParticleEmitter> mEmitter;
-	eastl::vector<Particle> mParticles;
+	ParticleArray mParticles;
 	Vector2<float> mParticleSize;
 	unsigned int mLastEmitTime;
-	int mMaxParticles;
+	unsigned int mMaxParticles;
+	unsigned int mParticleCapacity;
 
 	enum GRAPHIC_ITEM ParticlePrimitive
 	{
@@ -70,7 +70,8 @@ RectangleNode::RectangleNode(const ActorId actorId, PVWUpdater* updater,
 		texture, SamplerState::MIN_L_MAG_L_MIP_L, SamplerState::WRAP, SamplerState::WRAP);
 	mVisual->SetEffect(mEffect);
 	mVisual->UpdateModelBound();
-	mPVWUpdater->Subscribe(mWorldTransform, mEffect->GetPVWMatrixConstant());
+	MarkBoundDirty();
+	mPVWUpdater->Subscribe(this, mEffect->GetPVWMatrixConstant());
 }
 
 
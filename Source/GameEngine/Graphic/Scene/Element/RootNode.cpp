@@ -78,6 +78,9 @@ bool RootNode::RenderChildren(Scene *pScene)
 
 		}
 
+		// draw the instances the nodes of this pass have queued
+		pScene->GetInstanceBatcher().Flush(pScene);
+
 		if (pScene->GetLightManager())
 			pScene->GetLightManager()->OnRenderPassPostRender((RenderPass)pass);
 	}
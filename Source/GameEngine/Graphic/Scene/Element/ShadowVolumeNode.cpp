@@ -11,6 +11,14 @@
 
 #include "Graphic/Scene/Scene.h"
 
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <xmmintrin.h>
+#define SHADOW_SSE
+#endif
+
+eastl::hash_map<BaseMesh const*, eastl::weak_ptr<ShadowVolumeNode::Adjacency>>
+	ShadowVolumeNode::msAdjacencyCache;
+
 
 //! constructor
 ShadowVolumeNode::ShadowVolumeNode(const ActorId actorId, PVWUpdater* updater, 
@@ -32,6 +40,7 @@ void ShadowVolumeNode::SetShadowMesh(const eastl::shared_ptr<BaseMesh>& mesh)
 		return;
 
 	mShadowMesh = mesh;
+	mAdjacency.reset();
 
 	if (mShadowMesh)
 	{
@@ -72,8 +81,9 @@ void ShadowVolumeNode::SetShadowMesh(const eastl::shared_ptr<BaseMesh>& mesh)
 				eastl::shared_ptr<Visual> visual = eastl::make_shared<Visual>(
 					meshBuffer->GetVertice(), meshBuffer->GetIndice(), mEffect);
 				visual->UpdateModelBound();
+				MarkBoundDirty();
 				mVisuals.push_back(visual);
-				mPVWUpdater->Subscribe(mWorldTransform, mEffect->GetPVWMatrixConstant());
+				mPVWUpdater->Subscribe(this, mEffect->GetPVWMatrixConstant());
 			}
 		}
 	}
@@ -142,26 +152,16 @@ unsigned int ShadowVolumeNode::CreateEdgesAndCaps(const Vector3<float>& light, S
 	bs->SetCenter(Vector4<float>::Zero());
 
 	// Check every face if it is front or back facing the light.
+	ClassifyFaces(light, faceCount);
+
 	for (unsigned int i=0; i<faceCount; ++i)
 	{
-		const Vector3<float> v0 = mVertices[mIndices[3*i+0]];
-		const Vector3<float> v1 = mVertices[mIndices[3*i+1]];
-		const Vector3<float> v2 = mVertices[mIndices[3*i+2]];
-
-#ifdef _USE_REVERSE_EXTRUDED
-		//! Test if the triangle would be front or backfacing from any point.
-		Vector3<float> normal = Cross(v1 - v0, v2 - v2);
-		Normalize(normal);
-		mFaceData[i] = Dot(normal, light) <= 0.0f;
-#else
-		//! Test if the triangle would be front or backfacing from any point.
-		Vector3<float> normal = Cross(v1 - v2, v2 - v0);
-		Normalize(normal);
-		mFaceData[i] = Dot(normal, light) <= 0.0f;
-#endif
-
 		if (mUseZFailMethod && mFaceData[i])
 		{
+			const Vector3<float> v0 = mVertices[mIndices[3*i+0]];
+			const Vector3<float> v1 = mVertices[mIndices[3*i+1]];
+			const Vector3<float> v2 = mVertices[mIndices[3*i+2]];
+
 			// add front cap from light-facing faces
 			svp->push_back(v2);
 			svp->push_back(v1);
@@ -195,9 +195,9 @@ unsigned int ShadowVolumeNode::CreateEdgesAndCaps(const Vector3<float>& light, S
 			const unsigned int wFace1 = mIndices[3*i+1];
 			const unsigned int wFace2 = mIndices[3*i+2];
 
-			const unsigned int adj0 = mAdjacency[3*i+0];
-			const unsigned int adj1 = mAdjacency[3*i+1];
-			const unsigned int adj2 = mAdjacency[3*i+2];
+			const unsigned int adj0 = mAdjacency->mFaces[3*i+0];
+			const unsigned int adj1 = mAdjacency->mFaces[3*i+1];
+			const unsigned int adj2 = mAdjacency->mFaces[3*i+2];
 
 			// add edges if face is adjacent to back-facing face
 			// or if no adjacent face was found
@@ -235,6 +235,65 @@ unsigned int ShadowVolumeNode::CreateEdgesAndCaps(const Vector3<float>& light, S
 	return numEdges;
 }
 
+//! Test if the triangles would be front or backfacing from any point. The
+//! sign of the dot product doesn't need the normals to be normalized, so
+//! four faces are tested at once from their vertices gathered by lanes.
+void ShadowVolumeNode::ClassifyFaces(const Vector3<float>& light, unsigned int faceCount)
+{
+	unsigned int i = 0;
+#ifdef SHADOW_SSE
+	const __m128 lx = _mm_set1_ps(light[0]);
+	const __m128 ly = _mm_set1_ps(light[1]);
+	const __m128 lz = _mm_set1_ps(light[2]);
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= faceCount; i += 4)
+	{
+		const Vector3<float>* v[3][4];
+		for (unsigned int f = 0; f < 4; ++f)
+			for (unsigned int c = 0; c < 3; ++c)
+				v[c][f] = &mVertices[mIndices[3*(i+f)+c]];
+
+#define SHADOW_GATHER(c, k) _mm_setr_ps((*v[c][0])[k], (*v[c][1])[k], (*v[c][2])[k], (*v[c][3])[k])
+		const __m128 x0 = SHADOW_GATHER(0, 0), y0 = SHADOW_GATHER(0, 1), z0 = SHADOW_GATHER(0, 2);
+		const __m128 x1 = SHADOW_GATHER(1, 0), y1 = SHADOW_GATHER(1, 1), z1 = SHADOW_GATHER(1, 2);
+		const __m128 x2 = SHADOW_GATHER(2, 0), y2 = SHADOW_GATHER(2, 1), z2 = SHADOW_GATHER(2, 2);
+#undef SHADOW_GATHER
+
+#ifdef _USE_REVERSE_EXTRUDED
+		// normal = (v1 - v0) x (v2 - v0)
+		const __m128 ax = _mm_sub_ps(x1, x0), ay = _mm_sub_ps(y1, y0), az = _mm_sub_ps(z1, z0);
+		const __m128 bx = _mm_sub_ps(x2, x0), by = _mm_sub_ps(y2, y0), bz = _mm_sub_ps(z2, z0);
+#else
+		// normal = (v1 - v2) x (v2 - v0)
+		const __m128 ax = _mm_sub_ps(x1, x2), ay = _mm_sub_ps(y1, y2), az = _mm_sub_ps(z1, z2);
+		const __m128 bx = _mm_sub_ps(x2, x0), by = _mm_sub_ps(y2, y0), bz = _mm_sub_ps(z2, z0);
+#endif
+		const __m128 nx = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+		const __m128 ny = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+		const __m128 nz = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+
+		const __m128 dot = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(nx, lx), _mm_mul_ps(ny, ly)), _mm_mul_ps(nz, lz));
+		const int front = _mm_movemask_ps(_mm_cmple_ps(dot, zero));
+		for (unsigned int f = 0; f < 4; ++f)
+			mFaceData[i + f] = (front & (1 << f)) != 0;
+	}
+#endif
+	for (; i < faceCount; ++i)
+	{
+		const Vector3<float>& v0 = mVertices[mIndices[3*i+0]];
+		const Vector3<float>& v1 = mVertices[mIndices[3*i+1]];
+		const Vector3<float>& v2 = mVertices[mIndices[3*i+2]];
+
+#ifdef _USE_REVERSE_EXTRUDED
+		Vector3<float> normal = Cross(v1 - v0, v2 - v0);
+#else
+		Vector3<float> normal = Cross(v1 - v2, v2 - v0);
+#endif
+		mFaceData[i] = Dot(normal, light) <= 0.0f;
+	}
+}
+
 void ShadowVolumeNode::UpdateShadowVolumes(Scene *pScene)
 {
 	const unsigned int oldIndexCount = mIndexCount;
@@ -263,11 +322,15 @@ void ShadowVolumeNode::UpdateShadowVolumes(Scene *pScene)
 
 	for (i=0; i<bufcnt; ++i)
 	{
-		const BaseMeshBuffer* buf = mesh->GetMeshBuffer(i).get();
-		totalIndices += buf->GetNumElements();
-		totalVertices += buf->GetNumElements();
+		totalIndices += mVisuals[i]->GetIndexBuffer()->GetNumElements();
+		totalVertices += mVisuals[i]->GetVertexBuffer()->GetNumElements();
 	}
 
+	mIndices.resize(totalIndices);
+	mVertices.resize(totalVertices);
+	mEdges.resize(2 * totalIndices);
+	mFaceData.resize(totalIndices / 3);
+
 	// copy mesh
 	for (unsigned int i = 0; i<mesh->GetMeshBufferCount(); ++i)
 	{
@@ -287,7 +350,7 @@ void ShadowVolumeNode::UpdateShadowVolumes(Scene *pScene)
 	}
 
 	// recalculate adjacency if necessary
-	if (oldVertexCount != mVertexCount || oldIndexCount != mIndexCount)
+	if (!mAdjacency || oldVertexCount != mVertexCount || oldIndexCount != mIndexCount)
 		CalculateAdjacency();
 
 	//Matrix4x4<float> toWorld, fromWorld;
@@ -382,45 +445,102 @@ bool ShadowVolumeNode::Render(Scene* pScene)
 //! Generates adjacency information based on mesh indices.
 void ShadowVolumeNode::CalculateAdjacency()
 {
-	// go through all faces and fetch their three neighbours
-	for (unsigned int f=0; f<mIndexCount; f+=3)
+	// the adjacency of the mesh may have been built by another node
+	eastl::weak_ptr<Adjacency>& cached = msAdjacencyCache[mShadowMesh.get()];
+	mAdjacency = cached.lock();
+	if (mAdjacency && mAdjacency->mVertexCount == mVertexCount &&
+		mAdjacency->mIndexCount == mIndexCount)
+		return;
+
+	mAdjacency = eastl::make_shared<Adjacency>();
+	mAdjacency->mVertexCount = mVertexCount;
+	mAdjacency->mIndexCount = mIndexCount;
+	mAdjacency->mFaces.resize(mIndexCount);
+	cached = mAdjacency;
+
+	// drop the entries of the meshes which no node uses anymore
+	for (auto it = msAdjacencyCache.begin(); it != msAdjacencyCache.end();)
 	{
-		for (unsigned int edge = 0; edge<3; ++edge)
+		if (it->second.expired())
+			it = msAdjacencyCache.erase(it);
+		else
+			++it;
+	}
+
+	// weld the vertices with the same position, the faces of a mesh buffer
+	// often don't share the vertices of their seams
+	struct WeldKey
+	{
+		uint32_t mBits[3];
+		bool operator==(const WeldKey& other) const
 		{
-			const Vector3<float>& v1 = mVertices[mIndices[f+edge]];
-			const Vector3<float>& v2 = mVertices[mIndices[f+((edge+1)%3)]];
+			return mBits[0] == other.mBits[0] &&
+				mBits[1] == other.mBits[1] && mBits[2] == other.mBits[2];
+		}
+	};
+	struct WeldHash
+	{
+		size_t operator()(const WeldKey& key) const
+		{
+			return (size_t)(key.mBits[0] * 73856093u ^ key.mBits[1] * 19349663u ^ key.mBits[2] * 83492791u);
+		}
+	};
 
-			// now we search an_O_ther _F_ace with these two
-			// vertices, which is not the current face.
-			unsigned int of;
+	eastl::vector<unsigned int> welded(mVertexCount);
+	eastl::hash_map<WeldKey, unsigned int, WeldHash> positions;
+	positions.reserve(mVertexCount);
+	for (unsigned int v = 0; v < mVertexCount; ++v)
+	{
+		WeldKey key;
+		for (unsigned int k = 0; k < 3; ++k)
+		{
+			// adding zero turns -0 into 0, as the float comparison does
+			float value = mVertices[v][k] + 0.0f;
+			memcpy(&key.mBits[k], &value, sizeof(uint32_t));
+		}
+		welded[v] = positions.insert(eastl::make_pair(key, v)).first->second;
+	}
 
-			for (of=0; of<mIndexCount; of+=3)
-			{
-				// only other faces
-				if (of != f)
-				{
-					bool cnt1 = false;
-					bool cnt2 = false;
-
-					for (int e=0; e<3; ++e)
-					{
-						if (v1 == mVertices[mIndices[of+e]])
-							cnt1=true;
-
-						if (v2 == mVertices[mIndices[of+e]])
-							cnt2=true;
-					}
-					// one match for each vertex, i.e. edge is the same
-					if (cnt1 && cnt2)
-						break;
-				}
-			}
+	// the first two faces of every edge, in face order
+	struct EdgeFaces
+	{
+		unsigned int mFaces[2];
+	};
+	const unsigned int noFace = 0xFFFFFFFF;
+
+	eastl::hash_map<uint64_t, EdgeFaces> edges;
+	edges.reserve(mIndexCount);
+	for (unsigned int f=0; f<mIndexCount; f+=3)
+	{
+		for (unsigned int edge = 0; edge<3; ++edge)
+		{
+			unsigned int v1 = welded[mIndices[f+edge]];
+			unsigned int v2 = welded[mIndices[f+((edge+1)%3)]];
+			uint64_t key = v1 < v2 ?
+				((uint64_t)v1 << 32) | v2 : ((uint64_t)v2 << 32) | v1;
+
+			EdgeFaces empty = { { noFace, noFace } };
+			EdgeFaces& faces = edges.insert(eastl::make_pair(key, empty)).first->second;
+			if (faces.mFaces[0] == noFace)
+				faces.mFaces[0] = f/3;
+			else if (faces.mFaces[0] != f/3 && faces.mFaces[1] == noFace)
+				faces.mFaces[1] = f/3;
+		}
+	}
 
-			// no adjacent edges -> store face number, else store adjacent face
-			if (of >= mIndexCount)
-				mAdjacency[f + edge] = f/3;
-			else
-				mAdjacency[f + edge] = of/3;
+	// no adjacent edges -> store face number, else store the first other face
+	for (unsigned int f=0; f<mIndexCount; f+=3)
+	{
+		for (unsigned int edge = 0; edge<3; ++edge)
+		{
+			unsigned int v1 = welded[mIndices[f+edge]];
+			unsigned int v2 = welded[mIndices[f+((edge+1)%3)]];
+			uint64_t key = v1 < v2 ?
+				((uint64_t)v1 << 32) | v2 : ((uint64_t)v2 << 32) | v1;
+
+			const EdgeFaces& faces = edges.find(key)->second;
+			unsigned int other = faces.mFaces[0] != f/3 ? faces.mFaces[0] : faces.mFaces[1];
+			mAdjacency->mFaces[f + edge] = other != noFace ? other : f/3;
 		}
 	}
-}
\ No newline at end of file
+}
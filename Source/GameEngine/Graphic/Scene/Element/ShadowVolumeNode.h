@@ -41,9 +41,23 @@ private:
 	void CreateShadowVolume(const Vector3<float>& pos, bool isDirectional=false);
 	unsigned int CreateEdgesAndCaps(const Vector3<float>& light, ShadowVolume* svp, BoundingSphere* bs);
 
+	//! Classifies the faces as front or back facing the light.
+	void ClassifyFaces(const Vector3<float>& light, unsigned int faceCount);
+
 	//! Generates adjacency information based on mesh indices.
 	void CalculateAdjacency();
 
+	//! Neighbour face of each face edge, the face itself when the edge has
+	//! no neighbour. It only depends on the mesh, so the nodes which share a
+	//! mesh share it through the cache.
+	struct Adjacency
+	{
+		unsigned int mVertexCount;
+		unsigned int mIndexCount;
+		eastl::vector<unsigned int> mFaces;
+	};
+	static eastl::hash_map<BaseMesh const*, eastl::weak_ptr<Adjacency>> msAdjacencyCache;
+
 	// a shadow volume for every light
 	eastl::vector<ShadowVolume> mShadowVolumes;
 
@@ -52,7 +66,7 @@ private:
 
 	eastl::vector<Vector3<float>> mVertices;
 	eastl::vector<unsigned int> mIndices;
-	eastl::vector<unsigned int> mAdjacency;
+	eastl::shared_ptr<Adjacency> mAdjacency;
 	eastl::vector<unsigned int> mEdges;
 	// tells if face is front facing
 	eastl::vector<bool> mFaceData;
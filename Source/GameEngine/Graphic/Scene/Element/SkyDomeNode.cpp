@@ -65,7 +65,8 @@ SkyDomeNode::SkyDomeNode(const ActorId actorId, PVWUpdater* updater, WeakBaseRen
 	mVisual = eastl::make_shared<Visual>(mMeshBuffer->GetVertice(), mMeshBuffer->GetIndice(), effect);
 	mVisual->SetEffect(effect);
 	mVisual->UpdateModelBound();
-	mPVWUpdater->Subscribe(mWorldTransform, effect->GetPVWMatrixConstant());
+	MarkBoundDirty();
+	mPVWUpdater->Subscribe(this, effect->GetPVWMatrixConstant());
 }
 
 void SkyDomeNode::GenerateMesh(const eastl::shared_ptr<Texture2>& sky)
@@ -59,7 +59,8 @@ SphereNode::SphereNode(const ActorId actorId, PVWUpdater* updater, WeakBaseRende
 		texture, SamplerState::MIN_L_MAG_L_MIP_L, SamplerState::WRAP, SamplerState::WRAP);
 	mVisual->SetEffect(mEffect);
 	mVisual->UpdateModelBound();
-	mPVWUpdater->Subscribe(mWorldTransform, mEffect->GetPVWMatrixConstant());
+	MarkBoundDirty();
+	mPVWUpdater->Subscribe(this, mEffect->GetPVWMatrixConstant());
 }
 
 
@@ -192,9 +192,10 @@ void VolumeLightNode::ConstructLight()
 	mEffect = effect;
 	mVisual = eastl::make_shared<Visual>(
 		mMeshBuffer->GetVertice(), mMeshBuffer->GetIndice(), mEffect);
-	mPVWUpdater->Subscribe(mWorldTransform, effect->GetPVWMatrixConstant());
+	mPVWUpdater->Subscribe(this, effect->GetPVWMatrixConstant());
 
 	mVisual->UpdateModelBound();
+	MarkBoundDirty();
 }
 
 
@@ -387,15 +387,10 @@ bool Node::OnUpdate(Scene *pScene, unsigned int timeMs, unsigned long const elap
 		++i;
 	}
 
-	// update spatial data
-	Spatial::UpdateWorldData();
-
-	// animate this node
+	// animate this node, the world transforms and bounds of the changed
+	// nodes are updated afterwards by the scene in a single pass
 	OnAnimate(pScene, timeMs);
 
-	//update bounds
-	UpdateWorldBound();
-
 	return true;
 }
 
@@ -448,81 +443,68 @@ bool Node::PreRender(Scene *pScene)
 	return true;
 }
 
-//! Sort the nodes which are going to be rendered
-void Node::SortRenderList(Scene* pScene)
+//! Sort the nodes of a render list by the keys of the render queue, either
+//! grouped by state or ordered by depth when a pass blends or counts lights
+static void SortPassRenderList(Scene* pScene, RenderPass pass,
+	bool byDepth, bool backToFront, const Vector4<float>& camWorldPos)
 {
-	//LIGHT NODES
-	if (!pScene->GetLightManager())
-	{
-		SceneNodeRenderList& renderList = pScene->GetRenderList(RP_LIGHT);
-
-		// Sort the lights by distance from the camera
-		Vector4<float> camWorldPos;
-		if (pScene->GetActiveCamera())
-			camWorldPos = pScene->GetActiveCamera()->Get()->GetPosition();
-
-		eastl::vector<DistanceNodeEntry> SortedLights;
-		for (int light = renderList.size() - 1; light >= 0; --light)
-			SortedLights.push_back(DistanceNodeEntry(renderList[light], camWorldPos));
-
-		eastl::sort(SortedLights.begin(), SortedLights.end());
-
-		for (int light = (int)renderList.size() - 1; light >= 0; --light)
-			renderList[light] = SortedLights[light].mNode;
-	}
-
-	//SOLID NODES
-	{
-		SceneNodeRenderList& renderList = pScene->GetRenderList(RP_SOLID);
-
-		// Sort the solids by texture id
-		eastl::vector<DefaultNodeEntry> SortedSolids;
-		for (int solid = renderList.size() - 1; solid >= 0; --solid)
-			SortedSolids.push_back(DefaultNodeEntry(renderList[solid]));
-
-		eastl::sort(SortedSolids.begin(), SortedSolids.end());
+	SceneNodeRenderList& renderList = pScene->GetRenderList(pass);
+	if (renderList.size() < 2)
+		return;
 
-		for (int solid = (int)renderList.size() - 1; solid >= 0; --solid)
-			renderList[solid] = SortedSolids[solid].mNode;
-	}
-
-	//TRANSPARENT NODES
+	RenderQueue& renderQueue = pScene->GetRenderQueue();
+	renderQueue.Clear();
+	for (Node* node : renderList)
 	{
-		SceneNodeRenderList& renderList = pScene->GetRenderList(RP_TRANSPARENT);
-
-		// Sort the transparent nodes by distance from the camera
-		Vector4<float> camWorldPos;
-		if (pScene->GetActiveCamera())
-			camWorldPos = pScene->GetActiveCamera()->Get()->GetPosition();
-
-		eastl::vector<TransparentNodeEntry> SortedTransparent;
-		for (int transparent = renderList.size() - 1; transparent >= 0; --transparent)
-			SortedTransparent.push_back(TransparentNodeEntry(renderList[transparent], camWorldPos));
+		// the first visual and material stand for the state of the node
+		void const* program = nullptr;
+		if (node->GetVisualCount() > 0)
+		{
+			const eastl::shared_ptr<Visual>& visual = node->GetVisual(0);
+			if (visual && visual->GetEffect())
+				program = visual->GetEffect()->GetProgram().get();
+		}
+		void const* texture = nullptr;
+		if (node->GetMaterialCount() > 0)
+		{
+			const eastl::shared_ptr<Material>& material = node->GetMaterial(0);
+			if (material)
+				texture = material->GetTexture(0).get();
+		}
 
-		eastl::sort(SortedTransparent.begin(), SortedTransparent.end());
+		Vector4<float> diff = node->GetAbsoulteBound().GetCenter() - camWorldPos;
+		diff[3] = 0.f;
+		float depth = Dot(diff, diff);
 
-		for (int transparent = (int)renderList.size() - 1; transparent >= 0; --transparent)
-			renderList[transparent] = SortedTransparent[transparent].mNode;
+		if (byDepth)
+			renderQueue.Add(RenderQueue::MakeDepthKey(pass, program, texture, depth, backToFront), node);
+		else
+			renderQueue.Add(RenderQueue::MakeStateKey(pass, program, texture, depth), node);
 	}
+	renderQueue.Sort();
 
-	//TRANSPARENT EFFECT NODES
-	{
-		SceneNodeRenderList& renderList = pScene->GetRenderList(RP_TRANSPARENT_EFFECT);
+	const eastl::vector<RenderQueue::Entry>& entries = renderQueue.GetEntries();
+	for (unsigned int entry = 0; entry < entries.size(); ++entry)
+		renderList[entry] = entries[entry].mNode;
+}
 
-		// Sort the transparent nodes by distance from the camera
-		Vector4<float> camWorldPos;
-		if (pScene->GetActiveCamera())
-			camWorldPos = pScene->GetActiveCamera()->Get()->GetPosition();
+//! Sort the nodes which are going to be rendered
+void Node::SortRenderList(Scene* pScene)
+{
+	Vector4<float> camWorldPos = Vector4<float>::Zero();
+	if (pScene->GetActiveCamera())
+		camWorldPos = pScene->GetActiveCamera()->Get()->GetPosition();
 
-		eastl::vector<TransparentNodeEntry> SortedTransparent;
-		for (int transparent = renderList.size() - 1; transparent >= 0; --transparent)
-			SortedTransparent.push_back(TransparentNodeEntry(renderList[transparent], camWorldPos));
+	//LIGHT NODES, nearest to the camera first
+	if (!pScene->GetLightManager())
+		SortPassRenderList(pScene, RP_LIGHT, true, false, camWorldPos);
 
-		eastl::sort(SortedTransparent.begin(), SortedTransparent.end());
+	//SOLID NODES, grouped by program and texture
+	SortPassRenderList(pScene, RP_SOLID, false, false, camWorldPos);
 
-		for (int transparent = (int)renderList.size() - 1; transparent >= 0; --transparent)
-			renderList[transparent] = SortedTransparent[transparent].mNode;
-	}
+	//TRANSPARENT NODES, farthest from the camera first
+	SortPassRenderList(pScene, RP_TRANSPARENT, true, true, camWorldPos);
+	SortPassRenderList(pScene, RP_TRANSPARENT_EFFECT, true, true, camWorldPos);
 }
 
 //
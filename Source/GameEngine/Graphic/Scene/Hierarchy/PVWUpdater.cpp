@@ -7,6 +7,10 @@
 
 #include "PVWUpdater.h"
 
+#include "Spatial.h"
+
+#include "Core/Process/JobSystem.h"
+
 PVWUpdater::~PVWUpdater()
 {
 }
@@ -31,56 +35,176 @@ bool PVWUpdater::Subscribe(Matrix4x4<float> const& worldMatrix,
     eastl::shared_ptr<ConstantBuffer> const& cbuffer,
     eastl::string const& pvwMatrixName)
 {
-    if (cbuffer && cbuffer->HasMember(pvwMatrixName))
-    {
-		for (PVWIterator it = mSubscribers.begin(); it != mSubscribers.end(); it++)
-			if ((*it).second.first == cbuffer)
-				return false;
+    return Subscribe(worldMatrix, nullptr, cbuffer, pvwMatrixName);
+}
+
+bool PVWUpdater::Subscribe(Spatial* spatial,
+    eastl::shared_ptr<ConstantBuffer> const& cbuffer,
+    eastl::string const& pvwMatrixName)
+{
+    if (!spatial)
+        return false;
+
+    Matrix4x4<float> const& worldMatrix = spatial->GetAbsoluteTransform();
+    return Subscribe(worldMatrix, spatial, cbuffer, pvwMatrixName);
+}
+
+bool PVWUpdater::Subscribe(Matrix4x4<float> const& worldMatrix, Spatial* spatial,
+    eastl::shared_ptr<ConstantBuffer> const& cbuffer,
+    eastl::string const& pvwMatrixName)
+{
+    if (!cbuffer || mSubscriberIndices.find(cbuffer.get()) != mSubscriberIndices.end())
+        return false;
 
-		mSubscribers.insert(eastl::make_pair(&worldMatrix,
-			eastl::make_pair(cbuffer, pvwMatrixName)));
-		return true;
+    auto const& layout = cbuffer->GetLayout();
+    auto iter = eastl::find_if(layout.begin(), layout.end(),
+        [&pvwMatrixName](MemberLayout const& item){ return pvwMatrixName == item.name; });
+    if (iter == layout.end() || iter->numElements > 0 ||
+        iter->offset + sizeof(Matrix4x4<float>) > cbuffer->GetNumBytes())
+    {
+        return false;
     }
-    return false;
+
+    PVWSubscriber subscriber;
+    subscriber.worldMatrix = &worldMatrix;
+    subscriber.spatial = spatial;
+    subscriber.cbuffer = cbuffer;
+    subscriber.offset = iter->offset;
+    subscriber.deferred = false;
+    mSubscriberIndices[cbuffer.get()] = (unsigned int)mSubscribers.size();
+    mSubscribers.push_back(subscriber);
+    return true;
 }
 
 bool PVWUpdater::Unsubscribe(eastl::shared_ptr<ConstantBuffer> const& cbuffer)
 {
-	for (PVWIterator it = mSubscribers.begin(); it != mSubscribers.end(); it++)
-	{
-		if ((*it).second.first == cbuffer)
-		{
-			mSubscribers.erase(it);
-			return true;
-		}
-	}
-	return false;
+    auto iter = mSubscriberIndices.find(cbuffer.get());
+    if (iter == mSubscriberIndices.end())
+        return false;
+
+    // Move the last subscriber into the hole to keep the array dense.
+    unsigned int index = iter->second;
+    mSubscriberIndices.erase(iter);
+    if (index + 1 < mSubscribers.size())
+    {
+        mSubscribers[index] = mSubscribers.back();
+        mSubscriberIndices[mSubscribers[index].cbuffer.get()] = index;
+    }
+    mSubscribers.pop_back();
+    return true;
 }
 
 void PVWUpdater::UnsubscribeAll()
 {
     mSubscribers.clear();
+    mSubscriberIndices.clear();
+}
+
+bool PVWUpdater::Defer(eastl::shared_ptr<ConstantBuffer> const& cbuffer, bool deferred)
+{
+    auto iter = mSubscriberIndices.find(cbuffer.get());
+    if (iter == mSubscriberIndices.end())
+        return false;
+
+    mSubscribers[iter->second].deferred = deferred;
+    return true;
 }
 
-void PVWUpdater::Update()
+void PVWUpdater::Update(Culler* culler, eastl::vector<Spatial*> const* culledDrawn)
 {
+    // Gather the subscribers that will be drawn.  Those of culled spatial
+    // objects keep their previous pvw-matrix and are refreshed the first
+    // frame they become visible again, unless the object is drawn anyway.
+    mVisible.clear();
+    for (unsigned int i = 0; i < mSubscribers.size(); ++i)
+    {
+        if (mSubscribers[i].deferred)
+            continue;
+
+        Spatial* spatial = mSubscribers[i].spatial;
+        if (!culler || !spatial || culler->IsVisible(spatial) || (culledDrawn &&
+            eastl::find(culledDrawn->begin(), culledDrawn->end(), spatial) != culledDrawn->end()))
+        {
+            mVisible.push_back(i);
+        }
+    }
+
+    unsigned int const numVisible = (unsigned int)mVisible.size();
+    if (numVisible == 0)
+        return;
+    mChanged.resize(numVisible);
+
     // The function is called knowing that mCamera is not null.
     Matrix4x4<float> pvMatrix = mCamera->GetProjectionViewMatrix();
-    for (auto& element : mSubscribers)
+
+    // Each subscriber owns its constant buffer, so the matrix products are
+    // independent.  A job costs more than the products of a small scene,
+    // which is updated on the calling thread.
+    unsigned int const minPerJob = 1024;
+    JobSystem* jobSystem = JobSystem::Get();
+    if (jobSystem && numVisible >= 2 * minPerJob)
+    {
+        jobSystem->ParallelFor(numVisible, minPerJob,
+            [this, &pvMatrix](unsigned int begin, unsigned int end)
+        {
+            UpdateRange(pvMatrix, begin, end);
+        });
+    }
+    else
+    {
+        UpdateRange(pvMatrix, 0, numVisible);
+    }
+
+    // Allow the caller to update GPU memory as desired.  The uploads are
+    // issued from the calling thread, and only for the matrices that
+    // changed since the buffer was last written.
+    for (unsigned int i = 0; i < numVisible; ++i)
     {
-        // Compute the new projection-view-world matrix.  The matrix
-        // *element.first is the model-to-world matrix for the associated
-        // object.
+        if (mChanged[i])
+            mBufferUpdater(mSubscribers[mVisible[i]].cbuffer);
+    }
+}
+
+bool PVWUpdater::Update(eastl::shared_ptr<ConstantBuffer> const& cbuffer)
+{
+    auto iter = mSubscriberIndices.find(cbuffer.get());
+    if (iter == mSubscriberIndices.end())
+        return false;
+
+    // The function is called knowing that mCamera is not null.
+    Matrix4x4<float> pvMatrix = mCamera->GetProjectionViewMatrix();
+    if (UpdateSubscriber(pvMatrix, mSubscribers[iter->second]))
+        mBufferUpdater(cbuffer);
+    return true;
+}
+
+void PVWUpdater::UpdateRange(Matrix4x4<float> const& pvMatrix,
+    unsigned int begin, unsigned int end)
+{
+    for (unsigned int i = begin; i < end; ++i)
+        mChanged[i] = UpdateSubscriber(pvMatrix, mSubscribers[mVisible[i]]) ? 1 : 0;
+}
+
+bool PVWUpdater::UpdateSubscriber(Matrix4x4<float> const& pvMatrix,
+    PVWSubscriber const& subscriber)
+{
+    // Compute the new projection-view-world matrix.  The matrix
+    // *subscriber.worldMatrix is the model-to-world matrix for the
+    // associated object.  The float product runs on the SIMD kernels of
+    // Matrix.h when a backend is available.
 #if defined(GE_USE_MAT_VEC)
-        Matrix4x4<float> pvwMatrix = pvMatrix * (*element.first);
+    Matrix4x4<float> pvwMatrix = pvMatrix * (*subscriber.worldMatrix);
 #else
-        Matrix4x4<float> pvwMatrix = (*element.first) * pvMatrix;
+    Matrix4x4<float> pvwMatrix = (*subscriber.worldMatrix) * pvMatrix;
 #endif
-        // Copy the source matrix into the system memory of the constant
-        // buffer.
-        element.second.first->SetMember(element.second.second, pvwMatrix);
+    // Copy the matrix into the system memory of the constant buffer
+    // unless it is already there, as for static objects seen from a
+    // static camera.
+    Matrix4x4<float>* target = reinterpret_cast<Matrix4x4<float>*>(
+        subscriber.cbuffer->GetData() + subscriber.offset);
+    if (*target == pvwMatrix)
+        return false;
 
-        // Allow the caller to update GPU memory as desired.
-        mBufferUpdater(element.second.first);
-    }
+    *target = pvwMatrix;
+    return true;
 }
@@ -13,6 +13,9 @@
 #include "Graphic/Scene/Hierarchy/Camera.h"
 #include "Graphic/Resource/Buffer/ConstantBuffer.h"
 
+class Culler;
+class Spatial;
+
 class GRAPHIC_ITEM PVWUpdater
 {
 public:
@@ -31,35 +34,82 @@ public:
     // Update the constant buffer's projection-view-world matrix (pvw-matrix)
     // when the camera's view or projection matrices change.  The input
     // 'pvwMatrixName' is the name specified in the shader program and is
-    // used in calls to ConstantBuffer::SetMember<Matrix4x4<float>>(...).
+    // used to look up the offset of the member in the constant buffer.
     // If you modify the view or projection matrices directly through the
     // Camera interface, you are responsible for calling UpdatePVWMatrices().
     //
-    // The Subscribe function uses the address of 'worldMatrix' as a key
-    // to a std::map, so be careful to ensure that 'worldMatrix' persists
-    // until a call to an Unsubscribe function.  The return value of Subscribe
-    // is 'true' as long as 'cbuffer' is not already subscribed and actually
-    // has a member named 'pvwMatrixName'.  The return value of Unsubscribe is
-    // true if and only if the input matrix is currently subscribed.
+    // The Subscribe function stores the address of 'worldMatrix', so be
+    // careful to ensure that 'worldMatrix' persists until a call to an
+    // Unsubscribe function.  The subscription of a spatial object uses its
+    // world transform and lets Update skip the object when it is culled.
+    // The return value of Subscribe is 'true' as long as 'cbuffer' is not
+    // already subscribed and actually has a member named 'pvwMatrixName'.
+    // The return value of Unsubscribe is true if and only if the input
+    // buffer is currently subscribed.
     bool Subscribe(Matrix4x4<float> const& worldMatrix,
 		eastl::shared_ptr<ConstantBuffer> const& cbuffer,
 		eastl::string const& pvwMatrixName = "pvwMatrix");
+    bool Subscribe(Spatial* spatial,
+        eastl::shared_ptr<ConstantBuffer> const& cbuffer,
+        eastl::string const& pvwMatrixName = "pvwMatrix");
     bool Unsubscribe(eastl::shared_ptr<ConstantBuffer> const& cbuffer);
     void UnsubscribeAll();
 
+    // A deferred subscriber is skipped by Update(Culler*).  Its owner draws
+    // it with a pvw-matrix computed elsewhere, as the instance batcher does,
+    // or calls Update(cbuffer) right before drawing it.  The return value is
+    // true if and only if the input buffer is currently subscribed.
+    bool Defer(eastl::shared_ptr<ConstantBuffer> const& cbuffer, bool deferred = true);
+
     // After any camera modifictions that change the projection or view
     // matrices, call this function to update the constant buffers that
-    // are subscribed.
-    void Update();
+    // are subscribed.  When a culler is passed, the buffers of the spatial
+    // objects it has culled are not updated, except for the objects listed
+    // in 'culledDrawn' which are drawn without being culled.  The matrix
+    // products are split into jobs when there are enough subscribers.  Only
+    // the buffers whose pvw-matrix changed are passed to the buffer updater.
+    void Update(Culler* culler = nullptr, eastl::vector<Spatial*> const* culledDrawn = nullptr);
+
+    // Update the pvw-matrix of a single subscriber.  The return value is
+    // true if and only if the input buffer is currently subscribed.
+    bool Update(eastl::shared_ptr<ConstantBuffer> const& cbuffer);
 
 protected:
 	eastl::shared_ptr<Camera> mCamera;
     BufferUpdater mBufferUpdater;
 
-    typedef Matrix4x4<float> const* PVWKey;
-    typedef eastl::pair<eastl::shared_ptr<ConstantBuffer>, eastl::string> PVWValue;
-	typedef eastl::multimap<PVWKey, PVWValue>::iterator PVWIterator;
-	eastl::multimap<PVWKey, PVWValue> mSubscribers;
+    // The subscribers are stored in a dense array.  The offset of the
+    // pvw-matrix member is resolved once at subscription.
+    struct PVWSubscriber
+    {
+        Matrix4x4<float> const* worldMatrix;
+        Spatial* spatial;
+        eastl::shared_ptr<ConstantBuffer> cbuffer;
+        unsigned int offset;
+        bool deferred;
+    };
+
+    bool Subscribe(Matrix4x4<float> const& worldMatrix, Spatial* spatial,
+        eastl::shared_ptr<ConstantBuffer> const& cbuffer,
+        eastl::string const& pvwMatrixName);
+
+    // Compute the pvw-matrices of the visible subscribers in the range
+    // [begin, end) and flag the ones that changed.
+    void UpdateRange(Matrix4x4<float> const& pvMatrix,
+        unsigned int begin, unsigned int end);
+
+    // Compute the pvw-matrix of a subscriber.  The return value is true
+    // when it differs from the one in the constant buffer.
+    bool UpdateSubscriber(Matrix4x4<float> const& pvMatrix,
+        PVWSubscriber const& subscriber);
+
+    eastl::vector<PVWSubscriber> mSubscribers;
+    eastl::hash_map<ConstantBuffer const*, unsigned int> mSubscriberIndices;
+
+    // Per-frame scratch storage: the indices of the visible subscribers and
+    // whether their pvw-matrix changed.
+    eastl::vector<unsigned int> mVisible;
+    eastl::vector<unsigned char> mChanged;
 };
 
 
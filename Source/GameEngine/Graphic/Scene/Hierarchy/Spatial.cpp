@@ -9,8 +9,11 @@
 
 #include "Core/OS/OS.h"
 
+unsigned int Spatial::msHierarchyVersion = 0;
+
 Spatial::Spatial()
-    : mParent(nullptr), mCullMode(CULL_DYNAMIC)
+    : mParent(nullptr), mCullMode(CULL_DYNAMIC), mCullingIndex(-1),
+    mLocalTransformDirty(true), mWorldBoundDirty(true)
 {
 }
 
@@ -24,30 +27,20 @@ void Spatial::Update(bool initiator)
 {
     UpdateWorldData();
     UpdateWorldBound();
-    if (initiator)
+    if (initiator && mParent)
     {
-        PropagateBoundToRoot();
+        mParent->mWorldBoundDirty = true;
     }
 }
 
 void Spatial::OnGetVisibleSet(Culler& culler, 
 	eastl::shared_ptr<Camera> const& camera, bool noCull)
 {
-    if (mCullMode == CULL_ALWAYS)
-        return;
-
-    if (mCullMode == CULL_NEVER)
-        noCull = true;
-
-    unsigned int savePlaneState = culler.GetPlaneState();
-
-	if (noCull || culler.IsVisible(mWorldBound))
-	{
-		culler.Insert(this);
-		GetVisibleSet(culler, camera, noCull);
-	}
-
-    culler.SetPlaneState(savePlaneState);
+    // The culling mode and the world bound are read by the culler every
+    // frame, the hierarchy only has to be recorded when it changes.
+    culler.BeginSpatial(this);
+    GetVisibleSet(culler, camera, noCull);
+    culler.EndSpatial(this);
 }
 
 void Spatial::UpdateAbsoluteTransform()
@@ -89,4 +82,11 @@ Spatial* Spatial::GetParent()
 void Spatial::SetParent(Spatial* parent)
 {
 	mParent = parent;
+	mLocalTransformDirty = true;
+	++msHierarchyVersion;
+}
+
+unsigned int Spatial::GetHierarchyVersion()
+{
+	return msHierarchyVersion;
 }
\ No newline at end of file
@@ -26,7 +26,8 @@ public:
     // on the downward pass of the scene graph traversal and world bounding
     // volumes on the upward pass of the traversal.  The object that calls the
     // update is the initiator.  Other objects visited during the update are
-    // not initiators.
+    // not initiators.  The bounds of the ancestors of the initiator are not
+    // refitted here, they are marked and refitted once by the scene update.
     void Update(bool initiator = true);
 
     // Access to the parent object, which is null for the root of the
@@ -45,8 +46,17 @@ public:
 	/** The relative transformation is stored internally as 3
 	vectors: translation, rotation and scale. To get the relative
 	transformation matrix, it is calculated from these values.
-	\return The relative transformation matrix. */
-	Transform& GetRelativeTransform() { return mLocalTransform; }
+	\return The relative transformation matrix. The non-const access marks
+	the transformation as changed, read it through a const node otherwise. */
+	Transform& GetRelativeTransform() { mLocalTransformDirty = true; return mLocalTransform; }
+	const Transform& GetRelativeTransform() const { return mLocalTransform; }
+
+	//! Sets the relative transformation of the spatial node.
+	void SetRelativeTransform(const Transform& transform)
+	{
+		mLocalTransformDirty = true;
+		mLocalTransform = transform;
+	}
 
 	//! Returns the absolute transformation of the spatial node.
 	/** The absolute transformation is stored internally as 3
@@ -63,7 +73,13 @@ public:
 	//! Returns the absoulte bound of the spatial node
 	BoundingSphere& GetAbsoulteBound() { return mWorldBound; }
 
-    // Support for hierarchical culling.
+	//! Marks the world bound to be refitted by the next scene update. Needed
+	//! when the model bound of a visual changes, the transforms changes are
+	//! tracked by GetRelativeTransform.
+	void MarkBoundDirty() { mWorldBoundDirty = true; }
+
+    // Support for hierarchical culling.  The traversal records the object
+    // and its children in the culler, which culls the flattened hierarchy.
     void OnGetVisibleSet(
 		Culler& culler, eastl::shared_ptr<Camera> const& camera, bool noCull);
     virtual void GetVisibleSet(
@@ -73,6 +89,10 @@ public:
     // children.
     void SetParent(Spatial* parent);
 
+    // The version changes every time a parent is set, which tells the
+    // culler that the flattened hierarchy has to be rebuilt.
+    static unsigned int GetHierarchyVersion();
+
 protected:
     // Constructor accessible by Node, Visual, and Audial.
     Spatial();
@@ -104,6 +124,18 @@ private:
     // manager, it is not possible to use eastl::weak_ptr to avoid the cycle
     // because we do not know the shared_ptr object that owns mParent.
     Spatial* mParent;
+
+    // Position of the object in the flattened hierarchy of the culler.
+    friend class Culler;
+    int mCullingIndex;
+
+    // Dirty flags of the transform updater.  The local transform is dirty
+    // whenever it is accessed for writing or the parent changes.
+    friend class TransformUpdater;
+    bool mLocalTransformDirty;
+    bool mWorldBoundDirty;
+
+    static unsigned int msHierarchyVersion;
 };
 
 #endif
\ No newline at end of file
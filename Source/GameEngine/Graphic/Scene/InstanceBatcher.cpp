@@ -0,0 +1,253 @@
+#include "InstanceBatcher.h"
+
+#include "Graphic/Effect/Texture2ArrayEffect.h"
+#include "Graphic/Effect/Texture2Effect.h"
+#include "Graphic/Effect/Texture2MorphEffect.h"
+#include "Graphic/Renderer/Renderer.h"
+#include "Graphic/Scene/Element/CameraNode.h"
+#include "Graphic/Scene/Scene.h"
+
+InstanceBatcher::InstanceBatcher()
+	: mEnabled(true)
+{
+
+}
+
+bool InstanceBatcher::IsInstanceable(const eastl::shared_ptr<Visual>& visual)
+{
+	// only the texture effects have an instanced variant, the morph effect
+	// blends two frames which the instanced shaders don't have
+	return visual && (
+		eastl::dynamic_shared_pointer_cast<Texture2ArrayEffect>(visual->GetEffect()) ||
+		(eastl::dynamic_shared_pointer_cast<Texture2Effect>(visual->GetEffect()) &&
+		!eastl::dynamic_shared_pointer_cast<Texture2MorphEffect>(visual->GetEffect())));
+}
+
+bool InstanceBatcher::Add(void const* mesh, unsigned int visualIndex,
+	const eastl::shared_ptr<Material>& material, const eastl::shared_ptr<Visual>& visual,
+	const eastl::shared_ptr<BlendState>& blendState,
+	const eastl::shared_ptr<DepthStencilState>& depthStencilState,
+	const eastl::shared_ptr<RasterizerState>& rasterizerState,
+	const Matrix4x4<float>& worldMatrix, const Vector4<float>& color,
+	bool updateVertices)
+{
+	if (!mEnabled || !mesh || !IsInstanceable(visual))
+		return false;
+
+	BatchKey key;
+	key.mMesh = mesh;
+	key.mMaterial = material.get();
+	key.mVisualIndex = visualIndex;
+
+	auto itBatch = mBatchIndices.find(key);
+	if (itBatch == mBatchIndices.end())
+	{
+		itBatch = mBatchIndices.insert(eastl::make_pair(key, (unsigned int)mBatches.size())).first;
+
+		Batch batch;
+		batch.mBlendState = blendState;
+		batch.mDepthStencilState = depthStencilState;
+		batch.mRasterizerState = rasterizerState;
+		batch.mUpdateVertices = false;
+		mBatches.push_back(batch);
+	}
+
+	Batch& batch = mBatches[itBatch->second];
+	batch.mVisuals.push_back(visual);
+	batch.mWorldMatrices.push_back(worldMatrix);
+	batch.mColors.push_back(color);
+	batch.mUpdateVertices |= updateVertices;
+	return true;
+}
+
+void InstanceBatcher::Flush(Scene* pScene)
+{
+	if (mBatches.empty())
+		return;
+
+	if (!Renderer::Get() || !pScene->GetActiveCamera())
+	{
+		Clear();
+		return;
+	}
+
+	Matrix4x4<float> pvMatrix = pScene->GetActiveCamera()->Get()->GetProjectionViewMatrix();
+	unsigned int texture2ArraySlot = 0, texture2Slot = 0;
+	for (const Batch& batch : mBatches)
+	{
+		Renderer::Get()->SetBlendState(batch.mBlendState);
+		Renderer::Get()->SetDepthStencilState(batch.mDepthStencilState);
+		Renderer::Get()->SetRasterizerState(batch.mRasterizerState);
+
+		// the instances share the vertices of the first visual
+		if (batch.mUpdateVertices)
+			Renderer::Get()->Update(batch.mVisuals[0]->GetVertexBuffer());
+
+		// a lone instance keeps its own effect, and so does every instance
+		// of a group which couldn't be drawn instanced
+		bool instanced = false;
+		if (batch.mVisuals.size() > 1)
+		{
+			if (eastl::dynamic_shared_pointer_cast<Texture2ArrayEffect>(batch.mVisuals[0]->GetEffect()))
+				instanced = DrawTexture2ArrayBatch(batch, texture2ArraySlot++, pvMatrix);
+			else
+				instanced = DrawTexture2Batch(batch, texture2Slot++, pvMatrix);
+		}
+		if (!instanced)
+			DrawVisuals(batch, pvMatrix);
+
+		Renderer::Get()->SetDefaultBlendState();
+		Renderer::Get()->SetDefaultDepthStencilState();
+		Renderer::Get()->SetDefaultRasterizerState();
+	}
+
+	Clear();
+}
+
+void InstanceBatcher::DrawVisuals(const Batch& batch, const Matrix4x4<float>& pvMatrix)
+{
+	for (unsigned int i = 0; i < batch.mVisuals.size(); ++i)
+	{
+#if defined(GE_USE_MAT_VEC)
+		Matrix4x4<float> pvwMatrix = pvMatrix * batch.mWorldMatrices[i];
+#else
+		Matrix4x4<float> pvwMatrix = batch.mWorldMatrices[i] * pvMatrix;
+#endif
+		const eastl::shared_ptr<Visual>& visual = batch.mVisuals[i];
+		eastl::shared_ptr<Texture2ArrayEffect> textureArrayEffect =
+			eastl::dynamic_shared_pointer_cast<Texture2ArrayEffect>(visual->GetEffect());
+		if (textureArrayEffect)
+		{
+			textureArrayEffect->SetPVWMatrix(pvwMatrix);
+			Renderer::Get()->Update(textureArrayEffect->GetPVWMatrixConstant());
+		}
+		else
+		{
+			eastl::shared_ptr<Texture2Effect> textureEffect =
+				eastl::static_pointer_cast<Texture2Effect>(visual->GetEffect());
+			textureEffect->SetPVWMatrix(pvwMatrix);
+			Renderer::Get()->Update(textureEffect->GetPVWMatrixConstant());
+		}
+		Renderer::Get()->Draw(visual);
+	}
+}
+
+bool InstanceBatcher::DrawTexture2ArrayBatch(const Batch& batch, unsigned int slot, const Matrix4x4<float>& pvMatrix)
+{
+	eastl::shared_ptr<Texture2ArrayEffect> effect =
+		eastl::static_pointer_cast<Texture2ArrayEffect>(batch.mVisuals[0]->GetEffect());
+
+	if (slot >= mTexture2ArrayVisuals.size())
+		mTexture2ArrayVisuals.resize(slot + 1);
+
+	eastl::shared_ptr<Visual>& instancedVisual = mTexture2ArrayVisuals[slot];
+	if (!instancedVisual)
+	{
+		eastl::vector<eastl::string> path;
+#if defined(_OPENGL_)
+		path.push_back("Effects/Texture2ArrayInstancedEffectVS.glsl");
+		path.push_back("Effects/Texture2ArrayInstancedEffectPS.glsl");
+#else
+		path.push_back("Effects/Texture2ArrayInstancedEffectVS.hlsl");
+		path.push_back("Effects/Texture2ArrayInstancedEffectPS.hlsl");
+#endif
+		SamplerState const* sampler = effect->GetSampler().get();
+		eastl::shared_ptr<Texture2ArrayInstancedEffect> instancedEffect =
+			eastl::make_shared<Texture2ArrayInstancedEffect>(ProgramFactory::Get(), path,
+			effect->GetTextures(), sampler->mFilter, sampler->mMode[0], sampler->mMode[1]);
+		if (!instancedEffect->GetProgram())
+		{
+			LogError("Cannot create the instanced effect.");
+			return false;
+		}
+
+		instancedVisual = eastl::make_shared<Visual>(
+			batch.mVisuals[0]->GetVertexBuffer(), batch.mVisuals[0]->GetIndexBuffer(), instancedEffect);
+	}
+
+	eastl::shared_ptr<Texture2ArrayInstancedEffect> instancedEffect =
+		eastl::static_pointer_cast<Texture2ArrayInstancedEffect>(instancedVisual->GetEffect());
+	if (instancedEffect->GetTextures() != effect->GetTextures())
+		instancedEffect->SetTextures(effect->GetTextures());
+	if (instancedEffect->GetSampler() != effect->GetSampler())
+		instancedEffect->SetSampler(effect->GetSampler());
+
+	DrawInstances<Texture2ArrayInstancedEffect>(batch, instancedVisual, pvMatrix);
+	return true;
+}
+
+bool InstanceBatcher::DrawTexture2Batch(const Batch& batch, unsigned int slot, const Matrix4x4<float>& pvMatrix)
+{
+	eastl::shared_ptr<Texture2Effect> effect =
+		eastl::static_pointer_cast<Texture2Effect>(batch.mVisuals[0]->GetEffect());
+
+	if (slot >= mTexture2Visuals.size())
+		mTexture2Visuals.resize(slot + 1);
+
+	eastl::shared_ptr<Visual>& instancedVisual = mTexture2Visuals[slot];
+	if (!instancedVisual)
+	{
+		eastl::vector<eastl::string> path;
+#if defined(_OPENGL_)
+		path.push_back("Effects/Texture2InstancedEffectVS.glsl");
+		path.push_back("Effects/Texture2InstancedEffectPS.glsl");
+#else
+		path.push_back("Effects/Texture2InstancedEffectVS.hlsl");
+		path.push_back("Effects/Texture2InstancedEffectPS.hlsl");
+#endif
+		SamplerState const* sampler = effect->GetSampler().get();
+		eastl::shared_ptr<Texture2InstancedEffect> instancedEffect =
+			eastl::make_shared<Texture2InstancedEffect>(ProgramFactory::Get(), path,
+			effect->GetTexture(), sampler->mFilter, sampler->mMode[0], sampler->mMode[1]);
+		if (!instancedEffect->GetProgram())
+		{
+			LogError("Cannot create the instanced effect.");
+			return false;
+		}
+
+		instancedVisual = eastl::make_shared<Visual>(
+			batch.mVisuals[0]->GetVertexBuffer(), batch.mVisuals[0]->GetIndexBuffer(), instancedEffect);
+	}
+
+	eastl::shared_ptr<Texture2InstancedEffect> instancedEffect =
+		eastl::static_pointer_cast<Texture2InstancedEffect>(instancedVisual->GetEffect());
+	if (instancedEffect->GetTexture() != effect->GetTexture())
+		instancedEffect->SetTexture(effect->GetTexture());
+	if (instancedEffect->GetSampler() != effect->GetSampler())
+		instancedEffect->SetSampler(effect->GetSampler());
+
+	DrawInstances<Texture2InstancedEffect>(batch, instancedVisual, pvMatrix);
+	return true;
+}
+
+template <typename InstancedEffect>
+void InstanceBatcher::DrawInstances(const Batch& batch,
+	const eastl::shared_ptr<Visual>& instancedVisual, const Matrix4x4<float>& pvMatrix)
+{
+	instancedVisual->SetVertexBuffer(batch.mVisuals[0]->GetVertexBuffer());
+	instancedVisual->SetIndexBuffer(batch.mVisuals[0]->GetIndexBuffer());
+
+	eastl::shared_ptr<InstancedEffect> instancedEffect =
+		eastl::static_pointer_cast<InstancedEffect>(instancedVisual->GetEffect());
+	instancedEffect->SetPVMatrix(pvMatrix);
+	Renderer::Get()->Update(instancedEffect->GetPVMatrixConstant());
+
+	// groups larger than the instance buffer are drawn in chunks
+	unsigned int numInstances = (unsigned int)batch.mWorldMatrices.size();
+	for (unsigned int first = 0; first < numInstances; first += InstancedEffect::MAX_INSTANCES)
+	{
+		unsigned int count = eastl::min(numInstances - first,
+			(unsigned int)InstancedEffect::MAX_INSTANCES);
+		for (unsigned int i = 0; i < count; ++i)
+			instancedEffect->SetInstance(i, batch.mWorldMatrices[first + i], batch.mColors[first + i]);
+
+		Renderer::Get()->Update(instancedEffect->GetInstancesConstant());
+		Renderer::Get()->DrawInstanced(instancedVisual, count);
+	}
+}
+
+void InstanceBatcher::Clear()
+{
+	mBatchIndices.clear();
+	mBatches.clear();
+}
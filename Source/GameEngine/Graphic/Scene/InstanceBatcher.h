@@ -0,0 +1,113 @@
+#ifndef INSTANCEBATCHER_H
+#define INSTANCEBATCHER_H
+
+#include "GameEngineStd.h"
+
+#include "Graphic/Effect/Material.h"
+#include "Graphic/Effect/Texture2ArrayInstancedEffect.h"
+#include "Graphic/Effect/Texture2InstancedEffect.h"
+#include "Graphic/Scene/Hierarchy/Visual.h"
+#include "Graphic/State/BlendState.h"
+#include "Graphic/State/DepthStencilState.h"
+#include "Graphic/State/RasterizerState.h"
+
+class Scene;
+
+/*
+	Collects the solid visuals of a render pass which come from the same mesh
+	buffer and material, and draws each group with one instanced call instead
+	of one draw per node. The geometry and the states of the first queued
+	instance are used for the whole group, the world matrix and color of each
+	instance go to the instance buffer of a Texture2ArrayInstancedEffect or a
+	Texture2InstancedEffect, depending on the effect of the visual.
+
+	A group with a single instance is drawn with its own visual, so nothing
+	changes for meshes which are not repeated. The pvw-matrix of the queued
+	visuals is only needed then, so the batcher computes it itself and the
+	nodes leave it out of the pvw updater.
+*/
+class InstanceBatcher
+{
+public:
+
+	InstanceBatcher();
+
+	//! Enables or disables the batching. When disabled Add always fails.
+	void SetEnabled(bool enabled) { mEnabled = enabled; }
+	bool IsEnabled() const { return mEnabled; }
+
+	//! Returns true if the effect of the visual has an instanced variant.
+	static bool IsInstanceable(const eastl::shared_ptr<Visual>& visual);
+
+	//! Queues an instance of the visual number visualIndex of a mesh. Returns
+	//! false if the visual can't be instanced and the caller must draw it.
+	//! The vertices of the group are uploaded once before drawing it when
+	//! updateVertices is set, for meshes animated on the cpu.
+	bool Add(void const* mesh, unsigned int visualIndex,
+		const eastl::shared_ptr<Material>& material, const eastl::shared_ptr<Visual>& visual,
+		const eastl::shared_ptr<BlendState>& blendState,
+		const eastl::shared_ptr<DepthStencilState>& depthStencilState,
+		const eastl::shared_ptr<RasterizerState>& rasterizerState,
+		const Matrix4x4<float>& worldMatrix, const Vector4<float>& color,
+		bool updateVertices = false);
+
+	//! Draws the queued groups and empties the batcher.
+	void Flush(Scene* pScene);
+
+	//! Drops the queued groups without drawing them.
+	void Clear();
+
+private:
+
+	struct BatchKey
+	{
+		void const* mMesh;
+		void const* mMaterial;
+		unsigned int mVisualIndex;
+
+		bool operator<(const BatchKey& other) const
+		{
+			if (mMesh != other.mMesh)
+				return mMesh < other.mMesh;
+			if (mMaterial != other.mMaterial)
+				return mMaterial < other.mMaterial;
+			return mVisualIndex < other.mVisualIndex;
+		}
+	};
+
+	struct Batch
+	{
+		eastl::vector<eastl::shared_ptr<Visual>> mVisuals;
+		eastl::shared_ptr<BlendState> mBlendState;
+		eastl::shared_ptr<DepthStencilState> mDepthStencilState;
+		eastl::shared_ptr<RasterizerState> mRasterizerState;
+		eastl::vector<Matrix4x4<float>> mWorldMatrices;
+		eastl::vector<Vector4<float>> mColors;
+		bool mUpdateVertices;
+	};
+
+	//! Draws every visual of the batch with its own effect.
+	void DrawVisuals(const Batch& batch, const Matrix4x4<float>& pvMatrix);
+
+	//! Draws the batch with the instanced visual of its slot, which is
+	//! created the first time. Returns false if the effect can't be created.
+	bool DrawTexture2ArrayBatch(const Batch& batch, unsigned int slot, const Matrix4x4<float>& pvMatrix);
+	bool DrawTexture2Batch(const Batch& batch, unsigned int slot, const Matrix4x4<float>& pvMatrix);
+
+	//! Fills the instance buffer and draws the instances in chunks.
+	template <typename InstancedEffect>
+	void DrawInstances(const Batch& batch,
+		const eastl::shared_ptr<Visual>& instancedVisual, const Matrix4x4<float>& pvMatrix);
+
+	bool mEnabled;
+
+	eastl::map<BatchKey, unsigned int> mBatchIndices;
+	eastl::vector<Batch> mBatches;
+
+	//! instanced visuals reused by the batch in the same slot every frame,
+	//! the slots are counted separately for each effect
+	eastl::vector<eastl::shared_ptr<Visual>> mTexture2ArrayVisuals;
+	eastl::vector<eastl::shared_ptr<Visual>> mTexture2Visuals;
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "MorphUpdater.h"
+
+#include "Graphic/Scene/Element/AnimatedMeshNode.h"
+#include "Graphic/Scene/Element/Mesh/MeshMD3.h"
+
+#include "Core/Process/JobSystem.h"
+
+void MorphUpdater::Add(MD3Mesh* mesh)
+{
+	if (!mesh || !mesh->IsVerticesPending())
+		return;
+
+	if (eastl::find(mMeshes.begin(), mMeshes.end(), mesh) == mMeshes.end())
+		mMeshes.push_back(mesh);
+}
+
+void MorphUpdater::Add(AnimatedMeshNode* node)
+{
+	if (node)
+		mNodes.push_back(node);
+}
+
+void MorphUpdater::Update()
+{
+	unsigned int const numMeshes = (unsigned int)mMeshes.size();
+	if (numMeshes > 0)
+	{
+		unsigned int numVertices = 0;
+		for (MD3Mesh* mesh : mMeshes)
+			numVertices += mesh->GetVertexCount();
+
+		// Each mesh owns its vertices, so the meshes are built independently.
+		// The jobs get runs of meshes with about minPerJob vertices on average,
+		// and the job system balances the runs which are heavier.
+		unsigned int const minPerJob = 4096;
+		JobSystem* jobSystem = JobSystem::Get();
+		if (jobSystem && numMeshes > 1 && numVertices >= 2 * minPerJob)
+		{
+			unsigned int const grain = eastl::max(1u,
+				(unsigned int)((unsigned long long)numMeshes * minPerJob / numVertices));
+			jobSystem->ParallelFor(numMeshes, grain,
+				[this](unsigned int begin, unsigned int end)
+			{
+				UpdateRange(begin, end);
+			});
+		}
+		else
+		{
+			UpdateRange(0, numMeshes);
+		}
+		mMeshes.clear();
+	}
+
+	// the bounds are marked dirty up the hierarchy, which is not thread safe
+	for (AnimatedMeshNode* node : mNodes)
+		node->UpdateBound();
+	mNodes.clear();
+}
+
+void MorphUpdater::UpdateRange(unsigned int begin, unsigned int end)
+{
+	for (unsigned int i = begin; i < end; ++i)
+		mMeshes[i]->BuildVertices();
+}
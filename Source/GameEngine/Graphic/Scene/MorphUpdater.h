@@ -0,0 +1,40 @@
+#ifndef MORPHUPDATER_H
+#define MORPHUPDATER_H
+
+#include "GameEngineStd.h"
+
+class MD3Mesh;
+class AnimatedMeshNode;
+
+/*
+	Builds the interpolated vertices of the key frame animated meshes of a
+	frame together. The nodes queue their meshes while they select the frames
+	in PreRender, and the scene builds every queued mesh before the render
+	pass, splitting the meshes in jobs when the whole set has enough vertices
+	to pay for them. A mesh shared by several nodes is queued once. The nodes
+	queue themselves as well, their bounds are updated once the vertices are
+	built so the culler sees the frame which is drawn.
+*/
+class MorphUpdater
+{
+public:
+
+	//! Queues a mesh whose vertices are pending.
+	void Add(MD3Mesh* mesh);
+
+	//! Queues a node whose bound depends on the queued meshes.
+	void Add(AnimatedMeshNode* node);
+
+	//! Builds the vertices of the queued meshes, updates the bounds of the
+	//! queued nodes and empties the queues.
+	void Update();
+
+private:
+
+	void UpdateRange(unsigned int begin, unsigned int end);
+
+	eastl::vector<MD3Mesh*> mMeshes;
+	eastl::vector<AnimatedMeshNode*> mNodes;
+};
+
+#endif
@@ -0,0 +1,116 @@
+#include "RenderQueue.h"
+
+RenderQueue::RenderQueue()
+{
+
+}
+
+//! The bit pattern of a non negative float grows with its value, so the top
+//! bits after the sign keep the ordering with 16 bits of mantissa.
+unsigned int RenderQueue::QuantizeDepth(float depth)
+{
+	if (!(depth > 0.f))
+		return 0;
+
+	unsigned int bits;
+	memcpy(&bits, &depth, sizeof(bits));
+	return (bits >> 7) & 0xFFFFFF;
+}
+
+unsigned int RenderQueue::FoldPointer(void const* pointer, unsigned int bits)
+{
+	if (!pointer)
+		return 0;
+
+	uint64_t value = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(pointer));
+	return static_cast<unsigned int>((value * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+uint64_t RenderQueue::MakeStateKey(RenderPass pass,
+	void const* program, void const* texture, float depth)
+{
+	return (static_cast<uint64_t>(pass & 0xF) << 60) |
+		(static_cast<uint64_t>(FoldPointer(program, 16)) << 44) |
+		(static_cast<uint64_t>(FoldPointer(texture, 20)) << 24) |
+		static_cast<uint64_t>(QuantizeDepth(depth));
+}
+
+uint64_t RenderQueue::MakeDepthKey(RenderPass pass,
+	void const* program, void const* texture, float depth, bool backToFront)
+{
+	unsigned int depthBits = QuantizeDepth(depth);
+	if (backToFront)
+		depthBits = ~depthBits & 0xFFFFFF;
+
+	return (static_cast<uint64_t>(pass & 0xF) << 60) |
+		(static_cast<uint64_t>(depthBits) << 36) |
+		(static_cast<uint64_t>(FoldPointer(program, 16)) << 20) |
+		static_cast<uint64_t>(FoldPointer(texture, 20));
+}
+
+void RenderQueue::Clear()
+{
+	mEntries.clear();
+}
+
+void RenderQueue::Add(uint64_t key, Node* node)
+{
+	Entry entry;
+	entry.mKey = key;
+	entry.mNode = node;
+	mEntries.push_back(entry);
+}
+
+void RenderQueue::Sort()
+{
+	unsigned int const numEntries = (unsigned int)mEntries.size();
+	if (numEntries < 2)
+		return;
+
+	// below a thousand entries the eight passes cost more than comparing. The
+	// merge sort works in the buffer of the radix sort, which is kept from one
+	// frame to the next, eastl::stable_sort would allocate its own every time
+	mSorted.resize(numEntries);
+	if (numEntries < 1024)
+	{
+		eastl::merge_sort_buffer(mEntries.begin(), mEntries.end(), mSorted.data(),
+			[](Entry const& a, Entry const& b) { return a.mKey < b.mKey; });
+		return;
+	}
+
+	// the histograms of the eight bytes are built in a single pass
+	unsigned int histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+	for (Entry const& entry : mEntries)
+		for (unsigned int digit = 0; digit < 8; ++digit)
+			++histograms[digit][(entry.mKey >> (digit * 8)) & 0xFF];
+
+	Entry* source = mEntries.data();
+	Entry* target = mSorted.data();
+	for (unsigned int digit = 0; digit < 8; ++digit)
+	{
+		unsigned int* histogram = histograms[digit];
+
+		// skip the bytes which are the same for every key, as the pass and
+		// most of the depth exponent usually are
+		unsigned int const firstByte = (source[0].mKey >> (digit * 8)) & 0xFF;
+		if (histogram[firstByte] == numEntries)
+			continue;
+
+		unsigned int offset = 0;
+		for (unsigned int byte = 0; byte < 256; ++byte)
+		{
+			unsigned int count = histogram[byte];
+			histogram[byte] = offset;
+			offset += count;
+		}
+
+		for (unsigned int entry = 0; entry < numEntries; ++entry)
+			target[histogram[(source[entry].mKey >> (digit * 8)) & 0xFF]++] = source[entry];
+
+		eastl::swap(source, target);
+	}
+
+	if (source != mEntries.data())
+		mEntries.swap(mSorted);
+}
@@ -0,0 +1,62 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include "GameEngineStd.h"
+
+#include "Graphic/Scene/Hierarchy/Node.h"
+
+/*
+	Per-frame buffer of the nodes registered for a render pass, each one
+	tagged with a packed 64-bit sort key. Ordering the frame becomes a radix
+	sort of integers instead of a comparison sort which chases node pointers,
+	and nodes which share a shader program and a texture end up next to each
+	other so that the renderer state cache can skip their binds.
+
+	State keys (solid passes), from the most significant bit:
+		pass (4) | program (16) | texture (20) | depth (24)
+	Depth keys (lights and transparent passes):
+		pass (4) | depth (24) | program (16) | texture (20)
+
+	The depth is the squared distance from the camera. Program and texture
+	are folded pointers, a collision only merges two groups in the ordering.
+*/
+class RenderQueue
+{
+public:
+
+	struct Entry
+	{
+		uint64_t mKey;
+		Node* mNode;
+	};
+
+	RenderQueue();
+
+	//! Packs a key which groups by program and texture, nearest first.
+	static uint64_t MakeStateKey(RenderPass pass,
+		void const* program, void const* texture, float depth);
+
+	//! Packs a key ordered by depth, nearest first or farthest first.
+	static uint64_t MakeDepthKey(RenderPass pass,
+		void const* program, void const* texture, float depth, bool backToFront);
+
+	void Clear();
+	void Add(uint64_t key, Node* node);
+
+	//! Stable sort of the entries by key, least significant digit radix sort
+	//! for long lists and merge sort for short ones.
+	void Sort();
+
+	const eastl::vector<Entry>& GetEntries() const { return mEntries; }
+
+private:
+
+	static unsigned int FoldPointer(void const* pointer, unsigned int bits);
+	static unsigned int QuantizeDepth(float depth);
+
+	eastl::vector<Entry> mEntries;
+	// scratch space of the merge and radix sorts, kept between frames
+	eastl::vector<Entry> mSorted;
+};
+
+#endif
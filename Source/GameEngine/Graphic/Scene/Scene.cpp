@@ -111,7 +111,11 @@ bool Scene::OnUpdate(unsigned int timeMs, unsigned long elapsedTime)
 	if (!mRoot)
 		return true;
 
-	return mRoot->OnUpdate(this, timeMs, elapsedTime);
+	bool result = mRoot->OnUpdate(this, timeMs, elapsedTime);
+
+	// the animators have moved the nodes, now the world data follows
+	mTransformUpdater.Update(mRoot.get());
+	return result;
 }
 
 
@@ -124,7 +128,13 @@ bool Scene::OnRender()
 	{
 		if (mRoot->PreRender(this)==true)
 		{
-			mPVWUpdater.Update();
+			// the animated meshes have selected their frames in PreRender
+			mMorphUpdater.Update();
+
+			// the nodes have queued themselves with the visible set of the
+			// culler, so only their matrices need to be updated, and those
+			// of the nodes which were queued although culled
+			mPVWUpdater.Update(&mCuller, &mCulledRenderList);
 			mCuller.ComputeVisibleSet(mPVWUpdater.GetCamera(), mRoot);
 
 			if (mLightManager)
@@ -174,6 +184,11 @@ void Scene::AddToRenderQueue(RenderPass pass, const eastl::shared_ptr<Node>& nod
 		return;
 
 	mRenderList[pass].push_back(node.get());
+
+	// nodes which are always drawn, like the volume lights, don't check
+	// the culler before they queue themselves
+	if (IsCulled(node.get()))
+		mCulledRenderList.push_back(node.get());
 }
 
 
@@ -182,6 +197,7 @@ void Scene::ClearRenderList()
 {
 	for (int pass=0; pass < RP_LAST; pass++)
 		mRenderList[pass].clear();
+	mCulledRenderList.clear();
 }
 
 //! Adds a scene node to the deletion queue.
@@ -617,22 +633,27 @@ void Scene::SyncActorDelegate(BaseEventDataPtr pEventData)
 			pGameActor->GetComponent<TransformComponent>(TransformComponent::Name).lock());
 		if (pTransformComponent)
 			pTransformComponent->SetPosition(pCastEventData->GetTransform().GetTranslation());
-		pNode->GetRelativeTransform().SetRotation(pCastEventData->GetTransform().GetRotation());
-		pNode->GetRelativeTransform().SetTranslation(pCastEventData->GetTransform().GetTranslation());
+
+		// the node keeps its scale
+		const Node* node = pNode.get();
+		Transform transform = node->GetRelativeTransform();
+		transform.SetRotation(pCastEventData->GetTransform().GetRotation());
+		transform.SetTranslation(pCastEventData->GetTransform().GetTranslation());
 
 		eastl::shared_ptr<PhysicComponent> pPhysicComponent(
 			pGameActor->GetComponent<PhysicComponent>(PhysicComponent::Name).lock());
 		if (pPhysicComponent)
 		{
 			Vector4<float> actorPosOffset = HLift(pPhysicComponent->GetPositionOffset(), 0.f);
-			Vector3<float> actorTranslation = pNode->GetRelativeTransform().GetTranslation();
-			Matrix4x4<float> actorRotation = pNode->GetRelativeTransform().GetRotation();
+			Vector3<float> actorTranslation = transform.GetTranslation();
+			Matrix4x4<float> actorRotation = transform.GetRotation();
 #if defined(GE_USE_MAT_VEC)
 			actorTranslation -= HProject(actorRotation * actorPosOffset);
 #else
 			actorTranslation -= HProject(actorPosOffset * actorRotation);
 #endif
-			pNode->GetRelativeTransform().SetTranslation(actorTranslation);
+			transform.SetTranslation(actorTranslation);
 		}
+		pNode->SetRelativeTransform(transform);
 	}
 }
@@ -49,6 +49,11 @@
 #include "Graphic/Scene/Hierarchy/Node.h"
 #include "Graphic/Scene/Hierarchy/Light.h"
 
+#include "RenderQueue.h"
+#include "InstanceBatcher.h"
+#include "MorphUpdater.h"
+#include "TransformUpdater.h"
+
 // Forward declarations
 ////////////////////////////////////////////////////
 //
@@ -461,6 +466,18 @@ public:
 	SceneNodeRenderList& GetDeletionList() { return mDeletionList; }
 	SceneNodeRenderList& GetRenderList(unsigned int pass) { return mRenderList[pass]; }
 
+	//! Scratch queue used to sort the render lists by key.
+	RenderQueue& GetRenderQueue() { return mRenderQueue; }
+
+	//! Groups the repeated solid meshes of a pass into instanced draws.
+	InstanceBatcher& GetInstanceBatcher() { return mInstanceBatcher; }
+
+	//! Builds the vertices of the key frame animated meshes after PreRender.
+	MorphUpdater& GetMorphUpdater() { return mMorphUpdater; }
+
+	//! Updates the world transforms and bounds of the moved nodes after OnUpdate.
+	TransformUpdater& GetTransformUpdater() { return mTransformUpdater; }
+
 	//! Adds a scene node to the render queue.
 	void AddToRenderQueue(RenderPass renderPass, const eastl::shared_ptr<Node>& node);
 
@@ -491,6 +508,11 @@ protected:
 	//! scene node lists
 	SceneNodeRenderList mDeletionList;
 	SceneNodeRenderList mRenderList[RP_LAST];
+	eastl::vector<Spatial*> mCulledRenderList;
+	RenderQueue mRenderQueue;
+	InstanceBatcher mInstanceBatcher;
+	MorphUpdater mMorphUpdater;
+	TransformUpdater mTransformUpdater;
 
 	void RemoveAll();
 	void Clear();
@@ -0,0 +1,98 @@
+#include "TransformUpdater.h"
+
+#include "Graphic/Scene/Hierarchy/Node.h"
+
+TransformUpdater::TransformUpdater()
+	: mFlattenedRoot(nullptr), mFlattenedVersion(0), mFullUpdate(true),
+	mNumUpdatedTransforms(0), mNumUpdatedBounds(0)
+{
+
+}
+
+void TransformUpdater::Flatten(Node* root)
+{
+	mSpatials.clear();
+	mParents.clear();
+
+	// depth-first preorder, the order the scene was built in
+	eastl::vector<eastl::pair<Node*, int>> stack;
+	stack.push_back(eastl::make_pair(root, -1));
+	while (!stack.empty())
+	{
+		Node* node = stack.back().first;
+		int const parent = stack.back().second;
+		stack.pop_back();
+
+		int const index = (int)mSpatials.size();
+		mSpatials.push_back(node);
+		mParents.push_back(parent);
+
+		auto const& children = node->GetChildren();
+		for (auto child = children.rbegin(); child != children.rend(); ++child)
+		{
+			if (*child)
+				stack.push_back(eastl::make_pair(static_cast<Node*>(child->get()), index));
+		}
+	}
+	mFlags.resize(mSpatials.size());
+
+	mFlattenedRoot = root;
+	mFlattenedVersion = Spatial::GetHierarchyVersion();
+
+	// detached objects leave no trace in the flags, so everything is redone
+	mFullUpdate = true;
+}
+
+void TransformUpdater::Update(Node* root)
+{
+	mNumUpdatedTransforms = 0;
+	mNumUpdatedBounds = 0;
+	if (!root)
+		return;
+
+	if (root != mFlattenedRoot || Spatial::GetHierarchyVersion() != mFlattenedVersion)
+		Flatten(root);
+
+	unsigned int const numSpatials = (unsigned int)mSpatials.size();
+
+	// Downward pass, the parents are updated before their children.
+	for (unsigned int i = 0; i < numSpatials; ++i)
+	{
+		Spatial* spatial = mSpatials[i];
+		int const parent = mParents[i];
+
+		unsigned char flags = 0;
+		if (mFullUpdate || spatial->mLocalTransformDirty ||
+			(parent >= 0 && (mFlags[parent] & WORLD_TRANSFORM_CHANGED)))
+		{
+			spatial->UpdateAbsoluteTransform();
+			spatial->mLocalTransformDirty = false;
+			flags = WORLD_TRANSFORM_CHANGED | WORLD_BOUND_DIRTY;
+			++mNumUpdatedTransforms;
+		}
+
+		if (spatial->mWorldBoundDirty)
+		{
+			spatial->mWorldBoundDirty = false;
+			flags |= WORLD_BOUND_DIRTY;
+		}
+		mFlags[i] = flags;
+	}
+
+	// Upward pass, the children are refitted before their parents and each
+	// refitted object marks its parent once.
+	for (unsigned int i = numSpatials; i-- > 0;)
+	{
+		if (mFlags[i] & WORLD_BOUND_DIRTY)
+		{
+			mSpatials[i]->UpdateWorldBound();
+			++mNumUpdatedBounds;
+
+			int const parent = mParents[i];
+			if (parent >= 0)
+				mFlags[parent] |= WORLD_BOUND_DIRTY;
+		}
+	}
+
+	mFullUpdate = false;
+}
@@ -0,0 +1,59 @@
+#ifndef TRANSFORMUPDATER_H
+#define TRANSFORMUPDATER_H
+
+#include "GameEngineStd.h"
+
+class Node;
+class Spatial;
+
+/*
+	Updates the world transforms and the world bounds of the scene once per
+	frame. The hierarchy is flattened in depth-first preorder, so a parent is
+	always stored before its children and the world transforms are computed
+	in one linear pass. A subtree stays together in the array, as it usually
+	is in memory when a scene is built. Only the objects whose local
+	transform changed, and their descendants, are recomputed. The bounds are
+	refitted in a second pass over the array in reverse order, and a parent
+	is refitted once after all of its changed children, however many of them
+	moved.
+
+	The flattened hierarchy is rebuilt, and fully updated, whenever a child
+	is attached or detached anywhere in the scene.
+*/
+class TransformUpdater
+{
+public:
+
+	TransformUpdater();
+
+	//! Updates the hierarchy under the root.
+	void Update(Node* root);
+
+	//! Statistics of the last update.
+	unsigned int GetNumSpatials() const { return (unsigned int)mSpatials.size(); }
+	unsigned int GetNumUpdatedTransforms() const { return mNumUpdatedTransforms; }
+	unsigned int GetNumUpdatedBounds() const { return mNumUpdatedBounds; }
+
+private:
+
+	enum
+	{
+		WORLD_TRANSFORM_CHANGED = 1,
+		WORLD_BOUND_DIRTY = 2
+	};
+
+	void Flatten(Node* root);
+
+	eastl::vector<Spatial*> mSpatials;
+	eastl::vector<int> mParents;
+	eastl::vector<unsigned char> mFlags;
+
+	Node* mFlattenedRoot;
+	unsigned int mFlattenedVersion;
+	bool mFullUpdate;
+
+	unsigned int mNumUpdatedTransforms;
+	unsigned int mNumUpdatedBounds;
+};
+
+#endif
@@ -8,13 +8,17 @@
 #include "Graphic/Scene/Hierarchy/Camera.h"
 #include "Graphic/Scene/Hierarchy/Spatial.h"
 
+#include "Mathematic/Algebra/SIMD.h"
+
 Culler::~Culler()
 {
 }
 
 Culler::Culler()
     :
-    mPlaneQuantity(6)
+    mPlaneQuantity(6),
+    mFlattenedRoot(nullptr),
+    mFlattenedVersion(0)
 {
     // The data members mFrustum, mPlane, and mPlaneState are
     // uninitialized.  They are initialized in the GetVisibleSet call.
@@ -52,7 +56,25 @@ void Culler::ComputeVisibleSet(
     {
         PushViewFrustumPlanes(camera);
         mVisibleSet.clear();
-		root->OnGetVisibleSet(*this, camera, false);
+
+        if (mFlattenedRoot != root.get() || 
+            mFlattenedVersion != Spatial::GetHierarchyVersion() || mSpatials.empty())
+        {
+            mSpatials.clear();
+            mParents.clear();
+            mSubtreeEnds.clear();
+            mSpatialStack.clear();
+            root->OnGetVisibleSet(*this, camera, false);
+
+            mFlattenedRoot = root.get();
+            mFlattenedVersion = Spatial::GetHierarchyVersion();
+
+            size_t const numSpatials = mSpatials.size();
+            mPlaneStates.resize(numSpatials);
+            mFlags.resize(numSpatials);
+        }
+
+        CullHierarchy();
     }
     else
     {
@@ -101,7 +123,162 @@ bool Culler::IsVisible(BoundingSphere const& sphere)
 
 bool Culler::IsVisible(Spatial* spatial)
 {
-	return eastl::find(mVisibleSet.begin(), mVisibleSet.end(), spatial) != mVisibleSet.end();
+	int const index = spatial->mCullingIndex;
+	return index >= 0 && index < static_cast<int>(mSpatials.size()) &&
+		mSpatials[index] == spatial && (mFlags[index] & SPATIAL_VISIBLE) != 0;
+}
+
+void Culler::BeginSpatial(Spatial* spatial)
+{
+    int const index = static_cast<int>(mSpatials.size());
+    spatial->mCullingIndex = index;
+
+    mSpatials.push_back(spatial);
+    mParents.push_back(mSpatialStack.empty() ? -1 : mSpatialStack.back());
+    mSubtreeEnds.push_back(index + 1);
+    mSpatialStack.push_back(index);
+}
+
+void Culler::EndSpatial(Spatial* spatial)
+{
+    mSubtreeEnds[spatial->mCullingIndex] = static_cast<int>(mSpatials.size());
+    mSpatialStack.pop_back();
+}
+
+void Culler::CullHierarchy()
+{
+    // The objects skipped with a culled ancestor are not visible either.
+    int const numSpatials = static_cast<int>(mSpatials.size());
+    eastl::fill(mFlags.begin(), mFlags.end(), (unsigned char)0);
+
+    for (int i = 0; i < mPlaneQuantity; ++i)
+    {
+        Vector4<float> normal;
+        mPlane[i].Get(normal, mPlaneConstant[i]);
+        mPlaneNormalX[i] = normal[0];
+        mPlaneNormalY[i] = normal[1];
+        mPlaneNormalZ[i] = normal[2];
+    }
+
+#if defined(MATH_SSE)
+    // The planes are tested in groups of four.  The unused planes of the
+    // last group are zero and their bits are never active.
+    for (int i = mPlaneQuantity; i < MAX_PLANE_QUANTITY && (i & 3) != 0; ++i)
+    {
+        mPlaneNormalX[i] = 0.0f;
+        mPlaneNormalY[i] = 0.0f;
+        mPlaneNormalZ[i] = 0.0f;
+        mPlaneConstant[i] = 0.0f;
+    }
+    unsigned int const planeMask = mPlaneQuantity < 32 ?
+        (1u << mPlaneQuantity) - 1u : 0xFFFFFFFFu;
+#endif
+
+    int i = 0;
+    while (i < numSpatials)
+    {
+        CullingMode const cullMode = mSpatials[i]->GetCullingMode();
+        if (cullMode == CULL_ALWAYS)
+        {
+            i = mSubtreeEnds[i];
+            continue;
+        }
+
+        // The children start from the plane state of their parent.
+        int const parent = mParents[i];
+        unsigned int planeState = parent >= 0 ? mPlaneStates[parent] : 0xFFFFFFFFu;
+        bool const noCull = cullMode == CULL_NEVER ||
+            (parent >= 0 && (mFlags[parent] & SPATIAL_NO_CULL) != 0);
+
+        bool visible = true;
+        if (!noCull)
+        {
+            // The bound is read only for the objects which are reached, the
+            // descendants of a culled object are never touched.
+            BoundingSphere const& sphere = mSpatials[i]->GetAbsoulteBound();
+            Vector4<float> const center = sphere.GetCenter();
+            float const radius = sphere.GetRadius();
+            if (radius == 0.0f)
+            {
+                // The node is a dummy node and cannot be visible.
+                visible = false;
+            }
+
+#if defined(MATH_SSE)
+            // The signed distances to four planes at once.  The sums are
+            // added in the same order as the scalar test below, so both
+            // paths cull the same objects.
+            __m128 const centerX = _mm_set1_ps(center[0]);
+            __m128 const centerY = _mm_set1_ps(center[1]);
+            __m128 const centerZ = _mm_set1_ps(center[2]);
+            __m128 const positiveRadius = _mm_set1_ps(radius);
+            __m128 const negativeRadius = _mm_set1_ps(-radius);
+            unsigned int const activePlanes = planeState & planeMask;
+            for (int first = 0; first < mPlaneQuantity && visible; first += 4)
+            {
+                int const groupState = (int)((activePlanes >> first) & 0xFu);
+                if (groupState == 0)
+                    continue;
+
+                __m128 const signedDistance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(_mm_loadu_ps(mPlaneNormalX + first), centerX),
+                    _mm_mul_ps(_mm_loadu_ps(mPlaneNormalY + first), centerY)),
+                    _mm_mul_ps(_mm_loadu_ps(mPlaneNormalZ + first), centerZ)),
+                    _mm_loadu_ps(mPlaneConstant + first));
+
+                // On the negative side of an active plane the object is
+                // culled.  On the positive side the plane is inactive for
+                // the subobjects.
+                if (_mm_movemask_ps(_mm_cmple_ps(signedDistance, negativeRadius)) & groupState)
+                    visible = false;
+                else
+                    planeState &= ~((unsigned int)(_mm_movemask_ps(
+                        _mm_cmpge_ps(signedDistance, positiveRadius)) & groupState) << first);
+            }
+#else
+            // Start with the last pushed plane, which is potentially the
+            // most restrictive plane.
+            int index = mPlaneQuantity - 1;
+            unsigned int mask = (1u << index);
+            for (int p = 0; p < mPlaneQuantity && visible; ++p, --index, mask >>= 1)
+            {
+                if (planeState & mask)
+                {
+                    float const signedDistance = 
+                        mPlaneNormalX[index] * center[0] + 
+                        mPlaneNormalY[index] * center[1] +
+                        mPlaneNormalZ[index] * center[2] + mPlaneConstant[index];
+
+                    if (signedDistance <= -radius)
+                    {
+                        // The object is on the negative side of the plane,
+                        // so cull it.
+                        visible = false;
+                    }
+                    else if (signedDistance >= radius)
+                    {
+                        // The object is on the positive side of plane.
+                        // There is no need to compare subobjects against
+                        // this plane, so mark it as inactive.
+                        planeState &= ~mask;
+                    }
+                }
+            }
+#endif
+        }
+
+        if (visible)
+        {
+            mPlaneStates[i] = planeState;
+            mFlags[i] = SPATIAL_VISIBLE | (noCull ? SPATIAL_NO_CULL : 0);
+            Insert(mSpatials[i]);
+            ++i;
+        }
+        else
+        {
+            i = mSubtreeEnds[i];
+        }
+    }
 }
 
 void Culler::Insert(Spatial* spatial)
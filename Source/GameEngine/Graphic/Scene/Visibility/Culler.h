@@ -69,7 +69,8 @@ public:
     // Access to the potentially visible set.
     inline VisibleSet& GetVisibleSet();
 
-	// Find the spatial object in the visible set
+	// Find the spatial object in the visible set.  The flattened hierarchy
+	// keeps a visibility flag for each object, so this is a direct lookup.
 	bool IsVisible(Spatial* spatial);
 
 protected:
@@ -100,6 +101,17 @@ protected:
 
     void PushViewFrustumPlanes(eastl::shared_ptr<Camera> const& camera);
 
+    // The scene graph is flattened in depth-first order the first time it
+    // is culled and again whenever a child is attached or detached anywhere
+    // in the hierarchy.  Spatial::OnGetVisibleSet records each object with
+    // these functions while the scene graph is traversed.
+    void BeginSpatial(Spatial* spatial);
+    void EndSpatial(Spatial* spatial);
+
+    // Cull the flattened hierarchy.  The objects are tested in order and a
+    // culled object skips the range of its descendants.
+    void CullHierarchy();
+
     // The world culling planes corresponding to the view frustum plus any
     // additional user-defined culling planes.  The member mPlaneState
     // represents bit flags to store whether or not a plane is active in the
@@ -116,6 +128,32 @@ protected:
 
     // The potentially visible set generated by ComputeVisibleSet(scene).
     VisibleSet mVisibleSet;
+
+    // The flattened hierarchy stored as a structure of arrays.  For each
+    // object it keeps the index of its parent, the index past its last
+    // descendant, the plane state after testing the object (the initial
+    // state of its children) and the flags.
+    enum
+    {
+        SPATIAL_VISIBLE = 1,
+        SPATIAL_NO_CULL = 2
+    };
+
+    eastl::vector<Spatial*> mSpatials;
+    eastl::vector<int> mParents;
+    eastl::vector<int> mSubtreeEnds;
+    eastl::vector<unsigned int> mPlaneStates;
+    eastl::vector<unsigned char> mFlags;
+    eastl::vector<int> mSpatialStack;
+
+    Spatial* mFlattenedRoot;
+    unsigned int mFlattenedVersion;
+
+    // The active culling planes as a structure of arrays.
+    float mPlaneNormalX[MAX_PLANE_QUANTITY];
+    float mPlaneNormalY[MAX_PLANE_QUANTITY];
+    float mPlaneNormalZ[MAX_PLANE_QUANTITY];
+    float mPlaneConstant[MAX_PLANE_QUANTITY];
 };
 
 
@@ -978,4 +978,70 @@ Matrix<NumRows - 1, NumCols - 1, Real> HProject(Matrix<NumRows, NumCols, Real> c
 }
 
 
+#if defined(MATH_SSE)
+
+// Float 4x4 matrices.  See SIMD.h, the results are the same bits as the
+// generic loops.
+template <> inline
+void Matrix<4, 4, float>::Transformation(
+	Vector<4, float> const& in, Vector<4, float>& out) const
+{
+	SIMD::MultiplyVM(reinterpret_cast<float const*>(&in), mTable,
+		reinterpret_cast<float*>(&out));
+}
+
+template <> inline
+Matrix<4, 4, float> Transpose(Matrix<4, 4, float> const& M)
+{
+	Matrix<4, 4, float> result;
+	SIMD::Transpose(reinterpret_cast<float const*>(&M),
+		reinterpret_cast<float*>(&result));
+	return result;
+}
+
+template <> inline
+Vector<4, float> operator*(Matrix<4, 4, float> const& M,
+	Vector<4, float> const& V)
+{
+	Vector<4, float> result;
+	SIMD::MultiplyMV(reinterpret_cast<float const*>(&M),
+		reinterpret_cast<float const*>(&V),
+		reinterpret_cast<float*>(&result));
+	return result;
+}
+
+template <> inline
+Vector<4, float> operator*(Vector<4, float> const& V,
+	Matrix<4, 4, float> const& M)
+{
+	Vector<4, float> result;
+	SIMD::MultiplyVM(reinterpret_cast<float const*>(&V),
+		reinterpret_cast<float const*>(&M),
+		reinterpret_cast<float*>(&result));
+	return result;
+}
+
+template <> inline
+Matrix<4, 4, float> operator*(Matrix<4, 4, float> const& A,
+	Matrix<4, 4, float> const& B)
+{
+	Matrix<4, 4, float> result;
+	SIMD::MultiplyMM(reinterpret_cast<float const*>(&A),
+		reinterpret_cast<float const*>(&B), reinterpret_cast<float*>(&result));
+	return result;
+}
+
+// The generic MultiplyAB adds A(i,c)*B(r,i), which is the product B*A.
+template <> inline
+Matrix<4, 4, float> MultiplyAB(Matrix<4, 4, float> const& A,
+	Matrix<4, 4, float> const& B)
+{
+	Matrix<4, 4, float> result;
+	SIMD::MultiplyMM(reinterpret_cast<float const*>(&B),
+		reinterpret_cast<float const*>(&A), reinterpret_cast<float*>(&result));
+	return result;
+}
+
+#endif
+
 #endif
\ No newline at end of file
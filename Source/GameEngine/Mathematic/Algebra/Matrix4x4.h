@@ -355,4 +355,23 @@ Matrix4x4<Real> MakeReflection(Vector4<Real> const& origin, Vector4<Real> const&
 }
 
 
+#if defined(MATH_SSE)
+
+// The float inverse works on 2x2 blocks, see SIMD.h.
+template <> inline
+Matrix4x4<float> Inverse<float>(Matrix4x4<float> const& M, bool* reportInvertibility)
+{
+    Matrix4x4<float> inverse;
+    bool invertible = SIMD::Inverse(reinterpret_cast<float const*>(&M),
+        reinterpret_cast<float*>(&inverse));
+
+    if (reportInvertibility)
+    {
+        *reportInvertibility = invertible;
+    }
+    return inverse;
+}
+
+#endif
+
 #endif
\ No newline at end of file
@@ -305,4 +305,44 @@ Quaternion<Real> SlerpRP(Real t, Quaternion<Real> const& q0,
     return q0 * f0 + q1 * f1;
 }
 
+#if defined(MATH_SSE)
+
+template <> inline
+Quaternion<float> operator*(Quaternion<float> const& q0,
+    Quaternion<float> const& q1)
+{
+    Quaternion<float> result;
+    SIMD::MultiplyQQ(reinterpret_cast<float const*>(&q0),
+        reinterpret_cast<float const*>(&q1), reinterpret_cast<float*>(&result));
+    return result;
+}
+
+template <> inline
+Quaternion<float> Slerp(float t, Quaternion<float> const& q0,
+    Quaternion<float> const& q1)
+{
+    float cosA = Dot(q0, q1);
+    float sign;
+    if (cosA >= 0.0f)
+    {
+        sign = 1.0f;
+    }
+    else
+    {
+        cosA = -cosA;
+        sign = -1.0f;
+    }
+
+    float f0, f1;
+    ChebyshevRatio<float>::Get(t, cosA, f0, f1);
+
+    Quaternion<float> result;
+    SIMD::Combine(reinterpret_cast<float const*>(&q0), f0,
+        reinterpret_cast<float const*>(&q1), sign * f1,
+        reinterpret_cast<float*>(&result));
+    return result;
+}
+
+#endif
+
 #endif
\ No newline at end of file
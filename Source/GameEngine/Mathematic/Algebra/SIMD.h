@@ -0,0 +1,314 @@
+// Geometric Tools, LLC
+// Copyright (c) 1998-2014
+// Distributed under the Boost Software License, Version 1.0.
+// http://www.boost.org/LICENSE_1_0.txt
+// http://www.geometrictools.com/License/Boost/LICENSE_1_0.txt
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#include "Mathematic/MathematicStd.h"
+
+// Kernels for the float 4-tuples and 4x4 matrices.  Vector.h, Matrix.h,
+// Matrix4x4.h and Quaternion.h specialize their float templates on top of
+// them when a backend is available, the generic templates stay as the
+// fallback otherwise.  Define MATH_NO_SIMD to force the fallback.
+//
+// The kernels add the products in the same order as the loops of the
+// generic templates and never contract a multiply and an add, so the vector
+// and matrix products, Transpose and the quaternion product return the same
+// bits as the fallback, save for the sign of a sum which is exactly zero.
+// Only Inverse differs: it uses 2x2 blocks instead of the cofactor
+// expansion, which agrees with the fallback to rounding.
+//
+// The matrices are stored row major (GE_USE_ROW_MAJOR), 16 floats which do
+// not need to be aligned.  A NEON backend slots in as MATH_NEON with the same
+// kernels over float32x4_t.
+#if !defined(MATH_NO_SIMD)
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MATH_SSE
+#if defined(__AVX__)
+#include <immintrin.h>
+#define MATH_AVX
+#endif
+#endif
+#endif
+
+#if defined(MATH_SSE)
+
+class SIMD
+{
+public:
+    // r = a + b, r = a - b, r = a * b (componentwise) for 4-tuples.
+    inline static void Add(float const* a, float const* b, float* r);
+    inline static void Subtract(float const* a, float const* b, float* r);
+    inline static void Multiply(float const* a, float const* b, float* r);
+
+    // r = a * s.
+    inline static void Scale(float const* a, float s, float* r);
+
+    // r = a * sa + b * sb, the blend of Slerp.
+    inline static void Combine(float const* a, float sa, float const* b,
+        float sb, float* r);
+
+    // r = a * b for 4x4 matrices.
+    inline static void MultiplyMM(float const* a, float const* b, float* r);
+
+    // r = m * v and r = v * m.
+    inline static void MultiplyMV(float const* m, float const* v, float* r);
+    inline static void MultiplyVM(float const* v, float const* m, float* r);
+
+    // r = Transpose(m).
+    inline static void Transpose(float const* m, float* r);
+
+    // r = Inverse(m).  The return value is 'false' and r is the zero matrix
+    // when m is not invertible.
+    inline static bool Inverse(float const* m, float* r);
+
+    // r = q0 * q1 for quaternions (x,y,z,w).
+    inline static void MultiplyQQ(float const* q0, float const* q1, float* r);
+
+private:
+    inline static __m128 Splat(__m128 v, int i);
+    inline static __m128 Mat2Mul(__m128 a, __m128 b);
+    inline static __m128 Mat2AdjMul(__m128 a, __m128 b);
+    inline static __m128 Mat2MulAdj(__m128 a, __m128 b);
+};
+
+
+inline void SIMD::Add(float const* a, float const* b, float* r)
+{
+    _mm_storeu_ps(r, _mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+}
+
+inline void SIMD::Subtract(float const* a, float const* b, float* r)
+{
+    _mm_storeu_ps(r, _mm_sub_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+}
+
+inline void SIMD::Multiply(float const* a, float const* b, float* r)
+{
+    _mm_storeu_ps(r, _mm_mul_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)));
+}
+
+inline void SIMD::Scale(float const* a, float s, float* r)
+{
+    _mm_storeu_ps(r, _mm_mul_ps(_mm_loadu_ps(a), _mm_set1_ps(s)));
+}
+
+inline void SIMD::Combine(float const* a, float sa, float const* b,
+    float sb, float* r)
+{
+    _mm_storeu_ps(r, _mm_add_ps(
+        _mm_mul_ps(_mm_loadu_ps(a), _mm_set1_ps(sa)),
+        _mm_mul_ps(_mm_loadu_ps(b), _mm_set1_ps(sb))));
+}
+
+inline __m128 SIMD::Splat(__m128 v, int i)
+{
+    switch (i)
+    {
+    case 0: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0));
+    case 1: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1));
+    case 2: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2));
+    default: return _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+}
+
+inline void SIMD::MultiplyMM(float const* a, float const* b, float* r)
+{
+    // Row r of the product is sum_i a(r,i) * row i of b, added in the order
+    // of the generic loop.
+#if defined(MATH_AVX)
+    __m256 b0 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(b + 0));
+    __m256 b1 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(b + 4));
+    __m256 b2 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(b + 8));
+    __m256 b3 = _mm256_broadcast_ps(reinterpret_cast<__m128 const*>(b + 12));
+    for (int row = 0; row < 4; row += 2)
+    {
+        __m256 rows = _mm256_loadu_ps(a + row * 4);
+        __m256 sum = _mm256_mul_ps(
+            _mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(
+            _mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(
+            _mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(
+            _mm256_shuffle_ps(rows, rows, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+        _mm256_storeu_ps(r + row * 4, sum);
+    }
+#else
+    __m128 b0 = _mm_loadu_ps(b + 0);
+    __m128 b1 = _mm_loadu_ps(b + 4);
+    __m128 b2 = _mm_loadu_ps(b + 8);
+    __m128 b3 = _mm_loadu_ps(b + 12);
+    for (int row = 0; row < 4; ++row)
+    {
+        __m128 ar = _mm_loadu_ps(a + row * 4);
+        __m128 sum = _mm_mul_ps(Splat(ar, 0), b0);
+        sum = _mm_add_ps(sum, _mm_mul_ps(Splat(ar, 1), b1));
+        sum = _mm_add_ps(sum, _mm_mul_ps(Splat(ar, 2), b2));
+        sum = _mm_add_ps(sum, _mm_mul_ps(Splat(ar, 3), b3));
+        _mm_storeu_ps(r + row * 4, sum);
+    }
+#endif
+}
+
+inline void SIMD::MultiplyMV(float const* m, float const* v, float* r)
+{
+    // The columns of m scaled by v, which adds the products of each row in
+    // the order of the generic loop without a horizontal sum.
+    __m128 c0 = _mm_loadu_ps(m + 0);
+    __m128 c1 = _mm_loadu_ps(m + 4);
+    __m128 c2 = _mm_loadu_ps(m + 8);
+    __m128 c3 = _mm_loadu_ps(m + 12);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    __m128 vec = _mm_loadu_ps(v);
+    __m128 sum = _mm_mul_ps(c0, Splat(vec, 0));
+    sum = _mm_add_ps(sum, _mm_mul_ps(c1, Splat(vec, 1)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(c2, Splat(vec, 2)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(c3, Splat(vec, 3)));
+    _mm_storeu_ps(r, sum);
+}
+
+inline void SIMD::MultiplyVM(float const* v, float const* m, float* r)
+{
+    __m128 vec = _mm_loadu_ps(v);
+    __m128 sum = _mm_mul_ps(Splat(vec, 0), _mm_loadu_ps(m + 0));
+    sum = _mm_add_ps(sum, _mm_mul_ps(Splat(vec, 1), _mm_loadu_ps(m + 4)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(Splat(vec, 2), _mm_loadu_ps(m + 8)));
+    sum = _mm_add_ps(sum, _mm_mul_ps(Splat(vec, 3), _mm_loadu_ps(m + 12)));
+    _mm_storeu_ps(r, sum);
+}
+
+inline void SIMD::Transpose(float const* m, float* r)
+{
+    __m128 r0 = _mm_loadu_ps(m + 0);
+    __m128 r1 = _mm_loadu_ps(m + 4);
+    __m128 r2 = _mm_loadu_ps(m + 8);
+    __m128 r3 = _mm_loadu_ps(m + 12);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(r + 0, r0);
+    _mm_storeu_ps(r + 4, r1);
+    _mm_storeu_ps(r + 8, r2);
+    _mm_storeu_ps(r + 12, r3);
+}
+
+// The 2x2 blocks are stored in one register as (m00,m01,m10,m11).  With A#
+// the adjugate of A:  Mat2Mul = A*B, Mat2AdjMul = A#*B, Mat2MulAdj = A*B#.
+inline __m128 SIMD::Mat2Mul(__m128 a, __m128 b)
+{
+    return _mm_add_ps(
+        _mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+            _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+inline __m128 SIMD::Mat2AdjMul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)),
+            _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+inline __m128 SIMD::Mat2MulAdj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(
+        _mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+            _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+inline bool SIMD::Inverse(float const* m, float* r)
+{
+    // M = |A B|, inverse(M) = 1/|M| * |X Y|
+    //     |C D|                       |Z W|
+    // with X# = |D|A - B(D#C), Y# = |B|C - D(A#B)#, Z# = |C|B - A(D#C)#,
+    // W# = |A|D - C(A#B) and |M| = |A||D| + |B||C| - tr((A#B)(D#C)).
+    __m128 r0 = _mm_loadu_ps(m + 0);
+    __m128 r1 = _mm_loadu_ps(m + 4);
+    __m128 r2 = _mm_loadu_ps(m + 8);
+    __m128 r3 = _mm_loadu_ps(m + 12);
+
+    __m128 A = _mm_movelh_ps(r0, r1);
+    __m128 B = _mm_movehl_ps(r1, r0);
+    __m128 C = _mm_movelh_ps(r2, r3);
+    __m128 D = _mm_movehl_ps(r3, r2);
+
+    // (|A|, |B|, |C|, |D|)
+    __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(2, 0, 2, 0)),
+            _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(3, 1, 3, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(r0, r2, _MM_SHUFFLE(3, 1, 3, 1)),
+            _mm_shuffle_ps(r1, r3, _MM_SHUFFLE(2, 0, 2, 0))));
+    __m128 detA = Splat(detSub, 0);
+    __m128 detB = Splat(detSub, 1);
+    __m128 detC = Splat(detSub, 2);
+    __m128 detD = Splat(detSub, 3);
+
+    __m128 DC = Mat2AdjMul(D, C);
+    __m128 AB = Mat2AdjMul(A, B);
+    __m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, DC));
+    __m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, AB));
+    __m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, AB));
+    __m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, DC));
+
+    __m128 trace = _mm_mul_ps(AB, _mm_shuffle_ps(DC, DC, _MM_SHUFFLE(3, 1, 2, 0)));
+    trace = _mm_add_ps(trace, _mm_movehl_ps(trace, trace));
+    trace = _mm_add_ss(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(1, 1, 1, 1)));
+    __m128 detM = _mm_add_ss(_mm_mul_ss(detA, detD), _mm_mul_ss(detB, detC));
+    detM = _mm_sub_ss(detM, trace);
+
+    float det = _mm_cvtss_f32(detM);
+    if (det == 0.0f)
+    {
+        __m128 zero = _mm_setzero_ps();
+        _mm_storeu_ps(r + 0, zero);
+        _mm_storeu_ps(r + 4, zero);
+        _mm_storeu_ps(r + 8, zero);
+        _mm_storeu_ps(r + 12, zero);
+        return false;
+    }
+
+    // The adjugate signs (+,-,-,+) are folded into the reciprocal.
+    __m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f),
+        _mm_shuffle_ps(detM, detM, _MM_SHUFFLE(0, 0, 0, 0)));
+    X = _mm_mul_ps(X, invDet);
+    Y = _mm_mul_ps(Y, invDet);
+    Z = _mm_mul_ps(Z, invDet);
+    W = _mm_mul_ps(W, invDet);
+
+    // Undo the adjugates while storing the blocks back in rows.
+    _mm_storeu_ps(r + 0, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(r + 4, _mm_shuffle_ps(X, Y, _MM_SHUFFLE(0, 2, 0, 2)));
+    _mm_storeu_ps(r + 8, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(r + 12, _mm_shuffle_ps(Z, W, _MM_SHUFFLE(0, 2, 0, 2)));
+    return true;
+}
+
+inline void SIMD::MultiplyQQ(float const* q0, float const* q1, float* r)
+{
+    // The columns of the product formula in Quaternion.h, with the signs of
+    // each column applied to the products by flipping the sign bit.
+    __m128 p = _mm_loadu_ps(q0);
+    __m128 q = _mm_loadu_ps(q1);
+    __m128 const sign0 = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+    __m128 const sign1 = _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f);
+    __m128 const sign2 = _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+
+    __m128 sum = _mm_xor_ps(_mm_mul_ps(Splat(p, 0),
+        _mm_shuffle_ps(q, q, _MM_SHUFFLE(0, 1, 2, 3))), sign0);
+    sum = _mm_add_ps(sum, _mm_xor_ps(_mm_mul_ps(Splat(p, 1),
+        _mm_shuffle_ps(q, q, _MM_SHUFFLE(1, 0, 3, 2))), sign1));
+    sum = _mm_add_ps(sum, _mm_xor_ps(_mm_mul_ps(Splat(p, 2),
+        _mm_shuffle_ps(q, q, _MM_SHUFFLE(2, 3, 0, 1))), sign2));
+    sum = _mm_add_ps(sum, _mm_mul_ps(Splat(p, 3), q));
+    _mm_storeu_ps(r, sum);
+}
+
+#endif
+
+#endif
@@ -402,7 +402,20 @@ void Transform::UpdateHMatrix()
 
         if (mIsRSMatrix)
         {
+#if defined(MATH_SSE)
+            // Whole rows at once.  The fourth column is kept as it was, the
+            // translation is written below.
+            for (int r = 0; r < 3; ++r)
+            {
+                float last = hmatrix[r * 4 + 3];
 #if defined(GE_USE_MAT_VEC)
+                SIMD::Multiply(matrix + r * 4, scale, hmatrix + r * 4);
+#else
+                SIMD::Scale(matrix + r * 4, scale[r], hmatrix + r * 4);
+#endif
+                hmatrix[r * 4 + 3] = last;
+            }
+#elif defined(GE_USE_MAT_VEC)
 			hmatrix[0 * 4 + 0] = matrix[0 * 4 + 0] * scale[0];
 			hmatrix[0 * 4 + 1] = matrix[0 * 4 + 1] * scale[1];
 			hmatrix[0 * 4 + 2] = matrix[0 * 4 + 2] * scale[2];
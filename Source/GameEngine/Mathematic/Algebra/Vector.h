@@ -11,6 +11,8 @@
 #include <EASTL/array.h>
 #include <EASTL/initializer_list.h>
 
+#include "SIMD.h"
+
 #include <cmath>
 
 template <int N, typename Real>
@@ -743,4 +745,38 @@ Vector<N - 1, Real> Project(Vector<N, Real> const& v, int reject)
 	return result;
 }
 
+#if defined(MATH_SSE)
+
+// Float 4-tuples.  The binary operators are built on the compound ones, so
+// specializing these covers both.
+template <> inline
+Vector<4, float>& operator+=(Vector<4, float>& v0, Vector<4, float> const& v1)
+{
+	SIMD::Add(v0.mTuple, v1.mTuple, v0.mTuple);
+	return v0;
+}
+
+template <> inline
+Vector<4, float>& operator-=(Vector<4, float>& v0, Vector<4, float> const& v1)
+{
+	SIMD::Subtract(v0.mTuple, v1.mTuple, v0.mTuple);
+	return v0;
+}
+
+template <> inline
+Vector<4, float>& operator*=(Vector<4, float>& v, float scalar)
+{
+	SIMD::Scale(v.mTuple, scalar, v.mTuple);
+	return v;
+}
+
+template <> inline
+Vector<4, float>& operator*=(Vector<4, float>& v0, Vector<4, float> const& v1)
+{
+	SIMD::Multiply(v0.mTuple, v1.mTuple, v0.mTuple);
+	return v0;
+}
+
+#endif
+
 #endif
\ No newline at end of file
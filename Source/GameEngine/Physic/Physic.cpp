@@ -39,8 +39,14 @@
  
 #include "Physic.h"
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
 #include "PhysicDebugDrawer.h"
 #include "PhysicEventListener.h"
+#include "PhysicState.h"
 
 #include "Importer/Bsp/BspLoader.h"
 #include "Importer/Bsp/BspConverter.h"
@@ -51,6 +57,7 @@
 #include "Core/IO/XmlResource.h"
 #include "Core/Event/EventManager.h"
 #include "Core/Event/Event.h"
+#include "Core/Profiler/Profiler.h"
 
 #include "Application/GameApplication.h"
 
@@ -103,6 +110,7 @@ public:
 	virtual bool Initialize() { return true; }
 	virtual void SyncVisibleScene() { };
 	virtual void OnUpdate( float ) { }
+	virtual void StepSimulation( float ) { }
 
 	// Initialization of Physics Objects
 	virtual void AddTrigger(const Vector3<float>& dimensions, 
@@ -147,6 +155,7 @@ public:
 		eastl::vector<ActorId>& collisionActors,
 		eastl::vector<Vector3<float>>& collisionPoints,
 		eastl::vector<Vector3<float>>& collisionNormals) { }
+	virtual bool TestLineOfSight(const Vector3<float>& origin, const Vector3<float>& end) { return true; }
 
 	virtual void SetIgnoreCollision(ActorId actorId, ActorId ignoreActorId, bool ignoreCollision) { }
 	virtual void StopActor(ActorId actorId) { }
@@ -163,6 +172,11 @@ public:
 	virtual void Translate(ActorId actorId, const Vector3<float>& vec) { }
 	virtual void SetTransform(const ActorId id, const Transform& mat) { }
     virtual Transform GetTransform(const ActorId id) { return Transform::Identity; }
+
+	virtual eastl::shared_ptr<BasePhysicState> CreateState() 
+	{ return eastl::shared_ptr<BasePhysicState>(new BasePhysicState()); }
+	virtual void CaptureState(const eastl::vector<ActorId>& actors, BasePhysicState& state) { }
+	virtual void RestoreState(const BasePhysicState& state) { }
 };
 
 
@@ -263,6 +277,419 @@ struct ActorMotionState : public btMotionState
 	}
 };
 
+/////////////////////////////////////////////////////////////////////////////
+// class BulletActorTable						- not described in the book
+//
+//   Dense handle table with the bullet objects owned by each actor. Actor ids
+//   index a sparse array of slots pointing into a packed array of entries, so
+//   lookups are O(1) and removing an entry moves the last one into the hole.
+//   Each entry stores the kind of object that was created for the actor, so
+//   the physics calls can reach the rigid body or the character controller
+//   without going through a dynamic_cast. Actor ids are never reused by the
+//   game logic, therefore the slots don't need generation counters.
+//
+enum BulletObjectKind
+{
+	BOK_RIGID_BODY = 0,
+	BOK_TRIGGER,
+	BOK_CHARACTER
+};
+
+static const unsigned int INVALID_BULLET_SLOT = 0xFFFFFFFF;
+
+struct BulletActorEntry
+{
+	ActorId mActorId;
+	BulletObjectKind mKind;
+
+	btCollisionObject* mCollisionObject;
+	btRigidBody* mRigidBody;
+	BulletCharacterController* mController;
+
+	BulletActorEntry(ActorId actorId, BulletObjectKind kind, btCollisionObject* collisionObject,
+		btRigidBody* rigidBody = NULL, BulletCharacterController* controller = NULL)
+		: mActorId(actorId), mKind(kind), mCollisionObject(collisionObject),
+		mRigidBody(rigidBody), mController(controller)
+	{
+
+	}
+};
+
+class BulletActorTable
+{
+public:
+	typedef eastl::vector<BulletActorEntry> Entries;
+
+	BulletActorEntry* Find(ActorId id)
+	{
+		if (id >= mSlots.size() || mSlots[id] == INVALID_BULLET_SLOT)
+			return NULL;
+		return &mEntries[mSlots[id]];
+	}
+
+	BulletActorEntry const* Find(ActorId id) const
+	{
+		if (id >= mSlots.size() || mSlots[id] == INVALID_BULLET_SLOT)
+			return NULL;
+		return &mEntries[mSlots[id]];
+	}
+
+	void Insert(BulletActorEntry const& entry)
+	{
+		LogAssert(entry.mActorId != INVALID_ACTOR_ID, "invalid actor id");
+		if (entry.mActorId >= mSlots.size())
+			mSlots.resize(entry.mActorId + 1, INVALID_BULLET_SLOT);
+
+		LogAssert(mSlots[entry.mActorId] == INVALID_BULLET_SLOT, "Actor with more than one physics body?");
+		mSlots[entry.mActorId] = (unsigned int)mEntries.size();
+		mEntries.push_back(entry);
+
+		// the collision object knows its actor so ray and sweep hits can be
+		// resolved without looking the object up
+		entry.mCollisionObject->setUserIndex((int)entry.mActorId);
+	}
+
+	void Remove(ActorId id)
+	{
+		if (id >= mSlots.size() || mSlots[id] == INVALID_BULLET_SLOT)
+			return;
+
+		unsigned int const slot = mSlots[id];
+		if (slot + 1 != mEntries.size())
+		{
+			mEntries[slot] = mEntries.back();
+			mSlots[mEntries[slot].mActorId] = slot;
+		}
+		mEntries.pop_back();
+		mSlots[id] = INVALID_BULLET_SLOT;
+	}
+
+	void Clear()
+	{
+		mEntries.clear();
+		mSlots.clear();
+	}
+
+	Entries::const_iterator begin() const { return mEntries.begin(); }
+	Entries::const_iterator end() const { return mEntries.end(); }
+
+private:
+	eastl::vector<unsigned int> mSlots;
+	Entries mEntries;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// class BulletOcclusionGrid					- not described in the book
+//
+//   Simplified copy of the static level geometry which answers line of 
+//   sight queries without going through the collision world. The bounds of
+//   the level are split in cubic cells which are classified when the level
+//   is loaded as empty (no geometry touches them), solid (fully inside a
+//   solid brush) or mixed. A segment crossing a solid cell is occluded, a
+//   segment crossing only empty cells is visible and any other segment is
+//   ambiguous and has to be tested against the exact level geometry.
+//
+enum OcclusionCell
+{
+	OC_EMPTY = 0,
+	OC_MIXED,
+	OC_SOLID
+};
+
+enum OcclusionResult
+{
+	OR_VISIBLE = 0,
+	OR_OCCLUDED,
+	OR_AMBIGUOUS
+};
+
+class BulletOcclusionGrid
+{
+public:
+	BulletOcclusionGrid() : mCellSize(32.f), mGridCellSize(32.f), mOrigin(0.f, 0.f, 0.f)
+	{
+		mDimensions[0] = mDimensions[1] = mDimensions[2] = 0;
+	}
+
+	void SetCellSize(btScalar cellSize) { mCellSize = cellSize; }
+
+	// level geometry in world space, the grid is created by Build
+	void AddConvexHull(btAlignedObjectArray<btVector3> const & vertices);
+	void AddTriangle(btVector3 const & vertex0, btVector3 const & vertex1, btVector3 const & vertex2);
+	void Build();
+	void Clear();
+
+	OcclusionResult TestSegment(btVector3 const & from, btVector3 const & to) const;
+
+private:
+
+	struct ConvexHull
+	{
+		btVector3 mAabbMin;
+		btVector3 mAabbMax;
+		int mFirstPlane;
+		int mNumPlanes;
+	};
+
+	// stop doubling the cell size when the grid fits in this number of cells
+	static const int MaxCells = 1 << 24;
+
+	void MarkCells(btVector3 const & aabbMin, btVector3 const & aabbMax, ConvexHull const * hull);
+
+	btAlignedObjectArray<ConvexHull> mConvexHulls;
+	btAlignedObjectArray<btVector3> mPlaneEquations;
+	btAlignedObjectArray<btVector3> mTriangleAabbs;
+
+	btScalar mCellSize;
+	btScalar mGridCellSize;
+	btVector3 mOrigin;
+	int mDimensions[3];
+	eastl::vector<unsigned char> mCells;
+};
+
+void BulletOcclusionGrid::AddConvexHull(btAlignedObjectArray<btVector3> const & vertices)
+{
+	if (vertices.size() == 0)
+		return;
+
+	ConvexHull hull;
+	hull.mAabbMin = hull.mAabbMax = vertices[0];
+	for (int i = 1; i < vertices.size(); ++i)
+	{
+		hull.mAabbMin.setMin(vertices[i]);
+		hull.mAabbMax.setMax(vertices[i]);
+	}
+
+	// the plane normals point outside, points inside the hull have negative distance
+	btAlignedObjectArray<btVector3> planeEquations;
+	btGeometryUtil::getPlaneEquationsFromVertices(
+		const_cast<btAlignedObjectArray<btVector3>&>(vertices), planeEquations);
+	if (planeEquations.size() < 4)
+	{
+		// flat brush, it can't contain any cell
+		mTriangleAabbs.push_back(hull.mAabbMin);
+		mTriangleAabbs.push_back(hull.mAabbMax);
+		return;
+	}
+
+	hull.mFirstPlane = mPlaneEquations.size();
+	hull.mNumPlanes = planeEquations.size();
+	for (int i = 0; i < planeEquations.size(); ++i)
+		mPlaneEquations.push_back(planeEquations[i]);
+
+	mConvexHulls.push_back(hull);
+}
+
+void BulletOcclusionGrid::AddTriangle(
+	btVector3 const & vertex0, btVector3 const & vertex1, btVector3 const & vertex2)
+{
+	btVector3 aabbMin = vertex0, aabbMax = vertex0;
+	aabbMin.setMin(vertex1);
+	aabbMin.setMin(vertex2);
+	aabbMax.setMax(vertex1);
+	aabbMax.setMax(vertex2);
+
+	mTriangleAabbs.push_back(aabbMin);
+	mTriangleAabbs.push_back(aabbMax);
+}
+
+void BulletOcclusionGrid::Clear()
+{
+	mConvexHulls.clear();
+	mPlaneEquations.clear();
+	mTriangleAabbs.clear();
+	mCells.clear();
+	mDimensions[0] = mDimensions[1] = mDimensions[2] = 0;
+}
+
+void BulletOcclusionGrid::Build()
+{
+	mCells.clear();
+	if (mConvexHulls.size() == 0 && mTriangleAabbs.size() == 0)
+		return;
+
+	btVector3 aabbMin(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+	btVector3 aabbMax(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+	for (int i = 0; i < mConvexHulls.size(); ++i)
+	{
+		aabbMin.setMin(mConvexHulls[i].mAabbMin);
+		aabbMax.setMax(mConvexHulls[i].mAabbMax);
+	}
+	for (int i = 0; i < mTriangleAabbs.size(); i += 2)
+	{
+		aabbMin.setMin(mTriangleAabbs[i]);
+		aabbMax.setMax(mTriangleAabbs[i + 1]);
+	}
+
+	// the space outside the grid has no geometry, leave an empty border
+	mGridCellSize = mCellSize;
+	btVector3 extent;
+	do
+	{
+		mOrigin = aabbMin - btVector3(mGridCellSize, mGridCellSize, mGridCellSize);
+		extent = aabbMax - mOrigin;
+		for (int axis = 0; axis < 3; ++axis)
+			mDimensions[axis] = (int)(extent[axis] / mGridCellSize) + 2;
+
+		if ((long long)mDimensions[0] * mDimensions[1] * mDimensions[2] <= MaxCells)
+			break;
+		mGridCellSize *= 2.f;
+	} while (true);
+
+	mCells.resize(mDimensions[0] * mDimensions[1] * mDimensions[2], OC_EMPTY);
+
+	for (int i = 0; i < mTriangleAabbs.size(); i += 2)
+		MarkCells(mTriangleAabbs[i], mTriangleAabbs[i + 1], NULL);
+	for (int i = 0; i < mConvexHulls.size(); ++i)
+		MarkCells(mConvexHulls[i].mAabbMin, mConvexHulls[i].mAabbMax, &mConvexHulls[i]);
+
+	LogInformation("Occlusion grid " + eastl::to_string(mDimensions[0]) + "x" + 
+		eastl::to_string(mDimensions[1]) + "x" + eastl::to_string(mDimensions[2]) + 
+		" cells of size " + eastl::to_string(mGridCellSize));
+}
+
+void BulletOcclusionGrid::MarkCells(
+	btVector3 const & aabbMin, btVector3 const & aabbMax, ConvexHull const * hull)
+{
+	// cells closer than the margin to the geometry are never empty, so that 
+	// rounding errors while walking the grid can't miss any geometry
+	btScalar const margin = mGridCellSize * btScalar(0.01);
+
+	int cellMin[3], cellMax[3];
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		cellMin[axis] = btMax(0, (int)((aabbMin[axis] - margin - mOrigin[axis]) / mGridCellSize));
+		cellMax[axis] = btMin(mDimensions[axis] - 1, (int)((aabbMax[axis] + margin - mOrigin[axis]) / mGridCellSize));
+	}
+
+	for (int z = cellMin[2]; z <= cellMax[2]; ++z)
+	{
+		for (int y = cellMin[1]; y <= cellMax[1]; ++y)
+		{
+			for (int x = cellMin[0]; x <= cellMax[0]; ++x)
+			{
+				unsigned char& cell = mCells[x + mDimensions[0] * (y + mDimensions[1] * z)];
+				if (cell == OC_SOLID)
+					continue;
+
+				if (!hull)
+				{
+					cell = OC_MIXED;
+					continue;
+				}
+
+				btVector3 const boxMin = mOrigin + btVector3((btScalar)x, (btScalar)y, (btScalar)z) * mGridCellSize;
+				btVector3 const boxMax = boxMin + btVector3(mGridCellSize, mGridCellSize, mGridCellSize);
+
+				bool inside = true, outside = false;
+				for (int p = 0; p < hull->mNumPlanes && !outside; ++p)
+				{
+					btVector3 const & plane = mPlaneEquations[hull->mFirstPlane + p];
+
+					// box corners closest and farthest along the plane normal
+					btVector3 nearCorner, farCorner;
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						nearCorner[axis] = plane[axis] >= 0.f ? boxMin[axis] : boxMax[axis];
+						farCorner[axis] = plane[axis] >= 0.f ? boxMax[axis] : boxMin[axis];
+					}
+
+					if (plane.dot(nearCorner) + plane[3] > margin)
+						outside = true;
+					else if (plane.dot(farCorner) + plane[3] > 0.f)
+						inside = false;
+				}
+
+				if (!outside)
+					cell = inside ? OC_SOLID : OC_MIXED;
+			}
+		}
+	}
+}
+
+OcclusionResult BulletOcclusionGrid::TestSegment(btVector3 const & from, btVector3 const & to) const
+{
+	if (mCells.empty())
+		return OR_AMBIGUOUS;
+
+	// clip the segment against the grid bounds
+	btVector3 const direction = to - from;
+	btVector3 const gridMax = mOrigin + btVector3(
+		(btScalar)mDimensions[0], (btScalar)mDimensions[1], (btScalar)mDimensions[2]) * mGridCellSize;
+	btScalar tEnter = 0.f, tExit = 1.f;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if (btFabs(direction[axis]) < SIMD_EPSILON)
+		{
+			if (from[axis] < mOrigin[axis] || from[axis] > gridMax[axis])
+				return OR_VISIBLE;
+			continue;
+		}
+
+		btScalar t0 = (mOrigin[axis] - from[axis]) / direction[axis];
+		btScalar t1 = (gridMax[axis] - from[axis]) / direction[axis];
+		if (t0 > t1)
+			btSwap(t0, t1);
+		tEnter = btMax(tEnter, t0);
+		tExit = btMin(tExit, t1);
+		if (tEnter > tExit)
+			return OR_VISIBLE;
+	}
+
+	// walk the cells crossed by the segment (Amanatides & Woo)
+	btVector3 const start = from + direction * tEnter;
+	int cell[3], step[3];
+	btScalar tMax[3], tDelta[3];
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		cell[axis] = btMin(mDimensions[axis] - 1, 
+			btMax(0, (int)((start[axis] - mOrigin[axis]) / mGridCellSize)));
+
+		if (btFabs(direction[axis]) < SIMD_EPSILON)
+		{
+			step[axis] = 0;
+			tMax[axis] = tDelta[axis] = BT_LARGE_FLOAT;
+		}
+		else
+		{
+			step[axis] = direction[axis] > 0.f ? 1 : -1;
+			btScalar const boundary = mOrigin[axis] + 
+				(btScalar)(cell[axis] + (step[axis] > 0 ? 1 : 0)) * mGridCellSize;
+			tMax[axis] = (boundary - from[axis]) / direction[axis];
+			tDelta[axis] = mGridCellSize / btFabs(direction[axis]);
+		}
+	}
+
+	// a solid cell only occludes if the segment goes through it
+	btScalar const minCrossing = btScalar(0.01) * mGridCellSize / btMax(direction.length(), SIMD_EPSILON);
+
+	bool ambiguous = false;
+	btScalar t = tEnter;
+	while (true)
+	{
+		int const axis = tMax[0] < tMax[1] ? 
+			(tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+		btScalar const tNext = btMin(tMax[axis], tExit);
+
+		unsigned char const value = mCells[cell[0] + mDimensions[0] * (cell[1] + mDimensions[1] * cell[2])];
+		if (value == OC_SOLID && tNext - t > minCrossing)
+			return OR_OCCLUDED;
+		else if (value != OC_EMPTY)
+			ambiguous = true;
+
+		if (tMax[axis] >= tExit)
+			break;
+
+		t = tMax[axis];
+		cell[axis] += step[axis];
+		tMax[axis] += tDelta[axis];
+		if (cell[axis] < 0 || cell[axis] >= mDimensions[axis])
+			break;
+	}
+
+	return ambiguous ? OR_AMBIGUOUS : OR_VISIBLE;
+}
+
 // forward declaration
 class BspToBulletConverter;
 
@@ -296,34 +723,69 @@ class BulletPhysics : public BaseGamePhysic
     MaterialTable mMaterialTable;
 
 	void LoadXml();
+	void ReadOptions(tinyxml2::XMLElement* pRoot);
     float LookupSpecificGravity(const eastl::string& densityStr);
     MaterialData LookupMaterialData(const eastl::string& materialStr);
 
-	// keep track of the existing actions:  To check them for updates
-	//   to the actors' positions, and to remove them when their lives are over.
-	typedef eastl::map<ActorId, btActionInterface*> ActorIDToBulletActionMap;
-	ActorIDToBulletActionMap mActorIdToAction;
-	btActionInterface * FindBulletAction(ActorId id) const;
-
-	// keep track of the existing collision objects:  To check them for updates
-	//   to the actors' positions, and to remove them when their lives are over.
-	typedef eastl::map<ActorId, btCollisionObject*> ActorIDToBulletCollisionObjectMap;
-	ActorIDToBulletCollisionObjectMap mActorIdToCollisionObject;
+	// keep track of the existing collision objects and actions:  To check them
+	//   for updates to the actors' positions, and to remove them when their
+	//   lives are over. The actor id is stored as the collision object user
+	//   index to get the actor id back from the btCollisionObject*
+	BulletActorTable mActorTable;
 	btCollisionObject * FindBulletCollisionObject( ActorId id ) const;
-	
-	// also keep a map to get the actor id from the btCollisionObject*
-	typedef eastl::map<btCollisionObject const *, ActorId> BulletCollisionObjectToActorIDMap;
-	BulletCollisionObjectToActorIDMap mCollisionObjectToActorId;
+	btRigidBody * FindBulletRigidBody(ActorId id) const;
+	btKinematicCharacterController * FindBulletCharacter(ActorId id) const;
 	ActorId FindActorID(btCollisionObject const * ) const;
 	
 	// data used to store which collision pair (bodies that are touching) need
 	//   Collision events sent.  When a new pair of touching bodies are detected,
 	//   they are added to m_previousTickCollisionPairs and an event is sent.
 	//   When the pair is no longer detected, they are removed and another event
-	//   is sent.
-	typedef eastl::pair<btRigidBody const *, btRigidBody const *> CollisionPair;
-	typedef eastl::set<CollisionPair> CollisionPairs;
+	//   is sent. The pairs are kept in sorted vectors which are reused and
+	//   swapped every tick, so that tracking contacts doesn't allocate memory
+	//   once the vectors have grown to the number of contacts in the world.
+	struct CollisionPair
+	{
+		btRigidBody const * mBodyA;
+		btRigidBody const * mBodyB;
+
+		// contact data of the pair, only valid during the tick it was found
+		btPersistentManifold const * mManifold;
+
+		// for the sort buffer
+		CollisionPair() : mBodyA(NULL), mBodyB(NULL), mManifold(NULL)
+		{
+
+		}
+
+		CollisionPair(btRigidBody const * bodyA, btRigidBody const * bodyB,
+			btPersistentManifold const * manifold = NULL)
+			: mBodyA(bodyA), mBodyB(bodyB), mManifold(manifold)
+		{
+
+		}
+
+		bool operator<(CollisionPair const & other) const
+		{
+			return mBodyA < other.mBodyA || (mBodyA == other.mBodyA && mBodyB < other.mBodyB);
+		}
+
+		bool operator==(CollisionPair const & other) const
+		{
+			return mBodyA == other.mBodyA && mBodyB == other.mBodyB;
+		}
+	};
+	typedef eastl::vector<CollisionPair> CollisionPairs;
 	CollisionPairs mPreviousTickCollisionPairs;
+	CollisionPairs mCurrentTickCollisionPairs;
+
+	// scratch space of the stable sort of the current tick, reused like the buffers
+	CollisionPairs mSortCollisionPairs;
+
+	// pairs which began or ended during the last tick, their events are sent
+	//   after the tick buffers have been swapped
+	CollisionPairs mAddedCollisionPairs;
+	CollisionPairs mRemovedCollisionPairs;
 	
 	// helpers for sending events relating to collision pairs
 	void SendCollisionPairAddEvent( btPersistentManifold const * manifold, 
@@ -339,6 +801,56 @@ class BulletPhysics : public BaseGamePhysic
 
 	// callback from bullet for each physics time step. set in Initialize
 	static void BulletInternalTickCallback( btDynamicsWorld * const world, btScalar const timeStep );
+
+	// the world is shared by the game logic, the AI threads and the simulation
+	//   thread. The mutex is recursive because some calls are built on others.
+	std::recursive_mutex mWorldMutex;
+
+	// optional fixed timestep simulation which runs on its own thread. After
+	//   every step the simulation thread publishes the actors' transforms, and
+	//   SyncVisibleScene interpolates between the last two published snapshots
+	//   so that rendering doesn't have to wait for the physics.
+	struct ActorSnapshot
+	{
+		ActorId mActorId;
+		btTransform mTransform;
+	};
+	typedef btAlignedObjectArray<ActorSnapshot> ActorSnapshots;
+
+	struct SimulationSnapshot
+	{
+		double mTime;
+		ActorSnapshots mActors;
+	};
+
+	// the simulation thread writes the back snapshot and rotates it with the
+	//   current and previous ones under the snapshot mutex.
+	SimulationSnapshot mSnapshots[3];
+	unsigned int mBackSnapshot;
+	unsigned int mCurrentSnapshot;
+	unsigned int mPreviousSnapshot;
+	std::mutex mSnapshotMutex;
+	ActorSnapshots mInterpolatedSnapshot;
+
+	bool mThreadedSimulation;
+	float mFixedTimeStep;
+	std::thread mSimulationThread;
+	std::atomic<bool> mSimulationRunning;
+	std::atomic<std::thread::id> mSimulationThreadId;
+
+	void StartSimulationThread();
+	void StopSimulationThread();
+	void SimulationThreadProc();
+	void WriteSnapshot(SimulationSnapshot& snapshot, double time);
+	void SyncInterpolatedScene();
+	void SyncActor(ActorId id, const btTransform& transform);
+
+	// simplified level geometry for the line of sight queries
+	BulletOcclusionGrid mOcclusionGrid;
+	ActorId mLevelActorId;
+
+	// events are triggered right away unless they come from the simulation thread
+	void SendPhysicEvent(BaseEventDataPtr const & pEvent);
 	
 public:
 	BulletPhysics();				// [mrmike] This was changed post-press to add event registration!
@@ -348,6 +860,7 @@ public:
 	virtual bool Initialize() override;
 	virtual void SyncVisibleScene() override; 
 	virtual void OnUpdate( float deltaSeconds ) override; 
+	virtual void StepSimulation( float deltaSeconds ) override;
 
 	// Initialization of Physics Objects
 	virtual void AddTrigger(const Vector3<float> &dimension, 
@@ -391,6 +904,7 @@ public:
 		eastl::vector<ActorId>& collisionActors,
 		eastl::vector<Vector3<float>>& collisionPoints,
 		eastl::vector<Vector3<float>>& collisionNormals);
+	virtual bool TestLineOfSight(const Vector3<float>& origin, const Vector3<float>& end);
 
 	virtual void SetIgnoreCollision(ActorId actorId, ActorId ignoreActorId, bool ignoreCollision);
 	virtual void StopActor(ActorId actorId);
@@ -408,6 +922,10 @@ public:
 
     virtual void SetTransform(const ActorId id, const Transform& mat);
 	virtual Transform GetTransform(const ActorId id);
+
+	virtual eastl::shared_ptr<BasePhysicState> CreateState();
+	virtual void CaptureState(const eastl::vector<ActorId>& actors, BasePhysicState& state);
+	virtual void RestoreState(const BasePhysicState& state);
 };
 
 ///BspToBulletConverter  extends the BspConverter to convert to Bullet datastructures
@@ -463,6 +981,12 @@ public:
 
 			btRigidBody* const body = new btRigidBody(rbInfo);
 			mPhysics->mDynamicsWorld->addRigidBody(body);
+
+			// the occlusion grid works with the level in world space
+			btTransform const worldTransform = TransformTobtTransform(transform);
+			for (int i = 0; i < vertices.size(); ++i)
+				vertices[i] = worldTransform * vertices[i];
+			mPhysics->mOcclusionGrid.AddConvexHull(vertices);
 		}
 	}
 
@@ -508,10 +1032,35 @@ public:
 
 			btRigidBody* const body = new btRigidBody(rbInfo);
 			mPhysics->mDynamicsWorld->addRigidBody(body);
+
+			OcclusionTriangleCallback triangleCallback(
+				mPhysics->mOcclusionGrid, TransformTobtTransform(transform));
+			btVector3 aabbMin(-BT_LARGE_FLOAT, -BT_LARGE_FLOAT, -BT_LARGE_FLOAT);
+			btVector3 aabbMax(BT_LARGE_FLOAT, BT_LARGE_FLOAT, BT_LARGE_FLOAT);
+			triangleMesh->InternalProcessAllTriangles(&triangleCallback, aabbMin, aabbMax);
 		}
 	}
 
 protected:
+	// adds the triangles of the curved surfaces to the occlusion grid
+	struct OcclusionTriangleCallback : public btInternalTriangleIndexCallback
+	{
+		BulletOcclusionGrid& mOcclusionGrid;
+		btTransform mTransform;
+
+		OcclusionTriangleCallback(BulletOcclusionGrid& occlusionGrid, btTransform const & transform)
+			: mOcclusionGrid(occlusionGrid), mTransform(transform)
+		{
+
+		}
+
+		virtual void internalProcessTriangleIndex(btVector3* triangle, int partId, int triangleIndex)
+		{
+			mOcclusionGrid.AddTriangle(
+				mTransform * triangle[0], mTransform * triangle[1], mTransform * triangle[2]);
+		}
+	};
+
 	BulletPhysics* mPhysics;
 	eastl::shared_ptr<Actor> mGameActor;
 	eastl::string mPhysicMaterial;
@@ -520,6 +1069,9 @@ protected:
 
 
 BulletPhysics::BulletPhysics()
+	: mBackSnapshot(0), mCurrentSnapshot(1), mPreviousSnapshot(2),
+	mThreadedSimulation(false), mFixedTimeStep(1.f / 60.f), mSimulationRunning(false),
+	mSimulationThreadId(std::thread::id()), mLevelActorId(INVALID_ACTOR_ID)
 {
 	// [mrmike] This was changed post-press to add event registration!
 	REGISTER_EVENT(EventDataPhysTriggerEnter);
@@ -534,7 +1086,18 @@ BulletPhysics::BulletPhysics()
 //
 BulletPhysics::~BulletPhysics()
 {
+	// the simulation thread must be done with the world before it goes away
+	StopSimulationThread();
+
 	// delete any physics objects which are still in the world
+	for (BulletActorTable::Entries::const_iterator it = mActorTable.begin(); it != mActorTable.end(); ++it)
+	{
+		if (it->mController)
+		{
+			mDynamicsWorld->removeAction(it->mController);
+			delete it->mController;
+		}
+	}
 	
 	// iterate backwards because removing the last object doesn't affect the
 	//  other objects stored in a vector-type array
@@ -545,7 +1108,7 @@ BulletPhysics::~BulletPhysics()
 		RemoveCollisionObject( obj );
 	}
 	
-	mCollisionObjectToActorId.clear();
+	mActorTable.Clear();
 
 	delete mDebugDrawer;
 	delete mDynamicsWorld;
@@ -618,6 +1181,7 @@ bool BulletPhysics::Initialize()
 	mDebugDrawer = new BulletDebugDrawer();
 	GameApplication* gameApp = (GameApplication*)Application::App;
 	mDebugDrawer->ReadOptions(gameApp->mOption.mRoot);
+	ReadOptions(gameApp->mOption.mRoot);
 
 	if(!mCollisionConfiguration || !mDispatcher || !mBroadphase ||
 			  !mSolver || !mDynamicsWorld || !mDebugDrawer)
@@ -640,6 +1204,28 @@ bool BulletPhysics::Initialize()
 //
 void BulletPhysics::OnUpdate( float const deltaSeconds )
 {
+	if (mThreadedSimulation)
+	{
+		// the simulation thread steps the world on its own at the fixed
+		// timestep. It is started by the first update of the running game.
+		if (!mSimulationRunning)
+			StartSimulationThread();
+		return;
+	}
+
+	StepSimulation(deltaSeconds);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::StepSimulation				- not described in the book
+//
+//    Steps the world right away on the calling thread, also when the
+//    simulation thread is running. Used by the AI to simulate ahead.
+//
+void BulletPhysics::StepSimulation( float const deltaSeconds )
+{
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	// Bullet uses an internal fixed timestep (default 1/60th of a second)
 	// Bullet will run the simulation in increments of the fixed timestep 
 	// until "deltaSeconds" amount of time has passed (maximum of 10 steps).
@@ -652,44 +1238,245 @@ void BulletPhysics::OnUpdate( float const deltaSeconds )
 void BulletPhysics::SyncVisibleScene()
 {
 	// Keep physics & graphics in sync
+	if (mSimulationRunning)
+	{
+		SyncInterpolatedScene();
+		return;
+	}
+
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
 
 	// check all the existing actor's collision object for changes. 
 	//  If there is a change, send the appropriate event for the game system.
-	for (	ActorIDToBulletCollisionObjectMap::const_iterator it = mActorIdToCollisionObject.begin();
-			it != mActorIdToCollisionObject.end(); ++it )
+	for (	BulletActorTable::Entries::const_iterator it = mActorTable.begin();
+			it != mActorTable.end(); ++it )
 	{ 
-		ActorId const id = it->first;
-		btCollisionObject* actorCollisionObject = it->second;
-		
-		eastl::shared_ptr<Actor> pGameActor(GameLogic::Get()->GetActor(id).lock());
-		if (pGameActor)
+		SyncActor(it->mActorId, it->mCollisionObject->getWorldTransform());
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::SyncActor						- not described in the book
+//
+//    Sends the sync event if the actor transform is different from the 
+//    transform given by the physics
+//
+void BulletPhysics::SyncActor(ActorId id, const btTransform& transform)
+{
+	eastl::shared_ptr<Actor> pGameActor(GameLogic::Get()->GetActor(id).lock());
+	if (pGameActor)
+	{
+		eastl::shared_ptr<TransformComponent> pTransformComponent(
+			pGameActor->GetComponent<TransformComponent>(TransformComponent::Name).lock());
+		if (pTransformComponent)
 		{
-            eastl::shared_ptr<TransformComponent> pTransformComponent(
-				pGameActor->GetComponent<TransformComponent>(TransformComponent::Name).lock());
-            if (pTransformComponent)
-            {
-				Transform actorTransform = 
-					btTransformToTransform(actorCollisionObject->getWorldTransform());
-
-			    if (pTransformComponent->GetTransform().GetMatrix() != actorTransform.GetMatrix() ||
-					pTransformComponent->GetTransform().GetTranslation() != actorTransform.GetTranslation())
-                {
-                    // Bullet has moved the actor's physics object. Sync and inform
-					// about game actor transform 
-					//pTransformComponent->SetTransform(actorTransform);
+			Transform actorTransform = btTransformToTransform(transform);
+
+			if (pTransformComponent->GetTransform().GetMatrix() != actorTransform.GetMatrix() ||
+				pTransformComponent->GetTransform().GetTranslation() != actorTransform.GetTranslation())
+			{
+				// Bullet has moved the actor's physics object. Sync and inform
+				// about game actor transform 
+				//pTransformComponent->SetTransform(actorTransform);
 /*
-					LogInformation("x = " + eastl::to_string(actorTransform.GetTranslation()[0]) +
-									" y = " + eastl::to_string(actorTransform.GetTranslation()[1]) +
-									" z = " + eastl::to_string(actorTransform.GetTranslation()[2]));
+				LogInformation("x = " + eastl::to_string(actorTransform.GetTranslation()[0]) +
+								" y = " + eastl::to_string(actorTransform.GetTranslation()[1]) +
+								" z = " + eastl::to_string(actorTransform.GetTranslation()[2]));
 */
-                    eastl::shared_ptr<EventDataSyncActor> pEvent(new EventDataSyncActor(id, actorTransform));
-                    BaseEventManager::Get()->TriggerEvent(pEvent);
-			    }
-            }
+				eastl::shared_ptr<EventDataSyncActor> pEvent(new EventDataSyncActor(id, actorTransform));
+				BaseEventManager::Get()->TriggerEvent(pEvent);
+			}
 		}
 	}
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::ReadOptions					- not described in the book
+//
+//    Reads the simulation options from the game options
+//
+void BulletPhysics::ReadOptions(tinyxml2::XMLElement *pRoot)
+{
+	tinyxml2::XMLElement *pNode = pRoot ? pRoot->FirstChildElement("Physics") : NULL;
+	if (pNode)
+	{
+		if (pNode->Attribute("Threaded"))
+		{
+			eastl::string attribute(pNode->Attribute("Threaded"));
+			mThreadedSimulation = (attribute == "true");
+		}
+
+		if (pNode->Attribute("TicksPerSecond"))
+		{
+			int ticksPerSecond = pNode->IntAttribute("TicksPerSecond", 60);
+			if (ticksPerSecond > 0)
+				mFixedTimeStep = 1.f / (float)ticksPerSecond;
+		}
+
+		if (pNode->Attribute("OcclusionCellSize"))
+		{
+			float cellSize = pNode->FloatAttribute("OcclusionCellSize", 32.f);
+			if (cellSize > 0.f)
+				mOcclusionGrid.SetCellSize(cellSize);
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::StartSimulationThread		- not described in the book
+//
+void BulletPhysics::StartSimulationThread()
+{
+	if (mSimulationRunning)
+		return;
+
+	// both snapshots start from the current state of the world so that there
+	// is something to interpolate before the first step is published
+	double const time = (double)std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count() / 1000000.0;
+	{
+		std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+		WriteSnapshot(mSnapshots[mPreviousSnapshot], time);
+		WriteSnapshot(mSnapshots[mCurrentSnapshot], time);
+	}
+
+	mSimulationRunning = true;
+	mSimulationThread = std::thread(&BulletPhysics::SimulationThreadProc, this);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::StopSimulationThread			- not described in the book
+//
+void BulletPhysics::StopSimulationThread()
+{
+	mSimulationRunning = false;
+	if (mSimulationThread.joinable())
+		mSimulationThread.join();
+	mSimulationThreadId = std::thread::id();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::SimulationThreadProc			- not described in the book
+//
+//    Steps the world at the fixed timestep. If the thread falls behind for
+//    more than a few steps, the missing time is dropped instead of running
+//    a burst of steps to catch up.
+//
+void BulletPhysics::SimulationThreadProc()
+{
+	typedef std::chrono::steady_clock Clock;
+	Clock::duration const timeStep = std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<float>(mFixedTimeStep));
+
+	// the events raised from this thread are recognized by its id
+	mSimulationThreadId = std::this_thread::get_id();
+
+	Clock::time_point nextStep = Clock::now();
+	while (mSimulationRunning)
+	{
+		double const time = (double)std::chrono::duration_cast<std::chrono::microseconds>(
+			nextStep.time_since_epoch()).count() / 1000000.0;
+		{
+			std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+			// exactly one step of the fixed timestep
+			mDynamicsWorld->stepSimulation(mFixedTimeStep, 1, mFixedTimeStep);
+			WriteSnapshot(mSnapshots[mBackSnapshot], time);
+		}
+
+		// publish the new snapshot. The oldest one becomes the next back buffer
+		{
+			std::lock_guard<std::mutex> lock(mSnapshotMutex);
+			unsigned int const backSnapshot = mPreviousSnapshot;
+			mPreviousSnapshot = mCurrentSnapshot;
+			mCurrentSnapshot = mBackSnapshot;
+			mBackSnapshot = backSnapshot;
+		}
+
+		nextStep += timeStep;
+		Clock::time_point const now = Clock::now();
+		if (now - nextStep > timeStep * 4)
+			nextStep = now;
+		else if (nextStep > now)
+			std::this_thread::sleep_until(nextStep);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::WriteSnapshot				- not described in the book
+//
+//    Copies the actors' transforms into the snapshot. Called with the world
+//    locked.
+//
+void BulletPhysics::WriteSnapshot(SimulationSnapshot& snapshot, double time)
+{
+	// resize keeps the memory of the previous snapshots
+	snapshot.mTime = time;
+	snapshot.mActors.resize(0);
+	for (BulletActorTable::Entries::const_iterator it = mActorTable.begin(); it != mActorTable.end(); ++it)
+	{
+		ActorSnapshot actorSnapshot;
+		actorSnapshot.mActorId = it->mActorId;
+		actorSnapshot.mTransform = it->mCollisionObject->getWorldTransform();
+		snapshot.mActors.push_back(actorSnapshot);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::SyncInterpolatedScene		- not described in the book
+//
+//    Interpolates the actors between the last two snapshots. The scene runs
+//    at most one step behind the simulation in exchange of a smooth motion.
+//
+void BulletPhysics::SyncInterpolatedScene()
+{
+	double const time = (double)std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count() / 1000000.0;
+
+	mInterpolatedSnapshot.resize(0);
+	{
+		std::lock_guard<std::mutex> lock(mSnapshotMutex);
+
+		SimulationSnapshot const & previous = mSnapshots[mPreviousSnapshot];
+		SimulationSnapshot const & current = mSnapshots[mCurrentSnapshot];
+
+		btScalar alpha = (btScalar)((time - current.mTime) / mFixedTimeStep);
+		alpha = btClamped(alpha, btScalar(0.f), btScalar(1.f));
+		for (int i = 0; i < current.mActors.size(); ++i)
+		{
+			ActorSnapshot actorSnapshot = current.mActors[i];
+
+			// both snapshots list the actors in the same order unless an actor
+			// was added or removed in between, then it just takes the last one
+			if (i < previous.mActors.size() && previous.mActors[i].mActorId == actorSnapshot.mActorId)
+			{
+				btTransform const & from = previous.mActors[i].mTransform;
+				btTransform const & to = current.mActors[i].mTransform;
+				actorSnapshot.mTransform.setOrigin(from.getOrigin().lerp(to.getOrigin(), alpha));
+				actorSnapshot.mTransform.setRotation(from.getRotation().slerp(to.getRotation(), alpha));
+			}
+			mInterpolatedSnapshot.push_back(actorSnapshot);
+		}
+	}
+
+	// the events are sent without holding the snapshot
+	for (int i = 0; i < mInterpolatedSnapshot.size(); ++i)
+		SyncActor(mInterpolatedSnapshot[i].mActorId, mInterpolatedSnapshot[i].mTransform);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::SendPhysicEvent				- not described in the book
+//
+void BulletPhysics::SendPhysicEvent(BaseEventDataPtr const & pEvent)
+{
+	// the game listeners aren't thread safe, so the events raised during the 
+	// steps of the simulation thread are handled with the next event update
+	if (std::this_thread::get_id() == mSimulationThreadId.load())
+		BaseEventManager::Get()->ThreadSafeQueueEvent(pEvent);
+	else
+		BaseEventManager::Get()->TriggerEvent(pEvent);
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // BulletPhysics::AddShape						- Chapter 17, page 600
 //
@@ -699,8 +1486,7 @@ void BulletPhysics::AddShape(eastl::shared_ptr<Actor> pGameActor, btCollisionSha
     LogAssert(pGameActor, "no actor");
 
     ActorId actorID = pGameActor->GetId();
-	LogAssert(mActorIdToCollisionObject.find( actorID ) == mActorIdToCollisionObject.end(),
-		"Actor with more than one physics body?");
+	LogAssert(!mActorTable.Find(actorID), "Actor with more than one physics body?");
 
     // lookup the material
     MaterialData material(LookupMaterialData(physicMaterial));
@@ -738,8 +1524,7 @@ void BulletPhysics::AddShape(eastl::shared_ptr<Actor> pGameActor, btCollisionSha
 	mDynamicsWorld->addRigidBody( body );
 	
 	// add it to the collection to be checked for changes in SyncVisibleScene
-	mActorIdToCollisionObject[actorID] = body;
-	mCollisionObjectToActorId[body] = actorID;
+	mActorTable.Insert(BulletActorEntry(actorID, BOK_RIGID_BODY, body, body));
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -753,20 +1538,16 @@ void BulletPhysics::RemoveCollisionObject( btCollisionObject * const removeMe )
 	mDynamicsWorld->removeCollisionObject( removeMe );
 	
 	// then remove the pointer from the ongoing contacts list
-	for ( CollisionPairs::iterator it = mPreviousTickCollisionPairs.begin();
-	      it != mPreviousTickCollisionPairs.end(); )
-    {
-		CollisionPairs::iterator next = it;
-		++next;
-		
-		if ( it->first == removeMe || it->second == removeMe )
+	for ( unsigned int pairIdx = 0; pairIdx < mPreviousTickCollisionPairs.size(); )
+	{
+		CollisionPair const pair = mPreviousTickCollisionPairs[pairIdx];
+		if ( pair.mBodyA == removeMe || pair.mBodyB == removeMe )
 		{
-			SendCollisionPairRemoveEvent( it->first, it->second );
-			mPreviousTickCollisionPairs.erase( it );
+			mPreviousTickCollisionPairs.erase( mPreviousTickCollisionPairs.begin() + pairIdx );
+			SendCollisionPairRemoveEvent( pair.mBodyA, pair.mBodyB );
 		}
-		
-		it = next;
-    }
+		else ++pairIdx;
+	}
 	
 	// if the object is a RigidBody (all of ours are RigidBodies, but it's good to be safe)
 	if ( btRigidBody * const body = btRigidBody::upcast(removeMe) )
@@ -789,40 +1570,51 @@ void BulletPhysics::RemoveCollisionObject( btCollisionObject * const removeMe )
 }
 
 /////////////////////////////////////////////////////////////////////////////
-// BulletPhysics::FindBulletAction			- not described in the book
-//    Finds a Bullet action given an actor ID
+// BulletPhysics::FindBulletCollisionObject			- not described in the book
+//    Finds a Bullet collision object given an actor ID
 //
-btActionInterface* BulletPhysics::FindBulletAction(ActorId const id) const
+btCollisionObject* BulletPhysics::FindBulletCollisionObject( ActorId const id ) const
 {
-	ActorIDToBulletActionMap::const_iterator found = mActorIdToAction.find(id);
-	if (found != mActorIdToAction.end())
-		return found->second;
+	if (BulletActorEntry const * const entry = mActorTable.Find(id))
+		return entry->mCollisionObject;
 
 	return NULL;
 }
 
 /////////////////////////////////////////////////////////////////////////////
-// BulletPhysics::FindBulletCollisionObject			- not described in the book
+// BulletPhysics::FindBulletRigidBody			- not described in the book
 //    Finds a Bullet rigid body given an actor ID
 //
-btCollisionObject* BulletPhysics::FindBulletCollisionObject( ActorId const id ) const
+btRigidBody* BulletPhysics::FindBulletRigidBody(ActorId const id) const
+{
+	if (BulletActorEntry const * const entry = mActorTable.Find(id))
+		return entry->mRigidBody;
+
+	return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::FindBulletCharacter			- not described in the book
+//    Finds a Bullet character controller given an actor ID
+//
+btKinematicCharacterController* BulletPhysics::FindBulletCharacter(ActorId const id) const
 {
-	ActorIDToBulletCollisionObjectMap::const_iterator found = mActorIdToCollisionObject.find( id );
-	if ( found != mActorIdToCollisionObject.end() )
-		return found->second;
+	if (BulletActorEntry const * const entry = mActorTable.Find(id))
+		return entry->mController;
 
 	return NULL;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 // BulletPhysics::FindActorID				- not described in the book
-//    Finds an Actor ID given a Bullet collision object
+//    Finds an Actor ID given a Bullet collision object. Objects which don't
+//    belong to any actor keep the default user index (-1).
 //
 ActorId BulletPhysics::FindActorID( btCollisionObject const * const collisionObject ) const
 {
-	BulletCollisionObjectToActorIDMap::const_iterator found = mCollisionObjectToActorId.find(collisionObject);
-	if ( found != mCollisionObjectToActorId.end() )
-		return found->second;
+	int const actorId = collisionObject->getUserIndex();
+	if ( actorId > 0 )
+		return (ActorId)actorId;
 		
 	return INVALID_ACTOR_ID;
 }
@@ -834,6 +1626,8 @@ ActorId BulletPhysics::FindActorID( btCollisionObject const * const collisionObj
 void BulletPhysics::AddTrigger(const Vector3<float> &dimension, 
 	eastl::weak_ptr<Actor> pGameActor, const eastl::string& physicMaterial)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	eastl::shared_ptr<Actor> pStrongActor(pGameActor.lock());
 	if (!pStrongActor)
 		return;  // FUTURE WORK: Add a call to the error log here
@@ -875,8 +1669,7 @@ void BulletPhysics::AddTrigger(const Vector3<float> &dimension,
 	body->setCollisionFlags(body->getCollisionFlags() | btRigidBody::CF_NO_CONTACT_RESPONSE);
 	body->setUserPointer(new int(pStrongActor->GetId()));
 
-	mActorIdToCollisionObject[pStrongActor->GetId()] = body;
-	mCollisionObjectToActorId[body] = pStrongActor->GetId();
+	mActorTable.Insert(BulletActorEntry(pStrongActor->GetId(), BOK_TRIGGER, body, body));
 }
 
 
@@ -887,6 +1680,8 @@ void BulletPhysics::AddTrigger(const Vector3<float> &dimension,
 void BulletPhysics::AddBSP(BspLoader& bspLoader, eastl::weak_ptr<Actor> pGameActor,
 	const eastl::string& densityStr, const eastl::string& physicMaterial)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	eastl::shared_ptr<Actor> pStrongActor(pGameActor.lock());
 	if (!pStrongActor)
 		return;  // FUTURE WORK - Add a call to the error log here
@@ -894,9 +1689,15 @@ void BulletPhysics::AddBSP(BspLoader& bspLoader, eastl::weak_ptr<Actor> pGameAct
 	// triggers are immoveable.  0 mass signals this to Bullet.
 	btScalar const mass = 0;
 
+	// the new level replaces the geometry of the previous one in the grid
+	mOcclusionGrid.Clear();
+	mLevelActorId = pStrongActor->GetId();
+
 	BspToBulletConverter bspToBullet(this, pStrongActor, mass, physicMaterial);
 	float bspScaling = 1.0f;
 	bspToBullet.ConvertBsp(bspLoader, bspScaling);
+
+	mOcclusionGrid.Build();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -906,6 +1707,8 @@ void BulletPhysics::AddCharacterController(
 	const Vector3<float>& dimensions, eastl::weak_ptr<Actor> pGameActor,
 	const eastl::string& densityStr, const eastl::string& physicMaterial)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	eastl::shared_ptr<Actor> pStrongActor(pGameActor.lock());
 	if (!pStrongActor)
 		return;  // FUTURE WORK - Add a call to the error log here
@@ -921,8 +1724,7 @@ void BulletPhysics::AddCharacterController(
 	btScalar const mass = volume * specificGravity;
 
 	ActorId actorID = pStrongActor->GetId();
-	LogAssert(mActorIdToCollisionObject.find(actorID) == mActorIdToCollisionObject.end(),
-		"Actor with more than one physics body?");
+	LogAssert(!mActorTable.Find(actorID), "Actor with more than one physics body?");
 
 	// lookup the material
 	MaterialData material(LookupMaterialData(physicMaterial));
@@ -951,7 +1753,7 @@ void BulletPhysics::AddCharacterController(
 	mBroadphase->getOverlappingPairCache()->setInternalGhostPairCallback(new btGhostPairCallback());
 	ghostObject->setCollisionShape(collisionShape);
 	ghostObject->setCollisionFlags(btCollisionObject::CF_CHARACTER_OBJECT);
-	btKinematicCharacterController* controller = new btKinematicCharacterController(ghostObject, collisionShape, 16.f);
+	BulletCharacterController* controller = new BulletCharacterController(ghostObject, collisionShape, 16.f);
 	controller->setGravity(mDynamicsWorld->getGravity() * 600);
 	controller->setFallSpeed(600);
 
@@ -959,9 +1761,7 @@ void BulletPhysics::AddCharacterController(
 	mDynamicsWorld->addAction(controller);
 
 	// add it to the collection to be checked for changes in SyncVisibleScene
-	mActorIdToAction[actorID] = controller;
-	mActorIdToCollisionObject[actorID] = ghostObject;
-	mCollisionObjectToActorId[ghostObject] = actorID;
+	mActorTable.Insert(BulletActorEntry(actorID, BOK_CHARACTER, ghostObject, NULL, controller));
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -970,6 +1770,8 @@ void BulletPhysics::AddCharacterController(
 void BulletPhysics::AddSphere(float const radius, eastl::weak_ptr<Actor> pGameActor, 
 	const eastl::string& densityStr, const eastl::string& physicMaterial)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	eastl::shared_ptr<Actor> pStrongActor(pGameActor.lock());
     if (!pStrongActor)
         return;  // FUTURE WORK - Add a call to the error log here
@@ -991,6 +1793,8 @@ void BulletPhysics::AddSphere(float const radius, eastl::weak_ptr<Actor> pGameAc
 void BulletPhysics::AddBox(const Vector3<float>& dimensions, eastl::weak_ptr<Actor> pGameActor,
 	const eastl::string& densityStr, const eastl::string& physicMaterial)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	eastl::shared_ptr<Actor> pStrongActor(pGameActor.lock());
     if (!pStrongActor)
         return;  // FUTURE WORK: Add a call to the error log here
@@ -1012,6 +1816,8 @@ void BulletPhysics::AddBox(const Vector3<float>& dimensions, eastl::weak_ptr<Act
 void BulletPhysics::AddPointCloud(Vector3<float> *verts, int numPoints, eastl::weak_ptr<Actor> pGameActor,
 	const eastl::string& densityStr, const eastl::string& physicMaterial)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	eastl::shared_ptr<Actor> pStrongActor(pGameActor.lock());
     if (!pStrongActor)
         return;  // FUTURE WORK: Add a call to the error log here
@@ -1041,6 +1847,8 @@ void BulletPhysics::AddPointCloud(Vector3<float> *verts, int numPoints, eastl::w
 void BulletPhysics::AddPointCloud(Plane3<float> *planes, int numPlanes, eastl::weak_ptr<Actor> pGameActor,
 	const eastl::string& densityStr, const eastl::string& physicMaterial)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	eastl::shared_ptr<Actor> pStrongActor(pGameActor.lock());
 	if (!pStrongActor)
 		return;  // FUTURE WORK: Add a call to the error log here
@@ -1084,12 +1892,27 @@ void BulletPhysics::AddPointCloud(Plane3<float> *planes, int numPlanes, eastl::w
 //
 void BulletPhysics::RemoveActor(ActorId id)
 {
-	if ( btCollisionObject * const collisionObject = FindBulletCollisionObject( id ) )
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	// the level is unloaded, its geometry can't occlude anything anymore
+	if (id == mLevelActorId)
+	{
+		mOcclusionGrid.Clear();
+		mLevelActorId = INVALID_ACTOR_ID;
+	}
+
+	if ( BulletActorEntry const * const entry = mActorTable.Find( id ) )
 	{
+		// the character controller action must leave the world with its ghost object
+		if (entry->mController)
+		{
+			mDynamicsWorld->removeAction(entry->mController);
+			delete entry->mController;
+		}
+
 		// destroy the body and all its components
-		RemoveCollisionObject(collisionObject);
-		mActorIdToCollisionObject.erase ( id );
-		mCollisionObjectToActorId.erase(collisionObject);
+		RemoveCollisionObject(entry->mCollisionObject);
+		mActorTable.Remove( id );
 	}
 }
 
@@ -1098,6 +1921,8 @@ void BulletPhysics::RemoveActor(ActorId id)
 //
 void BulletPhysics::RenderDiagnostics()
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	mDynamicsWorld->debugDrawWorld();
 
 	mDebugDrawer->Render();
@@ -1109,19 +1934,16 @@ void BulletPhysics::RenderDiagnostics()
 //
 void BulletPhysics::ApplyForce(ActorId aid, const Vector3<float> &velocity)
 {
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(aid))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (BulletActorEntry const * const entry = mActorTable.Find(aid))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
+		if (btKinematicCharacterController* const controller = entry->mController)
 		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(aid)))
-			{
-				controller->applyImpulse(Vector3TobtVector3(velocity));
-			}
+			controller->applyImpulse(Vector3TobtVector3(velocity));
 		}
-		else
+		else if (btRigidBody* const rigidBody = entry->mRigidBody)
 		{
-			btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(collisionObject);
 			rigidBody->applyCentralImpulse(Vector3TobtVector3(velocity));
 		}
 	}
@@ -1132,7 +1954,9 @@ void BulletPhysics::ApplyForce(ActorId aid, const Vector3<float> &velocity)
 //
 void BulletPhysics::ApplyTorque(ActorId aid, const Vector3<float> &velocity)
 {
-	if (btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(FindBulletCollisionObject(aid)))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (btRigidBody* const rigidBody = FindBulletRigidBody(aid))
 		rigidBody->applyTorqueImpulse( Vector3TobtVector3(velocity) );
 }
 
@@ -1143,6 +1967,8 @@ void BulletPhysics::ApplyTorque(ActorId aid, const Vector3<float> &velocity)
 //
 Transform BulletPhysics::GetTransform(const ActorId id)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	btCollisionObject * pCollisionObject = FindBulletCollisionObject(id);
     LogAssert(pCollisionObject, "no collision object");
 
@@ -1157,6 +1983,8 @@ Transform BulletPhysics::GetTransform(const ActorId id)
 //
 void BulletPhysics::SetTransform(ActorId actorId, const Transform& mat)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
 	{
 		// warp the body to the new position
@@ -1169,6 +1997,8 @@ void BulletPhysics::SetTransform(ActorId actorId, const Transform& mat)
 //
 void BulletPhysics::StopActor(ActorId actorId)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	SetVelocity(actorId, Vector3<float>());
 }
 
@@ -1177,6 +2007,8 @@ void BulletPhysics::StopActor(ActorId actorId)
 //
 void BulletPhysics::SetIgnoreCollision(ActorId actorId, ActorId ignoreActorId, bool ignoreCollision) 
 { 
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
 	{
 		if (btCollisionObject * const ignoreCollisionObject = FindBulletCollisionObject(ignoreActorId))
@@ -1190,30 +2022,26 @@ void BulletPhysics::SetIgnoreCollision(ActorId actorId, ActorId ignoreActorId, b
 // BulletPhysics::FindIntersection		
 bool BulletPhysics::FindIntersection(ActorId actorId, const Vector3<float>& point)
 {
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (BulletActorEntry const * const entry = mActorTable.Find(actorId))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
+		if (btKinematicCharacterController* const controller = entry->mController)
 		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(actorId)))
-			{
-				btCollisionShape* collisionShape = controller->getGhostObject()->getCollisionShape();
+			btCollisionShape* collisionShape = controller->getGhostObject()->getCollisionShape();
 
-				btAABB aaBBox;
-				collisionShape->getAabb(controller->getGhostObject()->getWorldTransform(), aaBBox.m_min, aaBBox.m_max);
-				if (aaBBox.m_min[0] > point[0] || aaBBox.m_max[0] < point[0] ||
-					aaBBox.m_min[1] > point[1] || aaBBox.m_max[1] < point[1] ||
-					aaBBox.m_min[2] > point[2] || aaBBox.m_max[2] < point[2])
-				{
-					return false;
-				}
-				return true;
+			btAABB aaBBox;
+			collisionShape->getAabb(controller->getGhostObject()->getWorldTransform(), aaBBox.m_min, aaBBox.m_max);
+			if (aaBBox.m_min[0] > point[0] || aaBBox.m_max[0] < point[0] ||
+				aaBBox.m_min[1] > point[1] || aaBBox.m_max[1] < point[1] ||
+				aaBBox.m_min[2] > point[2] || aaBBox.m_max[2] < point[2])
+			{
+				return false;
 			}
+			return true;
 		}
-		else
+		else if (btRigidBody* const rigidBody = entry->mRigidBody)
 		{
-			btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(collisionObject);
-			
 			btAABB aaBBox;
 			rigidBody->getAabb(aaBBox.m_min, aaBBox.m_max);
 			if (aaBBox.m_min[0] > point[0] || aaBBox.m_max[0] < point[0] ||
@@ -1235,6 +2063,9 @@ ActorId BulletPhysics::CastRay(
 	const Vector3<float>& origin, const Vector3<float>& end, 
 	Vector3<float>& collisionPoint, Vector3<float>& collisionNormal)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+	PROFILE_COUNTER("Rays cast", 1);
+
 	btVector3 from = Vector3TobtVector3(origin);
 	btVector3 to = Vector3TobtVector3(end);
 	btCollisionWorld::ClosestRayResultCallback closestResults(from, to);
@@ -1264,6 +2095,9 @@ void BulletPhysics::CastRay(
 	eastl::vector<Vector3<float>>& collisionPoints, 
 	eastl::vector<Vector3<float>>& collisionNormals)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+	PROFILE_COUNTER("Rays cast", 1);
+
 	btVector3 from = Vector3TobtVector3(origin);
 	btVector3 to = Vector3TobtVector3(end);
 	btCollisionWorld::AllHitsRayResultCallback allHitsResults(from, to);
@@ -1283,40 +2117,85 @@ void BulletPhysics::CastRay(
 	}
 }
 
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::TestLineOfSight				- not described in the book
+//
+//    Returns true if no level geometry is found between the two points. 
+//    The occlusion grid answers most of the queries, the collision world is
+//    only tested when the segment crosses cells partially filled.
+//
+bool BulletPhysics::TestLineOfSight(const Vector3<float>& origin, const Vector3<float>& end)
+{
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	btVector3 from = Vector3TobtVector3(origin);
+	btVector3 to = Vector3TobtVector3(end);
+	switch (mOcclusionGrid.TestSegment(from, to))
+	{
+		case OR_VISIBLE:
+			return true;
+		case OR_OCCLUDED:
+			return false;
+		default:
+			break;
+	}
+
+	// the level geometry is the only one without actor
+	struct LevelRayResultCallback : public btCollisionWorld::ClosestRayResultCallback
+	{
+		LevelRayResultCallback(btVector3 const & from, btVector3 const & to)
+			: btCollisionWorld::ClosestRayResultCallback(from, to)
+		{
+
+		}
+
+		virtual bool needsCollision(btBroadphaseProxy* proxy0) const
+		{
+			btCollisionObject const * const collisionObject = 
+				static_cast<btCollisionObject const *>(proxy0->m_clientObject);
+			return collisionObject->getUserIndex() <= 0 && 
+				btCollisionWorld::ClosestRayResultCallback::needsCollision(proxy0);
+		}
+	};
+
+	LevelRayResultCallback levelResults(from, to);
+	mDynamicsWorld->rayTest(from, to, levelResults);
+	return !levelResults.hasHit();
+}
+
 /////////////////////////////////////////////////////////////////////////////
 // BulletPhysics::ConvexSweep	
 ActorId BulletPhysics::ConvexSweep(
 	ActorId aId, const Transform& origin, const Transform& end,
 	Vector3<float>& collisionPoint, Vector3<float>& collisionNormal)
 {
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(aId))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+	PROFILE_COUNTER("Rays cast", 1);
+
+	if (BulletActorEntry const * const entry = mActorTable.Find(aId))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
+		if (btKinematicCharacterController* const controller = entry->mController)
 		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(aId)))
+			btVector3 from = Vector3TobtVector3(origin.GetTranslation());
+			btVector3 to = Vector3TobtVector3(end.GetTranslation());
+			btCollisionWorld::ClosestConvexResultCallback closestResults(from, to);
+			btConvexShape* collisionShape = static_cast<btConvexShape*>(entry->mCollisionObject->getCollisionShape());
+
+			controller->getGhostObject()->convexSweepTest(
+				collisionShape, TransformTobtTransform(origin), TransformTobtTransform(end), closestResults);
+			if (closestResults.hasHit())
 			{
-				btVector3 from = Vector3TobtVector3(origin.GetTranslation());
-				btVector3 to = Vector3TobtVector3(end.GetTranslation());
-				btCollisionWorld::ClosestConvexResultCallback closestResults(from, to);
-				btConvexShape* collisionShape = dynamic_cast<btConvexShape*>(collisionObject->getCollisionShape());
-
-				controller->getGhostObject()->convexSweepTest(
-					collisionShape, TransformTobtTransform(origin), TransformTobtTransform(end), closestResults);
-				if (closestResults.hasHit())
-				{
-					collisionPoint = btVector3ToVector3(closestResults.m_hitPointWorld);
-					collisionNormal = btVector3ToVector3(closestResults.m_hitNormalWorld);
-					return FindActorID(closestResults.m_hitCollisionObject);
-				}
+				collisionPoint = btVector3ToVector3(closestResults.m_hitPointWorld);
+				collisionNormal = btVector3ToVector3(closestResults.m_hitNormalWorld);
+				return FindActorID(closestResults.m_hitCollisionObject);
 			}
 		}
-		else
+		else if (entry->mRigidBody && entry->mRigidBody->getCollisionShape()->isConvex())
 		{
 			btVector3 from = Vector3TobtVector3(origin.GetTranslation());
 			btVector3 to = Vector3TobtVector3(end.GetTranslation());
 			btCollisionWorld::ClosestConvexResultCallback closestResults(from, to);
-			btConvexShape* collisionShape = dynamic_cast<btConvexShape*>(collisionObject->getCollisionShape());
+			btConvexShape* collisionShape = static_cast<btConvexShape*>(entry->mRigidBody->getCollisionShape());
 
 			mDynamicsWorld->convexSweepTest(
 				collisionShape, TransformTobtTransform(origin), TransformTobtTransform(end), closestResults);
@@ -1340,25 +2219,21 @@ ActorId BulletPhysics::ConvexSweep(
 //
 Vector3<float> BulletPhysics::GetCenter(ActorId actorId)
 {
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (BulletActorEntry const * const entry = mActorTable.Find(actorId))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
+		if (btKinematicCharacterController* const controller = entry->mController)
 		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(actorId)))
-			{
-				btCollisionShape* collisionShape = controller->getGhostObject()->getCollisionShape();
+			btCollisionShape* collisionShape = controller->getGhostObject()->getCollisionShape();
 
-				btVector3 aabbMin, aabbMax;
-				collisionShape->getAabb(controller->getGhostObject()->getWorldTransform(), aabbMin, aabbMax);
-				btVector3 const aabbCenter = aabbMin + (aabbMax - aabbMin) / 2.f;
-				return btVector3ToVector3(aabbCenter);
-			}
+			btVector3 aabbMin, aabbMax;
+			collisionShape->getAabb(controller->getGhostObject()->getWorldTransform(), aabbMin, aabbMax);
+			btVector3 const aabbCenter = aabbMin + (aabbMax - aabbMin) / 2.f;
+			return btVector3ToVector3(aabbCenter);
 		}
-		else
+		else if (btRigidBody* const rigidBody = entry->mRigidBody)
 		{
-			btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(collisionObject);
-
 			btVector3 aabbMin, aabbMax;
 			rigidBody->getAabb(aabbMin, aabbMax);
 			btVector3 const aabbCenter = aabbMin + (aabbMax - aabbMin) / 2.f;
@@ -1373,25 +2248,21 @@ Vector3<float> BulletPhysics::GetCenter(ActorId actorId)
 //
 Vector3<float> BulletPhysics::GetScale(ActorId actorId)
 {
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (BulletActorEntry const * const entry = mActorTable.Find(actorId))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
+		if (btKinematicCharacterController* const controller = entry->mController)
 		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(actorId)))
-			{
-				btCollisionShape* collisionShape = controller->getGhostObject()->getCollisionShape();
+			btCollisionShape* collisionShape = controller->getGhostObject()->getCollisionShape();
 
-				btVector3 aabbMin, aabbMax;
-				collisionShape->getAabb(controller->getGhostObject()->getWorldTransform(), aabbMin, aabbMax);
-				btVector3 const aabbExtents = aabbMax - aabbMin;
-				return btVector3ToVector3(aabbExtents);
-			}
+			btVector3 aabbMin, aabbMax;
+			collisionShape->getAabb(controller->getGhostObject()->getWorldTransform(), aabbMin, aabbMax);
+			btVector3 const aabbExtents = aabbMax - aabbMin;
+			return btVector3ToVector3(aabbExtents);
 		}
-		else
+		else if (btRigidBody* const rigidBody = entry->mRigidBody)
 		{
-			btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(collisionObject);
-
 			btVector3 aabbMin, aabbMax;
 			rigidBody->getAabb(aabbMin, aabbMax);
 			btVector3 const aabbExtents = aabbMax - aabbMin;
@@ -1406,20 +2277,17 @@ Vector3<float> BulletPhysics::GetScale(ActorId actorId)
 //
 Vector3<float> BulletPhysics::GetVelocity(ActorId actorId)
 {
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (BulletActorEntry const * const entry = mActorTable.Find(actorId))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
+		if (btKinematicCharacterController* const controller = entry->mController)
 		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(actorId)))
-			{
-				btVector3 btVel = controller->getLinearVelocity();
-				return btVector3ToVector3(btVel);
-			}
+			btVector3 btVel = controller->getLinearVelocity();
+			return btVector3ToVector3(btVel);
 		}
-		else
+		else if (btRigidBody* const rigidBody = entry->mRigidBody)
 		{
-			btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(collisionObject);
 			btVector3 btVel = rigidBody->getLinearVelocity();
 			return btVector3ToVector3(btVel);
 		}
@@ -1430,17 +2298,12 @@ Vector3<float> BulletPhysics::GetVelocity(ActorId actorId)
 /////////////////////////////////////////////////////////////////////////////
 float BulletPhysics::GetJumpSpeed(ActorId actorId)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	float jumpSpeed = 0;
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
+	if (btKinematicCharacterController* const controller = FindBulletCharacter(actorId))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
-		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(actorId)))
-			{
-				jumpSpeed = controller->getJumpSpeed();
-			}
-		}
+		jumpSpeed = controller->getJumpSpeed();
 	}
 	return jumpSpeed;
 }
@@ -1448,20 +2311,17 @@ float BulletPhysics::GetJumpSpeed(ActorId actorId)
 /////////////////////////////////////////////////////////////////////////////
 void BulletPhysics::SetGravity(ActorId actorId, const Vector3<float>& g)
 {
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (BulletActorEntry const * const entry = mActorTable.Find(actorId))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
+		if (btKinematicCharacterController* const controller = entry->mController)
 		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(actorId)))
-			{
-				btVector3 btGravity = Vector3TobtVector3(g);
-				controller->setGravity(btGravity);
-			}
+			btVector3 btGravity = Vector3TobtVector3(g);
+			controller->setGravity(btGravity);
 		}
-		else
+		else if (btRigidBody* const rigidBody = entry->mRigidBody)
 		{
-			btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(collisionObject);
 			btVector3 btGravity = Vector3TobtVector3(g);
 			rigidBody->setGravity(btGravity);
 		}
@@ -1471,20 +2331,17 @@ void BulletPhysics::SetGravity(ActorId actorId, const Vector3<float>& g)
 /////////////////////////////////////////////////////////////////////////////
 void BulletPhysics::SetVelocity(ActorId actorId, const Vector3<float>& vel)
 {
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (BulletActorEntry const * const entry = mActorTable.Find(actorId))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
+		if (btKinematicCharacterController* const controller = entry->mController)
 		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(actorId)))
-			{
-				btVector3 btVel = Vector3TobtVector3(vel);
-				controller->setLinearVelocity(btVel);
-			}
+			btVector3 btVel = Vector3TobtVector3(vel);
+			controller->setLinearVelocity(btVel);
 		}
-		else
+		else if (btRigidBody* const rigidBody = entry->mRigidBody)
 		{
-			btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(collisionObject);
 			btVector3 btVel = Vector3TobtVector3(vel);
 			rigidBody->setLinearVelocity(btVel);
 		}
@@ -1494,20 +2351,17 @@ void BulletPhysics::SetVelocity(ActorId actorId, const Vector3<float>& vel)
 /////////////////////////////////////////////////////////////////////////////
 Vector3<float> BulletPhysics::GetAngularVelocity(ActorId actorId)
 {
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (BulletActorEntry const * const entry = mActorTable.Find(actorId))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
+		if (btKinematicCharacterController* const controller = entry->mController)
 		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(actorId)))
-			{
-				btVector3 btVel = controller->getAngularVelocity();
-				return btVector3ToVector3(btVel);
-			}
+			btVector3 btVel = controller->getAngularVelocity();
+			return btVector3ToVector3(btVel);
 		}
-		else
+		else if (btRigidBody* const rigidBody = entry->mRigidBody)
 		{
-			btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(collisionObject);
 			btVector3 btVel = rigidBody->getAngularVelocity();
 			return btVector3ToVector3(btVel);
 		}
@@ -1518,20 +2372,17 @@ Vector3<float> BulletPhysics::GetAngularVelocity(ActorId actorId)
 /////////////////////////////////////////////////////////////////////////////
 void BulletPhysics::SetAngularVelocity(ActorId actorId, const Vector3<float>& vel)
 {
-	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (BulletActorEntry const * const entry = mActorTable.Find(actorId))
 	{
-		if (collisionObject->getCollisionFlags() & btCollisionObject::CF_CHARACTER_OBJECT)
+		if (btKinematicCharacterController* const controller = entry->mController)
 		{
-			if (btKinematicCharacterController* const controller =
-				dynamic_cast<btKinematicCharacterController*>(FindBulletAction(actorId)))
-			{
-				btVector3 btVel = Vector3TobtVector3(vel);
-				controller->setAngularVelocity(btVel);
-			}
+			btVector3 btVel = Vector3TobtVector3(vel);
+			controller->setAngularVelocity(btVel);
 		}
-		else
+		else if (btRigidBody* const rigidBody = entry->mRigidBody)
 		{
-			btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(collisionObject);
 			btVector3 btVel = Vector3TobtVector3(vel);
 			rigidBody->setAngularVelocity(btVel);
 		}
@@ -1541,7 +2392,9 @@ void BulletPhysics::SetAngularVelocity(ActorId actorId, const Vector3<float>& ve
 /////////////////////////////////////////////////////////////////////////////
 void BulletPhysics::Translate(ActorId actorId, const Vector3<float>& vec)
 {
-	if (btRigidBody* const rigidBody = dynamic_cast<btRigidBody*>(FindBulletCollisionObject(actorId)))
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	if (btRigidBody* const rigidBody = FindBulletRigidBody(actorId))
 	{
 		btVector3 btVec = Vector3TobtVector3(vec);
 		rigidBody->translate(btVec);
@@ -1552,8 +2405,10 @@ void BulletPhysics::Translate(ActorId actorId, const Vector3<float>& vec)
 // BulletPhysics::OnGround
 bool BulletPhysics::OnGround(ActorId aid)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	if (btKinematicCharacterController* const controller =
-		dynamic_cast<btKinematicCharacterController*>(FindBulletAction(aid)))
+		FindBulletCharacter(aid))
 	{
 		return controller->onGround();
 	}
@@ -1564,8 +2419,10 @@ bool BulletPhysics::OnGround(ActorId aid)
 // BulletPhysics::Jump
 void BulletPhysics::Jump(ActorId aid, const Vector3<float> &dir)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	if (btKinematicCharacterController* const controller =
-		dynamic_cast<btKinematicCharacterController*>(FindBulletAction(aid)))
+		FindBulletCharacter(aid))
 	{
 		controller->setGravity(btVector3(0.f, 0.f, 0.f));
 		controller->setFallSpeed(0.f);
@@ -1577,8 +2434,10 @@ void BulletPhysics::Jump(ActorId aid, const Vector3<float> &dir)
 // BulletPhysics::FallDirection
 void BulletPhysics::FallDirection(ActorId aid, const Vector3<float> &dir)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	if (btKinematicCharacterController* const controller =
-		dynamic_cast<btKinematicCharacterController*>(FindBulletAction(aid)))
+		FindBulletCharacter(aid))
 	{
 		controller->setGravity(Vector3TobtVector3(dir));
 		controller->setFallSpeed(Length(dir));
@@ -1589,8 +2448,10 @@ void BulletPhysics::FallDirection(ActorId aid, const Vector3<float> &dir)
 // BulletPhysics::WalkDirection
 void BulletPhysics::WalkDirection(ActorId aid, const Vector3<float> &dir)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	if (btKinematicCharacterController* const controller =
-		dynamic_cast<btKinematicCharacterController*>(FindBulletAction(aid)))
+		FindBulletCharacter(aid))
 	{
 		controller->setWalkDirection(Vector3TobtVector3(dir));
 	}
@@ -1600,6 +2461,8 @@ void BulletPhysics::WalkDirection(ActorId aid, const Vector3<float> &dir)
 // BulletPhysics::SetPosition
 void BulletPhysics::SetPosition(ActorId actorId, const Vector3<float>& pos)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
 	{
 		btTransform transform = collisionObject->getWorldTransform();
@@ -1612,6 +2475,8 @@ void BulletPhysics::SetPosition(ActorId actorId, const Vector3<float>& pos)
 // BulletPhysics::SetRotation
 void BulletPhysics::SetRotation(ActorId actorId, const Transform& mat)
 {
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
 	if (btCollisionObject * const collisionObject = FindBulletCollisionObject(actorId))
 	{
 		btTransform transform = TransformTobtTransform(mat);
@@ -1621,6 +2486,57 @@ void BulletPhysics::SetRotation(ActorId actorId, const Transform& mat)
 }
 
 /////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::CreateState					- not described in the book
+//
+eastl::shared_ptr<BasePhysicState> BulletPhysics::CreateState()
+{
+	return eastl::shared_ptr<BasePhysicState>(new BulletPhysicState());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::CaptureState					- not described in the book
+//
+//    Copies the simulation state of the actors into the physic state. The
+//    actors without physics objects are ignored.
+//
+void BulletPhysics::CaptureState(const eastl::vector<ActorId>& actors, BasePhysicState& state)
+{
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	BulletPhysicState& physicState = static_cast<BulletPhysicState&>(state);
+	physicState.Clear();
+	for (ActorId actorId : actors)
+	{
+		BulletActorEntry const * const entry = mActorTable.Find(actorId);
+		if (entry)
+			physicState.Capture(actorId, entry->mCollisionObject, entry->mController);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysics::RestoreState					- not described in the book
+//
+//    Puts the captured actors back in the state they had when the physic
+//    state was captured
+//
+void BulletPhysics::RestoreState(const BasePhysicState& state)
+{
+	std::lock_guard<std::recursive_mutex> lock(mWorldMutex);
+
+	BulletPhysicState const & physicState = static_cast<BulletPhysicState const &>(state);
+	for (int actorIdx = 0; actorIdx < physicState.mActors.size(); ++actorIdx)
+	{
+		BulletActorState const & actorState = physicState.mActors[actorIdx];
+		BulletActorEntry const * const entry = mActorTable.Find(actorState.mActorId);
+		if (entry)
+		{
+			physicState.Restore(actorState, 
+				entry->mCollisionObject, entry->mController, mDynamicsWorld);
+		}
+	}
+}
+
+/////
 // BulletPhysics::BulletInternalTickCallback		- Chapter 17, page 606
 //
 // This function is called after bullet performs its internal update.  We
@@ -1633,7 +2549,10 @@ void BulletPhysics::BulletInternalTickCallback(btDynamicsWorld * const world, bt
 	LogAssert( world->getWorldUserInfo(), "no world user info" );
 	BulletPhysics * const bulletPhysics = static_cast<BulletPhysics*>( world->getWorldUserInfo() );
 	
-	CollisionPairs currentTickCollisionPairs;
+	// the buffer of the current tick keeps its capacity from earlier ticks
+	CollisionPairs& currentTickCollisionPairs = bulletPhysics->mCurrentTickCollisionPairs;
+	CollisionPairs& previousTickCollisionPairs = bulletPhysics->mPreviousTickCollisionPairs;
+	currentTickCollisionPairs.clear();
 	
 	// look at all existing contacts
 	btDispatcher * const dispatcher = world->getDispatcher();
@@ -1660,36 +2579,66 @@ void BulletPhysics::BulletInternalTickCallback(btDynamicsWorld * const world, bt
 		btRigidBody const * const sortedBodyA = swapped ? body1 : body0;
 		btRigidBody const * const sortedBodyB = swapped ? body0 : body1;
 		
-		CollisionPair const thisPair = eastl::make_pair( sortedBodyA, sortedBodyB );
-		currentTickCollisionPairs.insert( thisPair );
-		
-		if ( bulletPhysics->mPreviousTickCollisionPairs.find( thisPair ) == bulletPhysics->mPreviousTickCollisionPairs.end() )
+		currentTickCollisionPairs.push_back( CollisionPair( sortedBodyA, sortedBodyB, manifold ) );
+	}
+	
+	// several manifolds may belong to the same pair, the stable sort keeps the first one.
+	//   eastl::stable_sort would allocate its merge buffer on every substep
+	CollisionPairs& sortCollisionPairs = bulletPhysics->mSortCollisionPairs;
+	sortCollisionPairs.resize( currentTickCollisionPairs.size() );
+	eastl::merge_sort_buffer( currentTickCollisionPairs.begin(), currentTickCollisionPairs.end(),
+		sortCollisionPairs.data() );
+	currentTickCollisionPairs.erase( eastl::unique( 
+		currentTickCollisionPairs.begin(), currentTickCollisionPairs.end() ), currentTickCollisionPairs.end() );
+	
+	// merge both sorted ticks to find the contacts which are new and the ones that
+	//   existed during the previous tick but not any more
+	CollisionPairs& addedCollisionPairs = bulletPhysics->mAddedCollisionPairs;
+	CollisionPairs& removedCollisionPairs = bulletPhysics->mRemovedCollisionPairs;
+	addedCollisionPairs.clear();
+	removedCollisionPairs.clear();
+	
+	CollisionPairs::const_iterator previousIt = previousTickCollisionPairs.begin();
+	CollisionPairs::const_iterator previousEnd = previousTickCollisionPairs.end();
+	CollisionPairs::const_iterator currentIt = currentTickCollisionPairs.begin();
+	CollisionPairs::const_iterator currentEnd = currentTickCollisionPairs.end();
+	while ( previousIt != previousEnd || currentIt != currentEnd )
+	{
+		if ( currentIt == currentEnd || (previousIt != previousEnd && *previousIt < *currentIt) )
 		{
-			// this is a new contact, which wasn't in our list before.  send an event to the game.
-			bulletPhysics->SendCollisionPairAddEvent( manifold, body0, body1 );
+			removedCollisionPairs.push_back( *previousIt );
+			++previousIt;
+		}
+		else if ( previousIt == previousEnd || *currentIt < *previousIt )
+		{
+			addedCollisionPairs.push_back( *currentIt );
+			++currentIt;
+		}
+		else
+		{
+			++previousIt;
+			++currentIt;
 		}
 	}
 	
-	CollisionPairs removedCollisionPairs;
+	// the current tick becomes the previous tick.  this is the way of all things.
+	previousTickCollisionPairs.swap( currentTickCollisionPairs );
 	
-	// use the STL set difference function to find collision pairs that existed during the previous tick but not any more
-	eastl::set_difference( 
-		bulletPhysics->mPreviousTickCollisionPairs.begin(), 
-		bulletPhysics->mPreviousTickCollisionPairs.end(),
-		currentTickCollisionPairs.begin(), currentTickCollisionPairs.end(),
-		eastl::inserter( removedCollisionPairs, removedCollisionPairs.begin() ) );
+	for ( CollisionPairs::const_iterator it = addedCollisionPairs.begin(), 
+         end = addedCollisionPairs.end(); it != end; ++it )
+	{
+		// this is a new contact, which wasn't in our list before.  send an event to the game.
+		btPersistentManifold const * const manifold = it->mManifold;
+		bulletPhysics->SendCollisionPairAddEvent( manifold, 
+			static_cast<btRigidBody const *>(manifold->getBody0()),
+			static_cast<btRigidBody const *>(manifold->getBody1()) );
+	}
 	
 	for ( CollisionPairs::const_iterator it = removedCollisionPairs.begin(), 
          end = removedCollisionPairs.end(); it != end; ++it )
 	{
-		btRigidBody const * const body0 = it->first;
-		btRigidBody const * const body1 = it->second;
-		
-		bulletPhysics->SendCollisionPairRemoveEvent( body0, body1 );
+		bulletPhysics->SendCollisionPairRemoveEvent( it->mBodyA, it->mBodyB );
 	}
-	
-	// the current tick becomes the previous tick.  this is the way of all things.
-	bulletPhysics->mPreviousTickCollisionPairs = currentTickCollisionPairs;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -1718,7 +2667,7 @@ void BulletPhysics::SendCollisionPairAddEvent( btPersistentManifold const * mani
 		int const triggerId = *static_cast<int*>(triggerBody->getUserPointer());
         eastl::shared_ptr<EventDataPhysTriggerEnter> pEvent(
 			new EventDataPhysTriggerEnter(triggerId, FindActorID(otherBody)));
-		BaseEventManager::Get()->TriggerEvent(pEvent);
+		SendPhysicEvent(pEvent);
 	}
 	else
 	{
@@ -1750,7 +2699,7 @@ void BulletPhysics::SendCollisionPairAddEvent( btPersistentManifold const * mani
 		// send the event for the game
         eastl::shared_ptr<EventDataPhysCollision> pEvent(
 			new EventDataPhysCollision(id0, id1, sumNormalForce, sumFrictionForce, collisionPoints));
-		BaseEventManager::Get()->TriggerEvent(pEvent);
+		SendPhysicEvent(pEvent);
 	}
 }
 
@@ -1778,7 +2727,7 @@ void BulletPhysics::SendCollisionPairRemoveEvent(
 		int const triggerId = *static_cast<int*>(triggerBody->getUserPointer());
         eastl::shared_ptr<EventDataPhysTriggerLeave> pEvent(
 			new EventDataPhysTriggerLeave(triggerId, FindActorID( otherBody)));
-		BaseEventManager::Get()->TriggerEvent(pEvent);
+		SendPhysicEvent(pEvent);
 	}
 	else
 	{
@@ -1793,7 +2742,7 @@ void BulletPhysics::SendCollisionPairRemoveEvent(
 		}
 
         eastl::shared_ptr<EventDataPhysSeparation> pEvent(new EventDataPhysSeparation(id0, id1));
-		BaseEventManager::Get()->TriggerEvent(pEvent);
+		SendPhysicEvent(pEvent);
 	}
 }
 
@@ -50,6 +50,20 @@
 #include "Mathematic/Algebra/Vector3.h"
 #include "Mathematic/Geometric/Hyperplane.h"
 
+/////////////////////////////////////////////////////////////////////////////
+// class BasePhysicState
+//
+//   Copy of the simulation state of a group of physics actors. It is used
+//   to run "what if" simulations on the physics world and to put the world
+//   back as it was afterwards. The same state can be captured many times
+//   without allocating memory once it has grown to the number of actors.
+/////////////////////////////////////////////////////////////////////////////
+class BasePhysicState
+{
+public:
+	virtual ~BasePhysicState() { };
+};
+
 /////////////////////////////////////////////////////////////////////////////
 // class BaseGamePhysic							- Chapter 17, page 589
 //
@@ -63,6 +77,7 @@ public:
 	virtual bool Initialize() = 0;
 	virtual void SyncVisibleScene() = 0;
 	virtual void OnUpdate(float deltaSeconds) = 0;
+	virtual void StepSimulation(float deltaSeconds) = 0;
 
 	// Initialization of Physics Objects
 	virtual void AddTrigger(const Vector3<float>& dimensions, 
@@ -113,6 +128,7 @@ public:
 		eastl::vector<ActorId>& collisionActors,
 		eastl::vector<Vector3<float>>& collisionPoints,
 		eastl::vector<Vector3<float>>& collisionNormals) = 0;
+	virtual bool TestLineOfSight(const Vector3<float>& origin, const Vector3<float>& end) = 0;
 
 	virtual void SetIgnoreCollision(
 		ActorId actorId, ActorId ignoreActorId, bool ignoreCollision) = 0;
@@ -131,6 +147,11 @@ public:
 	virtual void SetTransform(const ActorId id, const Transform& mat) = 0;
 	virtual Transform GetTransform(const ActorId id) = 0;
 
+	// Physics state snapshots
+	virtual eastl::shared_ptr<BasePhysicState> CreateState() = 0;
+	virtual void CaptureState(const eastl::vector<ActorId>& actors, BasePhysicState& state) = 0;
+	virtual void RestoreState(const BasePhysicState& state) = 0;
+
 	virtual ~BaseGamePhysic() { };
 };
 
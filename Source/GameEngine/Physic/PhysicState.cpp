@@ -0,0 +1,115 @@
+//========================================================================
+// PhysicState.cpp - saves and restores the simulation state of bullet actors
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "PhysicState.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysicState::Clear						- not described in the book
+//
+void BulletPhysicState::Clear()
+{
+	mActors.resize(0);
+	mOverlappingObjects.resize(0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysicState::Capture					- not described in the book
+//
+//    Appends the simulation state of the collision object of an actor
+//
+void BulletPhysicState::Capture(ActorId actorId, btCollisionObject* collisionObject,
+	BulletCharacterController* controller)
+{
+	mActors.expand();
+	BulletActorState& actorState = mActors[mActors.size() - 1];
+	actorState.mActorId = actorId;
+	actorState.mWorldTransform = collisionObject->getWorldTransform();
+	actorState.mInterpolationWorldTransform = collisionObject->getInterpolationWorldTransform();
+	actorState.mInterpolationLinearVelocity = collisionObject->getInterpolationLinearVelocity();
+	actorState.mInterpolationAngularVelocity = collisionObject->getInterpolationAngularVelocity();
+	actorState.mActivationState = collisionObject->getActivationState();
+	actorState.mDeactivationTime = collisionObject->getDeactivationTime();
+	actorState.mOverlapOffset = mOverlappingObjects.size();
+	actorState.mOverlapCount = 0;
+
+	if (controller)
+	{
+		controller->SaveState(actorState.mCharacter);
+
+		btAlignedObjectArray<btCollisionObject*>& overlaps =
+			controller->getGhostObject()->getOverlappingPairs();
+		for (int i = 0; i < overlaps.size(); ++i)
+			mOverlappingObjects.push_back(overlaps[i]);
+		actorState.mOverlapCount = overlaps.size();
+	}
+	else if (btRigidBody* const rigidBody = btRigidBody::upcast(collisionObject))
+	{
+		actorState.mLinearVelocity = rigidBody->getLinearVelocity();
+		actorState.mAngularVelocity = rigidBody->getAngularVelocity();
+		actorState.mGravity = rigidBody->getGravity();
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// BulletPhysicState::Restore					- not described in the book
+//
+//    Puts the collision object of an actor back in the captured state
+//
+void BulletPhysicState::Restore(BulletActorState const & actorState, btCollisionObject* collisionObject,
+	BulletCharacterController* controller, btCollisionWorld* world) const
+{
+	collisionObject->setWorldTransform(actorState.mWorldTransform);
+	collisionObject->setInterpolationWorldTransform(actorState.mInterpolationWorldTransform);
+	collisionObject->setInterpolationLinearVelocity(actorState.mInterpolationLinearVelocity);
+	collisionObject->setInterpolationAngularVelocity(actorState.mInterpolationAngularVelocity);
+	collisionObject->forceActivationState(actorState.mActivationState);
+	collisionObject->setDeactivationTime(actorState.mDeactivationTime);
+
+	if (controller)
+	{
+		controller->RestoreState(actorState.mCharacter);
+
+		// remove the overlaps which didn't exist and add back the lost ones
+		btPairCachingGhostObject* const ghostObject = controller->getGhostObject();
+		btAlignedObjectArray<btCollisionObject*>& overlaps = ghostObject->getOverlappingPairs();
+		btCollisionObject* const * const savedOverlaps =
+			mOverlappingObjects.size() ? &mOverlappingObjects[actorState.mOverlapOffset] : NULL;
+		for (int i = overlaps.size() - 1; i >= 0; --i)
+		{
+			btCollisionObject* const overlap = overlaps[i];
+			if (eastl::find(savedOverlaps, savedOverlaps + actorState.mOverlapCount, overlap) ==
+				savedOverlaps + actorState.mOverlapCount)
+			{
+				ghostObject->removeOverlappingObjectInternal(
+					overlap->getBroadphaseHandle(), world->getDispatcher(), ghostObject->getBroadphaseHandle());
+			}
+		}
+		for (int i = 0; i < actorState.mOverlapCount; ++i)
+		{
+			if (overlaps.findLinearSearch(savedOverlaps[i]) == overlaps.size())
+			{
+				ghostObject->addOverlappingObjectInternal(
+					savedOverlaps[i]->getBroadphaseHandle(), ghostObject->getBroadphaseHandle());
+			}
+		}
+
+		// same objects, keep also the order in which they were found
+		for (int i = 0; i < actorState.mOverlapCount; ++i)
+			overlaps[i] = savedOverlaps[i];
+	}
+	else if (btRigidBody* const rigidBody = btRigidBody::upcast(collisionObject))
+	{
+		rigidBody->setLinearVelocity(actorState.mLinearVelocity);
+		rigidBody->setAngularVelocity(actorState.mAngularVelocity);
+		rigidBody->setGravity(actorState.mGravity);
+		if (rigidBody->getMotionState())
+			rigidBody->getMotionState()->setWorldTransform(actorState.mWorldTransform);
+	}
+
+	// the broadphase must see the object where it was
+	world->updateSingleAabb(collisionObject);
+}
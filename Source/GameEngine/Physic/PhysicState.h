@@ -0,0 +1,169 @@
+//========================================================================
+// PhysicState.h - saves and restores the simulation state of bullet actors
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#ifndef PHYSICSTATE_H
+#define PHYSICSTATE_H
+
+#include "GameEngineStd.h"
+
+#include "Physic.h"
+
+#include "btBulletDynamicsCommon.h"
+#include "BulletCollision/CollisionDispatch/btGhostObject.h"
+#include "BulletDynamics/Character/btKinematicCharacterController.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// class BulletCharacterController				- not described in the book
+//
+//   Kinematic character controller which can save and restore the internal
+//   state that bullet changes during the simulation steps.
+//
+ATTRIBUTE_ALIGNED16(class) BulletCharacterController : public btKinematicCharacterController
+{
+public:
+	BT_DECLARE_ALIGNED_ALLOCATOR();
+
+	ATTRIBUTE_ALIGNED16(struct) State
+	{
+		btVector3 mWalkDirection;
+		btVector3 mNormalizedDirection;
+		btVector3 mAngularVelocity;
+		btVector3 mJumpPosition;
+		btVector3 mJumpAxis;
+		btVector3 mCurrentPosition;
+		btVector3 mTargetPosition;
+		btVector3 mTouchingNormal;
+		btQuaternion mCurrentOrientation;
+		btQuaternion mTargetOrientation;
+
+		btScalar mVerticalVelocity;
+		btScalar mVerticalOffset;
+		btScalar mFallSpeed;
+		btScalar mJumpSpeed;
+		btScalar mSetJumpSpeed;
+		btScalar mMaxJumpHeight;
+		btScalar mGravity;
+		btScalar mCurrentStepOffset;
+		btScalar mVelocityTimeInterval;
+
+		bool mTouchingContact;
+		bool mWasOnGround;
+		bool mWasJumping;
+		bool mUseWalkDirection;
+	};
+
+	BulletCharacterController(btPairCachingGhostObject* ghostObject, btConvexShape* convexShape, btScalar stepHeight)
+		: btKinematicCharacterController(ghostObject, convexShape, stepHeight)
+	{
+
+	}
+
+	void SaveState(State& state) const
+	{
+		state.mWalkDirection = m_walkDirection;
+		state.mNormalizedDirection = m_normalizedDirection;
+		state.mAngularVelocity = m_AngVel;
+		state.mJumpPosition = m_jumpPosition;
+		state.mJumpAxis = m_jumpAxis;
+		state.mCurrentPosition = m_currentPosition;
+		state.mTargetPosition = m_targetPosition;
+		state.mTouchingNormal = m_touchingNormal;
+		state.mCurrentOrientation = m_currentOrientation;
+		state.mTargetOrientation = m_targetOrientation;
+
+		state.mVerticalVelocity = m_verticalVelocity;
+		state.mVerticalOffset = m_verticalOffset;
+		state.mFallSpeed = m_fallSpeed;
+		state.mJumpSpeed = m_jumpSpeed;
+		state.mSetJumpSpeed = m_SetjumpSpeed;
+		state.mMaxJumpHeight = m_maxJumpHeight;
+		state.mGravity = m_gravity;
+		state.mCurrentStepOffset = m_currentStepOffset;
+		state.mVelocityTimeInterval = m_velocityTimeInterval;
+
+		state.mTouchingContact = m_touchingContact;
+		state.mWasOnGround = m_wasOnGround;
+		state.mWasJumping = m_wasJumping;
+		state.mUseWalkDirection = m_useWalkDirection;
+	}
+
+	void RestoreState(State const& state)
+	{
+		m_walkDirection = state.mWalkDirection;
+		m_normalizedDirection = state.mNormalizedDirection;
+		m_AngVel = state.mAngularVelocity;
+		m_jumpPosition = state.mJumpPosition;
+		m_jumpAxis = state.mJumpAxis;
+		m_currentPosition = state.mCurrentPosition;
+		m_targetPosition = state.mTargetPosition;
+		m_touchingNormal = state.mTouchingNormal;
+		m_currentOrientation = state.mCurrentOrientation;
+		m_targetOrientation = state.mTargetOrientation;
+
+		m_verticalVelocity = state.mVerticalVelocity;
+		m_verticalOffset = state.mVerticalOffset;
+		m_fallSpeed = state.mFallSpeed;
+		m_jumpSpeed = state.mJumpSpeed;
+		m_SetjumpSpeed = state.mSetJumpSpeed;
+		m_maxJumpHeight = state.mMaxJumpHeight;
+		m_gravity = state.mGravity;
+		m_currentStepOffset = state.mCurrentStepOffset;
+		m_velocityTimeInterval = state.mVelocityTimeInterval;
+
+		m_touchingContact = state.mTouchingContact;
+		m_wasOnGround = state.mWasOnGround;
+		m_wasJumping = state.mWasJumping;
+		m_useWalkDirection = state.mUseWalkDirection;
+	}
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// class BulletPhysicState						- not described in the book
+//
+//   Simulation state of the actors captured by BulletPhysics::CaptureState.
+//   The ghost objects of the characters also keep the list of objects they
+//   were overlapping, which is stored in a single array for all actors.
+//   The state refers to the bullet objects directly, so it can only be 
+//   restored while the captured actors and their overlaps are alive.
+//   Clearing the state keeps the capacity of the arrays, so capturing the
+//   same actors again doesn't allocate.
+//
+ATTRIBUTE_ALIGNED16(struct) BulletActorState
+{
+	btTransform mWorldTransform;
+	btTransform mInterpolationWorldTransform;
+	btVector3 mLinearVelocity;
+	btVector3 mAngularVelocity;
+	btVector3 mInterpolationLinearVelocity;
+	btVector3 mInterpolationAngularVelocity;
+	btVector3 mGravity;
+	BulletCharacterController::State mCharacter;
+
+	ActorId mActorId;
+	int mActivationState;
+	btScalar mDeactivationTime;
+
+	int mOverlapOffset;
+	int mOverlapCount;
+};
+
+class BulletPhysicState : public BasePhysicState
+{
+public:
+	void Clear();
+
+	// the controller is only given for the character actors
+	void Capture(ActorId actorId, btCollisionObject* collisionObject, 
+		BulletCharacterController* controller);
+	void Restore(BulletActorState const & actorState, btCollisionObject* collisionObject,
+		BulletCharacterController* controller, btCollisionWorld* world) const;
+
+	btAlignedObjectArray<BulletActorState> mActors;
+	btAlignedObjectArray<btCollisionObject*> mOverlappingObjects;
+};
+
+#endif
@@ -88,72 +88,58 @@ eastl::shared_ptr<Actor> QuakeLogic::GetRandomActor()
 
 void QuakeLogic::GetAmmoActors(eastl::vector<eastl::shared_ptr<Actor>>& ammo)
 {
-	for (auto actor : mActors)
-	{
-		eastl::shared_ptr<Actor> pActor = actor.second;
-		if (pActor->GetType() == "Ammo")
-			ammo.push_back(pActor);
-	}
+	static ActorTypeId const type = ActorRegistry::GetTypeId("Ammo");
+
+	ActorRegistry::ActorList const& actors = mActorRegistry.GetActors(type);
+	ammo.insert(ammo.end(), actors.begin(), actors.end());
 }
 
 void QuakeLogic::GetArmorActors(eastl::vector<eastl::shared_ptr<Actor>>& armor)
 {
-	for (auto actor : mActors)
-	{
-		eastl::shared_ptr<Actor> pActor = actor.second;
-		if (pActor->GetType() == "Armor")
-			armor.push_back(pActor);
-	}
+	static ActorTypeId const type = ActorRegistry::GetTypeId("Armor");
+
+	ActorRegistry::ActorList const& actors = mActorRegistry.GetActors(type);
+	armor.insert(armor.end(), actors.begin(), actors.end());
 }
 
 void QuakeLogic::GetWeaponActors(eastl::vector<eastl::shared_ptr<Actor>>& weapon)
 {
-	for (auto actor : mActors)
-	{
-		eastl::shared_ptr<Actor> pActor = actor.second;
-		if (pActor->GetType() == "Weapon")
-			weapon.push_back(pActor);
-	}
+	static ActorTypeId const type = ActorRegistry::GetTypeId("Weapon");
+
+	ActorRegistry::ActorList const& actors = mActorRegistry.GetActors(type);
+	weapon.insert(weapon.end(), actors.begin(), actors.end());
 }
 
 void QuakeLogic::GetHealthActors(eastl::vector<eastl::shared_ptr<Actor>>& health)
 {
-	for (auto actor : mActors)
-	{
-		eastl::shared_ptr<Actor> pActor = actor.second;
-		if (pActor->GetType() == "Health")
-			health.push_back(pActor);
-	}
+	static ActorTypeId const type = ActorRegistry::GetTypeId("Health");
+
+	ActorRegistry::ActorList const& actors = mActorRegistry.GetActors(type);
+	health.insert(health.end(), actors.begin(), actors.end());
 }
 
 void QuakeLogic::GetPlayerActors(eastl::vector<eastl::shared_ptr<PlayerActor>>& player)
 {
-	for (auto actor : mActors)
-	{
-		eastl::shared_ptr<Actor> pActor = actor.second;
-		if (pActor->GetType() == "Player")
-			player.push_back(eastl::dynamic_shared_pointer_cast<PlayerActor>(pActor));
-	}
+	static ActorTypeId const type = ActorRegistry::GetTypeId("Player");
+
+	for (eastl::shared_ptr<Actor> const& pActor : mActorRegistry.GetActors(type))
+		player.push_back(eastl::dynamic_shared_pointer_cast<PlayerActor>(pActor));
 }
 
 void QuakeLogic::GetTriggerActors(eastl::vector<eastl::shared_ptr<Actor>>& trigger)
 {
-	for (auto actor : mActors)
-	{
-		eastl::shared_ptr<Actor> pActor = actor.second;
-		if (pActor->GetType() == "Trigger")
-			trigger.push_back(pActor);
-	}
+	static ActorTypeId const type = ActorRegistry::GetTypeId("Trigger");
+
+	ActorRegistry::ActorList const& actors = mActorRegistry.GetActors(type);
+	trigger.insert(trigger.end(), actors.begin(), actors.end());
 }
 
 void QuakeLogic::GetTargetActors(eastl::vector<eastl::shared_ptr<Actor>>& target)
 {
-	for (auto actor : mActors)
-	{
-		eastl::shared_ptr<Actor> pActor = actor.second;
-		if (pActor->GetType() == "Target")
-			target.push_back(pActor);
-	}
+	static ActorTypeId const type = ActorRegistry::GetTypeId("Target");
+
+	ActorRegistry::ActorList const& actors = mActorRegistry.GetActors(type);
+	target.insert(target.end(), actors.begin(), actors.end());
 }
 
 //
@@ -472,7 +458,10 @@ void QuakeLogic::TeleportActorDelegate(BaseEventDataPtr pEventData)
 		eastl::shared_ptr<TransformComponent> pTransformComponent =
 			pPlayerActor->GetComponent<TransformComponent>(TransformComponent::Name).lock();
 		if (pTransformComponent)
+		{
 			pTransformComponent->SetTransform(pTeleporterTrigger->GetTarget());
+			mActorGrid.Move(pPlayerActor->GetId(), pTransformComponent->GetPosition());
+		}
 
 		eastl::shared_ptr<PhysicComponent> pPhysicalComponent =
 			pPlayerActor->GetComponent<PhysicComponent>(PhysicComponent::Name).lock();
@@ -524,6 +513,7 @@ void QuakeLogic::SpawnActorDelegate(BaseEventDataPtr pEventData)
 		{
 			SelectSpawnPoint(pTransformComponent->GetTransform().GetTranslation(), spawnTransform);
 			pTransformComponent->SetTransform(spawnTransform);
+			mActorGrid.Move(pPlayerActor->GetId(), pTransformComponent->GetPosition());
 
 			QuakeAIManager* aiManager =
 				dynamic_cast<QuakeAIManager*>(GameLogic::Get()->GetAIManager());
@@ -1036,7 +1026,7 @@ eastl::shared_ptr<PlayerActor> QuakeLogic::CreatePlayerActor(const eastl::string
 		ToWideString(actorResource.c_str()).c_str(), overrides, initialTransform, serversActorId);
 	if (pActor)
 	{
-		mActors.insert(eastl::make_pair(pActor->GetId(), pActor));
+		AddActor(pActor);
 		if (!mIsProxy && (mGameState == BGS_SPAWNINGPLAYERACTORS || mGameState == BGS_RUNNING))
 		{
 			eastl::shared_ptr<EventDataRequestNewActor> pNewActor(
@@ -1844,10 +1834,12 @@ bool QuakeLogic::RadiusDamage(float damage, float radius, int mod,
 	if (radius < 1)
 		radius = 1;
 
-	for (ActorMap::const_iterator it = mActors.begin(); it != mActors.end(); ++it)
+	eastl::vector<ActorId> actors;
+	mActorGrid.Query(origin, radius, actors);
+	for (ActorId actorId : actors)
 	{
 		eastl::shared_ptr<PlayerActor> playerActor =
-			eastl::dynamic_shared_pointer_cast<PlayerActor>((*it).second);
+			eastl::dynamic_shared_pointer_cast<PlayerActor>(GetActor(actorId).lock());
 		if (playerActor)
 		{
 			if (!playerActor->GetState().takeDamage)
@@ -2639,12 +2631,18 @@ void QuakeLogic::FireWeaponDelegate(BaseEventDataPtr pEventData)
 }
 
 
+const ActorRegistry::ActorList& QuakeLogic::GetSpawnPointActors()
+{
+	static ComponentId const locationTarget = ActorComponent::GetIdFromName(LocationTarget::Name);
+	return mActorRegistry.GetActorsWithComponent(locationTarget);
+}
+
 bool QuakeLogic::SpotTelefrag(const eastl::shared_ptr<Actor>& spot)
 {
-	for (ActorMap::const_iterator it = mActors.begin(); it != mActors.end(); ++it)
+	eastl::vector<eastl::shared_ptr<PlayerActor>> playerActors;
+	GetPlayerActors(playerActors);
+	for (eastl::shared_ptr<PlayerActor> const& playerActor : playerActors)
 	{
-		eastl::shared_ptr<PlayerActor> playerActor = 
-			eastl::dynamic_shared_pointer_cast<PlayerActor>((*it).second);
 		if (playerActor)
 		{
 			eastl::shared_ptr<TransformComponent> pTransformComponent(
@@ -2663,23 +2661,18 @@ bool QuakeLogic::SpotTelefrag(const eastl::shared_ptr<Actor>& spot)
 void QuakeLogic::SelectNearestSpawnPoint(const Vector3<float>& from, eastl::shared_ptr<Actor>& nearestSpot)
 {
 	float nearestDist = 999999;
-	eastl::shared_ptr<Actor> spot = NULL;
-	for (ActorMap::const_iterator it = mActors.begin(); it != mActors.end(); ++it)
+	for (eastl::shared_ptr<Actor> const& spot : GetSpawnPointActors())
 	{
-		spot = (*it).second;
-		if (spot->GetComponent<LocationTarget>(LocationTarget::Name).lock())
+		eastl::shared_ptr<TransformComponent> pTransformComponent(
+			spot->GetComponent<TransformComponent>(TransformComponent::Name).lock());
+		if (pTransformComponent)
 		{
-			eastl::shared_ptr<TransformComponent> pTransformComponent(
-				spot->GetComponent<TransformComponent>(TransformComponent::Name).lock());
-			if (pTransformComponent)
+			Vector3<float> delta = pTransformComponent->GetPosition() - from;
+			float dist = Length(delta);
+			if (dist < nearestDist)
 			{
-				Vector3<float> delta = pTransformComponent->GetPosition() - from;
-				float dist = Length(delta);
-				if (dist < nearestDist)
-				{
-					nearestDist = dist;
-					nearestSpot = spot;
-				}
+				nearestDist = dist;
+				nearestSpot = spot;
 			}
 		}
 	}
@@ -2692,18 +2685,15 @@ void QuakeLogic::SelectRandomSpawnPoint(eastl::shared_ptr<Actor>& spot)
 	eastl::shared_ptr<Actor> spots[MAX_SPAWN_POINTS];
 
 	int count = 0;
-	for (ActorMap::const_iterator it = mActors.begin(); it != mActors.end(); ++it)
+	spot = NULL;
+	for (eastl::shared_ptr<Actor> const& spawnPoint : GetSpawnPointActors())
 	{
-		spot = (*it).second;
-		if (spot->GetComponent<LocationTarget>(LocationTarget::Name).lock())
-		{
-			if (SpotTelefrag(spot))
-				continue;
+		spot = spawnPoint;
+		if (SpotTelefrag(spot))
+			continue;
 
-			spots[count] = spot;
-			count++;
-		}
-		else spot = NULL;
+		spots[count] = spot;
+		count++;
 	}
 
 	if (count)
@@ -2720,50 +2710,46 @@ void QuakeLogic::SelectRandomFurthestSpawnPoint(const Vector3<float>& avoidPoint
 	int numSpots = 0;
 	eastl::shared_ptr<Actor> spot = NULL;
 	eastl::shared_ptr<Actor> spots[64];
-	for (ActorMap::const_iterator it = mActors.begin(); it != mActors.end(); ++it)
+	for (eastl::shared_ptr<Actor> const& spawnPoint : GetSpawnPointActors())
 	{
-		spot = (*it).second;
-		if (spot->GetComponent<LocationTarget>(LocationTarget::Name).lock())
-		{
-			if (SpotTelefrag(spot))
-				continue;
+		spot = spawnPoint;
+		if (SpotTelefrag(spot))
+			continue;
 
-			eastl::shared_ptr<TransformComponent> pTransformComponent(
-				spot->GetComponent<TransformComponent>(TransformComponent::Name).lock());
-			if (pTransformComponent)
+		eastl::shared_ptr<TransformComponent> pTransformComponent(
+			spot->GetComponent<TransformComponent>(TransformComponent::Name).lock());
+		if (pTransformComponent)
+		{
+			Vector3<float> location = pTransformComponent->GetTransform().GetTranslation();
+			Vector3<float> delta = location - avoidPoint;
+			float dist = Length(delta);
+			int i;
+			for (i = 0; i < numSpots; i++)
 			{
-				Vector3<float> location = pTransformComponent->GetTransform().GetTranslation();
-				Vector3<float> delta = location - avoidPoint;
-				float dist = Length(delta);
-				int i;
-				for (i = 0; i < numSpots; i++)
+				if (dist > dists[i])
 				{
-					if (dist > dists[i])
+					if (numSpots >= 64)
+						numSpots = 64 - 1;
+					for (int j = numSpots; j > i; j--)
 					{
-						if (numSpots >= 64)
-							numSpots = 64 - 1;
-						for (int j = numSpots; j > i; j--)
-						{
-							dists[j] = dists[j - 1];
-							spots[j] = spots[j - 1];
-						}
-						dists[i] = dist;
-						spots[i] = spot;
-						numSpots++;
-						if (numSpots > 64)
-							numSpots = 64;
-						break;
+						dists[j] = dists[j - 1];
+						spots[j] = spots[j - 1];
 					}
-				}
-				if (i >= numSpots && numSpots < 64)
-				{
-					dists[numSpots] = dist;
-					spots[numSpots] = spot;
+					dists[i] = dist;
+					spots[i] = spot;
 					numSpots++;
+					if (numSpots > 64)
+						numSpots = 64;
+					break;
 				}
 			}
+			if (i >= numSpots && numSpots < 64)
+			{
+				dists[numSpots] = dist;
+				spots[numSpots] = spot;
+				numSpots++;
+			}
 		}
-		else spot = NULL;
 	}
 	if (!numSpots)
 	{
@@ -2795,19 +2781,15 @@ void QuakeLogic::SelectSpawnPoint(const Vector3<float>& avoidPoint, Transform& t
 void QuakeLogic::SelectInitialSpawnPoint(Transform& transform)
 {
 	eastl::shared_ptr<Actor> spot = NULL;
-	for (ActorMap::const_iterator it = mActors.begin(); it != mActors.end(); ++it)
+	ActorRegistry::ActorList const& spawnPoints = GetSpawnPointActors();
+	if (!spawnPoints.empty())
 	{
-		spot = (*it).second;
-		if (spot->GetComponent<LocationTarget>(LocationTarget::Name).lock())
+		spot = spawnPoints.front();
+		if (SpotTelefrag(spot))
 		{
-			if (SpotTelefrag(spot))
-			{
-				SelectSpawnPoint(Vector3<float>::Zero(), transform);
-				return;
-			}
-			break;
+			SelectSpawnPoint(Vector3<float>::Zero(), transform);
+			return;
 		}
-		else spot = NULL;
 	}
 
 	if (spot)
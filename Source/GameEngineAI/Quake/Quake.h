@@ -293,6 +293,8 @@ protected:
 
 private:
 
+	// actors with a location target, where the players spawn
+	const ActorRegistry::ActorList& GetSpawnPointActors();
 	bool SpotTelefrag(const eastl::shared_ptr<Actor>& spot);
 
 	bool RadiusDamage(float damage, float radius, int mod,
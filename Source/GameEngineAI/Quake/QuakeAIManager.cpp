@@ -9,6 +9,7 @@
 
 #include "Core/OS/OS.h"
 #include "Core/Logger/Logger.h"
+#include "Core/Profiler/Profiler.h"
 #include "Core/IO/XmlResource.h"
 #include "Core/Event/EventManager.h"
 #include "Core/Event/Event.h"
@@ -1797,8 +1798,11 @@ void QuakeAIManager::FindPath(NodeState& pNodeState,
 	eastl::map<ActorId, float>& excludeActors, float threshold)
 {
 	// find the best path using an A* search algorithm
+	PROFILE_ZONE("FindPath");
 	AIFinder aiFinder;
 	aiFinder(pNodeState, pGoalCluster, planPath, excludeActors, threshold);
+	if (!planPath.empty())
+		PROFILE_COUNTER("Paths found", 1);
 }
 
 void QuakeAIManager::OnUpdate(unsigned long deltaMs)
@@ -2428,16 +2432,7 @@ void QuakeAIManager::SimulateVisibility()
 			Vector3<float> end = visibleNode->GetPos() +
 				(float)mPlayerActor->GetState().viewHeight * Vector3<float>::Unit(YAW);
 
-			eastl::vector<ActorId> collisionActors;
-			eastl::vector<Vector3<float>> collisions, collisionNormals;
-			gamePhysics->CastRay(muzzle, end, collisionActors, collisions, collisionNormals);
-
-			Vector3<float> collision = NULL;
-			for (unsigned int i = 0; i < collisionActors.size(); i++)
-				if (collisionActors[i] == INVALID_ACTOR_ID)
-					collision = collisions[i];
-
-			if (collision == NULL)
+			if (gamePhysics->TestLineOfSight(muzzle, end))
 				pathNode->AddVisibleNode(visibleNode, Length(visibleNode->GetPos() - pathNode->GetPos()));
 		}
 	}
@@ -2567,29 +2562,24 @@ void QuakeAIManager::SimulateWaypoint()
 
 void QuakeAIManager::CreateClusters()
 {
-	eastl::vector<Point> points;
-	for (PathingNode* pathNode : mPathingGraph->GetNodes())
-	{
-		eastl::vector<float> pos{
-			pathNode->GetPos()[0], pathNode->GetPos()[1], pathNode->GetPos()[2] };
-		Point point(pathNode->GetId(), pos);
-		points.push_back(point);
-	}
-
 	//Running K-Means Clustering
 	unsigned int iters = 100;
-	KMeans kmeans(200, iters);
-	kmeans.Run(points);
-
-	for (Point point : points)
+	KMeans kmeans(200, 3, iters);
+	kmeans.Reserve((unsigned int)mPathingGraph->GetNodes().size());
+	for (PathingNode* pathNode : mPathingGraph->GetNodes())
 	{
-		PathingNode* pathNode = mPathingGraph->FindNode(point.GetId());
-		pathNode->SetCluster(point.GetCluster());
+		float pos[3] = { pathNode->GetPos()[0], pathNode->GetPos()[1], pathNode->GetPos()[2] };
+		kmeans.AddPoint(pos);
 	}
+	kmeans.Run();
+
+	unsigned int point = 0;
+	for (PathingNode* pathNode : mPathingGraph->GetNodes())
+		pathNode->SetCluster(kmeans.GetCluster(point++));
 
 	eastl::vector<unsigned short> searchClusters;
-	for (Clustering kCluster : kmeans.GetClusters())
-		searchClusters.push_back(kCluster.GetId());
+	for (unsigned short cluster = 0; cluster < kmeans.GetNumClusters(); cluster++)
+		searchClusters.push_back(cluster);
 
 	for (PathingNode* pathNode : mPathingGraph->GetNodes())
 	{
@@ -2802,7 +2792,7 @@ void QuakeAIManager::SimulateActorPosition(ActorId actorId, const Vector3<float>
 	Transform transform;
 	transform.SetTranslation(position);
 	gamePhysics->SetTransform(mPlayerActor->GetId(), transform);
-	gamePhysics->OnUpdate(0.02f);
+	gamePhysics->StepSimulation(0.02f);
 
 	transform = gamePhysics->GetTransform(mPlayerActor->GetId());
 	PathingNode* pNewNode = new PathingNode(
@@ -2820,7 +2810,7 @@ void QuakeAIManager::SimulateTriggerTeleport(PathingNode* pNode, const Vector3<f
 	Transform transform;
 	transform.SetTranslation(target);
 	gamePhysics->SetTransform(mPlayerActor->GetId(), transform);
-	gamePhysics->OnUpdate(0.02f);
+	gamePhysics->StepSimulation(0.02f);
 
 	// gravity falling simulation
 	transform = gamePhysics->GetTransform(mPlayerActor->GetId());
@@ -2843,7 +2833,7 @@ void QuakeAIManager::SimulateTriggerTeleport(PathingNode* pNode, const Vector3<f
 		direction[YAW] = -jumpSpeed * fallSpeed;
 
 		gamePhysics->FallDirection(mPlayerActor->GetId(), direction);
-		gamePhysics->OnUpdate(0.02f);
+		gamePhysics->StepSimulation(0.02f);
 
 		transform = gamePhysics->GetTransform(mPlayerActor->GetId());
 	}
@@ -2912,7 +2902,7 @@ void QuakeAIManager::SimulateTriggerPush(PathingNode* pNode, const Vector3<float
 	gamePhysics->SetTransform(mPlayerActor->GetId(), transform);
 	gamePhysics->WalkDirection(mPlayerActor->GetId(), direction);
 	gamePhysics->Jump(mPlayerActor->GetId(), direction);
-	gamePhysics->OnUpdate(0.02f);
+	gamePhysics->StepSimulation(0.02f);
 
 	// gravity falling simulation
 	transform = gamePhysics->GetTransform(mPlayerActor->GetId());
@@ -2935,7 +2925,7 @@ void QuakeAIManager::SimulateTriggerPush(PathingNode* pNode, const Vector3<float
 		direction[YAW] = -jumpSpeed * fallSpeed;
 
 		gamePhysics->FallDirection(mPlayerActor->GetId(), direction);
-		gamePhysics->OnUpdate(0.02f);
+		gamePhysics->StepSimulation(0.02f);
 
 		transform = gamePhysics->GetTransform(mPlayerActor->GetId());
 	}
@@ -3052,9 +3042,18 @@ void QuakeAIManager::SimulateMovement(PathingNode* pNode)
 	gamePhysics->SetTransform(mPlayerActor->GetId(), transform);
 	gamePhysics->SetVelocity(mPlayerActor->GetId(), Vector3<float>::Zero());
 
+	// every direction is simulated from the same player state
+	if (!mPlayerPhysicState)
+		mPlayerPhysicState = gamePhysics->CreateState();
+	mPlayerPhysicActors.resize(1);
+	mPlayerPhysicActors[0] = mPlayerActor->GetId();
+	gamePhysics->CaptureState(mPlayerPhysicActors, *mPlayerPhysicState);
+
 	// nodes closed to falling position
 	for (int angle = 0; angle < 360; angle += 5)
 	{
+		gamePhysics->RestoreState(*mPlayerPhysicState);
+
 		Matrix4x4<float> rotation = Rotation<4, float>(
 			AxisAngle<4, float>(Vector4<float>::Unit(YAW), angle * (float)GE_C_DEG_TO_RAD));
 
@@ -3096,7 +3095,7 @@ void QuakeAIManager::SimulateMovement(PathingNode* pNode)
 					direction[YAW] = -jumpSpeed * fallSpeed;
 
 					gamePhysics->FallDirection(mPlayerActor->GetId(), direction);
-					gamePhysics->OnUpdate(0.02f);
+					gamePhysics->StepSimulation(0.02f);
 
 					transform = gamePhysics->GetTransform(mPlayerActor->GetId());
 					position = transform.GetTranslation();
@@ -3129,7 +3128,7 @@ void QuakeAIManager::SimulateMovement(PathingNode* pNode)
 
 			gamePhysics->SetTransform(mPlayerActor->GetId(), transform);
 			gamePhysics->WalkDirection(mPlayerActor->GetId(), direction * mMoveSpeed);
-			gamePhysics->OnUpdate(0.02f);
+			gamePhysics->StepSimulation(0.02f);
 
 			transform = gamePhysics->GetTransform(mPlayerActor->GetId());
 			position = transform.GetTranslation();
@@ -3288,7 +3287,7 @@ void QuakeAIManager::SimulateJump(PathingNode* pNode)
 		gamePhysics->SetTransform(mPlayerActor->GetId(), transform);
 		gamePhysics->WalkDirection(mPlayerActor->GetId(), direction);
 		gamePhysics->Jump(mPlayerActor->GetId(), direction);
-		gamePhysics->OnUpdate(0.02f);
+		gamePhysics->StepSimulation(0.02f);
 
 		transform = gamePhysics->GetTransform(mPlayerActor->GetId());
 
@@ -3317,7 +3316,7 @@ void QuakeAIManager::SimulateJump(PathingNode* pNode)
 			direction[YAW] = -jumpSpeed * fallSpeed;
 
 			gamePhysics->FallDirection(mPlayerActor->GetId(), direction);
-			gamePhysics->OnUpdate(0.02f);
+			gamePhysics->StepSimulation(0.02f);
 
 			transform = gamePhysics->GetTransform(mPlayerActor->GetId());
 		}
@@ -15,6 +15,7 @@
 #include "Actors/PlayerActor.h"
 #include "Core/Event/EventManager.h"
 
+#include "Physic/Physic.h"
 #include "Physic/PhysicEventListener.h"
 #include "Mathematic/Algebra/Matrix4x4.h"
 
@@ -471,6 +472,10 @@ private:
 
 	eastl::shared_ptr<PlayerActor> mPlayerActor;
 
+	// physics state of the player at the start of a movement simulation
+	eastl::shared_ptr<BasePhysicState> mPlayerPhysicState;
+	eastl::vector<ActorId> mPlayerPhysicActors;
+
 };   // QuakeAIManager
 
 #endif
@@ -11,6 +11,7 @@
 #include "QuakeAIProcess.h"
 
 #include "Core/OS/OS.h"
+#include "Core/Profiler/Profiler.h"
 
 QuakeAIProcess::QuakeAIProcess() : RealtimeProcess()
 {
@@ -1239,12 +1240,16 @@ void QuakeAIProcess::EvaluatePlayers(NodeState& playerState, NodeState& otherPla
 
 void QuakeAIProcess::ThreadProc( )
 {
+	PROFILE_THREAD("AI");
+
 	unsigned int iteration = 0;
 
 	while (true)
 	{
 		if (GameLogic::Get()->GetState() == BGS_RUNNING)
 		{
+			PROFILE_ZONE("AI iteration");
+
 			eastl::map<GameViewType, eastl::vector<ActorId>> players;
 
 			GameApplication* gameApp = (GameApplication*)Application::App;
@@ -0,0 +1,239 @@
+//========================================================================
+// KMeansTest.cpp - clusters of the k-means and their assignment
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "AI/KMeans.h"
+
+#include "Core/Process/JobSystem.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+/*
+	Points are made from the raw output of the random engine so they are the
+	same on every platform. The assignment is checked against distances to
+	the centers computed here, which is what the SSE kernel has to match.
+*/
+static eastl::vector<float> CreatePoints(unsigned int numPoints, unsigned int dimension,
+	float range, unsigned int seed)
+{
+	std::mt19937 random(seed);
+	eastl::vector<float> values(numPoints * dimension);
+	for (float& value : values)
+		value = range * ((random() >> 8) * (1.f / 16777216.f));
+	return values;
+}
+
+static void AddPoints(KMeans& kmeans, eastl::vector<float> const& values)
+{
+	kmeans.Reserve((unsigned int)values.size() / kmeans.GetDimension());
+	for (unsigned int i = 0; i < values.size(); i += kmeans.GetDimension())
+		kmeans.AddPoint(&values[i]);
+}
+
+static float GetDistance(KMeans const& kmeans, float const* point, unsigned int cluster)
+{
+	float distance = 0.f;
+	for (unsigned int d = 0; d < kmeans.GetDimension(); d++)
+	{
+		float diff = kmeans.GetCenter(cluster, d) - point[d];
+		distance += diff * diff;
+	}
+	return distance;
+}
+
+// Counts the points which aren't in the cluster of their nearest center
+static unsigned int CountMisassigned(KMeans const& kmeans, eastl::vector<float> const& values)
+{
+	unsigned int misassigned = 0;
+	for (unsigned int i = 0; i < kmeans.GetNumPoints(); i++)
+	{
+		float const* point = &values[i * kmeans.GetDimension()];
+		float minDistance = FLT_MAX;
+		for (unsigned int c = 0; c < kmeans.GetNumClusters(); c++)
+			minDistance = eastl::min(minDistance, GetDistance(kmeans, point, c));
+
+		if (GetDistance(kmeans, point, kmeans.GetCluster(i)) > minDistance * 1.0001f)
+			misassigned++;
+	}
+	return misassigned;
+}
+
+TEST_CASE(KMeansFindsTheGroups)
+{
+	// four groups of points far apart, each of them a cluster
+	float const groups[4][3] = { { 0, 0, 0 }, { 100, 0, 0 }, { 0, 100, 0 }, { 0, 0, 100 } };
+	eastl::vector<float> values = CreatePoints(400, 3, 2.f, 7);
+	for (unsigned int i = 0; i < 400; i++)
+		for (unsigned int d = 0; d < 3; d++)
+			values[i * 3 + d] += groups[i % 4][d];
+
+	KMeans kmeans(4, 3, 100);
+	AddPoints(kmeans, values);
+	kmeans.Run();
+	TEST_CHECK(kmeans.GetNumClusters() == 4);
+
+	for (unsigned int i = 0; i < 400; i++)
+		TEST_CHECK(kmeans.GetCluster(i) == kmeans.GetCluster(i % 4));
+
+	for (unsigned int g = 0; g < 4; g++)
+	{
+		unsigned int cluster = kmeans.GetCluster(g);
+		TEST_CHECK(kmeans.GetClusterSize(cluster) == 100);
+		for (unsigned int d = 0; d < 3; d++)
+			TEST_CHECK(fabs(kmeans.GetCenter(cluster, d) - (groups[g][d] + 1.f)) < 0.5f);
+	}
+}
+
+TEST_CASE(KMeansAssignsToTheNearestCenter)
+{
+	// cluster counts which leave padding centers, and a dimension past the values
+	// broadcast once per point
+	unsigned int const dimensions[] = { 1, 3, 5, 20 };
+	for (unsigned int dimension : dimensions)
+	{
+		eastl::vector<float> values = CreatePoints(3000, dimension, 100.f, dimension);
+		KMeans kmeans(37, dimension, 1000);
+		AddPoints(kmeans, values);
+		kmeans.Run();
+
+		// a run which stopped because no point changed cluster leaves each point
+		// in the cluster of its nearest center
+		TEST_CHECK(kmeans.GetIterations() < 1000);
+		TEST_CHECK(CountMisassigned(kmeans, values) == 0);
+
+		unsigned int numPoints = 0;
+		for (unsigned int c = 0; c < kmeans.GetNumClusters(); c++)
+			numPoints += kmeans.GetClusterSize(c);
+		TEST_CHECK(numPoints == 3000);
+	}
+}
+
+TEST_CASE(KMeansFewerPointsThanClusters)
+{
+	eastl::vector<float> values = { 0.f, 0.f, 10.f, 0.f, 0.f, 10.f };
+	KMeans kmeans(10, 2, 100);
+	AddPoints(kmeans, values);
+	kmeans.Run();
+
+	TEST_CHECK(kmeans.GetNumClusters() == 3);
+	TEST_CHECK(kmeans.GetCluster(0) != kmeans.GetCluster(1));
+	TEST_CHECK(kmeans.GetCluster(1) != kmeans.GetCluster(2));
+	TEST_CHECK(kmeans.GetCluster(0) != kmeans.GetCluster(2));
+
+	KMeans empty(10, 2, 100);
+	empty.Run();
+	TEST_CHECK(empty.GetNumClusters() == 0);
+}
+
+// Counts the centers of the first run which the second doesn't have
+static unsigned int CountDifferentCenters(KMeans const& first, KMeans const& second)
+{
+	unsigned int different = 0;
+	for (unsigned int c = 0; c < first.GetNumClusters(); c++)
+	{
+		for (unsigned int d = 0; d < first.GetDimension(); d++)
+		{
+			if (first.GetCenter(c, d) != second.GetCenter(c, d))
+			{
+				different++;
+				break;
+			}
+		}
+	}
+	return different;
+}
+
+TEST_CASE(KMeansSeedIsDeterministic)
+{
+	// the same seed gives the same clusters
+	eastl::vector<float> values = CreatePoints(2000, 3, 100.f, 17);
+	KMeans first(20, 3, 100), second(20, 3, 100);
+	first.SetSeed(5);
+	second.SetSeed(5);
+	AddPoints(first, values);
+	AddPoints(second, values);
+	first.Run();
+	second.Run();
+
+	TEST_CHECK(first.GetIterations() == second.GetIterations());
+	TEST_CHECK(CountDifferentCenters(first, second) == 0);
+	unsigned int mismatches = 0;
+	for (unsigned int i = 0; i < 2000; i++)
+	{
+		if (first.GetCluster(i) != second.GetCluster(i))
+			mismatches++;
+	}
+	TEST_CHECK(mismatches == 0);
+
+	// another seed picks other initial centers, which a single iteration
+	// doesn't have the time to bring together
+	KMeans seeded(20, 3, 1), reseeded(20, 3, 1), other(20, 3, 1);
+	seeded.SetSeed(5);
+	reseeded.SetSeed(5);
+	other.SetSeed(6);
+	AddPoints(seeded, values);
+	AddPoints(reseeded, values);
+	AddPoints(other, values);
+	seeded.Run();
+	reseeded.Run();
+	other.Run();
+
+	TEST_CHECK(seeded.GetIterations() == 1 && other.GetIterations() == 1);
+	TEST_CHECK(CountDifferentCenters(seeded, reseeded) == 0);
+	TEST_CHECK(CountDifferentCenters(seeded, other) > 0);
+}
+
+TEST_CASE(KMeansParallelMatchesSerial)
+{
+	eastl::vector<float> values = CreatePoints(5000, 3, 1000.f, 11);
+	KMeans serial(50, 3, 100), parallel(50, 3, 100);
+	AddPoints(serial, values);
+	AddPoints(parallel, values);
+
+	serial.Run();
+	{
+		JobSystem jobSystem(3);
+		parallel.Run();
+	}
+
+	TEST_CHECK(serial.GetIterations() == parallel.GetIterations());
+	unsigned int mismatches = 0;
+	for (unsigned int i = 0; i < 5000; i++)
+	{
+		if (serial.GetCluster(i) != parallel.GetCluster(i))
+			mismatches++;
+	}
+	TEST_CHECK(mismatches == 0);
+}
+
+TEST_CASE(KMeansBenchmark)
+{
+	// the size of the clusters of a large pathing graph
+	unsigned int const numThreads[] = { 0, 3 };
+	eastl::vector<float> values = CreatePoints(20000, 3, 4000.f, 13);
+	for (unsigned int threads : numThreads)
+	{
+		eastl::unique_ptr<JobSystem> jobSystem;
+		if (threads)
+			jobSystem = eastl::make_unique<JobSystem>(threads);
+
+		KMeans kmeans(200, 3, 100);
+		AddPoints(kmeans, values);
+
+		auto const start = std::chrono::steady_clock::now();
+		kmeans.Run();
+		auto const end = std::chrono::steady_clock::now();
+		TEST_CHECK(kmeans.GetNumClusters() == 200);
+
+		printf("  20000 points in 200 clusters, %u workers: %.1f ms for %u iterations\n",
+			threads, std::chrono::duration<double, std::milli>(end - start).count(),
+			kmeans.GetIterations());
+	}
+}
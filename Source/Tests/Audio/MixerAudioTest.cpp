@@ -0,0 +1,325 @@
+//========================================================================
+// MixerAudioTest.cpp - voices, gains and looping of the software mixer
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Audio/MixerAudio.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+/*
+	The sounds are wav files built by the test and mixed offline with Mix, so
+	the output can be compared with the samples. The sources of the checks
+	play at the rate of the mixer, which makes the resampling an exact copy.
+*/
+static eastl::vector<char> EncodeWave(eastl::vector<short> const& samples, unsigned short channels, unsigned int rate)
+{
+	unsigned short const formatTag = 1;
+	unsigned short const bitsPerSample = 16;
+	unsigned short const blockAlign = channels * bitsPerSample / 8;
+	unsigned int const byteRate = rate * blockAlign;
+	unsigned int const formatSize = 16;
+	unsigned int const dataSize = (unsigned int)samples.size() * sizeof(short);
+	unsigned int const riffSize = 36 + dataSize;
+
+	eastl::vector<char> data(44 + dataSize);
+	char* out = data.data();
+	memcpy(out, "RIFF", 4);
+	memcpy(out + 4, &riffSize, 4);
+	memcpy(out + 8, "WAVEfmt ", 8);
+	memcpy(out + 16, &formatSize, 4);
+	memcpy(out + 20, &formatTag, 2);
+	memcpy(out + 22, &channels, 2);
+	memcpy(out + 24, &rate, 4);
+	memcpy(out + 28, &byteRate, 4);
+	memcpy(out + 32, &blockAlign, 2);
+	memcpy(out + 34, &bitsPerSample, 2);
+	memcpy(out + 36, "data", 4);
+	memcpy(out + 40, &dataSize, 4);
+	memcpy(out + 44, samples.data(), dataSize);
+	return data;
+}
+
+static eastl::shared_ptr<ResHandle> LoadWave(eastl::vector<char> raw)
+{
+	WaveResourceLoader loader;
+	unsigned int const size = loader.GetLoadedResourceSize(raw.data(), (unsigned int)raw.size());
+
+	BaseResource resource(L"sound.wav");
+	eastl::shared_ptr<ResHandle> handle = eastl::make_shared<ResHandle>(
+		resource, new char[size], size, false, ResCache::Get());
+	if (!loader.LoadResource(raw.data(), (unsigned int)raw.size(), handle))
+		return eastl::shared_ptr<ResHandle>();
+	return handle;
+}
+
+static eastl::shared_ptr<ResHandle> LoadWave(eastl::vector<short> const& samples,
+	unsigned short channels, unsigned int rate = 44100)
+{
+	return LoadWave(EncodeWave(samples, channels, rate));
+}
+
+// A buffer of the mixer, released before it is deleted the way a sound process does
+class MixerTestSound
+{
+public:
+	MixerTestSound(MixerAudio& mixer, eastl::shared_ptr<ResHandle> const& handle)
+		: mMixer(mixer), mBuffer(mixer.InitAudioBuffer(handle))
+	{
+	}
+
+	~MixerTestSound()
+	{
+		if (mBuffer)
+			mMixer.ReleaseAudioBuffer(mBuffer);
+		delete mBuffer;
+	}
+
+	BaseAudioBuffer* operator->() { return mBuffer; }
+	BaseAudioBuffer* Get() { return mBuffer; }
+
+private:
+	MixerAudio& mMixer;
+	BaseAudioBuffer* mBuffer;
+};
+
+TEST_CASE(MixerLoadsTheWave)
+{
+	ResCache cache(16, nullptr);
+	eastl::vector<short> samples = { 1, -2, 3, -4, 5, -6 };
+	eastl::shared_ptr<ResHandle> handle = LoadWave(samples, 2);
+	TEST_CHECK(handle != nullptr);
+	if (!handle)
+		return;
+
+	eastl::shared_ptr<SoundResourceExtraData> extra =
+		eastl::static_pointer_cast<SoundResourceExtraData>(handle->GetExtra());
+	TEST_CHECK(extra->GetFormat()->mFormatTag == 1);
+	TEST_CHECK(extra->GetFormat()->mChannels == 2);
+	TEST_CHECK(extra->GetFormat()->mSamplesPerSec == 44100);
+	TEST_CHECK(extra->GetFormat()->mAvgBytesPerSec == 44100 * 4);
+	TEST_CHECK(extra->GetFormat()->mBlockAlign == 4);
+	TEST_CHECK(extra->GetFormat()->mBitsPerSample == 16);
+	TEST_CHECK(handle->Size() == samples.size() * sizeof(short));
+	TEST_CHECK(memcmp(handle->Buffer(), samples.data(), handle->Size()) == 0);
+}
+
+TEST_CASE(MixerPansAndAttenuates)
+{
+	ResCache cache(16, nullptr);
+	MixerAudio mixer(eastl::make_shared<NullAudioDevice>(), 4);
+	mixer.SetReferenceDistance(10.f);
+
+	// a constant mono signal, the first block ramps the gains up from silence
+	unsigned int const block = 512;
+	eastl::vector<short> output(2 * block);
+	eastl::shared_ptr<ResHandle> handle = LoadWave(eastl::vector<short>(8 * block, 8000), 1);
+	MixerTestSound sound(mixer, handle);
+	TEST_CHECK(sound.Get() != nullptr);
+	if (!sound.Get())
+		return;
+
+	TEST_CHECK(sound->Play(100, false));
+	mixer.Mix(output.data(), block);
+	TEST_CHECK(output[0] == 0 && output[1] == 0);
+	TEST_CHECK(output[2 * block - 2] > 7900 && output[2 * block - 1] > 7900);
+
+	mixer.Mix(output.data(), block);
+	TEST_CHECK(output[0] == 8000 && output[1] == 8000);
+	TEST_CHECK(output[2 * block - 2] == 8000 && output[2 * block - 1] == 8000);
+
+	// full left, then twice the reference distance halves the gain
+	sound->SetPan(-1.f);
+	mixer.Mix(output.data(), block);
+	mixer.Mix(output.data(), block);
+	TEST_CHECK(output[0] == 8000 && output[1] == 0);
+
+	sound->SetPan(0.5f);
+	sound->SetDistance(20.f);
+	mixer.Mix(output.data(), block);
+	mixer.Mix(output.data(), block);
+	TEST_CHECK(output[0] == 2000 && output[1] == 4000);
+}
+
+TEST_CASE(MixerStealsTheLeastImportantVoice)
+{
+	ResCache cache(16, nullptr);
+	MixerAudio mixer(eastl::make_shared<NullAudioDevice>(), 2);
+	eastl::shared_ptr<ResHandle> handle = LoadWave(eastl::vector<short>(44100, 1000), 1);
+
+	MixerTestSound quiet(mixer, handle), loud(mixer, handle);
+	MixerTestSound important(mixer, handle), ignored(mixer, handle);
+	TEST_CHECK(quiet->Play(20, true));
+	TEST_CHECK(loud->Play(80, true));
+	TEST_CHECK(mixer.GetNumPlayingVoices() == 2);
+
+	// a higher priority takes the voice of the quietest sound of the lowest priority
+	important->SetPriority(1);
+	TEST_CHECK(important->Play(10, true));
+	TEST_CHECK(!quiet->IsPlaying());
+	TEST_CHECK(loud->IsPlaying() && important->IsPlaying());
+
+	// the same priority needs to be louder than the weakest voice
+	TEST_CHECK(!ignored->Play(50, true));
+	TEST_CHECK(!ignored->IsPlaying());
+	TEST_CHECK(ignored->Play(100, true));
+	TEST_CHECK(!loud->IsPlaying());
+	TEST_CHECK(important->IsPlaying());
+	TEST_CHECK(mixer.GetNumPlayingVoices() == 2);
+
+	// a stopped sound frees its voice
+	ignored->Stop();
+	TEST_CHECK(mixer.GetNumPlayingVoices() == 1);
+	TEST_CHECK(quiet->Play(20, true));
+	TEST_CHECK(mixer.GetNumPlayingVoices() == 2);
+}
+
+TEST_CASE(MixerLoopsAndEnds)
+{
+	ResCache cache(16, nullptr);
+	MixerAudio mixer(eastl::make_shared<NullAudioDevice>(), 4);
+
+	// a ramp of stereo frames, 1000 of them
+	unsigned int const numFrames = 1000;
+	eastl::vector<short> samples(2 * numFrames);
+	for (unsigned int frame = 0; frame < numFrames; ++frame)
+	{
+		samples[2 * frame] = (short)(frame * 10);
+		samples[2 * frame + 1] = (short)(-(int)frame * 10);
+	}
+	eastl::shared_ptr<ResHandle> handle = LoadWave(samples, 2);
+
+	// past the first block the output is the sound, then silence
+	{
+		MixerTestSound sound(mixer, handle);
+		TEST_CHECK(sound->Play(100, false));
+		eastl::vector<short> output(2 * 2048);
+		mixer.Mix(output.data(), 2048);
+		TEST_CHECK(!sound->IsPlaying());
+		TEST_CHECK(mixer.GetNumPlayingVoices() == 0);
+		TEST_CHECK(memcmp(output.data() + 2 * 512, samples.data() + 2 * 512, 2 * 488 * sizeof(short)) == 0);
+		for (unsigned int i = 2 * numFrames; i < output.size(); ++i)
+			TEST_CHECK(output[i] == 0);
+	}
+
+	// a looping sound wraps to the beginning and keeps its voice
+	{
+		MixerTestSound sound(mixer, handle);
+		TEST_CHECK(sound->Play(100, true));
+		eastl::vector<short> output(2 * 2560);
+		mixer.Mix(output.data(), 2560);
+		TEST_CHECK(sound->IsPlaying());
+		for (unsigned int frame = 512; frame < 2560; ++frame)
+		{
+			TEST_CHECK(output[2 * frame] == samples[2 * (frame % numFrames)]);
+			TEST_CHECK(output[2 * frame + 1] == samples[2 * (frame % numFrames) + 1]);
+		}
+
+		// a paused sound keeps its voice and is silent
+		sound->Pause();
+		mixer.Mix(output.data(), 512);
+		TEST_CHECK(sound->IsPlaying());
+		TEST_CHECK(output[0] == 0 && output[1023] == 0);
+	}
+}
+
+TEST_CASE(MixerRecordsTheWaveFile)
+{
+	// a looping 48 kHz source resampled by the mixing thread into the file
+	ResCache cache(16, nullptr);
+	char const* filename = "MixerAudioTest.wav";
+	eastl::vector<short> samples(2 * 48000);
+	for (unsigned int i = 0; i < samples.size(); ++i)
+		samples[i] = (short)((i * 7919) % 20000 - 10000);
+	eastl::shared_ptr<ResHandle> handle = LoadWave(samples, 2, 48000);
+
+	{
+		MixerAudio mixer(eastl::make_shared<WaveFileAudioDevice>(filename), 4);
+		MixerTestSound sound(mixer, handle);
+		TEST_CHECK(sound->Play(80, true));
+		TEST_CHECK(mixer.Initialize(nullptr));
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		mixer.Shutdown();
+	}
+
+	// the file is read back the way a wav resource is loaded
+	eastl::vector<char> raw;
+	{
+		std::ifstream file(filename, std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+		raw.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read(raw.data(), raw.size());
+	}
+	remove(filename);
+	eastl::shared_ptr<ResHandle> recorded = LoadWave(raw);
+	TEST_CHECK(recorded != nullptr);
+	if (!recorded)
+		return;
+
+	eastl::shared_ptr<SoundResourceExtraData> extra =
+		eastl::static_pointer_cast<SoundResourceExtraData>(recorded->GetExtra());
+	TEST_CHECK(extra->GetFormat()->mChannels == 2);
+	TEST_CHECK(extra->GetFormat()->mSamplesPerSec == 44100);
+	TEST_CHECK(recorded->Size() + 44 == raw.size());
+
+	// whole blocks were written, a few of them in 200 ms
+	unsigned int const numFrames = recorded->Size() / 4;
+	TEST_CHECK(numFrames % 512 == 0);
+	TEST_CHECK(numFrames >= 4 * 512);
+
+	// the thread mixed what an offline mix of the same sound gives
+	{
+		MixerAudio mixer(eastl::make_shared<NullAudioDevice>(), 4);
+		MixerTestSound sound(mixer, handle);
+		TEST_CHECK(sound->Play(80, true));
+
+		eastl::vector<short> output(2 * numFrames);
+		mixer.Mix(output.data(), numFrames);
+		TEST_CHECK(memcmp(output.data(), recorded->Buffer(), recorded->Size()) == 0);
+	}
+}
+
+TEST_CASE(MixerBenchmark)
+{
+	// a 48 kHz source, so every voice goes through the resampler
+	ResCache cache(16, nullptr);
+	eastl::vector<short> samples(2 * 48000);
+	for (unsigned int i = 0; i < samples.size(); ++i)
+		samples[i] = (short)((i * 7919) % 20000 - 10000);
+	eastl::shared_ptr<ResHandle> handle = LoadWave(samples, 2, 48000);
+
+	unsigned int const voices[] = { 32, 256 };
+	for (unsigned int numVoices : voices)
+	{
+		MixerAudio mixer(eastl::make_shared<NullAudioDevice>(), numVoices);
+		eastl::vector<eastl::unique_ptr<MixerTestSound>> sounds;
+		for (unsigned int v = 0; v < numVoices; ++v)
+		{
+			sounds.push_back(eastl::make_unique<MixerTestSound>(mixer, handle));
+			(*sounds.back())->SetPan(v / (float)numVoices * 2.f - 1.f);
+			(*sounds.back())->Play(50, true);
+		}
+		TEST_CHECK(mixer.GetNumPlayingVoices() == numVoices);
+
+		// ten seconds of output
+		unsigned int const block = 512;
+		unsigned int const numBlocks = 10 * 44100 / block;
+		eastl::vector<short> output(2 * block);
+		auto const start = std::chrono::steady_clock::now();
+		for (unsigned int b = 0; b < numBlocks; ++b)
+			mixer.Mix(output.data(), block);
+		auto const end = std::chrono::steady_clock::now();
+
+		double const ms = std::chrono::duration<double, std::milli>(end - start).count();
+		printf("  %u voices at 48 kHz: %.1f us per block of %u frames, %.2f%% of real time\n",
+			numVoices, 1000.0 * ms / numBlocks, block, ms / 100.0);
+	}
+}
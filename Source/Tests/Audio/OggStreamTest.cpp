@@ -0,0 +1,284 @@
+//========================================================================
+// OggStreamTest.cpp - decoded and streamed ogg sounds
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Audio/Audio.h"
+#include "Audio/SoundResource.h"
+
+#include <vorbis/vorbisenc.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+/*
+	The sounds are encoded by the test with the vorbis encoder, so no asset
+	is needed. A tone of two sines, one per channel, is easy to compare with
+	the decoded samples despite the loss of the compression.
+*/
+static short ToneSample(unsigned int frame, unsigned int channel, unsigned int rate)
+{
+	float const frequency = channel ? 660.f : 440.f;
+	return (short)(12000.f * sin(6.2831853f * frequency * frame / rate));
+}
+
+static void AppendPage(ogg_page const& page, eastl::vector<char>& data)
+{
+	data.insert(data.end(), (char*)page.header, (char*)page.header + page.header_len);
+	data.insert(data.end(), (char*)page.body, (char*)page.body + page.body_len);
+}
+
+static eastl::vector<char> EncodeTone(unsigned int frames, unsigned int rate)
+{
+	vorbis_info info;
+	vorbis_info_init(&info);
+	vorbis_encode_init_vbr(&info, 2, rate, 0.4f);
+
+	vorbis_comment comment;
+	vorbis_comment_init(&comment);
+	vorbis_dsp_state dsp;
+	vorbis_analysis_init(&dsp, &info);
+	vorbis_block block;
+	vorbis_block_init(&dsp, &block);
+	ogg_stream_state stream;
+	ogg_stream_init(&stream, 1);
+
+	eastl::vector<char> data;
+	ogg_page page;
+	ogg_packet header, headerComment, headerCode;
+	vorbis_analysis_headerout(&dsp, &comment, &header, &headerComment, &headerCode);
+	ogg_stream_packetin(&stream, &header);
+	ogg_stream_packetin(&stream, &headerComment);
+	ogg_stream_packetin(&stream, &headerCode);
+	while (ogg_stream_flush(&stream, &page))
+		AppendPage(page, data);
+
+	unsigned int const chunk = 1024;
+	for (unsigned int frame = 0;; frame += chunk)
+	{
+		// the last pass, with no frames, ends the stream
+		unsigned int const count = frame < frames ? eastl::min(chunk, frames - frame) : 0;
+		if (count)
+		{
+			float** buffer = vorbis_analysis_buffer(&dsp, count);
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				buffer[0][i] = ToneSample(frame + i, 0, rate) / 32768.f;
+				buffer[1][i] = ToneSample(frame + i, 1, rate) / 32768.f;
+			}
+		}
+		vorbis_analysis_wrote(&dsp, count);
+
+		while (vorbis_analysis_blockout(&dsp, &block) == 1)
+		{
+			vorbis_analysis(&block, NULL);
+			vorbis_bitrate_addblock(&block);
+
+			ogg_packet packet;
+			while (vorbis_bitrate_flushpacket(&dsp, &packet))
+			{
+				ogg_stream_packetin(&stream, &packet);
+				while (ogg_stream_pageout(&stream, &page))
+					AppendPage(page, data);
+			}
+		}
+		if (!count)
+			break;
+	}
+	while (ogg_stream_flush(&stream, &page))
+		AppendPage(page, data);
+
+	ogg_stream_clear(&stream);
+	vorbis_block_clear(&block);
+	vorbis_dsp_clear(&dsp);
+	vorbis_comment_clear(&comment);
+	vorbis_info_clear(&info);
+	return data;
+}
+
+/*
+	Loads the encoded data the way the resource cache does. The raw buffer is
+	discarded by the cache after the load, so it is copied here.
+*/
+static eastl::shared_ptr<ResHandle> LoadOgg(eastl::vector<char> const& data, unsigned int streamThreshold)
+{
+	OggResourceLoader loader(streamThreshold);
+	eastl::vector<char> raw(data);
+	unsigned int const size = loader.GetLoadedResourceSize(raw.data(), (unsigned int)raw.size());
+
+	BaseResource resource(L"tone.ogg");
+	eastl::shared_ptr<ResHandle> handle = eastl::make_shared<ResHandle>(
+		resource, new char[size], size, false, ResCache::Get());
+	if (!loader.LoadResource(raw.data(), (unsigned int)raw.size(), handle))
+		return eastl::shared_ptr<ResHandle>();
+	return handle;
+}
+
+static eastl::shared_ptr<SoundResourceExtraData> GetExtra(eastl::shared_ptr<ResHandle> const& handle)
+{
+	return eastl::static_pointer_cast<SoundResourceExtraData>(handle->GetExtra());
+}
+
+TEST_CASE(OggDecodesTheTone)
+{
+	ResCache cache(16, nullptr);
+	unsigned int const rate = 44100;
+	unsigned int const frames = rate;
+	eastl::vector<char> data = EncodeTone(frames, rate);
+
+	eastl::shared_ptr<ResHandle> handle = LoadOgg(data, 1024 * 1024);
+	TEST_CHECK(handle != nullptr);
+	if (!handle)
+		return;
+
+	eastl::shared_ptr<SoundResourceExtraData> extra = GetExtra(handle);
+	TEST_CHECK(!extra->IsStreaming());
+	TEST_CHECK(extra->GetFormat()->mChannels == 2);
+	TEST_CHECK(extra->GetFormat()->mSamplesPerSec == rate);
+	TEST_CHECK(handle->Size() == frames * 4);
+	TEST_CHECK(abs(extra->GetLength() - 1000) <= 1);
+
+	// the compression loses little of a pure tone
+	short const* samples = (short const*)handle->Buffer();
+	double error = 0.0, signal = 0.0;
+	for (unsigned int frame = 0; frame < frames; ++frame)
+	{
+		for (unsigned int channel = 0; channel < 2; ++channel)
+		{
+			double const expected = ToneSample(frame, channel, rate);
+			double const difference = samples[frame * 2 + channel] - expected;
+			error += difference * difference;
+			signal += expected * expected;
+		}
+	}
+	TEST_CHECK(error < 0.01 * signal);
+}
+
+TEST_CASE(OggStreamMatchesDecoded)
+{
+	ResCache cache(16, nullptr);
+	unsigned int const rate = 44100;
+	unsigned int const frames = 3 * rate;
+	eastl::vector<char> data = EncodeTone(frames, rate);
+
+	eastl::shared_ptr<ResHandle> decoded = LoadOgg(data, 1024 * 1024);
+	eastl::shared_ptr<ResHandle> streamed = LoadOgg(data, 0);
+	TEST_CHECK(decoded && streamed);
+	if (!decoded || !streamed)
+		return;
+
+	TEST_CHECK(!GetExtra(decoded)->IsStreaming());
+	TEST_CHECK(GetExtra(streamed)->IsStreaming());
+	TEST_CHECK(streamed->Size() == data.size());
+
+	char const* pcm = (char const*)decoded->Buffer();
+	unsigned int const size = decoded->Size();
+
+	// reads of odd sizes cross the decoder buffers, and the stream ends
+	// with a short read
+	{
+		OggStream stream(streamed, 4096, 4);
+		TEST_CHECK(stream.IsValid());
+		TEST_CHECK(stream.GetSize() == size);
+
+		eastl::vector<char> output(size + 1000);
+		unsigned int position = 0, read = 0, chunk = 1;
+		do
+		{
+			chunk = eastl::min(chunk, (unsigned int)output.size() - position);
+			read = stream.Read(output.data() + position, chunk);
+			position += read;
+			chunk = chunk * 3 % 5003 + 1;
+		} while (read && position < output.size());
+		TEST_CHECK(position == size);
+		TEST_CHECK(memcmp(output.data(), pcm, size) == 0);
+	}
+
+	// reads which don't wait see the same data, a short read before the end
+	// only means the decoder fell behind
+	{
+		OggStream stream(streamed, 4096, 4);
+		eastl::vector<char> output(size + 1000);
+		unsigned int position = 0;
+		bool ended = false;
+		while (!ended && position < output.size())
+		{
+			unsigned int const chunk = eastl::min(3000u, (unsigned int)output.size() - position);
+			unsigned int const read = stream.TryRead(output.data() + position, chunk, ended);
+			position += read;
+			if (read < chunk && !ended)
+				std::this_thread::yield();
+		}
+		TEST_CHECK(ended);
+		TEST_CHECK(position == size);
+		TEST_CHECK(memcmp(output.data(), pcm, size) == 0);
+	}
+
+	// the seek drops what was decoded ahead
+	{
+		OggStream stream(streamed, 4096, 4);
+		eastl::vector<char> output(8192);
+		stream.Read(output.data(), 1000);
+
+		unsigned int const seek = size / 2 + 4 * 123;
+		stream.Seek(seek);
+		TEST_CHECK(stream.Read(output.data(), 8192) == 8192);
+		TEST_CHECK(memcmp(output.data(), pcm + seek, 8192) == 0);
+	}
+
+	// a looping stream wraps to the beginning
+	{
+		OggStream stream(streamed, 4096, 4);
+		stream.SetLooping(true);
+		unsigned int const seek = size - 4000;
+		stream.Seek(seek);
+
+		eastl::vector<char> output(8000);
+		TEST_CHECK(stream.Read(output.data(), 8000) == 8000);
+		TEST_CHECK(memcmp(output.data(), pcm + seek, 4000) == 0);
+		TEST_CHECK(memcmp(output.data() + 4000, pcm, 4000) == 0);
+	}
+}
+
+TEST_CASE(OggStreamBenchmark)
+{
+	ResCache cache(64, nullptr);
+	unsigned int const rate = 44100;
+	unsigned int const frames = 30 * rate;
+	eastl::vector<char> data = EncodeTone(frames, rate);
+
+	auto const start = std::chrono::steady_clock::now();
+	eastl::shared_ptr<ResHandle> decoded = LoadOgg(data, 0xFFFFFFFF);
+	auto const middle = std::chrono::steady_clock::now();
+	eastl::shared_ptr<ResHandle> streamed = LoadOgg(data, 0);
+
+	// the stream is read the way a sound buffer refills its segments
+	unsigned int const bufferSize = 4096 * 8, numBuffers = 4;
+	unsigned int total = 0;
+	{
+		OggStream stream(streamed, bufferSize, numBuffers);
+		eastl::vector<char> segment(rate);
+		while (unsigned int read = stream.Read(segment.data(), (unsigned int)segment.size()))
+			total += read;
+	}
+	auto const end = std::chrono::steady_clock::now();
+	TEST_CHECK(decoded && total == decoded->Size());
+	if (!decoded)
+		return;
+
+	// a streamed sound holds its compressed data and the decoded buffers
+	unsigned int const resident = streamed->Size() + numBuffers * bufferSize;
+	TEST_CHECK(resident * 8 < decoded->Size());
+
+	printf("  30 s of stereo: load decoded %.1f ms (%u KB), streamed %.1f ms (%u KB resident)\n",
+		std::chrono::duration<double, std::milli>(middle - start).count(), decoded->Size() / 1024,
+		std::chrono::duration<double, std::milli>(end - middle).count(), resident / 1024);
+}
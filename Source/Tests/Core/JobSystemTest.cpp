@@ -0,0 +1,186 @@
+//========================================================================
+// JobSystemTest.cpp - dependencies, counters and waits of the job system
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Core/Process/JobSystem.h"
+
+#include <chrono>
+#include <cstdio>
+
+/*
+	The jobs record the order they ran in through atomics, the checks are made
+	on the submitting thread once the counters are done.
+*/
+static unsigned int HashWork(unsigned int value, unsigned int work)
+{
+	for (unsigned int i = 0; i < work; ++i)
+		value = value * 1664525u + 1013904223u;
+	return value;
+}
+
+TEST_CASE(JobSystemRunsDependenciesFirst)
+{
+	JobSystem jobSystem(3);
+
+	// a chain of stages, each of them waits for all the jobs of the previous
+	int const numStages = 8;
+	int const numJobs = 32;
+	std::atomic<int> finished[numStages];
+	std::atomic<int> violations(0);
+	JobCounter counters[numStages];
+	for (int s = 0; s < numStages; ++s)
+	{
+		finished[s] = 0;
+		for (int j = 0; j < numJobs; ++j)
+		{
+			auto job = [&finished, &violations, s]()
+			{
+				if (s > 0 && finished[s - 1].load() != numJobs)
+					violations++;
+				finished[s]++;
+			};
+			if (s > 0)
+				jobSystem.Submit(job, &counters[s], &counters[s - 1]);
+			else
+				jobSystem.Submit(job, &counters[s]);
+		}
+	}
+
+	jobSystem.Wait(&counters[numStages - 1]);
+	TEST_CHECK(violations.load() == 0);
+	for (int s = 0; s < numStages; ++s)
+	{
+		TEST_CHECK(counters[s].IsDone());
+		TEST_CHECK(finished[s].load() == numJobs);
+	}
+
+	// a dependency which is already done queues the job right away
+	JobCounter done, counter;
+	bool ran = false;
+	jobSystem.Submit([&ran]() { ran = true; }, &counter, &done);
+	jobSystem.Wait(&counter);
+	TEST_CHECK(ran);
+}
+
+TEST_CASE(JobSystemStackCounters)
+{
+	// the counters of ParallelFor and of each iteration live on the stack and
+	// are destroyed as soon as the wait returns, while the last job may still
+	// be leaving them
+	JobSystem jobSystem(3);
+	unsigned int mismatches = 0;
+	for (unsigned int i = 0; i < 20000; ++i)
+	{
+		std::atomic<unsigned int> sum(0);
+		jobSystem.ParallelFor(64, 1, [&sum](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int j = begin; j < end; ++j)
+				sum += j;
+		});
+		if (sum.load() != 64 * 63 / 2)
+			mismatches++;
+
+		JobCounter first, second;
+		unsigned int value = 0;
+		jobSystem.Submit([&value]() { value = 1; }, &first);
+		jobSystem.Submit([&value]() { value *= 2; }, &second, &first);
+		jobSystem.Wait(&second);
+		if (value != 2)
+			mismatches++;
+	}
+	TEST_CHECK(mismatches == 0);
+}
+
+// Sum of [begin, end), split in two jobs down to small ranges, each level
+// waiting on the jobs it submitted
+static unsigned int NestedSum(JobSystem& jobSystem, unsigned int begin, unsigned int end)
+{
+	if (end - begin <= 16)
+	{
+		unsigned int sum = 0;
+		for (unsigned int i = begin; i < end; ++i)
+			sum += i;
+		return sum;
+	}
+
+	unsigned int const middle = begin + (end - begin) / 2;
+	unsigned int left = 0, right = 0;
+	JobCounter counter;
+	jobSystem.Submit([&jobSystem, &left, begin, middle]()
+		{ left = NestedSum(jobSystem, begin, middle); }, &counter);
+	jobSystem.Submit([&jobSystem, &right, middle, end]()
+		{ right = NestedSum(jobSystem, middle, end); }, &counter);
+	jobSystem.Wait(&counter);
+	return left + right;
+}
+
+TEST_CASE(JobSystemNestedWaits)
+{
+	// the waits inside the jobs run other jobs, so even one worker which is
+	// blocked under a wait doesn't stop the recursion
+	unsigned int const numThreads[] = { 1, 3 };
+	for (unsigned int threads : numThreads)
+	{
+		JobSystem jobSystem(threads);
+		for (unsigned int run = 0; run < 20; ++run)
+			TEST_CHECK(NestedSum(jobSystem, 0, 10000) == 10000 * 9999 / 2);
+
+		// nested ParallelFor
+		std::atomic<unsigned int> count(0);
+		jobSystem.ParallelFor(16, 1, [&jobSystem, &count](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; ++i)
+			{
+				jobSystem.ParallelFor(256, 8, [&count](unsigned int begin, unsigned int end)
+				{
+					count += end - begin;
+				});
+			}
+		});
+		TEST_CHECK(count.load() == 16 * 256);
+	}
+}
+
+TEST_CASE(JobSystemBenchmark)
+{
+	// a ParallelFor over a million elements of a few hundred cycles each, run
+	// serially when there is no job system
+	unsigned int const numThreads[] = { 0, 1, 3, 7 };
+	unsigned int const count = 1 << 20;
+	eastl::vector<unsigned int> values(count), expected(count);
+	for (unsigned int i = 0; i < count; ++i)
+		expected[i] = HashWork(i, 64);
+
+	for (unsigned int threads : numThreads)
+	{
+		eastl::unique_ptr<JobSystem> jobSystem;
+		if (threads)
+			jobSystem = eastl::make_unique<JobSystem>(threads);
+
+		auto const body = [&values](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int i = begin; i < end; ++i)
+				values[i] = HashWork(i, 64);
+		};
+
+		int const runs = 10;
+		auto const start = std::chrono::steady_clock::now();
+		for (int run = 0; run < runs; ++run)
+		{
+			if (jobSystem)
+				jobSystem->ParallelFor(count, 1024, body);
+			else
+				body(0, count);
+		}
+		auto const end = std::chrono::steady_clock::now();
+		TEST_CHECK(values == expected);
+
+		printf("  %u elements, %u workers: %.2f ms per ParallelFor\n", count, threads,
+			std::chrono::duration<double, std::milli>(end - start).count() / runs);
+	}
+}
@@ -0,0 +1,188 @@
+//========================================================================
+// LoggerTest.cpp - delivery of the queued and the synchronous messages
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Core/Logger/Logger.h"
+
+#include <chrono>
+#include <cstdio>
+
+/*
+	Listener which keeps the messages it receives. The logging thread and the
+	calling threads both report, so the messages are guarded.
+*/
+class LoggerTestListener : public Logger::Listener
+{
+public:
+	LoggerTestListener(int flags) : Logger::Listener(flags)
+	{
+		Logger::Subscribe(this);
+	}
+
+	~LoggerTestListener()
+	{
+		Logger::Unsubscribe(this);
+	}
+
+	eastl::vector<eastl::string> GetMessages()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mMessages;
+	}
+
+	// index of the first message which contains the text, or -1
+	int Find(eastl::string const& text)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (unsigned int i = 0; i < mMessages.size(); ++i)
+			if (mMessages[i].find(text) != eastl::string::npos)
+				return (int)i;
+		return -1;
+	}
+
+private:
+	virtual void Report(eastl::string const& message)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mMessages.push_back(message);
+	}
+
+	std::mutex mMutex;
+	eastl::vector<eastl::string> mMessages;
+};
+
+TEST_CASE(LoggerErrorIsSynchronous)
+{
+	LoggerTestListener listener(Logger::Listener::LISTEN_FOR_ALL);
+	Logger::Start();
+
+	// the information waits in the ring, the error takes it out first
+	LogInformation("queued information");
+	LogWarning("queued warning");
+	LogError("synchronous error");
+	TEST_CHECK(listener.Find("queued information") == 0);
+	TEST_CHECK(listener.Find("queued warning") == 1);
+	TEST_CHECK(listener.Find("synchronous error") == 2);
+
+	LogAssert(1 + 1 == 3, "synchronous assertion");
+	TEST_CHECK(listener.Find("synchronous assertion") == 3);
+
+	Logger::Stop();
+	TEST_CHECK(listener.GetMessages().size() == 4);
+}
+
+TEST_CASE(LoggerThreadsKeepTheirOrder)
+{
+	LoggerTestListener listener(Logger::Listener::LISTEN_FOR_INFORMATION);
+	Logger::Start(1 << 20);
+
+	int const numThreads = 4;
+	int const numMessages = 2000;
+	eastl::vector<std::thread> threads;
+	for (int t = 0; t < numThreads; ++t)
+	{
+		threads.push_back(std::thread([t]()
+		{
+			for (int m = 0; m < numMessages; ++m)
+				LogInformation("thread " + eastl::to_string(t) + " message " + eastl::to_string(m) + "#");
+		}));
+	}
+	for (auto& thread : threads)
+		thread.join();
+	Logger::Stop();
+
+	// nothing is dropped with rings this big
+	TEST_CHECK(Logger::GetNumDropped() == 0);
+	eastl::vector<eastl::string> messages = listener.GetMessages();
+	TEST_CHECK(messages.size() == numThreads * numMessages);
+
+	int next[numThreads] = {};
+	for (eastl::string const& message : messages)
+	{
+		for (int t = 0; t < numThreads; ++t)
+		{
+			eastl::string const text = "thread " + eastl::to_string(t) + " message " +
+				eastl::to_string(next[t]) + "#";
+			if (message.find(text) != eastl::string::npos)
+			{
+				next[t]++;
+				break;
+			}
+		}
+	}
+	for (int t = 0; t < numThreads; ++t)
+		TEST_CHECK(next[t] == numMessages);
+}
+
+TEST_CASE(LoggerBenchmark)
+{
+	LoggerTestListener listener(Logger::Listener::LISTEN_FOR_INFORMATION);
+	int const numMessages = 20000;
+
+	auto const start = std::chrono::steady_clock::now();
+	for (int m = 0; m < numMessages; ++m)
+		LogInformation("benchmark message");
+	auto const middle = std::chrono::steady_clock::now();
+
+	Logger::Start(1 << 22);
+	auto const queued = std::chrono::steady_clock::now();
+	for (int m = 0; m < numMessages; ++m)
+		LogInformation("benchmark message");
+	auto const end = std::chrono::steady_clock::now();
+	Logger::Stop();
+
+	TEST_CHECK(listener.GetMessages().size() == 2 * numMessages);
+	printf("  information: synchronous %.0f ns, queued %.0f ns per message\n",
+		std::chrono::duration<double, std::nano>(middle - start).count() / numMessages,
+		std::chrono::duration<double, std::nano>(end - queued).count() / numMessages);
+}
+
+TEST_CASE(LoggerConcurrentBenchmark)
+{
+	// eight threads logging at once, into the default rings where a burst
+	// overflows and into rings which hold all of it
+	int const numThreads = 8;
+	int const numMessages = 20000;
+	unsigned int const ringSizes[] = { 65536, 1 << 22 };
+	for (unsigned int ringSize : ringSizes)
+	{
+		LoggerTestListener listener(Logger::Listener::LISTEN_FOR_INFORMATION);
+		unsigned int const droppedBefore = Logger::GetNumDropped();
+
+		Logger::Start(ringSize);
+		auto const start = std::chrono::steady_clock::now();
+		eastl::vector<std::thread> threads;
+		for (int t = 0; t < numThreads; ++t)
+		{
+			threads.push_back(std::thread([]()
+			{
+				for (int m = 0; m < numMessages; ++m)
+					LogInformation("concurrent benchmark message");
+			}));
+		}
+		for (auto& thread : threads)
+			thread.join();
+		auto const end = std::chrono::steady_clock::now();
+		Logger::Stop();
+
+		// what doesn't fit is dropped and counted, nothing is lost
+		unsigned int const sent = numThreads * numMessages;
+		unsigned int const dropped = Logger::GetNumDropped() - droppedBefore;
+		unsigned int delivered = 0;
+		for (eastl::string const& message : listener.GetMessages())
+		{
+			if (message.find("concurrent benchmark message") != eastl::string::npos)
+				delivered++;
+		}
+		TEST_CHECK(delivered + dropped == sent);
+
+		printf("  %d threads, %u byte rings: %.0f messages/s, %u delivered, %u dropped\n",
+			numThreads, ringSize, sent / std::chrono::duration<double>(end - start).count(),
+			delivered, dropped);
+	}
+}
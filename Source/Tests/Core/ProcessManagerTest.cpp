@@ -0,0 +1,136 @@
+//========================================================================
+// ProcessManagerTest.cpp - update of the parallel safe processes as jobs
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Core/Process/ProcessManager.h"
+
+#include <chrono>
+#include <cstdio>
+
+/*
+	Process which only works on its own state, so it can be ticked as a job.
+	It succeeds after a number of ticks.
+*/
+class WorkProcess : public Process
+{
+public:
+	WorkProcess(unsigned int seed, unsigned int numTicks, unsigned int work)
+		: mValue(seed), mNumTicks(numTicks), mWork(work), mTicks(0)
+	{
+	}
+
+	unsigned int mValue;
+	unsigned int mNumTicks;
+	unsigned int mWork;
+	unsigned int mTicks;
+
+protected:
+	virtual void OnUpdate(unsigned long deltaMs)
+	{
+		for (unsigned int i = 0; i < mWork; ++i)
+			mValue = mValue * 1664525u + 1013904223u + (unsigned int)deltaMs;
+
+		if (++mTicks == mNumTicks)
+			Succeed();
+	}
+
+	virtual bool IsParallelSafe(void) const { return true; }
+};
+
+/*
+	Process which is ticked on the calling thread and reads the work
+	processes, which must have finished their tick by then.
+*/
+class ReaderProcess : public Process
+{
+public:
+	ReaderProcess(eastl::vector<eastl::shared_ptr<WorkProcess>> const& processes)
+		: mProcesses(processes), mTicks(0), mMismatches(0)
+	{
+	}
+
+	eastl::vector<eastl::shared_ptr<WorkProcess>> mProcesses;
+	unsigned int mTicks;
+	unsigned int mMismatches;
+
+protected:
+	virtual void OnUpdate(unsigned long)
+	{
+		++mTicks;
+		for (auto const& process : mProcesses)
+			if (process->mTicks != eastl::min(mTicks, process->mNumTicks))
+				++mMismatches;
+
+		if (mTicks == 100)
+			Succeed();
+	}
+};
+
+static void RunProcesses(unsigned int numProcesses, unsigned int work,
+	eastl::vector<unsigned int>& values, unsigned int& successCount, unsigned int& mismatches)
+{
+	eastl::vector<eastl::shared_ptr<WorkProcess>> processes;
+	for (unsigned int p = 0; p < numProcesses; ++p)
+		processes.push_back(eastl::make_shared<WorkProcess>(p, 50 + p % 50, work));
+
+	// the processes are attached in front, so without jobs the reader is
+	// ticked last too
+	ProcessManager processManager;
+	eastl::shared_ptr<ReaderProcess> reader = eastl::make_shared<ReaderProcess>(processes);
+	processManager.AttachProcess(reader);
+	for (auto const& process : processes)
+		processManager.AttachProcess(process);
+
+	successCount = 0;
+	while (processManager.GetProcessCount())
+		successCount += processManager.UpdateProcesses(16) >> 16;
+
+	values.clear();
+	for (auto const& process : processes)
+		values.push_back(process->mValue);
+	mismatches = reader->mMismatches;
+}
+
+TEST_CASE(ProcessManagerParallelMatchesSerial)
+{
+	eastl::vector<unsigned int> serialValues, parallelValues;
+	unsigned int serialSuccess, parallelSuccess;
+	unsigned int serialMismatches, parallelMismatches;
+	RunProcesses(64, 100, serialValues, serialSuccess, serialMismatches);
+	{
+		JobSystem jobSystem(3);
+		RunProcesses(64, 100, parallelValues, parallelSuccess, parallelMismatches);
+	}
+
+	TEST_CHECK(serialSuccess == 65);
+	TEST_CHECK(parallelSuccess == 65);
+	TEST_CHECK(serialMismatches == 0);
+	TEST_CHECK(parallelMismatches == 0);
+	TEST_CHECK(serialValues == parallelValues);
+}
+
+TEST_CASE(ProcessManagerBenchmark)
+{
+	unsigned int const numThreads[] = { 0, 1, 3, 7 };
+	eastl::vector<unsigned int> values;
+	unsigned int successCount, mismatches;
+	for (unsigned int threads : numThreads)
+	{
+		eastl::unique_ptr<JobSystem> jobSystem;
+		if (threads)
+			jobSystem = eastl::make_unique<JobSystem>(threads);
+
+		auto const start = std::chrono::steady_clock::now();
+		RunProcesses(256, 20000, values, successCount, mismatches);
+		auto const end = std::chrono::steady_clock::now();
+		TEST_CHECK(mismatches == 0);
+
+		printf("  256 processes, %u workers: %.2f ms per tick\n", threads,
+			std::chrono::duration<double, std::milli>(end - start).count() / 100);
+	}
+}
@@ -0,0 +1,197 @@
+//========================================================================
+// ProfilerTest.cpp - capture of the zones and counters and its trace
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Core/Profiler/Profiler.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+/*
+	The Chrome trace writes one event per line, so the checks look the events
+	up by their name and read the thread id of the line.
+*/
+static eastl::vector<eastl::string> ReadLines(char const* filename)
+{
+	eastl::vector<eastl::string> lines;
+	std::ifstream file(filename);
+	std::string line;
+	while (std::getline(file, line))
+		lines.push_back(line.c_str());
+	return lines;
+}
+
+static int GetThreadId(eastl::string const& line)
+{
+	int thread = -1;
+	eastl_size_t found = line.find("\"tid\":");
+	if (found != eastl::string::npos)
+		sscanf(line.c_str() + found + 6, "%d", &thread);
+	return thread;
+}
+
+// Thread id of the thread with the name, or -1
+static int FindThread(eastl::vector<eastl::string> const& lines, eastl::string const& name)
+{
+	for (eastl::string const& line : lines)
+	{
+		if (line.find("\"thread_name\"") != eastl::string::npos &&
+			line.find("\"" + name + "\"") != eastl::string::npos)
+		{
+			return GetThreadId(line);
+		}
+	}
+	return -1;
+}
+
+// Begin and end phases of the zone in the thread, in the order of the trace
+static eastl::string GetZonePhases(eastl::vector<eastl::string> const& lines,
+	eastl::string const& zone, int thread)
+{
+	eastl::string phases;
+	for (eastl::string const& line : lines)
+	{
+		if (line.find("{\"name\":\"" + zone + "\"") == eastl::string::npos || GetThreadId(line) != thread)
+			continue;
+
+		if (line.find("\"ph\":\"B\"") != eastl::string::npos)
+			phases += 'B';
+		else if (line.find("\"ph\":\"E\"") != eastl::string::npos)
+			phases += 'E';
+	}
+	return phases;
+}
+
+// Value of the counter recorded by the last frame, or -1
+static long long GetCounterValue(eastl::vector<eastl::string> const& lines, eastl::string const& counter)
+{
+	long long value = -1;
+	for (eastl::string const& line : lines)
+	{
+		eastl_size_t found = line.find("\"value\":");
+		if (line.find("{\"name\":\"" + counter + "\",\"ph\":\"C\"") != eastl::string::npos &&
+			found != eastl::string::npos)
+		{
+			sscanf(line.c_str() + found + 8, "%lld", &value);
+		}
+	}
+	return value;
+}
+
+TEST_CASE(ProfilerExportsTheCapture)
+{
+	char const* captureFile = "ProfilerTest.capture";
+	char const* traceFile = "ProfilerTest.json";
+
+	// nothing is recorded outside of a capture
+	std::thread idle([]()
+	{
+		PROFILE_THREAD("Profiler Idle Thread");
+		PROFILE_ZONE("Profiler Idle Zone");
+		PROFILE_COUNTER("Profiler Idle Counter", 1);
+	});
+	idle.join();
+
+	// the counters are declared where they are used, one per name
+	TEST_CHECK(Profiler::StartCapture(captureFile));
+	TEST_CHECK(Profiler::IsCapturing());
+	std::thread first([]()
+	{
+		PROFILE_THREAD("Profiler Test Thread A");
+		for (int r = 0; r < 3; ++r)
+		{
+			PROFILE_ZONE("Profiler Test Zone A");
+			PROFILE_COUNTER("Profiler Test Counter A", 5);
+		}
+	});
+	std::thread second([]()
+	{
+		PROFILE_THREAD("Profiler Test Thread B");
+		for (int r = 0; r < 2; ++r)
+		{
+			PROFILE_ZONE("Profiler Test Zone B");
+			PROFILE_COUNTER("Profiler Test Counter B", 7);
+		}
+	});
+	first.join();
+	second.join();
+	PROFILE_FRAME();
+	Profiler::StopCapture();
+	TEST_CHECK(!Profiler::IsCapturing());
+
+	TEST_CHECK(Profiler::ExportChromeTrace(captureFile, traceFile));
+	eastl::vector<eastl::string> lines = ReadLines(traceFile);
+	remove(captureFile);
+	remove(traceFile);
+
+	TEST_CHECK(!lines.empty() && lines.front() == "{\"traceEvents\":[");
+	TEST_CHECK(!lines.empty() && lines.back() == "]}");
+
+	// each thread has its name and its own zones, which begin before they end
+	int const threadA = FindThread(lines, "Profiler Test Thread A");
+	int const threadB = FindThread(lines, "Profiler Test Thread B");
+	TEST_CHECK(threadA >= 0 && threadB >= 0 && threadA != threadB);
+	TEST_CHECK(GetZonePhases(lines, "Profiler Test Zone A", threadA) == "BEBEBE");
+	TEST_CHECK(GetZonePhases(lines, "Profiler Test Zone B", threadB) == "BEBE");
+	TEST_CHECK(GetZonePhases(lines, "Profiler Test Zone A", threadB).empty());
+
+	// the frame records what the counters summed during it
+	TEST_CHECK(GetCounterValue(lines, "Profiler Test Counter A") == 15);
+	TEST_CHECK(GetCounterValue(lines, "Profiler Test Counter B") == 14);
+
+	// the idle thread recorded nothing, its counter was registered but stayed at zero
+	unsigned int idleZones = 0;
+	for (eastl::string const& line : lines)
+	{
+		if (line.find("Profiler Idle Zone") != eastl::string::npos)
+			idleZones++;
+	}
+	TEST_CHECK(idleZones == 0);
+	TEST_CHECK(FindThread(lines, "Profiler Idle Thread") < 0);
+	TEST_CHECK(GetCounterValue(lines, "Profiler Idle Counter") == 0);
+}
+
+TEST_CASE(ProfilerBenchmark)
+{
+	// a zone and a counter per iteration, while idle and during a capture with
+	// rings which hold all of it
+	char const* captureFile = "ProfilerBenchmark.capture";
+	int const numIterations = 100000;
+	auto const Run = []()
+	{
+		auto const start = std::chrono::steady_clock::now();
+		for (int i = 0; i < numIterations; ++i)
+		{
+			PROFILE_ZONE("Profiler Benchmark Zone");
+			PROFILE_COUNTER("Profiler Benchmark Counter", 1);
+		}
+		return std::chrono::duration<double, std::nano>(
+			std::chrono::steady_clock::now() - start).count() / numIterations;
+	};
+
+	// a ring keeps the size of the capture which created it, so the capture
+	// runs on a new thread which makes its ring before the timing
+	double const idle = Run();
+	double capturing = 0.0;
+	TEST_CHECK(Profiler::StartCapture(captureFile, 1 << 18));
+	std::thread thread([&capturing, &Run]()
+	{
+		{
+			PROFILE_ZONE("Profiler Benchmark Warmup");
+		}
+		capturing = Run();
+	});
+	thread.join();
+	Profiler::StopCapture();
+	remove(captureFile);
+
+	printf("  zone and counter: idle %.1f ns, capturing %.1f ns\n", idle, capturing);
+}
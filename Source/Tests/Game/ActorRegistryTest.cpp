@@ -0,0 +1,250 @@
+//========================================================================
+// ActorRegistryTest.cpp - actor indices by type, component and position
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Game/Actor/Actor.h"
+#include "Game/Actor/ActorComponent.h"
+#include "Game/Actor/ActorGrid.h"
+#include "Game/Actor/ActorRegistry.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+/*
+	Actors are made with a type and empty components of the given names, the
+	way the factory makes them from their xml. The indices are compared with
+	scans of all the actors, which is how the game found them before.
+*/
+class RegistryTestComponent : public ActorComponent
+{
+public:
+	RegistryTestComponent(char const* name) : mName(name) { }
+
+	virtual bool Init(tinyxml2::XMLElement* pData) { return true; }
+	virtual tinyxml2::XMLElement* GenerateXml(void) { return nullptr; }
+	virtual const char *GetName() const { return mName; }
+
+private:
+	char const* mName;
+};
+
+static eastl::shared_ptr<Actor> CreateActor(ActorId id, char const* type,
+	eastl::vector<char const*> const& components)
+{
+	tinyxml2::XMLDocument doc;
+	tinyxml2::XMLElement* pData = doc.NewElement("Actor");
+	pData->SetAttribute("type", type);
+	pData->SetAttribute("resource", "");
+
+	eastl::shared_ptr<Actor> pActor = eastl::make_shared<Actor>(id);
+	pActor->Init(pData);
+	for (char const* component : components)
+		pActor->AddComponent(eastl::make_shared<RegistryTestComponent>(component));
+	return pActor;
+}
+
+static eastl::vector<ActorId> GetIds(ActorRegistry::ActorList const& actors)
+{
+	eastl::vector<ActorId> ids;
+	for (auto const& pActor : actors)
+		ids.push_back(pActor->GetId());
+	return ids;
+}
+
+static Vector3<float> RandomPosition(std::mt19937& random, float range)
+{
+	Vector3<float> position;
+	for (int i = 0; i < 3; i++)
+		position[i] = range * ((random() >> 8) * (2.f / 16777216.f) - 1.f);
+	return position;
+}
+
+TEST_CASE(ActorRegistryIndexesTypesAndComponents)
+{
+	ActorTypeId ammo = ActorRegistry::GetTypeId("RegistryAmmo");
+	ActorTypeId weapon = ActorRegistry::GetTypeId("RegistryWeapon");
+	TEST_CHECK(ammo != weapon);
+	TEST_CHECK(ActorRegistry::GetTypeId("RegistryAmmo") == ammo);
+
+	// added out of order, as actors created from a saved game may be
+	ActorRegistry registry;
+	registry.Add(CreateActor(5, "RegistryAmmo", { "RegistryPickup" }));
+	registry.Add(CreateActor(2, "RegistryWeapon", { "RegistryPickup", "RegistryLocation" }));
+	registry.Add(CreateActor(9, "RegistryAmmo", { "RegistryPickup" }));
+	registry.Add(CreateActor(1, "RegistryAmmo", { }));
+	registry.Add(CreateActor(7, "RegistryWeapon", { "RegistryLocation" }));
+
+	ComponentId pickup = ActorComponent::GetIdFromName("RegistryPickup");
+	ComponentId location = ActorComponent::GetIdFromName("RegistryLocation");
+	TEST_CHECK(GetIds(registry.GetActors(ammo)) == eastl::vector<ActorId>({ 1, 5, 9 }));
+	TEST_CHECK(GetIds(registry.GetActors(weapon)) == eastl::vector<ActorId>({ 2, 7 }));
+	TEST_CHECK(GetIds(registry.GetActorsWithComponent(pickup)) == eastl::vector<ActorId>({ 2, 5, 9 }));
+	TEST_CHECK(GetIds(registry.GetActorsWithComponent(location)) == eastl::vector<ActorId>({ 2, 7 }));
+	TEST_CHECK(registry.GetActors(ActorRegistry::GetTypeId("RegistryArmor")).empty());
+	TEST_CHECK(registry.GetActorsWithComponent(ActorComponent::GetIdFromName("RegistryNone")).empty());
+
+	eastl::shared_ptr<Actor> pActor = registry.GetActors(ammo)[1];
+	registry.Remove(pActor);
+	TEST_CHECK(GetIds(registry.GetActors(ammo)) == eastl::vector<ActorId>({ 1, 9 }));
+	TEST_CHECK(GetIds(registry.GetActorsWithComponent(pickup)) == eastl::vector<ActorId>({ 2, 9 }));
+
+	// adding an actor twice keeps one entry
+	registry.Add(pActor);
+	registry.Add(pActor);
+	TEST_CHECK(GetIds(registry.GetActors(ammo)) == eastl::vector<ActorId>({ 1, 5, 9 }));
+
+	registry.Clear();
+	TEST_CHECK(registry.GetActors(ammo).empty());
+}
+
+TEST_CASE(ActorGridMatchesScan)
+{
+	std::mt19937 random(3);
+	eastl::map<ActorId, Vector3<float>> positions;
+	ActorGrid grid;
+	for (ActorId id = 1; id <= 300; id++)
+	{
+		positions[id] = RandomPosition(random, 1000.f);
+		grid.Move(id, positions[id]);
+	}
+
+	// actors moving inside their cell and to other cells, and some destroyed
+	for (ActorId id = 1; id <= 300; id += 3)
+	{
+		positions[id] += Vector3<float>{ 1.f, -1.f, 0.5f };
+		grid.Move(id, positions[id]);
+	}
+	for (ActorId id = 2; id <= 300; id += 5)
+	{
+		positions[id] = RandomPosition(random, 1000.f);
+		grid.Move(id, positions[id]);
+	}
+	for (ActorId id = 4; id <= 300; id += 7)
+	{
+		positions.erase(id);
+		grid.Remove(id);
+	}
+	TEST_CHECK(grid.GetNumActors() == positions.size());
+
+	// small radii go through the cells, a large one through the actors
+	float const radii[] = { 0.f, 50.f, 150.f, 400.f, 5000.f };
+	for (float radius : radii)
+	{
+		unsigned int mismatches = 0;
+		for (unsigned int q = 0; q < 50; q++)
+		{
+			Vector3<float> center = RandomPosition(random, 1000.f);
+			eastl::vector<ActorId> expected, actors;
+			for (auto const& position : positions)
+			{
+				Vector3<float> delta = position.second - center;
+				if (Dot(delta, delta) <= radius * radius)
+					expected.push_back(position.first);
+			}
+
+			grid.Query(center, radius, actors);
+			if (actors != expected)
+				mismatches++;
+		}
+		TEST_CHECK(mismatches == 0);
+	}
+}
+
+TEST_CASE(ActorRegistryBenchmark)
+{
+	// a 500 actor map: players, items of four kinds, and triggers and targets
+	char const* const itemTypes[] = { "Ammo", "Weapon", "Health", "Armor" };
+	std::mt19937 random(5);
+	eastl::map<ActorId, eastl::shared_ptr<Actor>> actorMap;
+	ActorRegistry registry;
+	ActorGrid grid;
+	eastl::map<ActorId, Vector3<float>> positions;
+	for (ActorId id = 1; id <= 500; id++)
+	{
+		char const* type = id <= 8 ? "Player" : id <= 388 ? itemTypes[id % 4] : "Trigger";
+		eastl::shared_ptr<Actor> pActor = CreateActor(id, type, { "TransformComponent" });
+		actorMap[id] = pActor;
+		registry.Add(pActor);
+		positions[id] = RandomPosition(random, 2000.f);
+		grid.Move(id, positions[id]);
+	}
+
+	unsigned int const numRuns = 1000;
+	ActorTypeId typeIds[5];
+	for (unsigned int t = 0; t < 4; t++)
+		typeIds[t] = ActorRegistry::GetTypeId(itemTypes[t]);
+	typeIds[4] = ActorRegistry::GetTypeId("Player");
+
+	// the lists of each kind which the AI asks for on a decision
+	size_t scanCount = 0, registryCount = 0;
+	auto const scanStart = std::chrono::steady_clock::now();
+	for (unsigned int r = 0; r < numRuns; r++)
+	{
+		for (unsigned int t = 0; t < 5; t++)
+		{
+			eastl::vector<eastl::shared_ptr<Actor>> actors;
+			ActorType type = t < 4 ? itemTypes[t] : "Player";
+			for (auto const& actor : actorMap)
+			{
+				if (actor.second->GetType() == type)
+					actors.push_back(actor.second);
+			}
+			scanCount += actors.size();
+		}
+	}
+	auto const registryStart = std::chrono::steady_clock::now();
+	for (unsigned int r = 0; r < numRuns; r++)
+	{
+		for (unsigned int t = 0; t < 5; t++)
+		{
+			eastl::vector<eastl::shared_ptr<Actor>> actors = registry.GetActors(typeIds[t]);
+			registryCount += actors.size();
+		}
+	}
+	auto const registryEnd = std::chrono::steady_clock::now();
+	TEST_CHECK(scanCount == registryCount);
+
+	// the actors hit by an explosion
+	size_t scanHits = 0, gridHits = 0;
+	float const radius = 150.f;
+	eastl::vector<Vector3<float>> centers;
+	for (unsigned int r = 0; r < numRuns; r++)
+		centers.push_back(RandomPosition(random, 2000.f));
+
+	auto const scanQueryStart = std::chrono::steady_clock::now();
+	for (Vector3<float> const& center : centers)
+	{
+		for (auto const& position : positions)
+		{
+			Vector3<float> delta = position.second - center;
+			if (Dot(delta, delta) <= radius * radius)
+				scanHits++;
+		}
+	}
+	auto const gridQueryStart = std::chrono::steady_clock::now();
+	eastl::vector<ActorId> actors;
+	for (Vector3<float> const& center : centers)
+	{
+		actors.clear();
+		grid.Query(center, radius, actors);
+		gridHits += actors.size();
+	}
+	auto const gridQueryEnd = std::chrono::steady_clock::now();
+	TEST_CHECK(scanHits == gridHits);
+
+	auto const Microseconds = [numRuns](
+		std::chrono::steady_clock::time_point start, std::chrono::steady_clock::time_point end)
+	{
+		return std::chrono::duration<double, std::micro>(end - start).count() / numRuns;
+	};
+	printf("  500 actors, lists of five kinds: scan %.2f us, registry %.2f us\n",
+		Microseconds(scanStart, registryStart), Microseconds(registryStart, registryEnd));
+	printf("  500 actors, %.0f unit radius: scan %.2f us, grid %.2f us\n", radius,
+		Microseconds(scanQueryStart, gridQueryStart), Microseconds(gridQueryStart, gridQueryEnd));
+}
@@ -0,0 +1,405 @@
+//========================================================================
+// CookedMeshTest.cpp - round trip and validation of the cooked meshes
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Graphic/Scene/Element/Mesh/CookedMesh.h"
+#include "Graphic/Scene/Element/Mesh/MeshFileLoader.h"
+#include "Graphic/Scene/Element/Mesh/SkinnedMesh.h"
+#include "Graphic/Scene/Element/Mesh/StandardMesh.h"
+
+#include "Core/IO/FileSystem.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+/*
+	The meshes are built by the test the way the importer leaves them and are
+	cooked to the working directory, next to a texture file of made up bytes.
+	The cooked mesh keeps the decoded texels and only hashes the texture file,
+	so the file doesn't need to be an image. The loader benchmark writes an
+	obj file instead and goes through the importer.
+*/
+static char const* const gTextureFile = "CookedMeshTest.png";
+static char const* const gMeshFile = "CookedMeshTest.obj";
+static wchar_t const* const gCookedFile = L"CookedMeshTest.obj.cooked";
+
+static void WriteBytes(char const* filename, eastl::vector<char> const& data)
+{
+	FILE* file = fopen(filename, "wb");
+	fwrite(data.data(), 1, data.size(), file);
+	fclose(file);
+}
+
+static eastl::vector<char> ReadBytes(char const* filename)
+{
+	eastl::vector<char> data;
+	FILE* file = fopen(filename, "rb");
+	if (!file)
+		return data;
+
+	fseek(file, 0, SEEK_END);
+	data.resize(ftell(file));
+	fseek(file, 0, SEEK_SET);
+	fread(data.data(), 1, data.size(), file);
+	fclose(file);
+	return data;
+}
+
+static eastl::shared_ptr<Texture2> CreateTexture()
+{
+	eastl::shared_ptr<Texture2> texture =
+		eastl::make_shared<Texture2>(DF_R8G8B8A8_UNORM, 16, 8, true);
+	texture->SetName(ToWideString(gTextureFile));
+	for (unsigned int i = 0; i < texture->GetNumBytesFor(0); ++i)
+		texture->GetData()[i] = (char)(i * 3);
+	return texture;
+}
+
+static VertexFormat CreateVertexFormat()
+{
+	VertexFormat vformat;
+	vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+	vformat.Bind(VA_TEXCOORD, DF_R32G32_FLOAT, 0);
+	vformat.Bind(VA_NORMAL, DF_R32G32B32_FLOAT, 0);
+	return vformat;
+}
+
+// A strip of triangles over the vertices, each buffer moved up by its index
+static void FillBuffer(BaseMeshBuffer* meshBuffer, unsigned int index, unsigned int numVertices)
+{
+	for (unsigned int v = 0; v < numVertices; ++v)
+	{
+		meshBuffer->Position(v) = Vector3<float>{ (float)v, (float)index, 1.f };
+		meshBuffer->TCoord(0, v) = Vector2<float>{ 0.5f, (float)v };
+		meshBuffer->Normal(v) = Vector3<float>{ 0.f, 1.f, 0.f };
+	}
+	for (unsigned int t = 0; t < meshBuffer->GetIndice()->GetNumPrimitives(); ++t)
+	{
+		meshBuffer->GetIndice()->SetTriangle(
+			t, t % numVertices, (t + 1) % numVertices, (t + 2) % numVertices);
+	}
+
+	meshBuffer->SetName(L"buffer");
+	meshBuffer->GetMaterial()->mDiffuse = Vector4<float>{ 0.1f, 0.2f, 0.3f, (float)index };
+	meshBuffer->GetMaterial()->mBlendTarget.enable = (index & 1) != 0;
+	meshBuffer->GetMaterial()->mTextureLayer[TT_DIFFUSE].mModeU = SamplerState::CLAMP;
+}
+
+// Same names, vertices and indices in the buffers
+static bool HasSameGeometry(BaseMesh* mesh, BaseMesh* loaded)
+{
+	if (loaded->GetMeshBufferCount() != mesh->GetMeshBufferCount())
+		return false;
+
+	for (unsigned int b = 0; b < mesh->GetMeshBufferCount(); ++b)
+	{
+		eastl::shared_ptr<BaseMeshBuffer> expected = mesh->GetMeshBuffer(b);
+		eastl::shared_ptr<BaseMeshBuffer> buffer = loaded->GetMeshBuffer(b);
+		if (buffer->GetName() != expected->GetName() ||
+			buffer->GetVertice()->GetNumBytes() != expected->GetVertice()->GetNumBytes() ||
+			buffer->GetIndice()->GetNumBytes() != expected->GetIndice()->GetNumBytes() ||
+			memcmp(buffer->GetVertice()->GetData(), expected->GetVertice()->GetData(),
+				expected->GetVertice()->GetNumBytes()) != 0 ||
+			memcmp(buffer->GetIndice()->GetData(), expected->GetIndice()->GetData(),
+				expected->GetIndice()->GetNumBytes()) != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool HasSameBuffers(BaseMesh* mesh, BaseMesh* loaded)
+{
+	if (!HasSameGeometry(mesh, loaded))
+		return false;
+
+	for (unsigned int b = 0; b < mesh->GetMeshBufferCount(); ++b)
+	{
+		eastl::shared_ptr<BaseMeshBuffer> expected = mesh->GetMeshBuffer(b);
+		eastl::shared_ptr<BaseMeshBuffer> buffer = loaded->GetMeshBuffer(b);
+		Material const& material = *buffer->GetMaterial();
+		if (material.mDiffuse != expected->GetMaterial()->mDiffuse ||
+			material.mBlendTarget.enable != expected->GetMaterial()->mBlendTarget.enable ||
+			material.mTextureLayer[TT_DIFFUSE].mModeU != SamplerState::CLAMP)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// A grid of quads with texture coordinates and normals, without materials
+static void WriteGrid(char const* filename, unsigned int size)
+{
+	FILE* file = fopen(filename, "w");
+	for (unsigned int y = 0; y <= size; ++y)
+	{
+		for (unsigned int x = 0; x <= size; ++x)
+		{
+			float const height = (float)((x * 7 + y * 13) % 17) / 17.f;
+			fprintf(file, "v %u %f %u\n", x, height, y);
+			fprintf(file, "vt %f %f\n", (float)x / size, (float)y / size);
+		}
+	}
+	fprintf(file, "vn 0 1 0\n");
+	for (unsigned int y = 0; y < size; ++y)
+	{
+		for (unsigned int x = 0; x < size; ++x)
+		{
+			unsigned int const corner = y * (size + 1) + x + 1;
+			fprintf(file, "f %u/%u/1 %u/%u/1 %u/%u/1 %u/%u/1\n",
+				corner, corner, corner + size + 1, corner + size + 1,
+				corner + size + 2, corner + size + 2, corner + 1, corner + 1);
+		}
+	}
+	fclose(file);
+}
+
+// The mesh the loader makes of the file, as the resource cache asks for it
+static eastl::shared_ptr<BaseMesh> LoadMesh(MeshFileLoader& loader, char const* filename)
+{
+	BaseReadFile* file = FileSystem::Get()->CreateReadFile(ToWideString(filename));
+	if (!file)
+		return eastl::shared_ptr<BaseMesh>();
+
+	BaseResource resource(ToWideString(filename));
+	eastl::shared_ptr<ResHandle> handle = eastl::make_shared<ResHandle>(
+		resource, new char[1], 1, false, ResCache::Get());
+	bool const loaded = loader.LoadResource(file, (unsigned int)file->GetSize(), handle);
+	delete file;
+	if (!loaded)
+		return eastl::shared_ptr<BaseMesh>();
+	return eastl::static_pointer_cast<MeshResourceExtraData>(handle->GetExtra())->GetMesh();
+}
+
+TEST_CASE(CookedMeshRoundTrip)
+{
+	FileSystem fileSystem;
+	fileSystem.InsertDirectory("");
+	WriteBytes(gTextureFile, eastl::vector<char>(1000, 'x'));
+
+	// the buffers share the texture, which is cooked once
+	StandardMesh mesh;
+	eastl::shared_ptr<Texture2> texture = CreateTexture();
+	for (unsigned int b = 0; b < 3; ++b)
+	{
+		MeshBuffer* meshBuffer = new MeshBuffer(CreateVertexFormat(), 100, 80, sizeof(unsigned int));
+		FillBuffer(meshBuffer, b, 100);
+		meshBuffer->GetMaterial()->SetTexture(TT_DIFFUSE, texture);
+		mesh.AddMeshBuffer(meshBuffer);
+	}
+
+	CookedMesh::Source source = { 12345, 67890 };
+	TEST_CHECK(CookedMesh::Save(&mesh, source, gCookedFile));
+
+	eastl::shared_ptr<BaseMesh> loaded = CookedMesh::Load(gCookedFile, source);
+	TEST_CHECK(loaded != nullptr);
+	if (!loaded)
+		return;
+
+	TEST_CHECK(loaded->GetMeshType() == MT_STANDARD);
+	TEST_CHECK(HasSameBuffers(&mesh, loaded.get()));
+
+	eastl::shared_ptr<Texture2> loadedTexture =
+		loaded->GetMeshBuffer(0)->GetMaterial()->GetTexture(TT_DIFFUSE);
+	TEST_CHECK(loadedTexture != nullptr);
+	TEST_CHECK(loadedTexture == loaded->GetMeshBuffer(2)->GetMaterial()->GetTexture(TT_DIFFUSE));
+	if (loadedTexture)
+	{
+		TEST_CHECK(loadedTexture->GetName() == texture->GetName());
+		TEST_CHECK(loadedTexture->HasMipmaps());
+		TEST_CHECK(loadedTexture->GetNumBytesFor(0) == texture->GetNumBytesFor(0));
+		TEST_CHECK(memcmp(loadedTexture->GetData(), texture->GetData(), texture->GetNumBytesFor(0)) == 0);
+	}
+
+	// another source, a changed or missing texture file import the mesh again
+	CookedMesh::Source otherSource = { 12345, 67891 };
+	TEST_CHECK(CookedMesh::Load(gCookedFile, otherSource) == nullptr);
+
+	WriteBytes(gTextureFile, eastl::vector<char>(1000, 'y'));
+	TEST_CHECK(CookedMesh::Load(gCookedFile, source) == nullptr);
+	WriteBytes(gTextureFile, eastl::vector<char>(1000, 'x'));
+	TEST_CHECK(CookedMesh::Load(gCookedFile, source) != nullptr);
+
+	remove(gTextureFile);
+	TEST_CHECK(CookedMesh::Load(gCookedFile, source) == nullptr);
+
+	// a texture which can't be read isn't cooked
+	TEST_CHECK(!CookedMesh::Save(&mesh, source, gCookedFile));
+	remove(ToString(gCookedFile).c_str());
+}
+
+TEST_CASE(CookedMeshSkinRoundTrip)
+{
+	FileSystem fileSystem;
+	fileSystem.InsertDirectory("");
+
+	// two bones, the child weighting the last vertices of the second buffer
+	SkinnedMesh mesh;
+	for (unsigned int b = 0; b < 2; ++b)
+	{
+		SkinMeshBuffer* meshBuffer = new SkinMeshBuffer(CreateVertexFormat(), 10, 8, sizeof(unsigned int));
+		FillBuffer(meshBuffer, b, 10);
+		mesh.AddMeshBuffer(meshBuffer);
+	}
+
+	BaseSkinnedMesh::Joint* root = mesh.AddJoint();
+	root->mName = "root";
+	root->mAttachedMeshes.push_back(0);
+	BaseSkinnedMesh::Joint* child = mesh.AddJoint(root);
+	child->mName = "child";
+	child->mParent = root;
+	child->mLocalTransform.SetTranslation(0.f, 2.f, 0.f);
+
+	for (unsigned int k = 0; k < 3; ++k)
+	{
+		BaseSkinnedMesh::PositionKey* positionKey = mesh.AddPositionKey(child);
+		positionKey->mFrame = (float)k;
+		positionKey->mPosition = Vector3<float>{ 0.f, 2.f + k, 0.f };
+	}
+
+	// a strength no other float of the file has, to find the weight below
+	float const strength = 0.123456f;
+	for (unsigned int v = 5; v < 10; ++v)
+	{
+		BaseSkinnedMesh::Weight* weight = mesh.AddWeight(child);
+		weight->mBufferId = 1;
+		weight->mVertexId = v;
+		weight->mStrength = strength;
+	}
+
+	CookedMesh::Source source = { 54321, 9876 };
+	TEST_CHECK(CookedMesh::Save(&mesh, source, gCookedFile));
+
+	eastl::shared_ptr<BaseMesh> loaded = CookedMesh::Load(gCookedFile, source);
+	TEST_CHECK(loaded != nullptr);
+	if (!loaded)
+		return;
+
+	TEST_CHECK(loaded->GetMeshType() == MT_SKINNED);
+	TEST_CHECK(HasSameBuffers(&mesh, loaded.get()));
+
+	SkinnedMesh* skinnedMesh = static_cast<SkinnedMesh*>(loaded.get());
+	eastl::vector<BaseSkinnedMesh::Joint*>& joints = skinnedMesh->GetAllJoints();
+	TEST_CHECK(joints.size() == 2);
+	if (joints.size() == 2)
+	{
+		TEST_CHECK(joints[0]->mName == "root" && joints[1]->mName == "child");
+		TEST_CHECK(joints[0]->mParent == nullptr && joints[1]->mParent == joints[0]);
+		TEST_CHECK(joints[0]->mChildren.size() == 1 && joints[0]->mChildren[0] == joints[1]);
+		TEST_CHECK(joints[0]->mAttachedMeshes.size() == 1 && joints[0]->mAttachedMeshes[0] == 0);
+		TEST_CHECK(joints[1]->mPositionKeys.size() == 3);
+		TEST_CHECK(joints[1]->mLocalTransform.GetTranslation()[1] == 2.f);
+		TEST_CHECK(joints[1]->mWeights.size() == 5);
+		if (joints[1]->mWeights.size() == 5)
+		{
+			TEST_CHECK(joints[1]->mWeights[4].mBufferId == 1);
+			TEST_CHECK(joints[1]->mWeights[4].mVertexId == 9);
+			TEST_CHECK(joints[1]->mWeights[4].mStrength == strength);
+		}
+	}
+
+	// a weight past the vertices of its buffer is rejected before the skinning uses it
+	eastl::vector<char> data = ReadBytes(ToString(gCookedFile).c_str());
+	char const* found = nullptr;
+	for (size_t i = 0; i + sizeof(float) <= data.size() && !found; i += sizeof(float))
+	{
+		if (memcmp(data.data() + i, &strength, sizeof(float)) == 0)
+			found = data.data() + i;
+	}
+	TEST_CHECK(found != nullptr);
+	if (found)
+	{
+		unsigned int const vertexId = 10;
+		memcpy(data.data() + (found - data.data()) - sizeof(unsigned int), &vertexId, sizeof(vertexId));
+		WriteBytes(ToString(gCookedFile).c_str(), data);
+		TEST_CHECK(CookedMesh::Load(gCookedFile, source) == nullptr);
+	}
+	remove(ToString(gCookedFile).c_str());
+}
+
+TEST_CASE(CookedMeshBenchmark)
+{
+	FileSystem fileSystem;
+	fileSystem.InsertDirectory("");
+	WriteBytes(gTextureFile, eastl::vector<char>(1 << 20, 'x'));
+
+	StandardMesh mesh;
+	eastl::shared_ptr<Texture2> texture = CreateTexture();
+	for (unsigned int b = 0; b < 4; ++b)
+	{
+		MeshBuffer* meshBuffer = new MeshBuffer(CreateVertexFormat(), 50000, 40000, sizeof(unsigned int));
+		FillBuffer(meshBuffer, b, 50000);
+		meshBuffer->GetMaterial()->SetTexture(TT_DIFFUSE, texture);
+		mesh.AddMeshBuffer(meshBuffer);
+	}
+
+	CookedMesh::Source source = { 1, 2 };
+	TEST_CHECK(CookedMesh::Save(&mesh, source, gCookedFile));
+
+	auto const start = std::chrono::steady_clock::now();
+	eastl::shared_ptr<BaseMesh> loaded = CookedMesh::Load(gCookedFile, source);
+	auto const end = std::chrono::steady_clock::now();
+	TEST_CHECK(loaded != nullptr);
+
+	printf("  4 buffers of 50000 vertices and a 1 MB texture file: load %.1f ms\n",
+		std::chrono::duration<double, std::milli>(end - start).count());
+	remove(gTextureFile);
+	remove(ToString(gCookedFile).c_str());
+}
+
+TEST_CASE(CookedMeshLoaderBenchmark)
+{
+	// the same file imported each time, then cooked by a first load which the
+	// second load reads instead of the import
+	FileSystem fileSystem;
+	fileSystem.InsertDirectory("");
+	unsigned int const size = 200;
+	WriteGrid(gMeshFile, size);
+	remove(ToString(gCookedFile).c_str());
+
+	MeshFileLoader importer(false);
+	auto const importStart = std::chrono::steady_clock::now();
+	eastl::shared_ptr<BaseMesh> imported = LoadMesh(importer, gMeshFile);
+	auto const importEnd = std::chrono::steady_clock::now();
+	TEST_CHECK(imported != nullptr);
+	TEST_CHECK(ReadBytes(ToString(gCookedFile).c_str()).empty());
+
+	MeshFileLoader cooker(true);
+	auto const cookStart = std::chrono::steady_clock::now();
+	eastl::shared_ptr<BaseMesh> cooked = LoadMesh(cooker, gMeshFile);
+	auto const cookEnd = std::chrono::steady_clock::now();
+	TEST_CHECK(cooked != nullptr);
+	TEST_CHECK(!ReadBytes(ToString(gCookedFile).c_str()).empty());
+
+	// the cooked file matches its source, so the loader takes it over the import
+	BaseReadFile* file = fileSystem.CreateReadFile(ToWideString(gMeshFile));
+	CookedMesh::Source const source = CookedMesh::GetSource(file);
+	delete file;
+	TEST_CHECK(CookedMesh::Load(gCookedFile, source) != nullptr);
+
+	auto const loadStart = std::chrono::steady_clock::now();
+	eastl::shared_ptr<BaseMesh> loaded = LoadMesh(cooker, gMeshFile);
+	auto const loadEnd = std::chrono::steady_clock::now();
+	TEST_CHECK(loaded != nullptr);
+	if (imported && cooked && loaded)
+	{
+		TEST_CHECK(HasSameGeometry(imported.get(), cooked.get()));
+		TEST_CHECK(HasSameGeometry(imported.get(), loaded.get()));
+	}
+
+	printf("  obj grid of %u quads: import %.1f ms, import and cook %.1f ms, cooked %.1f ms\n",
+		size * size,
+		std::chrono::duration<double, std::milli>(importEnd - importStart).count(),
+		std::chrono::duration<double, std::milli>(cookEnd - cookStart).count(),
+		std::chrono::duration<double, std::milli>(loadEnd - loadStart).count());
+	remove(gMeshFile);
+	remove(ToString(gCookedFile).c_str());
+}
@@ -0,0 +1,192 @@
+//========================================================================
+// CullerTest.cpp - culling of the flattened scene hierarchy
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Graphic/Scene/Hierarchy/Camera.h"
+#include "Graphic/Scene/Hierarchy/Spatial.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+/*
+	Spatial with children and a world bound which is set by the test, so the
+	culler can be tested without the renderer.
+*/
+class CullerTestSpatial : public Spatial
+{
+public:
+	void Attach(eastl::shared_ptr<CullerTestSpatial> const& child)
+	{
+		child->SetParent(this);
+		mChildren.push_back(child);
+	}
+
+	virtual void GetVisibleSet(Culler& culler, eastl::shared_ptr<Camera> const& camera, bool noCull)
+	{
+		for (auto const& child : mChildren)
+			child->OnGetVisibleSet(culler, camera, noCull);
+	}
+
+	eastl::vector<eastl::shared_ptr<CullerTestSpatial>> mChildren;
+
+protected:
+	virtual void UpdateWorldBound() { }
+};
+
+/*
+	Culler with the recursive traversal which the flattened hierarchy replaced. It
+	tests each bound against the planes with BoundingSphere::WhichSide.
+*/
+class CullerTestCuller : public Culler
+{
+public:
+	void ComputeReferenceSet(eastl::shared_ptr<Camera> const& camera,
+		CullerTestSpatial* root, VisibleSet& visibleSet)
+	{
+		PushViewFrustumPlanes(camera);
+		visibleSet.clear();
+		Traverse(root, false, visibleSet);
+	}
+
+private:
+	void Traverse(CullerTestSpatial* spatial, bool noCull, VisibleSet& visibleSet)
+	{
+		if (spatial->GetCullingMode() == CULL_ALWAYS)
+			return;
+		if (spatial->GetCullingMode() == CULL_NEVER)
+			noCull = true;
+
+		unsigned int const savePlaneState = GetPlaneState();
+		if (noCull || IsVisible(spatial->GetAbsoulteBound()))
+		{
+			visibleSet.push_back(spatial);
+			for (auto const& child : spatial->mChildren)
+				Traverse(child.get(), noCull, visibleSet);
+		}
+		SetPlaneState(savePlaneState);
+	}
+};
+
+// The root has the given number of children, each of them the top of three levels of eight
+static void BuildHierarchy(CullerTestSpatial* parent, int depth, int rootChildren,
+	std::mt19937& random, int& count)
+{
+	std::uniform_real_distribution<float> position(-1000.f, 1000.f);
+	std::uniform_real_distribution<float> radius(1.f, 400.f / (float)(depth + 1));
+	std::uniform_int_distribution<int> mode(0, 99);
+
+	int const numChildren = depth == 0 ? rootChildren : (depth < 3 ? 8 : 0);
+	for (int i = 0; i < numChildren; ++i)
+	{
+		eastl::shared_ptr<CullerTestSpatial> child = eastl::make_shared<CullerTestSpatial>();
+		BoundingSphere& bound = child->GetAbsoulteBound();
+		bound.SetCenter(Vector4<float>{ position(random), position(random), position(random), 1.f });
+
+		// a few dummy nodes, and objects which are never or always culled
+		int const roll = mode(random);
+		bound.SetRadius(roll < 2 ? 0.f : radius(random));
+		if (roll >= 2 && roll < 4)
+			child->SetCullingMode(CULL_NEVER);
+		else if (roll >= 4 && roll < 6)
+			child->SetCullingMode(CULL_ALWAYS);
+
+		parent->Attach(child);
+		count++;
+		BuildHierarchy(child.get(), depth + 1, rootChildren, random, count);
+	}
+}
+
+static eastl::shared_ptr<Camera> CreateCamera(float yaw)
+{
+	eastl::shared_ptr<Camera> camera = eastl::make_shared<Camera>(true, true);
+	camera->SetFrustum(60.f, 4.f / 3.f, 1.f, 1500.f);
+	Vector4<float> const dVector{ cos(yaw), sin(yaw), 0.f, 0.f };
+	Vector4<float> const uVector{ 0.f, 0.f, 1.f, 0.f };
+	Vector4<float> const rVector = Cross(dVector, uVector);
+	camera->SetFrame(Vector4<float>{ 0.f, 0.f, 0.f, 1.f }, dVector, uVector, rVector);
+	return camera;
+}
+
+TEST_CASE(CullerMatchesRecursiveTraversal)
+{
+	std::mt19937 random(1234);
+	int count = 1;
+	eastl::shared_ptr<CullerTestSpatial> root = eastl::make_shared<CullerTestSpatial>();
+	root->GetAbsoulteBound().SetCenter(Vector4<float>{ 0.f, 0.f, 0.f, 1.f });
+	root->GetAbsoulteBound().SetRadius(2000.f);
+	BuildHierarchy(root.get(), 0, 64, random, count);
+
+	// extra planes take the plane count past the first group of four
+	CullingPlane extraPlanes[3];
+	extraPlanes[0].Set(Vector4<float>{ 0.f, 0.f, 1.f, 0.f }, 200.f);
+	extraPlanes[1].Set(Vector4<float>{ 0.f, 0.f, -1.f, 0.f }, 200.f);
+	extraPlanes[2].Set(Vector4<float>{ 0.f, 1.f, 0.f, 0.f }, 100.f);
+
+	for (int extra = 0; extra <= 3; ++extra)
+	{
+		CullerTestCuller culler, reference;
+		for (int p = 0; p < extra; ++p)
+		{
+			culler.PushPlane(extraPlanes[p]);
+			reference.PushPlane(extraPlanes[p]);
+		}
+
+		for (int view = 0; view < 8; ++view)
+		{
+			eastl::shared_ptr<Camera> camera = CreateCamera(view * 0.785f);
+			culler.ComputeVisibleSet(camera, root);
+
+			VisibleSet referenceSet;
+			reference.ComputeReferenceSet(camera, root.get(), referenceSet);
+
+			VisibleSet const& visibleSet = culler.GetVisibleSet();
+			TEST_CHECK(visibleSet.size() > 1 && visibleSet.size() < (size_t)count);
+			TEST_CHECK(visibleSet == referenceSet);
+			for (Spatial* spatial : referenceSet)
+				TEST_CHECK(culler.IsVisible(spatial));
+		}
+	}
+}
+
+static void RunCullerBenchmark(int numObjects)
+{
+	// each child of the root brings 73 objects with its descendants
+	std::mt19937 random(5678);
+	int count = 1;
+	eastl::shared_ptr<CullerTestSpatial> root = eastl::make_shared<CullerTestSpatial>();
+	root->GetAbsoulteBound().SetCenter(Vector4<float>{ 0.f, 0.f, 0.f, 1.f });
+	root->GetAbsoulteBound().SetRadius(2000.f);
+	BuildHierarchy(root.get(), 0, eastl::max(1, (numObjects - 1) / 73), random, count);
+
+	CullerTestCuller culler;
+	VisibleSet referenceSet;
+	eastl::shared_ptr<Camera> camera = CreateCamera(0.3f);
+	culler.ComputeVisibleSet(camera, root);
+
+	int const frames = eastl::max(10, 1000000 / count);
+	auto const start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+		culler.ComputeVisibleSet(camera, root);
+	auto const middle = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frames; ++frame)
+		culler.ComputeReferenceSet(camera, root.get(), referenceSet);
+	auto const end = std::chrono::steady_clock::now();
+	TEST_CHECK(culler.GetVisibleSet() == referenceSet);
+
+	printf("  %d objects: flattened %.1f us, recursive %.1f us per frame\n", count,
+		std::chrono::duration<double, std::micro>(middle - start).count() / frames,
+		std::chrono::duration<double, std::micro>(end - middle).count() / frames);
+}
+
+TEST_CASE(CullerBenchmark)
+{
+	int const numObjects[] = { 1000, 10000, 100000 };
+	for (int objects : numObjects)
+		RunCullerBenchmark(objects);
+}
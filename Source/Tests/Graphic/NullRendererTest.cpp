@@ -0,0 +1,290 @@
+//========================================================================
+// NullRendererTest.cpp - command stream and counters of the null renderer
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Core/Event/EventManager.h"
+
+#include "Graphic/Renderer/Null/NullRenderer.h"
+#include "Graphic/Scene/Element/CameraNode.h"
+#include "Graphic/Scene/MeshFactory.h"
+#include "Graphic/Scene/Scene.h"
+
+#include <cstdio>
+#include <random>
+
+/*
+	Nodes with a box and an effect whose program has no shaders, which is
+	enough for the null renderer. Each node sets its own blend state, updates
+	its vertex buffer and draws, the way the mesh nodes render. The default
+	camera looks along the y axis from (0, 10, 10), the boxes are put in front
+	of it.
+
+	The culler computes the visible set after the nodes queue themselves, so
+	the first frame of a scene draws nothing and the tests render one frame
+	before they look at the recording.
+*/
+class NullRendererTestNode : public Node
+{
+public:
+	NullRendererTestNode(int id, eastl::shared_ptr<Visual> const& visual,
+		eastl::shared_ptr<Material> const& material)
+		: Node(id, WeakBaseRenderComponentPtr(), NT_UNKNOWN), mVisual(visual), mMaterial(material)
+	{
+		mBlendState = eastl::make_shared<BlendState>();
+	}
+
+	virtual bool PreRender(Scene* pScene)
+	{
+		if (!pScene->IsCulled(this))
+			pScene->AddToRenderQueue(RP_SOLID, shared_from_this());
+
+		return Node::PreRender(pScene);
+	}
+
+	virtual bool Render(Scene* pScene)
+	{
+		Renderer* renderer = Renderer::Get();
+		renderer->SetBlendState(mBlendState);
+		renderer->Update(mVisual->GetVertexBuffer());
+		renderer->Draw(mVisual);
+		renderer->SetDefaultBlendState();
+		return true;
+	}
+
+	virtual eastl::shared_ptr<Visual> const& GetVisual(unsigned int i) { return mVisual; }
+	virtual unsigned int GetVisualCount() const { return 1; }
+	virtual eastl::shared_ptr<Material> const& GetMaterial(unsigned int i) { return mMaterial; }
+	virtual unsigned int GetMaterialCount() const { return 1; }
+
+private:
+	eastl::shared_ptr<Visual> mVisual;
+	eastl::shared_ptr<Material> mMaterial;
+	eastl::shared_ptr<BlendState> mBlendState;
+};
+
+static eastl::shared_ptr<Visual> CreateBox(eastl::shared_ptr<VisualEffect> const& effect)
+{
+	VertexFormat vformat;
+	vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+
+	MeshFactory mf;
+	mf.SetVertexFormat(vformat);
+	eastl::shared_ptr<Visual> visual = mf.CreateBox(1.f, 1.f, 1.f);
+	visual->SetEffect(effect);
+	visual->UpdateModelBound();
+	return visual;
+}
+
+static eastl::shared_ptr<NullRendererTestNode> AddBoxNode(Scene& scene, int id,
+	eastl::shared_ptr<Visual> const& visual, eastl::shared_ptr<Material> const& material)
+{
+	eastl::shared_ptr<NullRendererTestNode> node =
+		eastl::make_shared<NullRendererTestNode>(id, visual, material);
+
+	Transform transform;
+	transform.SetTranslation((float)(id % 8) * 3.f - 12.f, 60.f, (float)(id / 8) * 3.f);
+	node->SetRelativeTransform(transform);
+	scene.AddSceneNode(id, node);
+	return node;
+}
+
+static void SetCamera(Scene& scene)
+{
+	scene.SetActiveCamera(eastl::static_pointer_cast<CameraNode>(scene.AddCameraNode()));
+}
+
+static void RenderFrame(NullRenderer& renderer, Scene& scene)
+{
+	renderer.ClearBuffers();
+	scene.OnUpdate(0, 0);
+	scene.OnRender();
+	renderer.DisplayColorBuffer(1);
+}
+
+TEST_CASE(NullRendererRecordsScene)
+{
+	NullRenderer renderer(800, 600);
+	EventManager eventManager("NullRendererTest", true);
+
+	Scene scene;
+	SetCamera(scene);
+	eastl::shared_ptr<VisualEffect> effect =
+		eastl::make_shared<VisualEffect>(eastl::make_shared<VisualProgram>());
+	eastl::vector<eastl::shared_ptr<Visual>> visuals;
+	for (int id = 0; id < 3; ++id)
+	{
+		visuals.push_back(CreateBox(effect));
+		AddBoxNode(scene, id, visuals.back(), eastl::make_shared<Material>());
+	}
+
+	RenderFrame(renderer, scene);
+	TEST_CHECK(renderer.GetCounters().draws == 0);
+	TEST_CHECK(renderer.GetCounters().frames == 1);
+
+	renderer.ResetRecording();
+	RenderFrame(renderer, scene);
+
+	// clear, then for each node its blend state, the update of its vertex
+	// buffer, the draw and the default blend state, and the display
+	eastl::vector<NullRenderer::Command> const& commands = renderer.GetCommands();
+	TEST_CHECK(commands.size() == 3 * 4 + 2);
+	if (commands.size() == 3 * 4 + 2)
+	{
+		TEST_CHECK(commands.front().type == NullRenderer::RC_CLEAR);
+		TEST_CHECK(commands.front().count ==
+			(NullRenderer::CLEAR_COLOR | NullRenderer::CLEAR_DEPTH | NullRenderer::CLEAR_STENCIL));
+		TEST_CHECK(commands.back().type == NullRenderer::RC_DISPLAY);
+		TEST_CHECK(commands.back().count == 1);
+
+		unsigned int drawnVisuals = 0;
+		for (unsigned int node = 0; node < 3; ++node)
+		{
+			NullRenderer::Command const* nodeCommands = &commands[1 + node * 4];
+			TEST_CHECK(nodeCommands[0].type == NullRenderer::RC_SET_BLEND_STATE);
+			TEST_CHECK(nodeCommands[1].type == NullRenderer::RC_UPDATE_BUFFER);
+			TEST_CHECK(nodeCommands[2].type == NullRenderer::RC_DRAW);
+			TEST_CHECK(nodeCommands[3].type == NullRenderer::RC_SET_BLEND_STATE);
+			TEST_CHECK(nodeCommands[1].object == nodeCommands[2].object);
+			TEST_CHECK(nodeCommands[2].effect == effect.get());
+
+			for (unsigned int v = 0; v < visuals.size(); ++v)
+			{
+				if (nodeCommands[2].object == visuals[v]->GetVertexBuffer().get())
+				{
+					drawnVisuals |= 1 << v;
+					TEST_CHECK(nodeCommands[1].count == visuals[v]->GetVertexBuffer()->GetNumActiveBytes());
+					TEST_CHECK(nodeCommands[2].count == visuals[v]->GetIndexBuffer()->GetNumActiveIndices());
+				}
+			}
+		}
+		TEST_CHECK(drawnVisuals == 7);
+	}
+
+	NullRenderer::Counters const& counters = renderer.GetCounters();
+	unsigned int const numIndices = visuals[0]->GetIndexBuffer()->GetNumActiveIndices();
+	unsigned int const numBytes = visuals[0]->GetVertexBuffer()->GetNumActiveBytes();
+	TEST_CHECK(counters.frames == 1);
+	TEST_CHECK(counters.clears == 1);
+	TEST_CHECK(counters.draws == 3);
+	TEST_CHECK(counters.drawnInstances == 3);
+	TEST_CHECK(counters.drawnElements == 3 * numIndices);
+	TEST_CHECK(counters.stateChanges == 6);
+	TEST_CHECK(counters.redundantStateChanges == 0);
+	TEST_CHECK(counters.bufferUpdates == 3);
+	TEST_CHECK(counters.updatedBytes == 3 * numBytes);
+
+	// the nodes share the program, each one has its own buffers
+	TEST_CHECK(counters.programBinds == 1);
+	TEST_CHECK(counters.vertexBufferBinds == 3);
+	TEST_CHECK(counters.indexBufferBinds == 3);
+	TEST_CHECK(counters.redundantBinds == 2);
+}
+
+TEST_CASE(NullRendererResetRecording)
+{
+	NullRenderer renderer(800, 600);
+	EventManager eventManager("NullRendererTest", true);
+
+	Scene scene;
+	SetCamera(scene);
+	eastl::shared_ptr<VisualEffect> effect =
+		eastl::make_shared<VisualEffect>(eastl::make_shared<VisualProgram>());
+	eastl::shared_ptr<Visual> visual = CreateBox(effect);
+	AddBoxNode(scene, 0, visual, eastl::make_shared<Material>());
+	RenderFrame(renderer, scene);
+	RenderFrame(renderer, scene);
+	TEST_CHECK(renderer.GetCounters().frames == 2);
+	TEST_CHECK(renderer.GetCounters().draws == 1);
+
+	renderer.ResetRecording();
+	TEST_CHECK(renderer.GetCommands().empty());
+	TEST_CHECK(renderer.GetCounters().frames == 0);
+	TEST_CHECK(renderer.GetCounters().draws == 0);
+	TEST_CHECK(renderer.GetCounters().programBinds == 0);
+
+	// the bindings outlive the reset, drawing the same box binds nothing
+	RenderFrame(renderer, scene);
+	TEST_CHECK(renderer.GetCounters().draws == 1);
+	TEST_CHECK(renderer.GetCounters().programBinds == 0);
+	TEST_CHECK(renderer.GetCounters().vertexBufferBinds == 0);
+	TEST_CHECK(renderer.GetCounters().redundantBinds == 3);
+
+	// without recording only the counters go on
+	renderer.ResetRecording();
+	renderer.SetRecording(false);
+	TEST_CHECK(!renderer.IsRecording());
+	RenderFrame(renderer, scene);
+	TEST_CHECK(renderer.GetCommands().empty());
+	TEST_CHECK(renderer.GetCounters().frames == 1);
+	TEST_CHECK(renderer.GetCounters().draws == 1);
+	TEST_CHECK(renderer.GetCounters().bufferUpdates == 1);
+}
+
+TEST_CASE(NullRendererCountsSortedBinds)
+{
+	NullRenderer renderer(800, 600);
+	EventManager eventManager("NullRendererTest", true);
+
+	// 64 boxes of sixteen kinds, each kind a program, a texture and buffers of
+	// its own, added in a random order
+	std::mt19937 random(33);
+	eastl::shared_ptr<VisualEffect> effects[4];
+	eastl::shared_ptr<Material> materials[4];
+	for (unsigned int i = 0; i < 4; ++i)
+	{
+		effects[i] = eastl::make_shared<VisualEffect>(eastl::make_shared<VisualProgram>());
+		materials[i] = eastl::make_shared<Material>();
+		materials[i]->SetTexture(0, eastl::make_shared<Texture2>(DF_R8G8B8A8_UNORM, 1, 1));
+	}
+
+	Scene scene;
+	SetCamera(scene);
+	eastl::map<eastl::pair<unsigned int, unsigned int>, eastl::shared_ptr<Visual>> visuals;
+	eastl::vector<eastl::shared_ptr<NullRendererTestNode>> nodes;
+	for (int id = 0; id < 64; ++id)
+	{
+		unsigned int const effect = random() % 4, material = random() % 4;
+		eastl::shared_ptr<Visual>& visual = visuals[eastl::make_pair(effect, material)];
+		if (!visual)
+			visual = CreateBox(effects[effect]);
+		nodes.push_back(AddBoxNode(scene, id, visual, materials[material]));
+	}
+
+	// the order in which the nodes queue themselves, which the root would
+	// draw without the render queue sort
+	RenderFrame(renderer, scene);
+	renderer.ResetRecording();
+	for (auto const& node : nodes)
+		node->Render(&scene);
+	NullRenderer::Counters const unsorted = renderer.GetCounters();
+
+	renderer.ResetRecording();
+	RenderFrame(renderer, scene);
+	NullRenderer::Counters const sorted = renderer.GetCounters();
+
+	TEST_CHECK(unsorted.draws == 64);
+	TEST_CHECK(sorted.draws == 64);
+	TEST_CHECK(sorted.drawnElements == unsorted.drawnElements);
+
+	// every draw binds or skips its program and its buffers
+	auto const Binds = [](NullRenderer::Counters const& counters)
+	{
+		return counters.programBinds + counters.vertexBufferBinds + counters.indexBufferBinds;
+	};
+	TEST_CHECK(Binds(unsorted) + unsorted.redundantBinds == 3 * 64);
+	TEST_CHECK(Binds(sorted) + sorted.redundantBinds == 3 * 64);
+
+	// sorted, the nodes of a program and a texture are drawn together
+	TEST_CHECK(sorted.programBinds <= 4);
+	TEST_CHECK(sorted.vertexBufferBinds <= visuals.size());
+	TEST_CHECK(sorted.programBinds < unsorted.programBinds);
+	TEST_CHECK(sorted.redundantBinds > unsorted.redundantBinds);
+
+	printf("  64 nodes: %u binds and %u redundant unsorted, %u binds and %u redundant sorted\n",
+		Binds(unsorted), unsorted.redundantBinds, Binds(sorted), sorted.redundantBinds);
+}
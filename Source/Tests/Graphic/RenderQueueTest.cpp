@@ -0,0 +1,179 @@
+//========================================================================
+// RenderQueueTest.cpp - ordering of the render lists by packed keys
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Graphic/Scene/RenderQueue.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+/*
+	Render list entries as the scene would produce them, a node with the
+	program and texture of its first visual and its distance to the camera.
+	The nodes are only used as identities.
+*/
+struct RenderQueueTestItem
+{
+	Node* mNode;
+	void const* mProgram;
+	void const* mTexture;
+	float mDepth;
+};
+
+static void CreateItems(eastl::vector<RenderQueueTestItem>& items, unsigned int count,
+	unsigned int numPrograms, unsigned int numTextures, std::mt19937& random)
+{
+	static char programs[64], textures[256];
+	std::uniform_int_distribution<unsigned int> program(0, numPrograms - 1);
+	std::uniform_int_distribution<unsigned int> texture(0, numTextures - 1);
+	std::uniform_real_distribution<float> depth(1.f, 4000000.f);
+
+	items.resize(count);
+	for (unsigned int i = 0; i < count; ++i)
+	{
+		items[i].mNode = reinterpret_cast<Node*>(static_cast<uintptr_t>((i + 1) * 16));
+		items[i].mProgram = &programs[program(random)];
+		items[i].mTexture = &textures[texture(random)];
+		items[i].mDepth = depth(random);
+	}
+}
+
+// number of program and texture changes when drawing the items in order
+static unsigned int CountStateChanges(eastl::vector<RenderQueueTestItem> const& items)
+{
+	unsigned int changes = 0;
+	for (unsigned int i = 1; i < items.size(); ++i)
+	{
+		changes += items[i].mProgram != items[i - 1].mProgram;
+		changes += items[i].mTexture != items[i - 1].mTexture;
+	}
+	return changes;
+}
+
+static void SortItems(RenderQueue& renderQueue, eastl::vector<RenderQueueTestItem>& items,
+	bool byDepth, bool backToFront)
+{
+	eastl::hash_map<Node*, RenderQueueTestItem> itemsByNode;
+	renderQueue.Clear();
+	for (RenderQueueTestItem const& item : items)
+	{
+		itemsByNode[item.mNode] = item;
+		renderQueue.Add(byDepth ?
+			RenderQueue::MakeDepthKey(RP_TRANSPARENT, item.mProgram, item.mTexture, item.mDepth, backToFront) :
+			RenderQueue::MakeStateKey(RP_SOLID, item.mProgram, item.mTexture, item.mDepth), item.mNode);
+	}
+	renderQueue.Sort();
+
+	eastl::vector<RenderQueue::Entry> const& entries = renderQueue.GetEntries();
+	for (unsigned int entry = 0; entry < entries.size(); ++entry)
+		items[entry] = itemsByNode[entries[entry].mNode];
+}
+
+TEST_CASE(RenderQueueSortMatchesStableSort)
+{
+	std::mt19937 random(42);
+	std::uniform_int_distribution<uint64_t> key;
+	for (unsigned int count : { 0u, 1u, 2u, 17u, 1000u, 5000u })
+	{
+		RenderQueue renderQueue;
+		eastl::vector<RenderQueue::Entry> reference;
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			// few distinct keys, so the stability is checked too
+			uint64_t const value = key(random) & 0xF00F000000FF00FFull;
+			Node* const node = reinterpret_cast<Node*>(static_cast<uintptr_t>((i + 1) * 16));
+			renderQueue.Add(value, node);
+			reference.push_back(RenderQueue::Entry{ value, node });
+		}
+		renderQueue.Sort();
+		eastl::stable_sort(reference.begin(), reference.end(),
+			[](RenderQueue::Entry const& a, RenderQueue::Entry const& b) { return a.mKey < b.mKey; });
+
+		eastl::vector<RenderQueue::Entry> const& entries = renderQueue.GetEntries();
+		TEST_CHECK(entries.size() == reference.size());
+		for (unsigned int i = 0; i < entries.size() && i < reference.size(); ++i)
+			TEST_CHECK(entries[i].mKey == reference[i].mKey && entries[i].mNode == reference[i].mNode);
+	}
+}
+
+TEST_CASE(RenderQueueOrdersPasses)
+{
+	std::mt19937 random(7);
+	eastl::vector<RenderQueueTestItem> items;
+	RenderQueue renderQueue;
+
+	// solids are grouped by program, then by texture
+	CreateItems(items, 2000, 8, 64, random);
+	SortItems(renderQueue, items, false, false);
+	TEST_CHECK(CountStateChanges(items) <= 8 + 8 * 64);
+
+	// transparent nodes are drawn farthest first, lights nearest first. The
+	// keys keep 16 bits of the depth mantissa, closer depths may swap
+	float const precision = 1.f + 1.f / 65536.f;
+	CreateItems(items, 2000, 8, 64, random);
+	SortItems(renderQueue, items, true, true);
+	for (unsigned int i = 1; i < items.size(); ++i)
+		TEST_CHECK(items[i - 1].mDepth * precision >= items[i].mDepth);
+
+	CreateItems(items, 2000, 8, 64, random);
+	SortItems(renderQueue, items, true, false);
+	for (unsigned int i = 1; i < items.size(); ++i)
+		TEST_CHECK(items[i - 1].mDepth <= items[i].mDepth * precision);
+}
+
+TEST_CASE(RenderQueueBenchmark)
+{
+	std::mt19937 random(1234);
+	for (unsigned int count : { 256u, 2048u, 16384u })
+	{
+		eastl::vector<RenderQueueTestItem> items;
+		CreateItems(items, count, 16, 128, random);
+		unsigned int const unsortedChanges = CountStateChanges(items);
+
+		// comparison sort on the same fields, as the render lists were sorted
+		// before the queue with the keys read from the entries
+		int const runs = 100;
+		eastl::vector<RenderQueueTestItem> sorted;
+		auto const start = std::chrono::steady_clock::now();
+		for (int run = 0; run < runs; ++run)
+		{
+			sorted = items;
+			eastl::stable_sort(sorted.begin(), sorted.end(),
+				[](RenderQueueTestItem const& a, RenderQueueTestItem const& b)
+				{
+					if (a.mProgram != b.mProgram)
+						return a.mProgram < b.mProgram;
+					if (a.mTexture != b.mTexture)
+						return a.mTexture < b.mTexture;
+					return a.mDepth < b.mDepth;
+				});
+		}
+		auto const middle = std::chrono::steady_clock::now();
+
+		RenderQueue renderQueue;
+		for (int run = 0; run < runs; ++run)
+		{
+			renderQueue.Clear();
+			for (RenderQueueTestItem const& item : items)
+			{
+				renderQueue.Add(RenderQueue::MakeStateKey(
+					RP_SOLID, item.mProgram, item.mTexture, item.mDepth), item.mNode);
+			}
+			renderQueue.Sort();
+		}
+		auto const end = std::chrono::steady_clock::now();
+
+		SortItems(renderQueue, items, false, false);
+		printf("  %u nodes: comparison sort %.1f us, render queue %.1f us, "
+			"state changes %u unsorted, %u sorted\n", count,
+			std::chrono::duration<double, std::micro>(middle - start).count() / runs,
+			std::chrono::duration<double, std::micro>(end - middle).count() / runs,
+			unsortedChanges, CountStateChanges(items));
+	}
+}
@@ -0,0 +1,280 @@
+//========================================================================
+// SkinningTest.cpp - software skinning of the skinned meshes
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Graphic/Scene/Element/Mesh/SkinnedMesh.h"
+
+#include "Core/Process/JobSystem.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+/*
+	A tree of joints with random bind poses and two keys of position and
+	rotation, and buffers whose vertices are weighted by up to four joints,
+	as a loader leaves a mesh before Finalize. The skinned buffers are
+	compared with the skinning the mesh did before the influence array, each
+	weight transformed by Matrix4x4::Transformation and accumulated, with the
+	same swaps of the Y and Z axis.
+*/
+struct SkinningTestVertex
+{
+	Vector3<float> mPosition;
+	Vector3<float> mNormal;
+};
+
+static float RandomFloat(std::mt19937& random, float range)
+{
+	return range * ((random() >> 8) * (2.f / 16777216.f) - 1.f);
+}
+
+static Quaternion<float> RandomRotation(std::mt19937& random)
+{
+	Vector4<float> axis{ RandomFloat(random, 1.f), RandomFloat(random, 1.f), 1.f, 0.f };
+	Normalize(axis);
+	return Rotation<4, float>(AxisAngle<4, float>(axis, RandomFloat(random, 1.5f)));
+}
+
+static void BuildSkinnedMesh(SkinnedMesh& mesh, eastl::vector<eastl::vector<SkinningTestVertex>>& vertices,
+	unsigned int numBuffers, unsigned int numVertices, unsigned int numJoints, unsigned int seed)
+{
+	std::mt19937 random(seed);
+
+	VertexFormat vformat;
+	vformat.Bind(VA_POSITION, DF_R32G32B32_FLOAT, 0);
+	vformat.Bind(VA_NORMAL, DF_R32G32B32_FLOAT, 0);
+
+	vertices.resize(numBuffers);
+	for (unsigned int b = 0; b < numBuffers; ++b)
+	{
+		SkinMeshBuffer* meshBuffer = new SkinMeshBuffer(vformat, numVertices, 1, sizeof(unsigned int));
+		vertices[b].resize(numVertices);
+		for (unsigned int v = 0; v < numVertices; ++v)
+		{
+			SkinningTestVertex& vertex = vertices[b][v];
+			vertex.mPosition = Vector3<float>{
+				RandomFloat(random, 10.f), RandomFloat(random, 10.f), RandomFloat(random, 10.f) };
+			vertex.mNormal = Vector3<float>{
+				RandomFloat(random, 1.f), RandomFloat(random, 1.f), 1.f };
+			Normalize(vertex.mNormal);
+
+			meshBuffer->Position(v) = vertex.mPosition;
+			meshBuffer->Normal(v) = vertex.mNormal;
+		}
+		mesh.AddMeshBuffer(meshBuffer);
+	}
+
+	// a binary tree of joints
+	eastl::vector<BaseSkinnedMesh::Joint*> joints;
+	for (unsigned int j = 0; j < numJoints; ++j)
+	{
+		BaseSkinnedMesh::Joint* parent = j > 0 ? joints[(j - 1) / 2] : nullptr;
+		BaseSkinnedMesh::Joint* joint = mesh.AddJoint(parent);
+		joint->mParent = parent;
+		joint->mLocalTransform.SetTranslation(
+			RandomFloat(random, 2.f), RandomFloat(random, 2.f), RandomFloat(random, 2.f));
+		joint->mLocalTransform.SetRotation(RandomRotation(random));
+		joints.push_back(joint);
+
+		for (unsigned int k = 0; k < 2; ++k)
+		{
+			BaseSkinnedMesh::PositionKey* positionKey = mesh.AddPositionKey(joint);
+			positionKey->mFrame = 10.f * k;
+			positionKey->mPosition = Vector3<float>{
+				RandomFloat(random, 2.f), RandomFloat(random, 2.f), RandomFloat(random, 2.f) };
+
+			BaseSkinnedMesh::RotationKey* rotationKey = mesh.AddRotationKey(joint);
+			rotationKey->mFrame = 10.f * k;
+			rotationKey->mRotation = RandomRotation(random);
+		}
+	}
+
+	// one to four influences of different joints, the mesh normalizes them
+	for (unsigned int b = 0; b < numBuffers; ++b)
+	{
+		for (unsigned int v = 0; v < numVertices; ++v)
+		{
+			unsigned int const numWeights = 1 + random() % 4;
+			unsigned int const firstJoint = random() % numJoints;
+			for (unsigned int w = 0; w < numWeights; ++w)
+			{
+				BaseSkinnedMesh::Weight* weight = mesh.AddWeight(joints[(firstJoint + w * 3) % numJoints]);
+				weight->mBufferId = b;
+				weight->mVertexId = v;
+				weight->mStrength = 0.1f + (random() % 100) / 100.f;
+			}
+		}
+	}
+
+	mesh.Finalize();
+}
+
+// The skinning of SkinnedMesh::SkinJoint, which the influence array replaced
+static void ReferenceSkin(SkinnedMesh& mesh,
+	eastl::vector<eastl::vector<SkinningTestVertex>> const& vertices,
+	eastl::vector<eastl::vector<SkinningTestVertex>>& skinned)
+{
+	skinned.resize(vertices.size());
+	for (unsigned int b = 0; b < vertices.size(); ++b)
+	{
+		skinned[b].resize(vertices[b].size());
+		memset(skinned[b].data(), 0, skinned[b].size() * sizeof(SkinningTestVertex));
+	}
+
+	for (BaseSkinnedMesh::Joint* joint : mesh.GetAllJoints())
+	{
+		Transform jointTransform = joint->mGlobalAnimatedTransform * joint->mGlobalInversedTransform;
+		Matrix4x4<float> jointVertexPull = jointTransform.GetRotation();
+		Vector3<float> translation = jointTransform.GetTranslation();
+
+		for (BaseSkinnedMesh::Weight const& weight : joint->mWeights)
+		{
+			// the static position is kept with Y and Z swapped, the normal as is
+			SkinningTestVertex const& vertex = vertices[weight.mBufferId][weight.mVertexId];
+			Vector4<float> position{ vertex.mPosition[0], vertex.mPosition[2], vertex.mPosition[1], 0.f };
+			Vector4<float> normal{ vertex.mNormal[0], vertex.mNormal[1], vertex.mNormal[2], 0.f };
+
+			Vector4<float> vertexMove, normalMove;
+			jointVertexPull.Transformation(position, vertexMove);
+			jointVertexPull.Transformation(normal, normalMove);
+			for (unsigned int i = 0; i < 3; ++i)
+				vertexMove[i] += translation[i];
+
+			//swapping Y and Z axis
+			eastl::swap(vertexMove[2], vertexMove[1]);
+			eastl::swap(normalMove[2], normalMove[1]);
+
+			SkinningTestVertex& target = skinned[weight.mBufferId][weight.mVertexId];
+			for (unsigned int i = 0; i < 3; ++i)
+			{
+				target.mPosition[i] += vertexMove[i] * weight.mStrength;
+				target.mNormal[i] += normalMove[i] * weight.mStrength;
+			}
+		}
+	}
+}
+
+// Largest difference of the skinned buffers to the reference, relative to
+// the length of the reference vector
+static float CompareSkin(SkinnedMesh& mesh, eastl::vector<eastl::vector<SkinningTestVertex>> const& skinned)
+{
+	float maxError = 0.f;
+	eastl::vector<eastl::shared_ptr<SkinMeshBuffer>>& buffers = mesh.GetMeshBuffers();
+	for (unsigned int b = 0; b < skinned.size(); ++b)
+	{
+		for (unsigned int v = 0; v < skinned[b].size(); ++v)
+		{
+			SkinningTestVertex const& expected = skinned[b][v];
+			Vector3<float> position = buffers[b]->Position(v) - expected.mPosition;
+			Vector3<float> normal = buffers[b]->Normal(v) - expected.mNormal;
+			maxError = eastl::max(maxError, Length(position) / (1.f + Length(expected.mPosition)));
+			maxError = eastl::max(maxError, Length(normal) / (1.f + Length(expected.mNormal)));
+		}
+	}
+	return maxError;
+}
+
+TEST_CASE(SkinningMatchesJointTransformation)
+{
+	SkinnedMesh mesh;
+	eastl::vector<eastl::vector<SkinningTestVertex>> vertices, skinned;
+	BuildSkinnedMesh(mesh, vertices, 3, 500, 15, 37);
+
+	float const frames[] = { 0.f, 2.5f, 7.f, 10.f };
+	for (float frame : frames)
+	{
+		mesh.AnimateMesh(frame, 1.f);
+		mesh.SkinMesh();
+		ReferenceSkin(mesh, vertices, skinned);
+		TEST_CHECK(CompareSkin(mesh, skinned) < 1e-5f);
+	}
+}
+
+TEST_CASE(SkinningJobsMatchSerial)
+{
+	// large enough to be split in jobs
+	SkinnedMesh serial, parallel;
+	eastl::vector<eastl::vector<SkinningTestVertex>> vertices, skinned;
+	BuildSkinnedMesh(serial, vertices, 2, 20000, 31, 41);
+	BuildSkinnedMesh(parallel, vertices, 2, 20000, 31, 41);
+
+	serial.AnimateMesh(4.f, 1.f);
+	serial.SkinMesh();
+	{
+		JobSystem jobSystem(3);
+		parallel.AnimateMesh(4.f, 1.f);
+		parallel.SkinMesh();
+	}
+
+	// each vertex is skinned by the same code on either side
+	unsigned int mismatches = 0;
+	for (unsigned int b = 0; b < 2; ++b)
+	{
+		eastl::shared_ptr<SkinMeshBuffer> const& buffer = serial.GetMeshBuffers()[b];
+		eastl::shared_ptr<SkinMeshBuffer> const& parallelBuffer = parallel.GetMeshBuffers()[b];
+		for (unsigned int v = 0; v < 20000; ++v)
+		{
+			if (buffer->Position(v) != parallelBuffer->Position(v) ||
+				buffer->Normal(v) != parallelBuffer->Normal(v))
+			{
+				mismatches++;
+			}
+		}
+	}
+	TEST_CHECK(mismatches == 0);
+
+	ReferenceSkin(parallel, vertices, skinned);
+	TEST_CHECK(CompareSkin(parallel, skinned) < 1e-5f);
+}
+
+TEST_CASE(SkinningBenchmark)
+{
+	// a detailed character, 60000 vertices over four buffers and 64 joints
+	unsigned int const numVertices = 4 * 15000;
+	unsigned int const runs = 50;
+	SkinnedMesh mesh;
+	eastl::vector<eastl::vector<SkinningTestVertex>> vertices, skinned;
+	BuildSkinnedMesh(mesh, vertices, 4, numVertices / 4, 64, 43);
+
+	auto const Skin = [&mesh, runs]()
+	{
+		double milliseconds = 0.0;
+		for (unsigned int run = 0; run < runs; ++run)
+		{
+			mesh.AnimateMesh(10.f * run / runs, 1.f);
+			auto const start = std::chrono::steady_clock::now();
+			mesh.SkinMesh();
+			milliseconds += std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - start).count();
+		}
+		return milliseconds;
+	};
+
+	double reference = 0.0;
+	for (unsigned int run = 0; run < runs; ++run)
+	{
+		mesh.AnimateMesh(10.f * run / runs, 1.f);
+		mesh.SkinMesh();
+		auto const start = std::chrono::steady_clock::now();
+		ReferenceSkin(mesh, vertices, skinned);
+		reference += std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - start).count();
+	}
+	double const serial = Skin();
+	double parallel = 0.0;
+	{
+		JobSystem jobSystem(3);
+		parallel = Skin();
+	}
+	TEST_CHECK(CompareSkin(mesh, skinned) < 1e-5f);
+
+	printf("  %u vertices: joint transformation %.0f, serial %.0f, 3 workers %.0f vertices per ms\n",
+		numVertices, numVertices * runs / reference, numVertices * runs / serial,
+		numVertices * runs / parallel);
+}
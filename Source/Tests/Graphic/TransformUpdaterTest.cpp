@@ -0,0 +1,233 @@
+//========================================================================
+// TransformUpdaterTest.cpp - dirty update of the world transforms and bounds
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Graphic/Scene/Hierarchy/Node.h"
+#include "Graphic/Scene/TransformUpdater.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+/*
+	Node with a model bound which is set by the test, so the world bounds can
+	be checked without visuals.
+*/
+class TransformTestNode : public Node
+{
+public:
+	TransformTestNode(int id) : Node(id, WeakBaseRenderComponentPtr(), NT_UNKNOWN)
+	{
+		mModelBound.SetCenter(Vector4<float>{ 0.f, 0.f, 0.f, 1.f });
+		mModelBound.SetRadius(1.f);
+	}
+
+	// The recursive update which the transform updater replaced, every
+	// world transform and bound is computed each time.
+	void ReferenceUpdate()
+	{
+		UpdateAbsoluteTransform();
+		for (auto const& child : GetChildren())
+			static_cast<TransformTestNode*>(child.get())->ReferenceUpdate();
+		UpdateWorldBound();
+	}
+
+	BoundingSphere mModelBound;
+
+protected:
+	virtual void UpdateWorldBound()
+	{
+		mModelBound.TransformBy(mWorldTransform, mWorldBound);
+		for (auto const& child : GetChildren())
+			mWorldBound.GrowToContain(child->GetAbsoulteBound());
+	}
+};
+
+static void RandomTransform(std::mt19937& random, Transform& transform)
+{
+	std::uniform_real_distribution<float> position(-100.f, 100.f);
+	std::uniform_real_distribution<float> angle(-3.f, 3.f);
+	std::uniform_real_distribution<float> scale(0.5f, 2.f);
+	transform.SetTranslation(position(random), position(random), position(random));
+	transform.SetRotation(AxisAngle<4, float>(Vector4<float>::Unit(2), angle(random)));
+	transform.SetUniformScale(scale(random));
+}
+
+/*
+	Two identical trees, one updated by the transform updater and the other by
+	the recursive reference, so their transforms and bounds can be compared.
+*/
+static void BuildTree(int depth, int maxDepth, int fanout, std::mt19937& random,
+	TransformTestNode* parent, TransformTestNode* referenceParent,
+	eastl::vector<TransformTestNode*>& nodes, eastl::vector<TransformTestNode*>& referenceNodes)
+{
+	if (depth == maxDepth)
+		return;
+
+	for (int i = 0; i < fanout; ++i)
+	{
+		int const id = (int)nodes.size();
+		eastl::shared_ptr<TransformTestNode> child = eastl::make_shared<TransformTestNode>(id);
+		eastl::shared_ptr<TransformTestNode> referenceChild = eastl::make_shared<TransformTestNode>(id);
+
+		Transform transform;
+		RandomTransform(random, transform);
+		child->SetRelativeTransform(transform);
+		referenceChild->SetRelativeTransform(transform);
+
+		parent->AttachChild(child);
+		referenceParent->AttachChild(referenceChild);
+		nodes.push_back(child.get());
+		referenceNodes.push_back(referenceChild.get());
+
+		BuildTree(depth + 1, maxDepth, fanout, random,
+			child.get(), referenceChild.get(), nodes, referenceNodes);
+	}
+}
+
+static bool SameWorldData(eastl::vector<TransformTestNode*> const& nodes,
+	eastl::vector<TransformTestNode*> const& referenceNodes)
+{
+	for (unsigned int i = 0; i < nodes.size(); ++i)
+	{
+		Spatial* node = nodes[i];
+		Spatial* reference = referenceNodes[i];
+		if (memcmp(&node->GetAbsoluteTransform().GetMatrix(),
+			&reference->GetAbsoluteTransform().GetMatrix(), sizeof(Matrix4x4<float>)) != 0)
+		{
+			return false;
+		}
+
+		if (node->GetAbsoulteBound().GetCenter() != reference->GetAbsoulteBound().GetCenter() ||
+			node->GetAbsoulteBound().GetRadius() != reference->GetAbsoulteBound().GetRadius())
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE(TransformUpdaterMatchesRecursiveUpdate)
+{
+	std::mt19937 random(1234);
+	eastl::shared_ptr<TransformTestNode> root = eastl::make_shared<TransformTestNode>(-1);
+	eastl::shared_ptr<TransformTestNode> referenceRoot = eastl::make_shared<TransformTestNode>(-1);
+	eastl::vector<TransformTestNode*> nodes, referenceNodes;
+	BuildTree(0, 4, 6, random, root.get(), referenceRoot.get(), nodes, referenceNodes);
+
+	TransformUpdater updater;
+	updater.Update(root.get());
+	referenceRoot->ReferenceUpdate();
+	TEST_CHECK(updater.GetNumSpatials() == nodes.size() + 1);
+	TEST_CHECK(updater.GetNumUpdatedTransforms() == nodes.size() + 1);
+	TEST_CHECK(SameWorldData(nodes, referenceNodes));
+
+	std::uniform_int_distribution<unsigned int> pick(0, (unsigned int)nodes.size() - 1);
+	for (int frame = 0; frame < 20; ++frame)
+	{
+		// moved nodes, and a model bound which changed without a move
+		for (int move = 0; move < 8; ++move)
+		{
+			unsigned int const i = pick(random);
+			Transform transform;
+			RandomTransform(random, transform);
+			nodes[i]->SetRelativeTransform(transform);
+			referenceNodes[i]->SetRelativeTransform(transform);
+		}
+
+		unsigned int const i = pick(random);
+		nodes[i]->mModelBound.SetRadius(frame + 2.f);
+		nodes[i]->MarkBoundDirty();
+		referenceNodes[i]->mModelBound.SetRadius(frame + 2.f);
+
+		updater.Update(root.get());
+		referenceRoot->ReferenceUpdate();
+		TEST_CHECK(updater.GetNumUpdatedTransforms() < nodes.size() / 2);
+		TEST_CHECK(SameWorldData(nodes, referenceNodes));
+	}
+}
+
+TEST_CASE(TransformUpdaterConstReadKeepsClean)
+{
+	std::mt19937 random(5678);
+	eastl::shared_ptr<TransformTestNode> root = eastl::make_shared<TransformTestNode>(-1);
+	eastl::shared_ptr<TransformTestNode> referenceRoot = eastl::make_shared<TransformTestNode>(-1);
+	eastl::vector<TransformTestNode*> nodes, referenceNodes;
+	BuildTree(0, 3, 4, random, root.get(), referenceRoot.get(), nodes, referenceNodes);
+
+	TransformUpdater updater;
+	updater.Update(root.get());
+
+	// reading through a const node doesn't mark the transform
+	float sum = 0.f;
+	for (TransformTestNode const* node : nodes)
+		sum += node->GetRelativeTransform().GetTranslation()[0];
+	updater.Update(root.get());
+	TEST_CHECK(updater.GetNumUpdatedTransforms() == 0);
+	TEST_CHECK(updater.GetNumUpdatedBounds() == 0);
+
+	// the non-const access marks it, the leaf and its ancestors are refitted
+	nodes.back()->GetRelativeTransform().SetTranslation(sum, 0.f, 0.f);
+	updater.Update(root.get());
+	TEST_CHECK(updater.GetNumUpdatedTransforms() == 1);
+	TEST_CHECK(updater.GetNumUpdatedBounds() == 4);
+}
+
+TEST_CASE(TransformUpdaterBenchmark)
+{
+	std::mt19937 random(4321);
+	eastl::shared_ptr<TransformTestNode> root = eastl::make_shared<TransformTestNode>(-1);
+	eastl::shared_ptr<TransformTestNode> referenceRoot = eastl::make_shared<TransformTestNode>(-1);
+	eastl::vector<TransformTestNode*> nodes, referenceNodes;
+	BuildTree(0, 5, 8, random, root.get(), referenceRoot.get(), nodes, referenceNodes);
+
+	TransformUpdater updater;
+	updater.Update(root.get());
+
+	eastl::vector<Transform> moves(256);
+	for (Transform& transform : moves)
+		RandomTransform(random, transform);
+
+	// a few hundred moving objects in a big static scene, and an animated
+	// scene where nine nodes out of ten get a new local transform each frame
+	unsigned int const numNodes = (unsigned int)nodes.size();
+	unsigned int const numMoved[] = { 256, numNodes - numNodes / 10 };
+	for (unsigned int moved : numMoved)
+	{
+		eastl::vector<unsigned int> indices(numNodes);
+		for (unsigned int i = 0; i < numNodes; ++i)
+			indices[i] = i;
+		std::shuffle(indices.begin(), indices.end(), random);
+		indices.resize(moved);
+
+		int const frames = 100;
+		auto const start = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (unsigned int i = 0; i < moved; ++i)
+				nodes[indices[i]]->SetRelativeTransform(moves[(i + frame) % moves.size()]);
+			updater.Update(root.get());
+		}
+		auto const middle = std::chrono::steady_clock::now();
+		for (int frame = 0; frame < frames; ++frame)
+		{
+			for (unsigned int i = 0; i < moved; ++i)
+				referenceNodes[indices[i]]->SetRelativeTransform(moves[(i + frame) % moves.size()]);
+			referenceRoot->ReferenceUpdate();
+		}
+		auto const end = std::chrono::steady_clock::now();
+		TEST_CHECK(SameWorldData(nodes, referenceNodes));
+
+		printf("  %u nodes, %u moved: dirty pass %.1f us, recursive %.1f us per frame\n",
+			numNodes + 1, moved,
+			std::chrono::duration<double, std::micro>(middle - start).count() / frames,
+			std::chrono::duration<double, std::micro>(end - middle).count() / frames);
+	}
+}
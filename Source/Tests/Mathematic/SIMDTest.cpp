@@ -0,0 +1,201 @@
+//========================================================================
+// SIMDTest.cpp - accuracy of the SIMD kernels of the float math types
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Mathematic/Algebra/Matrix4x4.h"
+#include "Mathematic/Algebra/Quaternion.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+/*
+	The kernels add the products in the order of the loops of the generic
+	templates, so the results are compared for equality with the same loops
+	written out here. The random values keep the sums away from an exact zero,
+	whose sign is the only difference allowed. Without a SIMD backend the
+	float types use the generic templates and the checks hold trivially.
+*/
+static Matrix4x4<float> RandomMatrix(std::mt19937& random)
+{
+	std::uniform_real_distribution<float> value(-10.f, 10.f);
+	Matrix4x4<float> M;
+	for (int r = 0; r < 4; ++r)
+		for (int c = 0; c < 4; ++c)
+			M(r, c) = value(random);
+	return M;
+}
+
+static Vector4<float> RandomVector(std::mt19937& random)
+{
+	std::uniform_real_distribution<float> value(-10.f, 10.f);
+	return Vector4<float>{ value(random), value(random), value(random), value(random) };
+}
+
+TEST_CASE(SIMDMatrixProductsMatchLoops)
+{
+	std::mt19937 random(1234);
+	for (int test = 0; test < 1000; ++test)
+	{
+		Matrix4x4<float> A = RandomMatrix(random);
+		Matrix4x4<float> B = RandomMatrix(random);
+		Vector4<float> V = RandomVector(random);
+
+		Matrix4x4<float> AB = A * B;
+		Vector4<float> AV = A * V;
+		Vector4<float> VA = V * A;
+		Matrix4x4<float> T = Transpose(A);
+		for (int r = 0; r < 4; ++r)
+		{
+			float sumAV = 0.f, sumVA = 0.f;
+			for (int i = 0; i < 4; ++i)
+			{
+				sumAV += A(r, i) * V[i];
+				sumVA += V[i] * A(i, r);
+			}
+			TEST_CHECK(AV[r] == sumAV);
+			TEST_CHECK(VA[r] == sumVA);
+
+			for (int c = 0; c < 4; ++c)
+			{
+				float sum = 0.f;
+				for (int i = 0; i < 4; ++i)
+					sum += A(r, i) * B(i, c);
+				TEST_CHECK(AB(r, c) == sum);
+				TEST_CHECK(T(r, c) == A(c, r));
+			}
+		}
+	}
+}
+
+TEST_CASE(SIMDVectorAndQuaternionMatchLoops)
+{
+	std::mt19937 random(5678);
+	for (int test = 0; test < 1000; ++test)
+	{
+		Vector4<float> v0 = RandomVector(random);
+		Vector4<float> v1 = RandomVector(random);
+		float const s = v0[0];
+
+		Vector4<float> sum = v0 + v1;
+		Vector4<float> difference = v0 - v1;
+		Vector4<float> product = v0 * v1;
+		Vector4<float> scaled = v0 * s;
+		for (int i = 0; i < 4; ++i)
+		{
+			TEST_CHECK(sum[i] == v0[i] + v1[i]);
+			TEST_CHECK(difference[i] == v0[i] - v1[i]);
+			TEST_CHECK(product[i] == v0[i] * v1[i]);
+			TEST_CHECK(scaled[i] == v0[i] * s);
+		}
+
+		Quaternion<float> q0(v0[0], v0[1], v0[2], v0[3]);
+		Quaternion<float> q1(v1[0], v1[1], v1[2], v1[3]);
+		Quaternion<float> q = q0 * q1;
+		TEST_CHECK(q[0] == +q0[0] * q1[3] + q0[1] * q1[2] - q0[2] * q1[1] + q0[3] * q1[0]);
+		TEST_CHECK(q[1] == -q0[0] * q1[2] + q0[1] * q1[3] + q0[2] * q1[0] + q0[3] * q1[1]);
+		TEST_CHECK(q[2] == +q0[0] * q1[1] - q0[1] * q1[0] + q0[2] * q1[3] + q0[3] * q1[2]);
+		TEST_CHECK(q[3] == -q0[0] * q1[0] - q0[1] * q1[1] - q0[2] * q1[2] + q0[3] * q1[3]);
+	}
+}
+
+TEST_CASE(SIMDInverseMatchesDouble)
+{
+	// the block inverse rounds differently from the cofactor expansion, so
+	// it is compared with the inverse in double precision
+	std::mt19937 random(4321);
+	float maxError = 0.f;
+	for (int test = 0; test < 1000; ++test)
+	{
+		Matrix4x4<float> M = RandomMatrix(random);
+		for (int i = 0; i < 4; ++i)
+			M(i, i) += 20.f;
+
+		Matrix4x4<double> D;
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				D(r, c) = M(r, c);
+
+		bool invertible = false, invertibleD = false;
+		Matrix4x4<float> inverse = Inverse(M, &invertible);
+		Matrix4x4<double> inverseD = Inverse(D, &invertibleD);
+		TEST_CHECK(invertible && invertibleD);
+
+		for (int r = 0; r < 4; ++r)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				float error = (float)(fabs(inverse(r, c) - inverseD(r, c)) /
+					(fabs(inverseD(r, c)) + 1e-3));
+				maxError = eastl::max(maxError, error);
+			}
+		}
+	}
+	printf("  4x4 inverse: max relative error %g\n", maxError);
+	TEST_CHECK(maxError < 1e-4f);
+
+	// a singular matrix gives the zero matrix, small integers keep the
+	// determinant exactly zero
+	std::uniform_int_distribution<int> entry(-9, 9);
+	Matrix4x4<float> S;
+	for (int r = 0; r < 4; ++r)
+		for (int c = 0; c < 4; ++c)
+			S(r, c) = (float)entry(random);
+	for (int c = 0; c < 4; ++c)
+		S(3, c) = S(1, c);
+	bool invertible = true;
+	Matrix4x4<float> inverse = Inverse(S, &invertible);
+	TEST_CHECK(!invertible);
+	for (int r = 0; r < 4; ++r)
+		for (int c = 0; c < 4; ++c)
+			TEST_CHECK(inverse(r, c) == 0.f);
+}
+
+TEST_CASE(SIMDBenchmark)
+{
+	std::mt19937 random(8765);
+	unsigned int const numMatrices = 1024;
+	eastl::vector<Matrix4x4<float>> matrices(numMatrices);
+	for (Matrix4x4<float>& M : matrices)
+		M = RandomMatrix(random);
+
+	int const rounds = 200;
+	eastl::vector<Matrix4x4<float>> products(numMatrices), loopProducts(numMatrices);
+	auto const start = std::chrono::steady_clock::now();
+	for (int round = 0; round < rounds; ++round)
+	{
+		for (unsigned int m = 0; m < numMatrices; ++m)
+			products[m] = matrices[m] * matrices[(m + round) % numMatrices];
+	}
+	auto const middle = std::chrono::steady_clock::now();
+	for (int round = 0; round < rounds; ++round)
+	{
+		for (unsigned int m = 0; m < numMatrices; ++m)
+		{
+			Matrix4x4<float> const& A = matrices[m];
+			Matrix4x4<float> const& B = matrices[(m + round) % numMatrices];
+			for (int r = 0; r < 4; ++r)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					float sum = 0.f;
+					for (int i = 0; i < 4; ++i)
+						sum += A(r, i) * B(i, c);
+					loopProducts[m](r, c) = sum;
+				}
+			}
+		}
+	}
+	auto const end = std::chrono::steady_clock::now();
+	TEST_CHECK(products == loopProducts);
+
+	double const count = (double)rounds * numMatrices;
+	printf("  4x4 products: kernel %.2f ns, loops %.2f ns\n",
+		std::chrono::duration<double, std::nano>(middle - start).count() / count,
+		std::chrono::duration<double, std::nano>(end - middle).count() / count);
+}
@@ -0,0 +1,183 @@
+//========================================================================
+// PhysicStateTest.cpp - capture and restore of the bullet actors state
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Tests/Test.h"
+
+#include "Physic/PhysicState.h"
+
+#include <cstring>
+
+/*
+	Small world with the same objects as BulletPhysics: a static floor with a
+	block on it, a character which falls and walks into the block and a
+	sphere which falls from high enough to not touch anything during the
+	test. The character uses the world gravity, so its vertical velocity
+	is still growing when the state is captured.
+*/
+class PhysicStateWorld
+{
+public:
+	PhysicStateWorld()
+		: mDispatcher(&mConfiguration),
+		mWorld(&mDispatcher, &mBroadphase, &mSolver, &mConfiguration),
+		mFloorShape(btVector3(512.f, 512.f, 8.f)), mBlockShape(btVector3(16.f, 64.f, 32.f)),
+		mSphereShape(8.f), mCharacterShape(16.f, 24.f)
+	{
+		mWorld.setGravity(btVector3(0.f, 0.f, -300.f));
+		mBroadphase.getOverlappingPairCache()->setInternalGhostPairCallback(&mGhostPairCallback);
+
+		mFloor.setCollisionShape(&mFloorShape);
+		mFloor.setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(0.f, 0.f, -8.f)));
+		mWorld.addCollisionObject(&mFloor);
+
+		mBlock.setCollisionShape(&mBlockShape);
+		mBlock.setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(96.f, 0.f, 32.f)));
+		mWorld.addCollisionObject(&mBlock);
+
+		btVector3 inertia;
+		mSphereShape.calculateLocalInertia(1.f, inertia);
+		mSphereMotionState = new btDefaultMotionState(
+			btTransform(btQuaternion::getIdentity(), btVector3(-128.f, 0.f, 100000.f)));
+		mSphere = new btRigidBody(1.f, mSphereMotionState, &mSphereShape, inertia);
+		mSphere->setAngularVelocity(btVector3(1.f, 2.f, 3.f));
+		mWorld.addRigidBody(mSphere);
+
+		mGhostObject.setWorldTransform(btTransform(btQuaternion::getIdentity(), btVector3(0.f, 0.f, 200.f)));
+		mGhostObject.setCollisionShape(&mCharacterShape);
+		mGhostObject.setCollisionFlags(btCollisionObject::CF_CHARACTER_OBJECT);
+		mController = new BulletCharacterController(&mGhostObject, &mCharacterShape, 16.f);
+		mController->setGravity(mWorld.getGravity());
+		mController->setFallSpeed(600);
+		mWorld.addCollisionObject(&mGhostObject,
+			btBroadphaseProxy::CharacterFilter, btBroadphaseProxy::AllFilter);
+		mWorld.addAction(mController);
+	}
+
+	~PhysicStateWorld()
+	{
+		mWorld.removeAction(mController);
+		mWorld.removeCollisionObject(&mGhostObject);
+		mWorld.removeRigidBody(mSphere);
+		mWorld.removeCollisionObject(&mBlock);
+		mWorld.removeCollisionObject(&mFloor);
+
+		delete mController;
+		delete mSphere;
+		delete mSphereMotionState;
+	}
+
+	void Step(unsigned int steps)
+	{
+		for (unsigned int step = 0; step < steps; ++step)
+			mWorld.stepSimulation(0.02f, 10);
+	}
+
+	void Capture(BulletPhysicState& state)
+	{
+		state.Clear();
+		state.Capture(1, mSphere, NULL);
+		state.Capture(2, &mGhostObject, mController);
+	}
+
+	void Restore(BulletPhysicState const& state)
+	{
+		state.Restore(state.mActors[0], mSphere, NULL, &mWorld);
+		state.Restore(state.mActors[1], &mGhostObject, mController, &mWorld);
+	}
+
+	// positions and orientations of the moving objects, compared bit by bit
+	void Record(eastl::vector<btTransform>& transforms) const
+	{
+		transforms.push_back(mSphere->getWorldTransform());
+		transforms.push_back(mGhostObject.getWorldTransform());
+	}
+
+	btDefaultCollisionConfiguration mConfiguration;
+	btCollisionDispatcher mDispatcher;
+	btDbvtBroadphase mBroadphase;
+	btSequentialImpulseConstraintSolver mSolver;
+	btDiscreteDynamicsWorld mWorld;
+	btGhostPairCallback mGhostPairCallback;
+
+	btBoxShape mFloorShape;
+	btBoxShape mBlockShape;
+	btSphereShape mSphereShape;
+	btCapsuleShapeZ mCharacterShape;
+
+	btCollisionObject mFloor;
+	btCollisionObject mBlock;
+	btDefaultMotionState* mSphereMotionState;
+	btRigidBody* mSphere;
+	btPairCachingGhostObject mGhostObject;
+	BulletCharacterController* mController;
+};
+
+static bool SameTransforms(eastl::vector<btTransform> const& a, eastl::vector<btTransform> const& b)
+{
+	return a.size() == b.size() &&
+		memcmp(a.data(), b.data(), a.size() * sizeof(btTransform)) == 0;
+}
+
+static void Simulate(PhysicStateWorld& world, unsigned int steps, eastl::vector<btTransform>& transforms)
+{
+	transforms.clear();
+	world.mController->setWalkDirection(btVector3(4.f, 0.f, 0.f));
+	for (unsigned int step = 0; step < steps; ++step)
+	{
+		world.Step(1);
+		world.Record(transforms);
+	}
+}
+
+TEST_CASE(PhysicStateRestoreIsBitExact)
+{
+	PhysicStateWorld world;
+
+	// capture the character while it is falling
+	world.Step(10);
+	BulletPhysicState state;
+	world.Capture(state);
+
+	// the character lands and walks into the block, so its overlaps change
+	eastl::vector<btTransform> reference;
+	Simulate(world, 100, reference);
+	TEST_CHECK(world.mController->onGround());
+	TEST_CHECK(world.mGhostObject.getWorldTransform().getOrigin().x() > 48.f);
+
+	for (int attempt = 0; attempt < 3; ++attempt)
+	{
+		world.Restore(state);
+
+		// the ghost object is back to the overlaps it had while falling
+		BulletActorState const& character = state.mActors[1];
+		btAlignedObjectArray<btCollisionObject*>& overlaps = world.mGhostObject.getOverlappingPairs();
+		TEST_CHECK(overlaps.size() == character.mOverlapCount);
+		for (int i = 0; i < overlaps.size() && i < character.mOverlapCount; ++i)
+			TEST_CHECK(overlaps[i] == state.mOverlappingObjects[character.mOverlapOffset + i]);
+
+		eastl::vector<btTransform> transforms;
+		Simulate(world, 100, transforms);
+		TEST_CHECK(SameTransforms(reference, transforms));
+	}
+}
+
+TEST_CASE(PhysicStateCaptureReusesArrays)
+{
+	PhysicStateWorld world;
+	world.Step(30);
+
+	BulletPhysicState state;
+	world.Capture(state);
+	BulletActorState const* const actors = &state.mActors[0];
+	int const capacity = state.mActors.capacity();
+
+	world.Step(10);
+	world.Capture(state);
+	TEST_CHECK(state.mActors.size() == 2);
+	TEST_CHECK(&state.mActors[0] == actors);
+	TEST_CHECK(state.mActors.capacity() == capacity);
+}
@@ -0,0 +1,58 @@
+//========================================================================
+// Test.cpp - minimal test harness of the engine
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#include "Test.h"
+
+#include <cstdio>
+#include <cstring>
+
+TestRegistry& TestRegistry::Get()
+{
+	// constructed on first use, the registrations run before main
+	static TestRegistry registry;
+	return registry;
+}
+
+void TestRegistry::Add(char const* name, TestFunction function)
+{
+	TestCase testCase;
+	testCase.mName = name;
+	testCase.mFunction = function;
+	mTestCases.push_back(testCase);
+}
+
+void TestRegistry::Fail(char const* file, int line, char const* expression)
+{
+	printf("  %s(%d): check failed: %s\n", file, line, expression);
+	mFailedChecks++;
+}
+
+int TestRegistry::Run(char const* filter)
+{
+	int failedTestCases = 0;
+	int testCases = 0;
+	for (TestCase const& testCase : mTestCases)
+	{
+		if (filter && !strstr(testCase.mName, filter))
+			continue;
+
+		printf("%s\n", testCase.mName);
+		mFailedChecks = 0;
+		testCase.mFunction();
+		testCases++;
+		if (mFailedChecks)
+			failedTestCases++;
+	}
+
+	printf("%d test cases, %d failed\n", testCases, failedTestCases);
+	return failedTestCases;
+}
+
+int main(int argc, char* argv[])
+{
+	return TestRegistry::Get().Run(argc > 1 ? argv[1] : NULL);
+}
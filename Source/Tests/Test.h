@@ -0,0 +1,60 @@
+//========================================================================
+// Test.h - minimal test harness of the engine
+//
+// Part of the GameEngine Application
+//
+//========================================================================
+
+#ifndef TEST_H
+#define TEST_H
+
+#include "GameEngineStd.h"
+
+/*
+	Test cases register themselves before main runs. A failed check reports
+	its expression and carries on with the rest of the test case. The test
+	program runs the test cases whose name contains the first argument, or
+	all of them, and exits with the number of test cases which failed.
+*/
+typedef void (*TestFunction)();
+
+class TestRegistry
+{
+public:
+	static TestRegistry& Get();
+
+	void Add(char const* name, TestFunction function);
+	void Fail(char const* file, int line, char const* expression);
+	int Run(char const* filter);
+
+private:
+	TestRegistry() : mFailedChecks(0) { }
+
+	struct TestCase
+	{
+		char const* mName;
+		TestFunction mFunction;
+	};
+
+	eastl::vector<TestCase> mTestCases;
+	unsigned int mFailedChecks;
+};
+
+class TestRegistration
+{
+public:
+	TestRegistration(char const* name, TestFunction function)
+	{
+		TestRegistry::Get().Add(name, function);
+	}
+};
+
+#define TEST_CASE(name) \
+	static void name(); \
+	static TestRegistration name##Registration(#name, name); \
+	static void name()
+
+#define TEST_CHECK(expression) \
+	do { if (!(expression)) TestRegistry::Get().Fail(__FILE__, __LINE__, #expression); } while (0)
+
+#endif